@@ -1,11 +1,13 @@
 #include "app.h"
 
 #include "help_window.h"
+#include "qpc.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <float.h>
+#include <math.h>
 #include <windowsx.h>
 #include <psapi.h>
 #include <shellapi.h>
@@ -79,6 +81,10 @@ static const wchar_t *kWndClass = L"ccm_wnd";
 enum {
     IDM_VIEW_CPU0_15 = 1001,
     IDM_VIEW_STACK_PROCS = 1002,
+    IDM_VIEW_COPY_SELF_STATS = 1003,
+    IDM_VIEW_HISTORY_RAW = 1004,
+    IDM_VIEW_HISTORY_HOUR = 1005,
+    IDM_VIEW_HISTORY_DAY = 1006,
     IDM_PROC_END_TASK = 1501,
     IDM_PROC_KILL = 1502,
     IDM_PROC_COPY = 1503,
@@ -87,6 +93,7 @@ enum {
     IDM_PROC_COPY_ALL = 1506,
     IDM_PROC_COPY_PID = 1507,
     IDM_PROC_COPY_PATH = 1508,
+    IDM_PROC_WATCH = 1509,
     IDM_HELP_METRICS = 2001,
     IDM_HELP_ABOUT = 2002,
     IDM_HELP_MEMORY_DISKS = 2003,
@@ -99,8 +106,6 @@ typedef struct TextBufW {
     size_t cap;
 } TextBufW;
 
-static const ProcRow *find_row_by_pid(const ProcTable *pt, uint32_t pid);
-
 static bool textbuf_ensure_w(TextBufW *tb, size_t need)
 {
     if (!tb) return false;
@@ -186,456 +191,141 @@ static bool clipboard_set_text(HWND hwnd, const wchar_t *text)
     return true;
 }
 
-static int wcmp_insensitive_local(const wchar_t *a, const wchar_t *b)
-{
-    if (!a) a = L"";
-    if (!b) b = L"";
-#ifdef _MSC_VER
-    return _wcsicmp(a, b);
-#else
-    return wcsicmp(a, b);
-#endif
-}
+// UI-thread stages for the Self tab, registered in this order by App_Init.
+typedef enum AppStage {
+    APP_STAGE_PAINT = 0,
+    APP_STAGE_POLL_FRAME,
+    APP_STAGE_TABS,
+    APP_STAGE_HEADER,
+    APP_STAGE_USAGE_GRAPH,
+    APP_STAGE_PER_CORE,
+    APP_STAGE_WATCH_GRAPH,
+    APP_STAGE_MEMORY_HEADER,
+    APP_STAGE_PERCENT_GRAPH,
+    APP_STAGE_DISKS_GRAPH,
+    APP_STAGE_GPU_HEADER,
+    APP_STAGE_VALUE_GRAPH,
+    APP_STAGE_SELF_STATS,
+    APP_STAGE_PROCESS_TABLE,
+    APP_STAGE_PRESENT,
+    APP_STAGE_COUNT,
+} AppStage;
+
+static const wchar_t *const kAppStageNames[APP_STAGE_COUNT] = {
+    L"paint total",
+    L"poll frame",
+    L"draw tabs",
+    L"draw cpu header",
+    L"draw usage graph",
+    L"draw per-core",
+    L"draw watch graph",
+    L"draw memory header",
+    L"draw percent graph",
+    L"draw disks graph",
+    L"draw gpu header",
+    L"draw value graph",
+    L"draw self stats",
+    L"draw process table",
+    L"present (EndDraw)",
+};
+
+// Times one call into the UI-thread stage histogram.
+#define APP_TIMED(app, stage, call)                          \
+    do {                                                     \
+        const SelfTimer t_ = SelfStats_Begin();              \
+        call;                                                \
+        SelfStats_End(&(app)->self, (uint32_t)(stage), &t_); \
+    } while (0)
 
 static const ProcRow *app_proc_view_rows(const App *app, uint32_t *outCount)
 {
     if (outCount) *outCount = 0;
     if (!app) return NULL;
-
-    if (app->procStacked) {
-        if (outCount) *outCount = app->procViewCount;
-        return app->procViewRows;
-    }
-
-    if (outCount) *outCount = app->procTable.rowCount;
-    return app->procTable.rows;
+    if (!app->frame) return NULL;
+    return ProcView_Rows(&app->frame->procView, &app->frame->procTable, outCount);
 }
 
-static bool ensure_proc_view_rows(App *app, uint32_t want)
+static const ProcRow *app_find_view_row(App *app, uint32_t pid)
 {
-    if (!app) return false;
-    if (want <= app->procViewCap) return true;
-    uint32_t newCap = app->procViewCap ? (app->procViewCap * 2u) : 256u;
-    while (newCap < want) {
-        if (newCap > (UINT32_MAX / 2u)) {
-            newCap = want;
-            break;
-        }
-        newCap *= 2u;
-    }
-    void *p = realloc(app->procViewRows, (size_t)newCap * sizeof(*app->procViewRows));
-    if (!p) return false;
-    app->procViewRows = (ProcRow *)p;
-    app->procViewCap = newCap;
-    return true;
+    if (!app || !app->frame) return NULL;
+    return ProcView_FindRow(&app->frame->procView, &app->frame->procTable, pid);
 }
 
-static bool ensure_proc_groups(App *app, uint32_t want)
+// Hands the UI's sort/stacking/expansion state to the sampler, which rebuilds and republishes.
+static void App_RebuildProcView(App *app)
 {
-    if (!app) return false;
-    if (want <= app->procGroupCap) return true;
-    uint32_t newCap = app->procGroupCap ? (app->procGroupCap * 2u) : 64u;
-    while (newCap < want) {
-        if (newCap > (UINT32_MAX / 2u)) {
-            newCap = want;
-            break;
-        }
-        newCap *= 2u;
-    }
-    void *p = realloc(app->procGroups, (size_t)newCap * sizeof(*app->procGroups));
-    if (!p) return false;
-    app->procGroups = (struct ProcGroupIndex *)p;
-    app->procGroupCap = newCap;
-    return true;
+    Sampler_SetProcViewSettings(&app->sampler, &app->procViewSettings);
 }
 
-static bool ensure_proc_group_members(App *app, uint32_t want)
+// The sampler keeps the selected process at the full refresh rate; tell it when that changes.
+static void sync_selected_pid(App *app)
 {
-    if (!app) return false;
-    if (want <= app->procGroupMemberCap) return true;
-    uint32_t newCap = app->procGroupMemberCap ? (app->procGroupMemberCap * 2u) : 256u;
-    while (newCap < want) {
-        if (newCap > (UINT32_MAX / 2u)) {
-            newCap = want;
-            break;
-        }
-        newCap *= 2u;
-    }
-    void *p = realloc(app->procGroupMembers, (size_t)newCap * sizeof(*app->procGroupMembers));
-    if (!p) return false;
-    app->procGroupMembers = (uint32_t *)p;
-    app->procGroupMemberCap = newCap;
-    return true;
+    if (app->procViewSettings.selectedPid == app->procSelectedPid) return;
+    app->procViewSettings.selectedPid = app->procSelectedPid;
+    App_RebuildProcView(app);
 }
 
-static int find_group_by_name(App *app, const wchar_t *baseName)
+static void select_proc(App *app, uint32_t pid)
 {
-    if (!app || !baseName) return -1;
-    for (uint32_t i = 0; i < app->procGroupCount; i++) {
-        if (wcmp_insensitive_local(app->procGroups[i].baseName, baseName) == 0) {
-            return (int)i;
-        }
-    }
-    return -1;
+    const ProcRow *pr = app_find_view_row(app, pid);
+    app->procSelectedPid = pid;
+    app->procSelectedCreateTime = pr ? pr->createTime : 0;
+    sync_selected_pid(app);
 }
 
-static const struct ProcGroupIndex *find_group_by_leader_pid(const App *app, uint32_t leaderPid)
+// If selection doesn't exist in the current view (or its PID now names another
+// process), clear it.
+static void clear_missing_selection(App *app)
 {
-    if (!app || leaderPid == 0) return NULL;
-    for (uint32_t i = 0; i < app->procGroupCount; i++) {
-        if (app->procGroups[i].leaderPid == leaderPid) {
-            return &app->procGroups[i];
-        }
-    }
-    return NULL;
-}
+    if (app->procSelectedPid == 0) return;
 
-static const struct ProcGroupIndex *find_group_by_name_const(const App *app, const wchar_t *baseName)
-{
-    if (!app || !baseName) return NULL;
-    for (uint32_t i = 0; i < app->procGroupCount; i++) {
-        if (wcmp_insensitive_local(app->procGroups[i].baseName, baseName) == 0) {
-            return &app->procGroups[i];
-        }
-    }
-    return NULL;
+    const ProcRow *pr = app_find_view_row(app, app->procSelectedPid);
+    if (pr && pr->createTime == app->procSelectedCreateTime) return;
+    app->procSelectedPid = 0;
+    app->procSelectedCreateTime = 0;
+    sync_selected_pid(app);
 }
 
-static int row_cmp_cpu_desc_local(const void *a, const void *b)
+// The sampler only orders the rows the table can show plus a page of margin. Ask for
+// more as scrolling approaches the end of that, and for less again back near the top.
+static void update_proc_sort_depth(App *app)
 {
-    const ProcRow *ra = (const ProcRow *)a;
-    const ProcRow *rb = (const ProcRow *)b;
-    if (ra->cpuPct < rb->cpuPct) return 1;
-    if (ra->cpuPct > rb->cpuPct) return -1;
-    if (ra->workingSetBytes < rb->workingSetBytes) return 1;
-    if (ra->workingSetBytes > rb->workingSetBytes) return -1;
-    if (ra->pid < rb->pid) return -1;
-    if (ra->pid > rb->pid) return 1;
-    return 0;
+    const uint32_t page = app->render.procVisibleRows ? app->render.procVisibleRows : 32u;
+    const uint32_t want = (app->procScrollRow + 2u * page + 63u) & ~63u;
+    const uint32_t have = app->procViewSettings.sortDepth;
+    if (have != 0 && want <= have && want >= have / 4u) return;
+    app->procViewSettings.sortDepth = want;
+    App_RebuildProcView(app);
 }
 
-typedef struct GroupAgg {
-    float cpuSum;
-    uint64_t memSum;
-    bool ownerSame;
-    bool pathSame;
-    wchar_t owner[96];
-    wchar_t path[MAX_PATH];
-    bool hasAnyNet;
-    wchar_t netRemote[64];
-} GroupAgg;
-
-static bool ensure_group_aggs(GroupAgg **pAggs, uint32_t *pCap, uint32_t want)
+static bool append_self_stats_csv(TextBufW *tb, const wchar_t *thread, const SelfStats *set)
 {
-    if (!pAggs || !pCap) return false;
-    if (want <= *pCap) return true;
-    uint32_t newCap = (*pCap) ? (*pCap * 2u) : 64u;
-    while (newCap < want) {
-        if (newCap > (UINT32_MAX / 2u)) {
-            newCap = want;
-            break;
+    for (uint32_t i = 0; i < set->stageCount; i++) {
+        SelfStageSummary sum;
+        SelfStats_Summarize(&set->stages[i], &sum);
+        if (!textbuf_appendf_w(tb, L"%ls,%ls,%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%u\r\n",
+                               thread, set->stages[i].name, (unsigned long long)sum.count,
+                               sum.p50Us, sum.p99Us, sum.maxUs, sum.meanUs,
+                               sum.allocsPerCall, (unsigned)sum.allocMax)) {
+            return false;
         }
-        newCap *= 2u;
     }
-    void *p = realloc(*pAggs, (size_t)newCap * sizeof(**pAggs));
-    if (!p) return false;
-    *pAggs = (GroupAgg *)p;
-    *pCap = newCap;
     return true;
 }
 
-static void App_RebuildProcView(App *app)
+// Exports both stage sets as CSV to the clipboard.
+static bool copy_self_stats(App *app)
 {
-    if (!app) return;
-
-    if (!app->procStacked) {
-        app->procViewCount = 0;
-        app->procGroupCount = 0;
-        app->procGroupMemberCount = 0;
-        return;
-    }
-
-    const ProcRow *raw = app->procTable.rows;
-    const uint32_t rawCount = app->procTable.rowCount;
-    if (!raw || rawCount == 0) {
-        app->procViewCount = 0;
-        app->procGroupCount = 0;
-        app->procGroupMemberCount = 0;
-        return;
-    }
-
-    app->procGroupCount = 0;
-    app->procGroupMemberCount = 0;
-
-    // Temporary per-group aggregation.
-    static GroupAgg *aggs = NULL;
-    static uint32_t aggsCap = 0;
-
-    for (uint32_t i = 0; i < rawCount; i++) {
-        const ProcRow *pr = &raw[i];
-        if (pr->pid == 0) continue;
-
-        const int gi = find_group_by_name(app, pr->name);
-        int useGi = gi;
-        if (useGi < 0) {
-            if (!ensure_proc_groups(app, app->procGroupCount + 1)) break;
-            if (!ensure_group_aggs(&aggs, &aggsCap, app->procGroupCount + 1)) break;
-
-            const uint32_t idx = app->procGroupCount++;
-            memset(&app->procGroups[idx], 0, sizeof(app->procGroups[idx]));
-            wcsncpy(app->procGroups[idx].baseName, pr->name, (uint32_t)(sizeof(app->procGroups[idx].baseName) / sizeof(app->procGroups[idx].baseName[0])) - 1);
-            app->procGroups[idx].baseName[(uint32_t)(sizeof(app->procGroups[idx].baseName) / sizeof(app->procGroups[idx].baseName[0])) - 1] = 0;
-            app->procGroups[idx].leaderPid = pr->pid;
-            app->procGroups[idx].memberStart = app->procGroupMemberCount;
-            app->procGroups[idx].memberCount = 0;
-
-            memset(&aggs[idx], 0, sizeof(aggs[idx]));
-            aggs[idx].cpuSum = 0.0f;
-            aggs[idx].memSum = 0;
-            aggs[idx].ownerSame = true;
-            aggs[idx].pathSame = true;
-            wcsncpy(aggs[idx].owner, pr->owner, (uint32_t)(sizeof(aggs[idx].owner) / sizeof(aggs[idx].owner[0])) - 1);
-            aggs[idx].owner[(uint32_t)(sizeof(aggs[idx].owner) / sizeof(aggs[idx].owner[0])) - 1] = 0;
-            wcsncpy(aggs[idx].path, pr->path, (uint32_t)(sizeof(aggs[idx].path) / sizeof(aggs[idx].path[0])) - 1);
-            aggs[idx].path[(uint32_t)(sizeof(aggs[idx].path) / sizeof(aggs[idx].path[0])) - 1] = 0;
-            aggs[idx].hasAnyNet = pr->hasNet;
-            if (pr->hasNet) {
-                wcsncpy(aggs[idx].netRemote, pr->netRemote, (uint32_t)(sizeof(aggs[idx].netRemote) / sizeof(aggs[idx].netRemote[0])) - 1);
-                aggs[idx].netRemote[(uint32_t)(sizeof(aggs[idx].netRemote) / sizeof(aggs[idx].netRemote[0])) - 1] = 0;
-            } else {
-                aggs[idx].netRemote[0] = 0;
-            }
-
-            useGi = (int)idx;
-        }
-
-        if (useGi < 0) continue;
-
-        if (!ensure_proc_group_members(app, app->procGroupMemberCount + 1)) break;
-        app->procGroupMembers[app->procGroupMemberCount++] = pr->pid;
-        app->procGroups[useGi].memberCount++;
-
-        if (pr->pid < app->procGroups[useGi].leaderPid) {
-            app->procGroups[useGi].leaderPid = pr->pid;
-        }
-
-        aggs[useGi].cpuSum += pr->cpuPct;
-        aggs[useGi].memSum += pr->workingSetBytes;
-
-        if (aggs[useGi].ownerSame) {
-            if (wcmp_insensitive_local(aggs[useGi].owner, pr->owner) != 0) {
-                aggs[useGi].ownerSame = false;
-            }
-        }
-        if (aggs[useGi].pathSame) {
-            if (wcmp_insensitive_local(aggs[useGi].path, pr->path) != 0) {
-                aggs[useGi].pathSame = false;
-            }
-        }
-        if (!aggs[useGi].hasAnyNet && pr->hasNet) {
-            aggs[useGi].hasAnyNet = true;
-            wcsncpy(aggs[useGi].netRemote, pr->netRemote, (uint32_t)(sizeof(aggs[useGi].netRemote) / sizeof(aggs[useGi].netRemote[0])) - 1);
-            aggs[useGi].netRemote[(uint32_t)(sizeof(aggs[useGi].netRemote) / sizeof(aggs[useGi].netRemote[0])) - 1] = 0;
-        }
-    }
-
-    // Build view rows from groups (+ optional expanded group members).
-    uint32_t extra = 0;
-    if (app->procHasExpanded && app->procExpandedBaseName[0]) {
-        const struct ProcGroupIndex *eg = find_group_by_name_const(app, app->procExpandedBaseName);
-        if (eg && eg->memberCount > 1) {
-            // We'll show members except leader PID to avoid PID collisions with group header.
-            extra = eg->memberCount - 1;
-        }
-    }
-
-    if (!ensure_proc_view_rows(app, app->procGroupCount + extra)) {
-        app->procViewCount = 0;
-        return;
-    }
-    app->procViewCount = 0;
-
-    for (uint32_t i = 0; i < app->procGroupCount; i++) {
-        ProcRow vr;
-        memset(&vr, 0, sizeof(vr));
-
-        vr.pid = app->procGroups[i].leaderPid;
-        vr.cpuPct = aggs[i].cpuSum;
-        if (vr.cpuPct < 0.0f) vr.cpuPct = 0.0f;
-        if (vr.cpuPct > 100.0f) vr.cpuPct = 100.0f;
-        vr.workingSetBytes = aggs[i].memSum;
-
-        // Network endpoints are per-process; aggregated view doesn't try to summarize.
-        vr.hasNet = false;
-        vr.netRemote[0] = 0;
-
-        if (app->procGroups[i].memberCount > 1) {
-            swprintf(vr.name, (uint32_t)(sizeof(vr.name) / sizeof(vr.name[0])),
-                     L"%ls (%u)",
-                     app->procGroups[i].baseName,
-                     (unsigned)app->procGroups[i].memberCount);
-        } else {
-            wcsncpy(vr.name, app->procGroups[i].baseName, (uint32_t)(sizeof(vr.name) / sizeof(vr.name[0])) - 1);
-            vr.name[(uint32_t)(sizeof(vr.name) / sizeof(vr.name[0])) - 1] = 0;
-        }
-
-        if (aggs[i].ownerSame) {
-            wcsncpy(vr.owner, aggs[i].owner, (uint32_t)(sizeof(vr.owner) / sizeof(vr.owner[0])) - 1);
-            vr.owner[(uint32_t)(sizeof(vr.owner) / sizeof(vr.owner[0])) - 1] = 0;
-        } else {
-            vr.owner[0] = 0;
-        }
-
-        if (aggs[i].pathSame) {
-            wcsncpy(vr.path, aggs[i].path, (uint32_t)(sizeof(vr.path) / sizeof(vr.path[0])) - 1);
-            vr.path[(uint32_t)(sizeof(vr.path) / sizeof(vr.path[0])) - 1] = 0;
-        } else {
-            vr.path[0] = 0;
-        }
-
-        app->procViewRows[app->procViewCount++] = vr;
-
-        // Insert expanded member rows directly under the expanded group header.
-        if (app->procHasExpanded && app->procExpandedBaseName[0] &&
-            wcmp_insensitive_local(app->procExpandedBaseName, app->procGroups[i].baseName) == 0 &&
-            app->procGroups[i].memberCount > 1) {
-
-            // Collect member rows from the raw table.
-            const uint32_t m = app->procGroups[i].memberCount;
-            ProcRow *tmp = (ProcRow *)calloc(m, sizeof(ProcRow));
-            uint32_t tmpCount = 0;
-            if (tmp) {
-                for (uint32_t mi = 0; mi < m; mi++) {
-                    const uint32_t mpid = app->procGroupMembers[app->procGroups[i].memberStart + mi];
-                    if (mpid == app->procGroups[i].leaderPid) continue;
-                    const ProcRow *rawRow = find_row_by_pid(&app->procTable, mpid);
-                    if (!rawRow) continue;
-                    tmp[tmpCount++] = *rawRow;
-
-                    // Visual hint: indent member rows.
-                    wchar_t nn[64];
-                    wcsncpy(nn, tmp[tmpCount - 1].name, (uint32_t)(sizeof(nn) / sizeof(nn[0])) - 1);
-                    nn[(uint32_t)(sizeof(nn) / sizeof(nn[0])) - 1] = 0;
-                    swprintf(tmp[tmpCount - 1].name,
-                             (uint32_t)(sizeof(tmp[tmpCount - 1].name) / sizeof(tmp[tmpCount - 1].name[0])),
-                             L"  %ls",
-                             nn);
-                }
-
-                if (tmpCount > 1) {
-                    qsort(tmp, tmpCount, sizeof(tmp[0]), row_cmp_cpu_desc_local);
-                }
-
-                for (uint32_t k = 0; k < tmpCount; k++) {
-                    if (app->procViewCount < app->procViewCap) {
-                        app->procViewRows[app->procViewCount++] = tmp[k];
-                    }
-                }
-                free(tmp);
-            }
-        }
-    }
-
-    // Sort group rows only; keep expanded member rows directly beneath their group.
-    // Implementation approach: if nothing is expanded, sort the whole view.
-    if (!app->procHasExpanded || !app->procExpandedBaseName[0]) {
-        ProcTable st;
-        memset(&st, 0, sizeof(st));
-        st.rows = app->procViewRows;
-        st.rowCount = app->procViewCount;
-        ProcTable_Sort(&st, app->procSortKey, app->procSortAsc);
-    } else {
-        // Build a temporary group-only array, sort it, then re-insert members for the expanded group.
-        const struct ProcGroupIndex *eg = find_group_by_name_const(app, app->procExpandedBaseName);
-        const uint32_t groupCount = app->procGroupCount;
-        ProcRow *sortedGroups = (ProcRow *)calloc(groupCount, sizeof(ProcRow));
-        if (sortedGroups) {
-            uint32_t gcount = 0;
-            for (uint32_t i = 0; i < app->procGroupCount; i++) {
-                // Group headers are the first occurrence for each group in procViewRows at build time.
-                // We can reconstruct them by building again from procGroups/aggs would be expensive; instead
-                // take the already-built group headers from procViewRows by matching leaderPid and baseName.
-                // We know the group header was appended before any members for that group.
-                // So locate it in procViewRows by scanning from 0.
-                for (uint32_t j = 0; j < app->procViewCount; j++) {
-                    if (app->procViewRows[j].pid == app->procGroups[i].leaderPid) {
-                        // Also ensure this row looks like a group header for this group.
-                        if (wcsstr(app->procViewRows[j].name, app->procGroups[i].baseName) == app->procViewRows[j].name ||
-                            wcsstr(app->procViewRows[j].name, app->procGroups[i].baseName) != NULL) {
-                            sortedGroups[gcount++] = app->procViewRows[j];
-                            break;
-                        }
-                    }
-                }
-            }
-
-            ProcTable st;
-            memset(&st, 0, sizeof(st));
-            st.rows = sortedGroups;
-            st.rowCount = gcount;
-            ProcTable_Sort(&st, app->procSortKey, app->procSortAsc);
-
-            // Rewrite procViewRows: sorted group headers, and after the expanded one insert members.
-            uint32_t out = 0;
-            for (uint32_t gi = 0; gi < gcount; gi++) {
-                app->procViewRows[out++] = sortedGroups[gi];
-                if (eg && sortedGroups[gi].pid == eg->leaderPid) {
-                    // Rebuild members for expanded group (same logic as above, but without indenting twice).
-                    const uint32_t m = eg->memberCount;
-                    ProcRow *tmp = (ProcRow *)calloc(m, sizeof(ProcRow));
-                    uint32_t tmpCount = 0;
-                    if (tmp) {
-                        for (uint32_t mi = 0; mi < m; mi++) {
-                            const uint32_t mpid = app->procGroupMembers[eg->memberStart + mi];
-                            if (mpid == eg->leaderPid) continue;
-                            const ProcRow *rawRow = find_row_by_pid(&app->procTable, mpid);
-                            if (!rawRow) continue;
-                            tmp[tmpCount++] = *rawRow;
-                            wchar_t nn[64];
-                            wcsncpy(nn, tmp[tmpCount - 1].name, (uint32_t)(sizeof(nn) / sizeof(nn[0])) - 1);
-                            nn[(uint32_t)(sizeof(nn) / sizeof(nn[0])) - 1] = 0;
-                            swprintf(tmp[tmpCount - 1].name,
-                                     (uint32_t)(sizeof(tmp[tmpCount - 1].name) / sizeof(tmp[tmpCount - 1].name[0])),
-                                     L"  %ls",
-                                     nn);
-                        }
-                        if (tmpCount > 1) {
-                            qsort(tmp, tmpCount, sizeof(tmp[0]), row_cmp_cpu_desc_local);
-                        }
-                        for (uint32_t k = 0; k < tmpCount; k++) {
-                            app->procViewRows[out++] = tmp[k];
-                        }
-                        free(tmp);
-                    }
-                }
-            }
-            app->procViewCount = out;
-            free(sortedGroups);
-        }
-    }
-
-    // If selection doesn't exist in the new view, clear it.
-    if (app->procSelectedPid != 0) {
-        bool found = false;
-        for (uint32_t i = 0; i < app->procViewCount; i++) {
-            if (app->procViewRows[i].pid == app->procSelectedPid) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
-            app->procSelectedPid = 0;
-        }
-    }
-}
-
-static const ProcRow *find_row_by_pid(const ProcTable *pt, uint32_t pid)
-{
-    if (!pt || !pt->rows || pid == 0) return NULL;
-    for (uint32_t i = 0; i < pt->rowCount; i++) {
-        if (pt->rows[i].pid == pid) return &pt->rows[i];
-    }
-    return NULL;
+    if (!app || !app->frame) return false;
+
+    TextBufW tb;
+    memset(&tb, 0, sizeof(tb));
+    bool ok = textbuf_append_w(&tb, L"thread,stage,calls,p50_us,p99_us,max_us,mean_us,allocs_per_call,allocs_max\r\n");
+    ok = ok && append_self_stats_csv(&tb, L"sampler", &app->frame->self);
+    ok = ok && append_self_stats_csv(&tb, L"ui", &app->self);
+    ok = ok && clipboard_set_text(app->hwnd, tb.p);
+    textbuf_free_w(&tb);
+    return ok;
 }
 
 static const wchar_t *proc_copy_header_line(void)
@@ -644,14 +334,21 @@ static const wchar_t *proc_copy_header_line(void)
     return L"PID\tCPU%\tMem(MB)\tOwner\tNet(remote)\tName\tPath\r\n";
 }
 
-static bool proc_append_row_tab_line(TextBufW *tb, const ProcRow *pr)
+static const StrPool *app_proc_strings(const App *app)
+{
+    return app->frame ? &app->frame->procTable.strings : NULL;
+}
+
+static bool proc_append_row_tab_line(TextBufW *tb, const ProcRow *pr, const StrPool *strings)
 {
     if (!tb || !pr) return false;
     const double memMB = (double)pr->workingSetBytes / (1024.0 * 1024.0);
-    const wchar_t *owner = pr->owner[0] ? pr->owner : L"";
-    const wchar_t *net = pr->hasNet ? pr->netRemote : L"";
-    const wchar_t *name = pr->name[0] ? pr->name : L"";
-    const wchar_t *path = pr->path[0] ? pr->path : L"";
+    const wchar_t *owner = StrPool_Get(strings, pr->ownerId);
+    const wchar_t *path = StrPool_Get(strings, pr->pathId);
+    wchar_t net[80];
+    ProcView_RowNet(pr, strings, net, sizeof(net) / sizeof(net[0]));
+    wchar_t name[96];
+    ProcView_RowName(pr, strings, name, sizeof(name) / sizeof(name[0]));
 
     return textbuf_appendf_w(tb,
                              L"%u\t%.1f\t%.1f\t%ls\t%ls\t%ls\t%ls\r\n",
@@ -676,16 +373,27 @@ static bool copy_process_rows(App *app, uint32_t startRow, uint32_t count)
     const uint32_t maxCount = rowCount - startRow;
     if (count > maxCount) count = maxCount;
 
+    // Rows past the sampler's sort depth are only partitioned; order a copy.
+    ProcRow *ordered = NULL;
+    if (startRow + count > ProcView_SortedCount(&app->frame->procView, &app->frame->procTable)) {
+        ordered = (ProcRow *)malloc((size_t)rowCount * sizeof(ProcRow));
+        if (!ordered) return false;
+        if (ProcView_CopyOrdered(&app->frame->procView, &app->frame->procTable, ordered, rowCount)) {
+            rows = ordered;
+        }
+    }
+
     TextBufW tb = {0};
     bool ok = textbuf_append_w(&tb, proc_copy_header_line());
     for (uint32_t i = 0; ok && i < count; i++) {
-        ok = proc_append_row_tab_line(&tb, &rows[startRow + i]);
+        ok = proc_append_row_tab_line(&tb, &rows[startRow + i], app_proc_strings(app));
     }
 
     if (ok) {
         ok = clipboard_set_text(app->hwnd, tb.p);
     }
     textbuf_free_w(&tb);
+    free(ordered);
     return ok;
 }
 
@@ -717,43 +425,30 @@ static bool copy_selected_process_pid(App *app)
 static bool copy_selected_process_path(App *app)
 {
     if (!app || !app->hwnd) return false;
-    uint32_t rowCount = 0;
-    const ProcRow *rows = app_proc_view_rows(app, &rowCount);
-    if (!rows || rowCount == 0) return false;
     if (app->procSelectedPid == 0) return false;
 
     // In stacked mode, Path is only shown if common across group.
-    ProcTable tmp;
-    memset(&tmp, 0, sizeof(tmp));
-    tmp.rows = (ProcRow *)rows;
-    tmp.rowCount = rowCount;
-    const ProcRow *pr = find_row_by_pid(&tmp, app->procSelectedPid);
+    const ProcRow *pr = app_find_view_row(app, app->procSelectedPid);
     if (!pr) return false;
-    if (pr->path[0] == 0) return false;
+    const wchar_t *path = StrPool_Get(app_proc_strings(app), pr->pathId);
+    if (path[0] == 0) return false;
 
     wchar_t buf[MAX_PATH + 8];
-    swprintf(buf, (uint32_t)(sizeof(buf) / sizeof(buf[0])), L"%ls\r\n", pr->path);
+    swprintf(buf, (uint32_t)(sizeof(buf) / sizeof(buf[0])), L"%ls\r\n", path);
     return clipboard_set_text(app->hwnd, buf);
 }
 
 static bool copy_selected_process_row(App *app)
 {
     if (!app || !app->hwnd) return false;
-    uint32_t rowCount = 0;
-    const ProcRow *rows = app_proc_view_rows(app, &rowCount);
-    if (!rows || rowCount == 0) return false;
     if (app->procSelectedPid == 0) return false;
 
-    ProcTable tmp;
-    memset(&tmp, 0, sizeof(tmp));
-    tmp.rows = (ProcRow *)rows;
-    tmp.rowCount = rowCount;
-    const ProcRow *pr = find_row_by_pid(&tmp, app->procSelectedPid);
+    const ProcRow *pr = app_find_view_row(app, app->procSelectedPid);
     if (!pr) return false;
 
     TextBufW tb = {0};
     bool ok = textbuf_append_w(&tb, proc_copy_header_line());
-    ok = ok && proc_append_row_tab_line(&tb, pr);
+    ok = ok && proc_append_row_tab_line(&tb, pr, app_proc_strings(app));
     if (ok) {
         ok = clipboard_set_text(app->hwnd, tb.p);
     }
@@ -764,19 +459,13 @@ static bool copy_selected_process_row(App *app)
 static bool open_selected_process_location(App *app)
 {
     if (!app || !app->hwnd) return false;
-    uint32_t rowCount = 0;
-    const ProcRow *rows = app_proc_view_rows(app, &rowCount);
-    if (!rows || rowCount == 0) return false;
     if (app->procSelectedPid == 0) return false;
 
-    ProcTable tmp;
-    memset(&tmp, 0, sizeof(tmp));
-    tmp.rows = (ProcRow *)rows;
-    tmp.rowCount = rowCount;
-    const ProcRow *pr = find_row_by_pid(&tmp, app->procSelectedPid);
+    const ProcRow *pr = app_find_view_row(app, app->procSelectedPid);
     if (!pr) return false;
 
-    if (pr->path[0] == 0) {
+    const wchar_t *path = StrPool_Get(app_proc_strings(app), pr->pathId);
+    if (path[0] == 0) {
         MessageBoxW(app->hwnd,
                     L"No executable path available for this process (access denied or protected process).",
                     L"Open File Location",
@@ -786,7 +475,7 @@ static bool open_selected_process_location(App *app)
 
     // Open Explorer with the file selected.
     wchar_t args[MAX_PATH + 64];
-    swprintf(args, (uint32_t)(sizeof(args) / sizeof(args[0])), L"/select,\"%ls\"", pr->path);
+    swprintf(args, (uint32_t)(sizeof(args) / sizeof(args[0])), L"/select,\"%ls\"", path);
 
     HINSTANCE res = ShellExecuteW(app->hwnd, L"open", L"explorer.exe", args, NULL, SW_SHOWNORMAL);
     if ((INT_PTR)res <= 32) {
@@ -939,6 +628,14 @@ static bool tab_hit_test(const App *app, int x, int y, AppTab *outTab)
         }
     }
 
+    if (r->tabSelfW > 0.0f && r->tabSelfH > 0.0f) {
+        if (fx >= r->tabSelfX && fx <= (r->tabSelfX + r->tabSelfW) &&
+            fy >= r->tabSelfY && fy <= (r->tabSelfY + r->tabSelfH)) {
+            *outTab = APP_TAB_SELF;
+            return true;
+        }
+    }
+
     return false;
 }
 
@@ -980,226 +677,88 @@ static bool try_kill_process(uint32_t pid)
     return ok ? true : false;
 }
 
-static double qpc_seconds(int64_t delta, double freq)
+// Series a graph draws for the selected history range: the raw samples, or the peak of
+// each rollup bucket so short spikes stay visible over the long ranges.
+static const RingBufF *range_series(const App *app, const RingBufF *raw, const HistRollup *rollup)
 {
-    return (double)delta / freq;
+    if (app->historyRange == APP_HISTORY_RAW || !rollup) return raw;
+    const uint32_t tier = (app->historyRange == APP_HISTORY_HOUR) ? MONITOR_TIER_HOUR : MONITOR_TIER_DAY;
+    if (tier >= rollup->tierCount) return raw;
+    return &rollup->tiers[tier].max;
 }
 
-static int64_t qpc_now(void)
+// Scale top matching range_series: the raw window's max or the tier's sliding peak.
+static float range_max(const App *app, const WindowSummary *raw, const HistRollup *rollup)
 {
-    LARGE_INTEGER li;
-    QueryPerformanceCounter(&li);
-    return (int64_t)li.QuadPart;
+    if (app->historyRange == APP_HISTORY_RAW || !rollup) return raw->max;
+    const uint32_t tier = (app->historyRange == APP_HISTORY_HOUR) ? MONITOR_TIER_HOUR : MONITOR_TIER_DAY;
+    if (tier >= rollup->tierCount) return raw->max;
+    return rollup->tiers[tier].peakMax;
 }
 
-static double qpc_freq(void)
+static void sync_render_disks(App *app, const MonitorFrame *f)
 {
-    LARGE_INTEGER li;
-    QueryPerformanceFrequency(&li);
-    return (double)li.QuadPart;
+    if (app->renderDiskCount != f->diskCount) {
+        free(app->renderDisks);
+        app->renderDisks = NULL;
+        app->renderDiskCount = 0;
+        if (f->diskCount == 0) return;
+
+        app->renderDisks = (RenderDiskSeries *)calloc(f->diskCount, sizeof(*app->renderDisks));
+        if (!app->renderDisks) return;
+        SelfStats_NoteAlloc();
+        app->renderDiskCount = f->diskCount;
+    }
+
+    for (uint32_t i = 0; i < app->renderDiskCount; i++) {
+        app->renderDisks[i].name = f->disks[i].name;
+        app->renderDisks[i].readMBpsHistory = &f->disks[i].readMBpsHistory;
+        app->renderDisks[i].writeMBpsHistory = &f->disks[i].writeMBpsHistory;
+        app->renderDisks[i].readMBps = f->disks[i].readMBps;
+        app->renderDisks[i].writeMBps = f->disks[i].writeMBps;
+        app->renderDisks[i].peakMBps = (f->disks[i].readStats.max > f->disks[i].writeStats.max)
+                                           ? f->disks[i].readStats.max
+                                           : f->disks[i].writeStats.max;
+    }
 }
 
-static void App_Sample(App *app)
+// Picks up the newest frame published by the sampler thread (never blocks).
+static void App_PollFrame(App *app)
 {
-    const int64_t now = qpc_now();
-    const double dt = qpc_seconds(now - app->lastSampleQpc, app->qpcFreq);
-    if (dt < app->sampleIntervalSec) {
+    bool isNew = false;
+    app->frame = Sampler_AcquireFrame(&app->sampler, &isNew);
+    if (!isNew) {
         return;
     }
-    app->lastSampleQpc = now;
-
-    PdhSample sample = {0};
-    if (Pdh_TrySample(&app->pdh, &sample)) {
-        app->totalUsage = sample.totalCpu;
-        if (app->totalUsage < app->totalUsageMin) app->totalUsageMin = app->totalUsage;
-        if (app->totalUsage > app->totalUsageMax) app->totalUsageMax = app->totalUsage;
-        for (uint32_t i = 0; i < app->logicalCount; i++) {
-            app->coreUsage[i] = sample.coreCpu[i];
-            app->coreMHz[i] = sample.coreMHz ? sample.coreMHz[i] : 0.0f;
-        }
-    }
-
-    // Prefer powrprof per-core frequency when available.
-    PowerCpuSample ps;
-    ps.currentMHz = app->coreMHz;
-    ps.maxMHz = app->coreMaxMHz;
-    PowerCpu_TrySample(app->logicalCount, &ps);
-
-    // Frequency change events (best-effort): count core MHz changes between samples.
-    uint32_t changes = 0;
-    for (uint32_t i = 0; i < app->logicalCount; i++) {
-        const float prev = app->prevCoreMHz[i];
-        const float cur = app->coreMHz[i];
-        if (prev > 0.0f && cur > 0.0f && prev != cur) {
-            changes++;
-        }
-        app->prevCoreMHz[i] = cur;
-    }
-    app->freqChangeCount = changes;
-    app->freqChangesPerSec = (dt > 0.0) ? ((double)changes / dt) : 0.0;
-
-    // Throttling estimate: cores running significantly below their max.
-    uint32_t thr = 0;
-    uint32_t denom = 0;
-    for (uint32_t i = 0; i < app->logicalCount; i++) {
-        const float maxM = app->coreMaxMHz[i];
-        const float curM = app->coreMHz[i];
-        if (maxM > 0.0f && curM > 0.0f) {
-            denom++;
-            const float ratio = curM / maxM;
-            if (ratio < 0.95f) {
-                thr++;
-            }
-        }
-    }
-    app->throttlePct = (denom > 0) ? (100.0f * (float)thr / (float)denom) : 0.0f;
 
-    // ETW-derived scheduler/ISR/DPC rates
-    EtwKernel_ComputeRates(&app->etw, dt, &app->etwRates);
+    const SelfTimer poll = SelfStats_Begin();
 
-    RingBuf_Push(&app->totalUsageHistory, app->totalUsage);
-    for (uint32_t i = 0; i < app->logicalCount; i++) {
-        RingBuf_Push(&app->coreUsageHistory[i], app->coreUsage[i]);
-    }
+    const MonitorFrame *f = app->frame;
 
     // Optional sensors via external provider.
     // If no provider is running, try to auto-start a bundled provider executable.
-    ExternalSensors_TrySample(&app->extSensors);
-    if (!app->providerAutostartAttempted) {
+    if (!app->providerAutostartAttempted && f->snap.sensorStatus[0] != 0) {
         app->providerAutostartAttempted = true;
-        if (wcsstr(app->extSensors.status, L"provider not running") != NULL) {
+        if (wcsstr(f->snap.sensorStatus, L"provider not running") != NULL) {
             (void)try_start_bundled_provider(app);
         }
     }
 
-    float tempC = 0.0f;
-    if (app->extSensors.hasCpuTempC) {
-        app->cpuTempC = app->extSensors.cpuTempC;
-    } else if (WmiSensors_TryReadCpuTempC(&app->wmi, &tempC)) {
-        app->cpuTempC = tempC;
-    } else {
-        app->cpuTempC = -1.0f;
-    }
-
-    float rpm = 0.0f;
-    if (app->extSensors.hasFanRpm) {
-        app->fanRpm = app->extSensors.fanRpm;
-    } else if (WmiSensors_TryReadFanRpm(&app->wmi, &rpm)) {
-        app->fanRpm = rpm;
-    } else {
-        app->fanRpm = -1.0f;
-    }
-
-    // Process table (best-effort)
-    ProcTable_Sample(&app->procTable);
-
-    // Keep display sorted according to UI state.
-    if (!app->procStacked) {
-        ProcTable_Sort(&app->procTable, app->procSortKey, app->procSortAsc);
-    }
-
-    // Build stacked/grouped view if enabled (and sort the view rows).
-    App_RebuildProcView(app);
+    clear_missing_selection(app);
 
     // Clamp scroll after any change in row count.
     const uint32_t maxScroll = proc_max_scroll_rows(app);
     app->procScrollRow = clamp_u32(app->procScrollRow, 0, maxScroll);
 
-    // Memory + storage (best-effort)
-    MEMORYSTATUSEX ms;
-    ZeroMemory(&ms, sizeof(ms));
-    ms.dwLength = sizeof(ms);
-    if (GlobalMemoryStatusEx(&ms)) {
-        app->memTotalPhysBytes = (uint64_t)ms.ullTotalPhys;
-        app->memAvailPhysBytes = (uint64_t)ms.ullAvailPhys;
-        const uint64_t used = (app->memTotalPhysBytes > app->memAvailPhysBytes) ? (app->memTotalPhysBytes - app->memAvailPhysBytes) : 0;
-        app->memUsedPct = (app->memTotalPhysBytes > 0) ? (100.0f * (float)((double)used / (double)app->memTotalPhysBytes)) : 0.0f;
-        RingBuf_Push(&app->memUsedPctHistory, app->memUsedPct);
-    }
-
-    PERFORMANCE_INFORMATION pi;
-    ZeroMemory(&pi, sizeof(pi));
-    pi.cb = sizeof(pi);
-    if (GetPerformanceInfo(&pi, sizeof(pi))) {
-        const uint64_t pageSize = (uint64_t)pi.PageSize;
-        app->commitTotalBytes = (uint64_t)pi.CommitTotal * pageSize;
-        app->commitLimitBytes = (uint64_t)pi.CommitLimit * pageSize;
-        app->commitUsedPct = (app->commitLimitBytes > 0) ? (100.0f * (float)((double)app->commitTotalBytes / (double)app->commitLimitBytes)) : 0.0f;
-        RingBuf_Push(&app->commitUsedPctHistory, app->commitUsedPct);
-    }
-
-    // Disk throughput
-    if (app->pdh.hasPerDisk && app->pdh.diskCount > 0 && app->disks && app->diskCount == app->pdh.diskCount) {
-        for (uint32_t i = 0; i < app->diskCount; i++) {
-            const double rMBps = app->pdh.lastDiskReadBytesPerSec[i] / (1024.0 * 1024.0);
-            const double wMBps = app->pdh.lastDiskWriteBytesPerSec[i] / (1024.0 * 1024.0);
-            app->disks[i].readMBps = rMBps;
-            app->disks[i].writeMBps = wMBps;
-            if (app->renderDisks) {
-                app->renderDisks[i].readMBps = rMBps;
-                app->renderDisks[i].writeMBps = wMBps;
-            }
-            RingBuf_Push(&app->disks[i].readMBpsHistory, (float)rMBps);
-            RingBuf_Push(&app->disks[i].writeMBpsHistory, (float)wMBps);
-        }
-
-        // Also keep a legacy _Total fallback series updated (useful on layouts)
-        app->diskReadMBps = app->pdh.lastRates.hasDisk ? (app->pdh.lastRates.diskReadBytesPerSec / (1024.0 * 1024.0)) : 0.0;
-        app->diskWriteMBps = app->pdh.lastRates.hasDisk ? (app->pdh.lastRates.diskWriteBytesPerSec / (1024.0 * 1024.0)) : 0.0;
-        RingBuf_Push(&app->diskReadMBpsHistory, (float)app->diskReadMBps);
-        RingBuf_Push(&app->diskWriteMBpsHistory, (float)app->diskWriteMBps);
-    } else if (app->pdh.lastRates.hasDisk) {
-        app->diskReadMBps = app->pdh.lastRates.diskReadBytesPerSec / (1024.0 * 1024.0);
-        app->diskWriteMBps = app->pdh.lastRates.diskWriteBytesPerSec / (1024.0 * 1024.0);
-        RingBuf_Push(&app->diskReadMBpsHistory, (float)app->diskReadMBps);
-        RingBuf_Push(&app->diskWriteMBpsHistory, (float)app->diskWriteMBps);
-    } else {
-        app->diskReadMBps = 0.0;
-        app->diskWriteMBps = 0.0;
-        RingBuf_Push(&app->diskReadMBpsHistory, 0.0f);
-        RingBuf_Push(&app->diskWriteMBpsHistory, 0.0f);
-    }
-
-    // GPU (best-effort)
-    if (app->gpu) {
-        GpuPerfSample gs;
-        if (GpuPerf_TrySample(app->gpu, &gs)) {
-            app->gpuLast = gs;
-
-            if (gs.hasMemoryCounters) {
-                app->gpuDedicatedUsedMB = (double)gs.dedicatedUsageBytes / (1024.0 * 1024.0);
-                app->gpuDedicatedLimitMB = (double)gs.dedicatedLimitBytes / (1024.0 * 1024.0);
-                app->gpuSharedUsedMB = (double)gs.sharedUsageBytes / (1024.0 * 1024.0);
-                app->gpuSharedLimitMB = (double)gs.sharedLimitBytes / (1024.0 * 1024.0);
-            } else {
-                app->gpuDedicatedUsedMB = 0.0;
-                app->gpuDedicatedLimitMB = 0.0;
-                app->gpuSharedUsedMB = 0.0;
-                app->gpuSharedLimitMB = 0.0;
-            }
+    sync_render_disks(app, f);
 
-            RingBuf_Push(&app->gpuDedicatedUsedMBHistory, (float)app->gpuDedicatedUsedMB);
-            RingBuf_Push(&app->gpuSharedUsedMBHistory, (float)app->gpuSharedUsedMB);
-
-            if (gs.hasEngineCounters && app->gpuEnginePctHistory && app->gpuEngineTypeCount == gs.engineTypeCount) {
-                for (uint32_t i = 0; i < app->gpuEngineTypeCount; i++) {
-                    RingBuf_Push(&app->gpuEnginePctHistory[i], gs.engineTypes[i].utilizationPct);
-                }
-            }
-        } else {
-            RingBuf_Push(&app->gpuDedicatedUsedMBHistory, 0.0f);
-            RingBuf_Push(&app->gpuSharedUsedMBHistory, 0.0f);
-            if (app->gpuEnginePctHistory) {
-                for (uint32_t i = 0; i < app->gpuEngineTypeCount; i++) {
-                    RingBuf_Push(&app->gpuEnginePctHistory[i], 0.0f);
-                }
-            }
-        }
-    }
+    SelfStats_End(&app->self, APP_STAGE_POLL_FRAME, &poll);
 }
 
 static void App_Render(App *app)
 {
+    const SelfTimer paint = SelfStats_Begin();
+
     Render_Begin(&app->render);
 
     Render_Clear(&app->render);
@@ -1207,117 +766,193 @@ static void App_Render(App *app)
     int activeTab = 0;
     if (app->tab == APP_TAB_MEMORY) activeTab = 1;
     else if (app->tab == APP_TAB_GPU) activeTab = 2;
-    Render_DrawTabs(&app->render, activeTab);
+    else if (app->tab == APP_TAB_SELF) activeTab = 3;
+    APP_TIMED(app, APP_STAGE_TABS, Render_DrawTabs(&app->render, activeTab));
+
+    const MonitorFrame *m = app->frame;
+    const CollectorSnapshot *snap = &m->snap;
 
-    wchar_t etwStatus[196];
-    EtwKernel_GetStatusText(&app->etw, etwStatus, (uint32_t)(sizeof(etwStatus) / sizeof(etwStatus[0])));
+    // How old the displayed sample is, and what it cost the sampler thread.
+    wchar_t frameStatus[96];
+    app->frameAgeMs = Sampler_FrameAgeSec(m) * 1000.0;
+    swprintf(frameStatus, (uint32_t)(sizeof(frameStatus) / sizeof(frameStatus[0])),
+             L"Sample age %.0f ms | collect %.1f ms", app->frameAgeMs, m->collectMs);
+    Render_DrawStatusText(&app->render, frameStatus);
 
     const uint64_t uptimeMs = (uint64_t)GetTickCount64();
 
-    PdhRates rates = app->pdh.lastRates;
-    if (app->extSensors.hasPowerW) {
+    PdhRates rates = snap->rates;
+    if (snap->providerHasPowerW) {
         rates.hasPowerWatts = true;
-        rates.powerWatts = app->extSensors.powerW;
+        rates.powerWatts = snap->providerPowerW;
     }
 
     wchar_t sensShort[96];
     sensShort[0] = 0;
-    const bool anyProv = app->extSensors.hasCpuTempC || app->extSensors.hasPowerW || app->extSensors.hasFanRpm;
+    const bool anyProv = snap->providerHasTempC || snap->providerHasPowerW || snap->providerHasFanRpm;
     if (anyProv) {
         wchar_t flags[8];
         uint32_t n = 0;
-        if (app->extSensors.hasPowerW) flags[n++] = L'P';
-        if (app->extSensors.hasCpuTempC) flags[n++] = L'T';
-        if (app->extSensors.hasFanRpm) flags[n++] = L'F';
+        if (snap->providerHasPowerW) flags[n++] = L'P';
+        if (snap->providerHasTempC) flags[n++] = L'T';
+        if (snap->providerHasFanRpm) flags[n++] = L'F';
         flags[n] = 0;
         swprintf(sensShort, (uint32_t)(sizeof(sensShort) / sizeof(sensShort[0])), L"Sens: provider(%ls)", flags);
     } else {
         // Show a short, human-readable status so it's obvious whether a provider is running.
-        wcsncpy(sensShort, app->extSensors.status, (uint32_t)(sizeof(sensShort) / sizeof(sensShort[0])) - 1);
+        wcsncpy(sensShort, snap->sensorStatus, (uint32_t)(sizeof(sensShort) / sizeof(sensShort[0])) - 1);
         sensShort[(uint32_t)(sizeof(sensShort) / sizeof(sensShort[0])) - 1] = 0;
     }
 
     if (app->tab == APP_TAB_CPU) {
-        Render_DrawHeader(&app->render, &app->cpuStatic,
-                          app->totalUsage, app->totalUsageMin, app->totalUsageMax,
-                          app->cpuTempC,
-                          &rates, app->freqChangesPerSec, &app->etwRates,
-                          etwStatus,
-                          sensShort,
-                          uptimeMs,
-                          app->throttlePct, app->fanRpm);
-
-        Render_DrawUsageGraph(&app->render, &app->totalUsageHistory);
+        APP_TIMED(app, APP_STAGE_HEADER,
+                  Render_DrawHeader(&app->render, &app->cpuStatic,
+                                    m->totalUsage, m->totalUsageMin, m->totalUsageMax,
+                                    snap->cpuTempC,
+                                    &rates, m->freqChangesPerSec, &snap->etwRates,
+                                    snap->etwStatus,
+                                    sensShort,
+                                    uptimeMs,
+                                    m->throttlePct, snap->fanRpm));
+
+        APP_TIMED(app, APP_STAGE_USAGE_GRAPH,
+                  Render_DrawUsageGraph(&app->render,
+                                        range_series(app, &m->totalUsageHistory, &m->totalUsageRollup)));
+
+        // Watched processes, one graph each. Stop before we starve the process table.
+        const float reserveForProc = 240.0f * app->render.dpiScale;
+        ProcWatch_Copy(&app->watch, &app->watchView);
+        for (uint32_t i = 0; i < app->watchView.count; i++) {
+            if ((app->render.graphBottomY + reserveForProc) > (float)app->render.height) {
+                break;
+            }
+            const ProcWatchSeries *s = &app->watchView.series[i];
+            const ProcRow *pr = app_find_view_row(app, s->pid);
+            wchar_t name[96];
+            name[0] = 0;
+            if (pr && pr->createTime == s->createTime) {
+                ProcView_RowName(pr, &m->procTable.strings, name, _countof(name));
+            }
+            APP_TIMED(app, APP_STAGE_WATCH_GRAPH,
+                      Render_DrawWatchGraph(&app->render, s, name, app->watchView.hz));
+        }
 
         if (app->showCpu0to15) {
-            uint32_t count = app->logicalCount;
+            uint32_t count = m->logicalCount;
             if (count > 16) count = 16;
-            Render_DrawPerCore(&app->render, count, app->coreUsage, app->coreMHz,
-                               app->coreUsageHistory);
+            // Raw range: columns of the per-core matrix; long ranges: each core's rollup peaks.
+            RingBufSpans coreHistory[16];
+            uint32_t historyCap = m->coreUsageHistory.cap;
+            for (uint32_t i = 0; i < count; i++) {
+                const RingBufF *tier = (m->coreUsageRollup && m->logicalCount > i)
+                                           ? range_series(app, NULL, &m->coreUsageRollup[i])
+                                           : NULL;
+                if (tier) {
+                    RingBuf_GetSpans(tier, &coreHistory[i]);
+                    historyCap = tier->cap;
+                } else {
+                    CoreHistory_GetColumn(&m->coreUsageHistory, i, &coreHistory[i]);
+                }
+            }
+            APP_TIMED(app, APP_STAGE_PER_CORE,
+                      Render_DrawPerCore(&app->render, count, m->coreUsage, m->coreMHz,
+                                         coreHistory, historyCap));
         }
     } else if (app->tab == APP_TAB_MEMORY) {
-        Render_DrawMemoryHeader(&app->render,
-                                app->memTotalPhysBytes,
-                                app->memAvailPhysBytes,
-                                app->commitTotalBytes,
-                                app->commitLimitBytes,
-                                app->diskReadMBps,
-                                app->diskWriteMBps);
-
-        Render_DrawPercentGraph(&app->render, &app->memUsedPctHistory, L"RAM used (history)");
-        Render_DrawPercentGraph(&app->render, &app->commitUsedPctHistory, L"Commit used (history)");
-        if (app->renderDisks && app->diskCount > 0) {
-            Render_DrawDisksGraph(&app->render, app->renderDisks, app->diskCount);
+        APP_TIMED(app, APP_STAGE_MEMORY_HEADER,
+                  Render_DrawMemoryHeader(&app->render,
+                                          m->memTotalPhysBytes,
+                                          m->memAvailPhysBytes,
+                                          m->commitTotalBytes,
+                                          m->commitLimitBytes,
+                                          m->diskReadMBps,
+                                          m->diskWriteMBps));
+
+        APP_TIMED(app, APP_STAGE_PERCENT_GRAPH,
+                  Render_DrawPercentGraph(&app->render,
+                                          range_series(app, &m->memUsedPctHistory, &m->memUsedPctRollup),
+                                          L"RAM used (history)"));
+        APP_TIMED(app, APP_STAGE_PERCENT_GRAPH,
+                  Render_DrawPercentGraph(&app->render,
+                                          range_series(app, &m->commitUsedPctHistory, &m->commitUsedPctRollup),
+                                          L"Commit used (history)"));
+        if (app->renderDisks && m->diskCount > 0) {
+            APP_TIMED(app, APP_STAGE_DISKS_GRAPH, Render_DrawDisksGraph(&app->render, app->renderDisks, m->diskCount));
         } else {
-            Render_DrawDiskGraph(&app->render, &app->diskReadMBpsHistory, &app->diskWriteMBpsHistory);
-        }
+            APP_TIMED(app, APP_STAGE_DISKS_GRAPH,
+                      Render_DrawDiskGraph(&app->render,
+                                           range_series(app, &m->diskReadMBpsHistory, &m->diskReadMBpsRollup),
+                                           range_series(app, &m->diskWriteMBpsHistory, &m->diskWriteMBpsRollup),
+                                           fmaxf(range_max(app, &m->diskReadMBpsStats, &m->diskReadMBpsRollup),
+                                                 range_max(app, &m->diskWriteMBpsStats, &m->diskWriteMBpsRollup))));
+        }
+    } else if (app->tab == APP_TAB_SELF) {
+        const SelfStats *sets[2] = {&m->self, &app->self};
+        const wchar_t *names[2] = {L"Sampler thread", L"UI thread"};
+        const float reserveForProc = 240.0f * app->render.dpiScale;
+        APP_TIMED(app, APP_STAGE_SELF_STATS, Render_DrawSelfStats(&app->render, sets, names, 2, reserveForProc));
     } else {
         // GPU tab (best-effort)
-        const wchar_t *nm = (app->gpuLast.hasAdapter) ? app->gpuLast.adapterName : L"";
-        Render_DrawGpuHeader(&app->render,
-                             nm,
-                             app->gpuLast.vendorId,
-                             app->gpuLast.dedicatedVideoMemoryBytes,
-                             app->gpuLast.sharedSystemMemoryBytes,
-                             app->gpuDedicatedUsedMB,
-                             app->gpuDedicatedLimitMB,
-                             app->gpuSharedUsedMB,
-                             app->gpuSharedLimitMB);
-
-        Render_DrawValueGraph(&app->render, &app->gpuDedicatedUsedMBHistory,
-                              L"Dedicated GPU memory used (history)",
-                              (float)app->gpuDedicatedLimitMB);
-        Render_DrawValueGraph(&app->render, &app->gpuSharedUsedMBHistory,
-                              L"Shared GPU memory used (history)",
-                              (float)app->gpuSharedLimitMB);
+        const wchar_t *nm = snap->hasGpuAdapter ? snap->gpuAdapterName : L"";
+        APP_TIMED(app, APP_STAGE_GPU_HEADER,
+                  Render_DrawGpuHeader(&app->render,
+                                       nm,
+                                       snap->gpuVendorId,
+                                       snap->gpuDedicatedVideoMemoryBytes,
+                                       snap->gpuSharedSystemMemoryBytes,
+                                       m->gpuDedicatedUsedMB,
+                                       m->gpuDedicatedLimitMB,
+                                       m->gpuSharedUsedMB,
+                                       m->gpuSharedLimitMB));
+
+        APP_TIMED(app, APP_STAGE_VALUE_GRAPH,
+                  Render_DrawValueGraph(&app->render,
+                                        range_series(app, &m->gpuDedicatedUsedMBHistory, &m->gpuDedicatedUsedMBRollup),
+                                        L"Dedicated GPU memory used (history)",
+                                        (m->gpuDedicatedLimitMB > 0.0)
+                                            ? (float)m->gpuDedicatedLimitMB
+                                            : range_max(app, &m->gpuDedicatedUsedMBStats, &m->gpuDedicatedUsedMBRollup)));
+        APP_TIMED(app, APP_STAGE_VALUE_GRAPH,
+                  Render_DrawValueGraph(&app->render,
+                                        range_series(app, &m->gpuSharedUsedMBHistory, &m->gpuSharedUsedMBRollup),
+                                        L"Shared GPU memory used (history)",
+                                        (m->gpuSharedLimitMB > 0.0)
+                                            ? (float)m->gpuSharedLimitMB
+                                            : range_max(app, &m->gpuSharedUsedMBStats, &m->gpuSharedUsedMBRollup)));
 
         // Per-engine utilization graphs. Stop before we starve the process table.
         const float reserveForProc = 240.0f * app->render.dpiScale;
-        if (app->gpuLast.hasEngineCounters && app->gpuEnginePctHistory && app->gpuEngineTypeCount == app->gpuLast.engineTypeCount) {
-            for (uint32_t i = 0; i < app->gpuEngineTypeCount; i++) {
+        if (snap->hasGpuEngines && m->gpuEnginePctHistory && m->gpuEngineTypeCount == snap->gpuEngineCount) {
+            for (uint32_t i = 0; i < m->gpuEngineTypeCount; i++) {
                 if (app->render.graphBottomY > 0.0f && (app->render.graphBottomY + reserveForProc) > (float)app->render.height) {
                     break;
                 }
 
-                const wchar_t *ename = app->gpuLast.engineTypes[i].name ? app->gpuLast.engineTypes[i].name : L"Engine";
+                const wchar_t *ename = snap->gpuEngineNames[i] ? snap->gpuEngineNames[i] : L"Engine";
                 wchar_t title[128];
                 swprintf(title, (uint32_t)_countof(title), L"GPU %ls (history)", ename);
-                Render_DrawPercentGraph(&app->render, &app->gpuEnginePctHistory[i], title);
+                APP_TIMED(app, APP_STAGE_PERCENT_GRAPH,
+                          Render_DrawPercentGraph(&app->render, &m->gpuEnginePctHistory[i], title));
             }
         }
     }
 
     uint32_t viewCount = 0;
     const ProcRow *viewRows = app_proc_view_rows(app, &viewCount);
-    Render_DrawProcessTable(&app->render,
-                            viewRows,
-                            viewCount,
-                            app->procTable.rowCount,
-                            app->procStacked,
-                            app->procScrollRow,
-                            app->procSelectedPid);
-
-    Render_End(&app->render);
+    APP_TIMED(app, APP_STAGE_PROCESS_TABLE,
+              Render_DrawProcessTable(&app->render,
+                                      viewRows,
+                                      viewCount,
+                                      &m->procTable.strings,
+                                      m->procCount,
+                                      m->procView.settings.stacked,
+                                      app->procScrollRow,
+                                      app->procSelectedPid));
+    update_proc_sort_depth(app); // procVisibleRows is known once the table is laid out
+
+    APP_TIMED(app, APP_STAGE_PRESENT, Render_End(&app->render));
+
+    SelfStats_End(&app->self, APP_STAGE_PAINT, &paint);
 }
 
 // Window procedure for main application window.
@@ -1362,16 +997,30 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
             return 0;
         }
         if (id == IDM_VIEW_STACK_PROCS) {
-            app->procStacked = !app->procStacked;
+            app->procViewSettings.stacked = !app->procViewSettings.stacked;
             HMENU menu = GetMenu(hwnd);
             if (menu) {
-                CheckMenuItem(menu, IDM_VIEW_STACK_PROCS, MF_BYCOMMAND | (app->procStacked ? MF_CHECKED : MF_UNCHECKED));
+                CheckMenuItem(menu, IDM_VIEW_STACK_PROCS, MF_BYCOMMAND | (app->procViewSettings.stacked ? MF_CHECKED : MF_UNCHECKED));
             }
             App_RebuildProcView(app);
             app->procScrollRow = clamp_u32(app->procScrollRow, 0, proc_max_scroll_rows(app));
             InvalidateRect(hwnd, NULL, FALSE);
             return 0;
         }
+        if (id == IDM_VIEW_HISTORY_RAW || id == IDM_VIEW_HISTORY_HOUR || id == IDM_VIEW_HISTORY_DAY) {
+            app->historyRange = (id == IDM_VIEW_HISTORY_HOUR) ? APP_HISTORY_HOUR :
+                                (id == IDM_VIEW_HISTORY_DAY) ? APP_HISTORY_DAY : APP_HISTORY_RAW;
+            HMENU menu = GetMenu(hwnd);
+            if (menu) {
+                CheckMenuRadioItem(menu, IDM_VIEW_HISTORY_RAW, IDM_VIEW_HISTORY_DAY, id, MF_BYCOMMAND);
+            }
+            InvalidateRect(hwnd, NULL, FALSE);
+            return 0;
+        }
+        if (id == IDM_VIEW_COPY_SELF_STATS) {
+            (void)copy_self_stats(app);
+            return 0;
+        }
         if (id == IDM_HELP_METRICS) {
             HelpWindow_Show(hwnd);
             return 0;
@@ -1395,12 +1044,12 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
         if (id == IDM_PROC_END_TASK) {
             const uint32_t pid = app->procSelectedPid;
             if (pid == 0) return 0;
-            if (app->procStacked) {
-                const struct ProcGroupIndex *g = find_group_by_leader_pid(app, pid);
+            if (app->procViewSettings.stacked && app->frame) {
+                const ProcGroupIndex *g = ProcView_FindGroupByLeader(&app->frame->procView, pid);
                 if (g && g->memberCount > 1) {
                     uint32_t closed = 0;
                     for (uint32_t i = 0; i < g->memberCount; i++) {
-                        const uint32_t mpid = app->procGroupMembers[g->memberStart + i];
+                        const uint32_t mpid = app->frame->procView.members[g->memberStart + i];
                         if (try_end_task(mpid)) closed++;
                     }
                     if (closed == 0) {
@@ -1418,17 +1067,12 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
             const uint32_t pid = app->procSelectedPid;
             if (pid == 0) return 0;
 
-            uint32_t viewCount = 0;
-            const ProcRow *viewRows = app_proc_view_rows(app, &viewCount);
-            ProcTable tmp;
-            memset(&tmp, 0, sizeof(tmp));
-            tmp.rows = (ProcRow *)viewRows;
-            tmp.rowCount = viewCount;
-            const ProcRow *pr = find_row_by_pid(&tmp, pid);
-            const wchar_t *name = (pr && pr->name[0]) ? pr->name : L"(unknown)";
-
-            if (app->procStacked) {
-                const struct ProcGroupIndex *g = find_group_by_leader_pid(app, pid);
+            const ProcRow *pr = app_find_view_row(app, pid);
+            const wchar_t *name = pr ? StrPool_Get(app_proc_strings(app), pr->nameId) : L"";
+            if (name[0] == 0) name = L"(unknown)";
+
+            if (app->procViewSettings.stacked && app->frame) {
+                const ProcGroupIndex *g = ProcView_FindGroupByLeader(&app->frame->procView, pid);
                 if (g && g->memberCount > 1) {
                     wchar_t msg[512];
                     swprintf(msg, (uint32_t)(sizeof(msg) / sizeof(msg[0])),
@@ -1439,7 +1083,7 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
                     if (res == IDOK) {
                         uint32_t failed = 0;
                         for (uint32_t i = 0; i < g->memberCount; i++) {
-                            const uint32_t mpid = app->procGroupMembers[g->memberStart + i];
+                            const uint32_t mpid = app->frame->procView.members[g->memberStart + i];
                             if (!try_kill_process(mpid)) failed++;
                         }
                         if (failed > 0) {
@@ -1488,6 +1132,11 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
             (void)copy_selected_process_path(app);
             return 0;
         }
+        if (id == IDM_PROC_WATCH) {
+            (void)ProcWatch_Toggle(&app->watch, app->procSelectedPid);
+            InvalidateRect(hwnd, NULL, FALSE);
+            return 0;
+        }
         if (id == IDM_PROC_OPEN_LOCATION) {
             (void)open_selected_process_location(app);
             return 0;
@@ -1536,21 +1185,21 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
             ProcSortKey key;
             if (proc_hit_test_header(app, x, y, &key)) {
-                if (app->procSortKey == key) {
-                    app->procSortAsc = !app->procSortAsc;
+                if (app->procViewSettings.sortKey == key) {
+                    app->procViewSettings.sortAsc = !app->procViewSettings.sortAsc;
                 } else {
-                    app->procSortKey = key;
+                    app->procViewSettings.sortKey = key;
                     switch (key) {
                     case PROC_SORT_CPU:
                     case PROC_SORT_MEM:
-                        app->procSortAsc = false;
+                        app->procViewSettings.sortAsc = false;
                         break;
                     default:
-                        app->procSortAsc = true;
+                        app->procViewSettings.sortAsc = true;
                         break;
                     }
                 }
-                ProcTable_Sort(&app->procTable, app->procSortKey, app->procSortAsc);
+                App_RebuildProcView(app);
                 app->procScrollRow = clamp_u32(app->procScrollRow, 0, proc_max_scroll_rows(app));
                 InvalidateRect(hwnd, NULL, FALSE);
                 return 0;
@@ -1558,22 +1207,13 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
             uint32_t pid = 0;
             if (proc_hit_test_row_pid(app, x, y, &pid)) {
-                app->procSelectedPid = pid;
+                select_proc(app, pid);
 
                 // In stacked mode, clicking a multi-process group header toggles expansion.
-                if (app->procStacked) {
-                    const struct ProcGroupIndex *g = find_group_by_leader_pid(app, pid);
+                if (app->procViewSettings.stacked && app->frame) {
+                    const ProcGroupIndex *g = ProcView_FindGroupByLeader(&app->frame->procView, pid);
                     if (g && g->memberCount > 1) {
-                        if (app->procHasExpanded &&
-                            wcmp_insensitive_local(app->procExpandedBaseName, g->baseName) == 0) {
-                            app->procHasExpanded = false;
-                            app->procExpandedBaseName[0] = 0;
-                        } else {
-                            app->procHasExpanded = true;
-                            wcsncpy(app->procExpandedBaseName, g->baseName,
-                                    (uint32_t)(sizeof(app->procExpandedBaseName) / sizeof(app->procExpandedBaseName[0])) - 1);
-                            app->procExpandedBaseName[(uint32_t)(sizeof(app->procExpandedBaseName) / sizeof(app->procExpandedBaseName[0])) - 1] = 0;
-                        }
+                        ProcViewSettings_ToggleExpanded(&app->procViewSettings, g->baseName);
                         App_RebuildProcView(app);
                         app->procScrollRow = clamp_u32(app->procScrollRow, 0, proc_max_scroll_rows(app));
                     }
@@ -1594,21 +1234,17 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
             uint32_t pid = 0;
             if (proc_hit_test_row_pid(app, client.x, client.y, &pid)) {
-                app->procSelectedPid = pid;
+                select_proc(app, pid);
                 InvalidateRect(hwnd, NULL, FALSE);
 
-                uint32_t viewCount = 0;
-                const ProcRow *viewRows = app_proc_view_rows(app, &viewCount);
-                ProcTable tmp;
-                memset(&tmp, 0, sizeof(tmp));
-                tmp.rows = (ProcRow *)viewRows;
-                tmp.rowCount = viewCount;
-                const ProcRow *pr = find_row_by_pid(&tmp, pid);
+                const ProcRow *pr = app_find_view_row(app, pid);
                 const bool hasPid = (pid != 0) && (pr != NULL);
-                const bool hasPath = hasPid && pr->path[0];
+                const bool hasPath = hasPid && pr->pathId != STR_POOL_EMPTY;
 
                 const UINT en = MF_STRING | (hasPid ? MF_ENABLED : MF_GRAYED);
                 const UINT enPath = MF_STRING | (hasPath ? MF_ENABLED : MF_GRAYED);
+                // Replayed PIDs belong to the recording machine, not to live processes.
+                const UINT enLive = MF_STRING | ((hasPid && !app->replayMode) ? MF_ENABLED : MF_GRAYED);
 
                 HMENU popup = CreatePopupMenu();
                 AppendMenuW(popup, en, IDM_PROC_COPY, L"Copy");
@@ -1618,8 +1254,10 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
                 AppendMenuW(popup, enPath, IDM_PROC_COPY_PATH, L"Copy Path only");
                 AppendMenuW(popup, enPath, IDM_PROC_OPEN_LOCATION, L"Open file location");
                 AppendMenuW(popup, MF_SEPARATOR, 0, NULL);
-                AppendMenuW(popup, en, IDM_PROC_END_TASK, L"End Task (close window)");
-                AppendMenuW(popup, en, IDM_PROC_KILL, L"Kill Process");
+                AppendMenuW(popup, enLive | (ProcWatch_Contains(&app->watch, pid) ? MF_CHECKED : MF_UNCHECKED),
+                            IDM_PROC_WATCH, L"Watch (high-frequency)");
+                AppendMenuW(popup, enLive, IDM_PROC_END_TASK, L"End Task (close window)");
+                AppendMenuW(popup, enLive, IDM_PROC_KILL, L"Kill Process");
                 TrackPopupMenu(popup, TPM_RIGHTBUTTON | TPM_LEFTALIGN, pt.x, pt.y, 0, hwnd, NULL);
                 DestroyMenu(popup);
                 return 0;
@@ -1642,6 +1280,13 @@ static HMENU build_menu(bool showCpu0to15)
 
     AppendMenuW(view, MF_STRING | (showCpu0to15 ? MF_CHECKED : MF_UNCHECKED), IDM_VIEW_CPU0_15, L"Show CPU0-CPU15");
     AppendMenuW(view, MF_STRING | MF_CHECKED, IDM_VIEW_STACK_PROCS, L"Stack multi-process apps");
+    AppendMenuW(view, MF_SEPARATOR, 0, NULL);
+    AppendMenuW(view, MF_STRING, IDM_VIEW_HISTORY_RAW, L"History: last minute");
+    AppendMenuW(view, MF_STRING, IDM_VIEW_HISTORY_HOUR, L"History: last hour (peaks)");
+    AppendMenuW(view, MF_STRING, IDM_VIEW_HISTORY_DAY, L"History: last 24 hours (peaks)");
+    CheckMenuRadioItem(view, IDM_VIEW_HISTORY_RAW, IDM_VIEW_HISTORY_DAY, IDM_VIEW_HISTORY_RAW, MF_BYCOMMAND);
+    AppendMenuW(view, MF_SEPARATOR, 0, NULL);
+    AppendMenuW(view, MF_STRING, IDM_VIEW_COPY_SELF_STATS, L"Copy self-stats (CSV)");
     AppendMenuW(help, MF_STRING, IDM_HELP_METRICS, L"Metrics Help");
     AppendMenuW(help, MF_STRING, IDM_HELP_MEMORY_DISKS, L"Memory && Disks overview");
     AppendMenuW(help, MF_STRING, IDM_HELP_GPU, L"GPU && Motherboard overview");
@@ -1652,176 +1297,77 @@ static HMENU build_menu(bool showCpu0to15)
     return main;
 }
 
-bool App_Init(App *app, HINSTANCE hInstance)
+bool App_Init(App *app, HINSTANCE hInstance, const AppOptions *opts)
 {
     memset(app, 0, sizeof(*app));
     app->hInstance = hInstance;
 
-    app->qpcFreq = qpc_freq();
-    app->lastSampleQpc = qpc_now();
-    app->lastRenderQpc = app->lastSampleQpc;
+    app->qpcFreq = Qpc_Freq();
+    app->lastRenderQpc = Qpc_Now();
     app->sampleIntervalSec = 0.25;
+    app->exportPath = opts ? opts->exportPath : NULL;
 
     app->showCpu0to15 = true;
     app->tab = APP_TAB_CPU;
-    app->totalUsageMin = FLT_MAX;
-    app->totalUsageMax = -FLT_MAX;
 
-    app->procSortKey = PROC_SORT_CPU;
-    app->procSortAsc = false;
     app->procScrollRow = 0;
     app->procSelectedPid = 0;
-
-    app->procStacked = true;
-    app->procViewRows = NULL;
-    app->procViewCount = 0;
-    app->procViewCap = 0;
-    app->procGroups = NULL;
-    app->procGroupCount = 0;
-    app->procGroupCap = 0;
-    app->procGroupMembers = NULL;
-    app->procGroupMemberCount = 0;
-    app->procGroupMemberCap = 0;
-
-    app->procHasExpanded = false;
-    app->procExpandedBaseName[0] = 0;
+    app->procSelectedCreateTime = 0;
 
     app->providerAutostartAttempted = false;
     app->providerProcess = NULL;
     app->providerPid = 0;
 
-    ProcTable_Init(&app->procTable);
+    SelfStats_Init(&app->self);
+    for (uint32_t i = 0; i < APP_STAGE_COUNT; i++) {
+        (void)SelfStats_AddStage(&app->self, kAppStageNames[i]);
+    }
 
     CpuStatic_Init(&app->cpuStatic);
 
-    app->logicalCount = app->cpuStatic.logicalProcessorCount;
-    if (app->logicalCount == 0) {
-        app->logicalCount = 1;
+    uint32_t logicalCount = app->cpuStatic.logicalProcessorCount;
+    if (logicalCount == 0) {
+        logicalCount = 1;
     }
 
-    app->coreUsage = (float *)calloc(app->logicalCount, sizeof(float));
-    app->coreMHz = (float *)calloc(app->logicalCount, sizeof(float));
-    app->coreMaxMHz = (float *)calloc(app->logicalCount, sizeof(float));
-    app->prevCoreMHz = (float *)calloc(app->logicalCount, sizeof(float));
-    app->coreUsageHistory = (RingBufF *)calloc(app->logicalCount, sizeof(RingBufF));
-    if (!app->coreUsage || !app->coreMHz || !app->coreMaxMHz || !app->prevCoreMHz || !app->coreUsageHistory) {
-        return false;
-    }
-
-    // Keep ~60 seconds of history at 4 Hz sampling
+    // Keep ~60 seconds of history at 4 Hz sampling.
+    // Collectors (PDH, powrprof, ETW, sensors, processes, memory, GPU) are best-effort;
+    // any that fail to open are skipped and CCM still runs.
     const uint32_t histCap = 240;
-    if (!RingBuf_Init(&app->totalUsageHistory, histCap)) {
-        return false;
-    }
+    uint32_t collectorCount = 0;
+    const CollectorOps *const *collectors = Collector_PlatformDefaults(&collectorCount);
 
-    if (!RingBuf_Init(&app->memUsedPctHistory, histCap)) {
-        return false;
-    }
-    if (!RingBuf_Init(&app->commitUsedPctHistory, histCap)) {
-        return false;
-    }
-    if (!RingBuf_Init(&app->diskReadMBpsHistory, histCap)) {
-        return false;
-    }
-    if (!RingBuf_Init(&app->diskWriteMBpsHistory, histCap)) {
-        return false;
-    }
+    ProcViewSettings_Init(&app->procViewSettings);
 
-    if (!RingBuf_Init(&app->gpuDedicatedUsedMBHistory, histCap)) {
-        return false;
-    }
-    if (!RingBuf_Init(&app->gpuSharedUsedMBHistory, histCap)) {
-        return false;
-    }
-
-    for (uint32_t i = 0; i < app->logicalCount; i++) {
-        if (!RingBuf_Init(&app->coreUsageHistory[i], histCap)) {
+    // Sampling runs on its own thread; the UI only reads published frames.
+    if (opts && opts->replayPath) {
+        FILE *f = _wfopen(opts->replayPath, L"rb");
+        if (!f || !Sampler_StartReplay(&app->sampler, histCap, f, opts->replaySpeed)) {
+            MessageBoxW(NULL, L"Cannot open the capture file.", L"CCM - Replay", MB_OK | MB_ICONERROR);
             return false;
         }
-    }
-
-    if (!Pdh_Init(&app->pdh, app->logicalCount)) {
-        // Keep running; PDH might fail on some systems.
-    }
-
-    // GPU (best-effort). If unavailable, CCM still runs.
-    app->gpu = NULL;
-    app->gpuEnginePctHistory = NULL;
-    app->gpuEngineTypeCount = 0;
-    app->gpuDedicatedUsedMB = 0.0;
-    app->gpuDedicatedLimitMB = 0.0;
-    app->gpuSharedUsedMB = 0.0;
-    app->gpuSharedLimitMB = 0.0;
-    ZeroMemory(&app->gpuLast, sizeof(app->gpuLast));
-
-    if (GpuPerf_Init(&app->gpu)) {
-        // Prime once to discover engine type count.
-        GpuPerfSample gs;
-        if (GpuPerf_TrySample(app->gpu, &gs) && gs.hasEngineCounters && gs.engineTypeCount > 0) {
-            app->gpuEngineTypeCount = gs.engineTypeCount;
-            app->gpuEnginePctHistory = (RingBufF *)calloc(app->gpuEngineTypeCount, sizeof(RingBufF));
-            if (app->gpuEnginePctHistory) {
-                bool ok = true;
-                for (uint32_t i = 0; i < app->gpuEngineTypeCount; i++) {
-                    ok = ok && RingBuf_Init(&app->gpuEnginePctHistory[i], histCap);
-                }
-                if (!ok) {
-                    for (uint32_t i = 0; i < app->gpuEngineTypeCount; i++) {
-                        RingBuf_Shutdown(&app->gpuEnginePctHistory[i]);
-                    }
-                    free(app->gpuEnginePctHistory);
-                    app->gpuEnginePctHistory = NULL;
-                    app->gpuEngineTypeCount = 0;
-                }
-            } else {
-                app->gpuEngineTypeCount = 0;
-            }
+        app->replayMode = true;
+        app->providerAutostartAttempted = true; // recorded sensor status is not ours to act on
+    } else {
+        FILE *history = NULL;
+        if (opts && opts->historyPath) {
+            history = _wfopen(opts->historyPath, L"r+b");
+            if (!history) history = _wfopen(opts->historyPath, L"w+b");
         }
-    }
-
-    // Per-disk series (best-effort). Requires PDH init.
-    if (app->pdh.hasPerDisk && app->pdh.diskCount > 0 && app->pdh.diskInstances) {
-        app->diskCount = app->pdh.diskCount;
-        app->disks = (DiskSeries *)calloc(app->diskCount, sizeof(*app->disks));
-        app->renderDisks = (RenderDiskSeries *)calloc(app->diskCount, sizeof(*app->renderDisks));
-
-        bool ok = (app->disks != NULL) && (app->renderDisks != NULL);
-        if (ok) {
-            for (uint32_t i = 0; i < app->diskCount; i++) {
-                const wchar_t *nm = app->pdh.diskInstances[i] ? app->pdh.diskInstances[i] : L"Disk";
-                wcsncpy(app->disks[i].name, nm, (sizeof(app->disks[i].name) / sizeof(app->disks[i].name[0])) - 1);
-                app->disks[i].name[(sizeof(app->disks[i].name) / sizeof(app->disks[i].name[0])) - 1] = 0;
-
-                ok = ok && RingBuf_Init(&app->disks[i].readMBpsHistory, histCap);
-                ok = ok && RingBuf_Init(&app->disks[i].writeMBpsHistory, histCap);
-
-                app->renderDisks[i].name = app->disks[i].name;
-                app->renderDisks[i].readMBpsHistory = &app->disks[i].readMBpsHistory;
-                app->renderDisks[i].writeMBpsHistory = &app->disks[i].writeMBpsHistory;
-                app->renderDisks[i].readMBps = 0.0;
-                app->renderDisks[i].writeMBps = 0.0;
-            }
+        if (!Sampler_Start(&app->sampler, logicalCount, histCap, collectors, collectorCount, app->sampleIntervalSec,
+                           history)) {
+            return false;
         }
-
-        if (!ok) {
-            if (app->disks) {
-                for (uint32_t i = 0; i < app->diskCount; i++) {
-                    RingBuf_Shutdown(&app->disks[i].readMBpsHistory);
-                    RingBuf_Shutdown(&app->disks[i].writeMBpsHistory);
-                }
+        if (opts && opts->recordPath) {
+            FILE *f = _wfopen(opts->recordPath, L"wb");
+            if (f) {
+                Sampler_SetRecording(&app->sampler, f);
             }
-            free(app->disks);
-            free(app->renderDisks);
-            app->disks = NULL;
-            app->renderDisks = NULL;
-            app->diskCount = 0;
         }
+        // Best-effort: without it the Watch menu item does nothing.
+        (void)ProcWatch_Start(&app->watch, ProcWatch_PlatformOps(), PROC_WATCH_DEFAULT_HZ, PROC_WATCH_HISTORY);
     }
-
-    // Best-effort ETW kernel session (scheduler/ISR/DPC)
-    EtwKernel_Start(&app->etw);
-
-    WmiSensors_Init(&app->wmi);
+    App_PollFrame(app);
 
     WNDCLASSEXW wc = {0};
     wc.cbSize = sizeof(wc);
@@ -1837,7 +1383,7 @@ bool App_Init(App *app, HINSTANCE hInstance)
 
     app->hwnd = CreateWindowExW(
         0, kWndClass,
-        L"CCM - Const CPU Monitor",
+        app->replayMode ? L"CCM - Const CPU Monitor (replay)" : L"CCM - Const CPU Monitor",
         WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, 1600, 900,
         NULL, NULL, hInstance, app);
 
@@ -1865,7 +1411,7 @@ int App_Run(App *app)
     MSG msg;
     memset(&msg, 0, sizeof(msg));
 
-    // Simple fixed render loop: pump messages, sample at ~4Hz, render at ~60fps.
+    // Simple fixed render loop: pump messages, pick up sampler frames, render at ~60fps.
     const double targetFrameSec = 1.0 / 60.0;
 
     for (;;) {
@@ -1877,10 +1423,10 @@ int App_Run(App *app)
             DispatchMessageW(&msg);
         }
 
-        App_Sample(app);
+        App_PollFrame(app);
 
-        const int64_t now = qpc_now();
-        const double dt = qpc_seconds(now - app->lastRenderQpc, app->qpcFreq);
+        const int64_t now = Qpc_Now();
+        const double dt = Qpc_Seconds(now - app->lastRenderQpc, app->qpcFreq);
         if (dt >= targetFrameSec) {
             app->lastRenderQpc = now;
             InvalidateRect(app->hwnd, NULL, FALSE);
@@ -1902,70 +1448,24 @@ void App_Shutdown(App *app)
         app->providerProcess = NULL;
     }
 
-    free(app->procViewRows);
-    app->procViewRows = NULL;
-    app->procViewCount = 0;
-    app->procViewCap = 0;
-    free(app->procGroups);
-    app->procGroups = NULL;
-    app->procGroupCount = 0;
-    app->procGroupCap = 0;
-    free(app->procGroupMembers);
-    app->procGroupMembers = NULL;
-    app->procGroupMemberCount = 0;
-    app->procGroupMemberCap = 0;
-
     Render_Shutdown(&app->render);
 
-    Pdh_Shutdown(&app->pdh);
-    WmiSensors_Shutdown(&app->wmi);
-    EtwKernel_Stop(&app->etw);
-
-    ProcTable_Shutdown(&app->procTable);
-
-    CpuStatic_Shutdown(&app->cpuStatic);
-
-    if (app->coreUsageHistory) {
-        for (uint32_t i = 0; i < app->logicalCount; i++) {
-            RingBuf_Shutdown(&app->coreUsageHistory[i]);
+    if (app->exportPath && app->frame) {
+        FILE *f = _wfopen(app->exportPath, L"w");
+        if (f) {
+            (void)MonitorFrame_ExportArchive(Sampler_AcquireFrame(&app->sampler, NULL), f);
+            fclose(f);
         }
     }
-    RingBuf_Shutdown(&app->totalUsageHistory);
-    RingBuf_Shutdown(&app->memUsedPctHistory);
-    RingBuf_Shutdown(&app->commitUsedPctHistory);
-    RingBuf_Shutdown(&app->diskReadMBpsHistory);
-    RingBuf_Shutdown(&app->diskWriteMBpsHistory);
-
-    RingBuf_Shutdown(&app->gpuDedicatedUsedMBHistory);
-    RingBuf_Shutdown(&app->gpuSharedUsedMBHistory);
-    if (app->gpuEnginePctHistory) {
-        for (uint32_t i = 0; i < app->gpuEngineTypeCount; i++) {
-            RingBuf_Shutdown(&app->gpuEnginePctHistory[i]);
-        }
-    }
-    free(app->gpuEnginePctHistory);
-    app->gpuEnginePctHistory = NULL;
-    app->gpuEngineTypeCount = 0;
 
-    if (app->gpu) {
-        GpuPerf_Shutdown(app->gpu);
-        app->gpu = NULL;
-    }
+    ProcWatch_Stop(&app->watch);
+    ProcWatchView_Free(&app->watchView);
+    Sampler_Stop(&app->sampler);
+    app->frame = NULL;
 
-    if (app->disks) {
-        for (uint32_t i = 0; i < app->diskCount; i++) {
-            RingBuf_Shutdown(&app->disks[i].readMBpsHistory);
-            RingBuf_Shutdown(&app->disks[i].writeMBpsHistory);
-        }
-    }
-    free(app->disks);
-    free(app->renderDisks);
+    CpuStatic_Shutdown(&app->cpuStatic);
 
-    free(app->coreUsageHistory);
-    free(app->coreUsage);
-    free(app->coreMHz);
-    free(app->coreMaxMHz);
-    free(app->prevCoreMHz);
+    free(app->renderDisks);
 
     memset(app, 0, sizeof(*app));
 }
@@ -5,29 +5,34 @@
 
 #include "render_d2d.h"
 #include "cpu_static.h"
-#include "pdh_counters.h"
+#include "monitor.h"
+#include "proc_watch.h"
+#include "sampler.h"
 #include "ringbuf.h"
-#include "wmi_sensors.h"
-#include "power_cpu.h"
-#include "etw_kernel.h"
-#include "proc_table.h"
-#include "external_sensors.h"
-#include "gpu_perf.h"
+#include "self_stats.h"
+
+// Time span shown by the history graphs (monitor.h rollup tiers).
+typedef enum AppHistoryRange {
+    APP_HISTORY_RAW = 0, // raw samples (about a minute)
+    APP_HISTORY_HOUR = 1,
+    APP_HISTORY_DAY = 2,
+} AppHistoryRange;
 
 typedef enum AppTab {
     APP_TAB_CPU = 0,
     APP_TAB_MEMORY = 1,
     APP_TAB_GPU = 2,
+    APP_TAB_SELF = 3,
 } AppTab;
 
-typedef struct DiskSeries {
-    wchar_t name[128];
-    RingBufF readMBpsHistory;
-    RingBufF writeMBpsHistory;
-    double readMBps;
-    double writeMBps;
-} DiskSeries;
-
+// Command-line options (parsed in main.c).
+typedef struct AppOptions {
+    const wchar_t *recordPath; // --record FILE: capture raw collector output (record.h)
+    const wchar_t *replayPath; // --replay FILE: run on a capture instead of the collectors
+    double replaySpeed;        // --replay-speed X: 1 = recorded pace, 0 = as fast as possible
+    const wchar_t *exportPath; // --export-history FILE: archive CSV written on exit
+    const wchar_t *historyPath; // --history-file FILE: raw histories kept across restarts
+} AppOptions;
 
 typedef struct App {
     HINSTANCE hInstance;
@@ -37,126 +42,50 @@ typedef struct App {
 
     CpuStaticInfo cpuStatic;
 
-    PdhState pdh;
-    uint32_t logicalCount;
-
-    // History: total usage + per-core usage
-    RingBufF totalUsageHistory;
-    RingBufF *coreUsageHistory;
-
-    // Memory + storage history
-    RingBufF memUsedPctHistory;
-    RingBufF commitUsedPctHistory;
+    // Sampling engine on its own thread; frame = newest published snapshot (UI thread only).
+    Sampler sampler;
+    const MonitorFrame *frame;
+    double frameAgeMs;
 
-    // GPU history (best-effort)
-    RingBufF gpuDedicatedUsedMBHistory;
-    RingBufF gpuSharedUsedMBHistory;
-    RingBufF *gpuEnginePctHistory; // length = gpuEngineTypeCount
-    uint32_t gpuEngineTypeCount;
-
-    DiskSeries *disks;
-    uint32_t diskCount;
+    // Render view of frame->disks
     RenderDiskSeries *renderDisks;
+    uint32_t renderDiskCount;
 
-    // Fallback (if per-disk counters aren't available)
-    RingBufF diskReadMBpsHistory;
-    RingBufF diskWriteMBpsHistory;
-
-    // Latest sampled values
-    float totalUsage;
-    float totalUsageMin;
-    float totalUsageMax;
-    float *coreUsage;
-    float *coreMHz;
-    float *coreMaxMHz;
-
-    float *prevCoreMHz;
-    uint32_t freqChangeCount;
-    double freqChangesPerSec;
-
-    // Memory + storage (latest)
-    uint64_t memTotalPhysBytes;
-    uint64_t memAvailPhysBytes;
-    uint64_t commitTotalBytes;
-    uint64_t commitLimitBytes;
-    float memUsedPct;
-    float commitUsedPct;
-    double diskReadMBps;
-    double diskWriteMBps;
-
-    // GPU (latest, best-effort)
-    GpuPerfState *gpu;
-    GpuPerfSample gpuLast;
-    double gpuDedicatedUsedMB;
-    double gpuDedicatedLimitMB;
-    double gpuSharedUsedMB;
-    double gpuSharedLimitMB;
-
-    // System rates
     double qpcFreq;
-    int64_t lastSampleQpc;
     int64_t lastRenderQpc;
 
-    // Optional sensors
-    WmiSensors wmi;
-    float cpuTempC;
-    float fanRpm;
-    float throttlePct;
-
-    // Optional external sensor provider (named pipe).
-    ExternalSensorsSample extSensors;
+    // UI-thread self-instrumentation (paint and each Render_Draw* call; see AppStage).
+    SelfStats self;
 
     // Optional: auto-start a bundled provider executable (sample).
     bool providerAutostartAttempted;
     HANDLE providerProcess;
     DWORD providerPid;
 
-    // Optional ETW kernel session
-    EtwKernel etw;
-    EtwRates etwRates;
-
-    // Process table (top by CPU)
-    ProcTable procTable;
-
-    // Process table view (optional stacked/groups view)
-    bool procStacked;
-    ProcRow *procViewRows;
-    uint32_t procViewCount;
-    uint32_t procViewCap;
-
-    struct ProcGroupIndex {
-        wchar_t baseName[64];
-        uint32_t leaderPid;
-        uint32_t memberStart;
-        uint32_t memberCount;
-    } *procGroups;
-    uint32_t procGroupCount;
-    uint32_t procGroupCap;
-    uint32_t *procGroupMembers;
-    uint32_t procGroupMemberCount;
-    uint32_t procGroupMemberCap;
-
-    // Stacked view: one expanded group at a time (accordion).
-    bool procHasExpanded;
-    wchar_t procExpandedBaseName[64];
-
     // Process table UI state
-    ProcSortKey procSortKey;
-    bool procSortAsc;
+    ProcViewSettings procViewSettings;
     uint32_t procScrollRow;
     uint32_t procSelectedPid;
+    uint64_t procSelectedCreateTime; // catches the PID being reused while selected
+
+    // High-frequency watch list (pinned from the process menu) and the UI's copy of it.
+    ProcWatch watch;
+    ProcWatchView watchView;
 
     // Config
-    double sampleIntervalSec; // e.g. 0.25
+    double sampleIntervalSec; // base period for collectors without their own (e.g. 0.25)
+    bool replayMode;          // frames come from a capture (--replay), not the OS
+    const wchar_t *exportPath; // --export-history (points into the command line)
 
     // UI toggles
     bool showCpu0to15;
+    AppHistoryRange historyRange;
 
     // UI state
     AppTab tab;
 } App;
 
-bool App_Init(App *app, HINSTANCE hInstance);
+bool App_Init(App *app, HINSTANCE hInstance, const AppOptions *opts);
 void App_Show(App *app, int nCmdShow);
 int App_Run(App *app);
 void App_Shutdown(App *app);
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#include "etw_kernel.h"
+#include "proc_table.h"
+
+// Collector layer.
+//
+// Every OS data source (PDH, powrprof, ETW, sensors, Toolhelp, /proc, ...) implements
+// CollectorOps and writes its readings into its own section of a CollectorSnapshot.
+// The snapshot is plain data; everything derived from it (histories, min/max,
+// throttling, grouping, sorting) lives in the portable Monitor (monitor.h), so the
+// sampling engine builds and runs headless on non-Windows hosts.
+
+// System-wide rates. Historically filled from PDH; the Linux backend fills the same
+// fields from /proc/stat.
+typedef struct PdhRates {
+    double contextSwitchesPerSec;
+    double interruptsPerSec;
+    double dpcsPerSec;
+
+    double processorQueueLength;
+
+    // Best-effort disk throughput (legacy: _Total)
+    double diskReadBytesPerSec;
+    double diskWriteBytesPerSec;
+    bool hasDisk;
+
+    // Optional, requires a power meter provider.
+    double powerWatts;
+    bool hasPowerWatts;
+} PdhRates;
+
+typedef struct CollectorSnapshot {
+    // CPU. Arrays are owned by the Monitor (length = logicalCount); collectors write into them.
+    uint32_t logicalCount;
+    bool hasCpu;
+    float totalCpu;  // 0..100
+    float *coreCpu;  // 0..100
+    float *coreMHz;
+    float *coreMaxMHz;
+
+    PdhRates rates;
+
+    // Memory
+    bool hasMemory;
+    uint64_t memTotalPhysBytes;
+    uint64_t memAvailPhysBytes;
+
+    bool hasCommit;
+    uint64_t commitTotalBytes;
+    uint64_t commitLimitBytes;
+
+    // Per-disk throughput. Names are published by init and stay valid until shutdown;
+    // the value arrays are owned by the collector.
+    bool hasPerDisk;
+    uint32_t diskCount;
+    const wchar_t *const *diskNames;
+    const double *diskReadBytesPerSec;
+    const double *diskWriteBytesPerSec;
+
+    // GPU (best-effort). Presence and engine count/names are published by init.
+    bool gpuPresent;
+    bool hasGpu;
+    bool hasGpuAdapter;
+    wchar_t gpuAdapterName[128];
+    uint32_t gpuVendorId;
+    uint64_t gpuDedicatedVideoMemoryBytes;
+    uint64_t gpuSharedSystemMemoryBytes;
+    bool hasGpuMemory;
+    uint64_t gpuDedicatedUsageBytes;
+    uint64_t gpuDedicatedLimitBytes;
+    uint64_t gpuSharedUsageBytes;
+    uint64_t gpuSharedLimitBytes;
+    bool hasGpuEngines;
+    uint32_t gpuEngineCount;
+    const wchar_t *const *gpuEngineNames;
+    const float *gpuEnginePct;
+
+    // Sensors (best-effort; negative = N/A)
+    bool hasSensors;
+    float cpuTempC;
+    float fanRpm;
+    bool providerHasTempC;
+    bool providerHasFanRpm;
+    bool providerHasPowerW;
+    double providerPowerW;
+    wchar_t sensorStatus[160];
+
+    // ETW kernel rates
+    bool hasEtw;
+    EtwRates etwRates;
+    wchar_t etwStatus[196];
+
+    // Processes: the collector refreshes the Monitor's table in place.
+    ProcTable *procs;
+    bool hasProcs;
+} CollectorSnapshot;
+
+// Parts of CollectorSnapshot a collector refreshes. After a scheduler tick the Monitor
+// re-derives only the sections that were actually sampled, so a 1 Hz process walk
+// does not push duplicate points into the 4 Hz CPU histories (and vice versa).
+typedef enum CollectorSection {
+    COLLECTOR_SECTION_CPU = 1u << 0,     // totalCpu, coreCpu, CPU rates
+    COLLECTOR_SECTION_CPU_FREQ = 1u << 1, // coreMHz, coreMaxMHz
+    COLLECTOR_SECTION_MEMORY = 1u << 2,
+    COLLECTOR_SECTION_DISK = 1u << 3,
+    COLLECTOR_SECTION_GPU = 1u << 4,
+    COLLECTOR_SECTION_SENSORS = 1u << 5,
+    COLLECTOR_SECTION_ETW = 1u << 6,
+    COLLECTOR_SECTION_PROCS = 1u << 7,
+
+    COLLECTOR_SECTION_ALL = 0xFFu,
+} CollectorSection;
+
+typedef struct CollectorOps {
+    const wchar_t *name;
+
+    // Opens the source. May publish static shape (disk/engine names) into snap.
+    // Returning false disables the collector; the Monitor keeps running without it.
+    bool (*init)(void **outState, CollectorSnapshot *snap);
+
+    // Refreshes this collector's section of snap. dt = seconds since its previous sample.
+    bool (*sample)(void *state, double dt, CollectorSnapshot *snap);
+
+    void (*shutdown)(void *state);
+
+    uint32_t sections; // CollectorSection mask written by sample()
+
+    // Default schedule: sample every periodSec (0 = the Monitor's base period),
+    // first due phaseSec after start. Distinct phases keep slow sources (process
+    // walk, WMI) from landing on the same tick as the fast CPU counters.
+    double periodSec;
+    double phaseSec;
+} CollectorOps;
+
+// Default collectors for the host platform, in sampling order.
+// Implemented by collector_win.c / linux/collector_linux.c.
+const CollectorOps *const *Collector_PlatformDefaults(uint32_t *outCount);
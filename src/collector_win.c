@@ -0,0 +1,399 @@
+#include "collector.h"
+
+#include <windows.h>
+#include <psapi.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "external_sensors.h"
+#include "gpu_perf.h"
+#include "pdh_counters.h"
+#include "power_cpu.h"
+#include "wmi_sensors.h"
+
+// Windows collectors: thin adapters from the existing PDH/powrprof/ETW/WMI/DXGI
+// modules to CollectorSnapshot. Order matters: PDH fills CPU usage (and a fallback
+// MHz), powrprof then overrides MHz when available.
+
+// ---------------------------------------------------------------------------
+// PDH: CPU usage, system rates, disk throughput
+
+static bool pdh_init(void **outState, CollectorSnapshot *snap)
+{
+    PdhState *s = (PdhState *)calloc(1, sizeof(PdhState));
+    if (!s) return false;
+
+    if (!Pdh_Init(s, snap->logicalCount)) {
+        Pdh_Shutdown(s);
+        free(s);
+        return false;
+    }
+
+    if (s->hasPerDisk && s->diskCount > 0 && s->diskInstances) {
+        snap->diskCount = s->diskCount;
+        snap->diskNames = s->diskInstances;
+        snap->diskReadBytesPerSec = s->lastDiskReadBytesPerSec;
+        snap->diskWriteBytesPerSec = s->lastDiskWriteBytesPerSec;
+    }
+
+    *outState = s;
+    return true;
+}
+
+static bool pdh_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)dt;
+    PdhState *s = (PdhState *)state;
+
+    PdhSample sample = {0};
+    snap->hasCpu = Pdh_TrySample(s, &sample);
+    if (snap->hasCpu) {
+        snap->totalCpu = sample.totalCpu;
+        for (uint32_t i = 0; i < snap->logicalCount; i++) {
+            snap->coreCpu[i] = sample.coreCpu[i];
+            snap->coreMHz[i] = sample.coreMHz ? sample.coreMHz[i] : 0.0f;
+        }
+    }
+
+    snap->rates = s->lastRates;
+    snap->hasPerDisk = s->hasPerDisk;
+    return snap->hasCpu;
+}
+
+static void pdh_shutdown(void *state)
+{
+    PdhState *s = (PdhState *)state;
+    Pdh_Shutdown(s);
+    free(s);
+}
+
+static const CollectorOps kPdhCollector = {
+    L"pdh", pdh_init, pdh_sample, pdh_shutdown,
+    COLLECTOR_SECTION_CPU | COLLECTOR_SECTION_CPU_FREQ | COLLECTOR_SECTION_DISK,
+    0.25, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+// powrprof: per-core current/max MHz
+
+static bool power_init(void **outState, CollectorSnapshot *snap)
+{
+    (void)snap;
+    *outState = NULL;
+    return true;
+}
+
+static bool power_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)state;
+    (void)dt;
+
+    // Prefer powrprof per-core frequency when available.
+    PowerCpuSample ps;
+    ps.currentMHz = snap->coreMHz;
+    ps.maxMHz = snap->coreMaxMHz;
+    return PowerCpu_TrySample(snap->logicalCount, &ps);
+}
+
+static const CollectorOps kPowerCollector = {
+    L"powrprof", power_init, power_sample, NULL,
+    COLLECTOR_SECTION_CPU_FREQ,
+    0.25, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+// ETW kernel session: scheduler/ISR/DPC rates
+
+static bool etw_init(void **outState, CollectorSnapshot *snap)
+{
+    (void)snap;
+    EtwKernel *k = (EtwKernel *)calloc(1, sizeof(EtwKernel));
+    if (!k) return false;
+
+    // Best-effort: a failed start still reports its status text.
+    EtwKernel_Start(k);
+
+    *outState = k;
+    return true;
+}
+
+static bool etw_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    EtwKernel *k = (EtwKernel *)state;
+    EtwKernel_ComputeRates(k, dt, &snap->etwRates);
+    EtwKernel_GetStatusText(k, snap->etwStatus, (uint32_t)_countof(snap->etwStatus));
+    snap->hasEtw = k->ok;
+    return k->ok;
+}
+
+static void etw_shutdown(void *state)
+{
+    EtwKernel *k = (EtwKernel *)state;
+    EtwKernel_Stop(k);
+    free(k);
+}
+
+static const CollectorOps kEtwCollector = {
+    L"etw", etw_init, etw_sample, etw_shutdown,
+    COLLECTOR_SECTION_ETW,
+    1.0, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+// Sensors: external provider pipe, falling back to WMI
+
+typedef struct SensorsState {
+    WmiSensors wmi;
+    ExternalSensorsSample ext;
+} SensorsState;
+
+static bool sensors_init(void **outState, CollectorSnapshot *snap)
+{
+    (void)snap;
+    SensorsState *s = (SensorsState *)calloc(1, sizeof(SensorsState));
+    if (!s) return false;
+
+    WmiSensors_Init(&s->wmi);
+
+    *outState = s;
+    return true;
+}
+
+static bool sensors_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)dt;
+    SensorsState *s = (SensorsState *)state;
+
+    ExternalSensors_TrySample(&s->ext);
+
+    float tempC = 0.0f;
+    if (s->ext.hasCpuTempC) {
+        snap->cpuTempC = s->ext.cpuTempC;
+    } else if (WmiSensors_TryReadCpuTempC(&s->wmi, &tempC)) {
+        snap->cpuTempC = tempC;
+    } else {
+        snap->cpuTempC = -1.0f;
+    }
+
+    float rpm = 0.0f;
+    if (s->ext.hasFanRpm) {
+        snap->fanRpm = s->ext.fanRpm;
+    } else if (WmiSensors_TryReadFanRpm(&s->wmi, &rpm)) {
+        snap->fanRpm = rpm;
+    } else {
+        snap->fanRpm = -1.0f;
+    }
+
+    snap->providerHasTempC = s->ext.hasCpuTempC;
+    snap->providerHasFanRpm = s->ext.hasFanRpm;
+    snap->providerHasPowerW = s->ext.hasPowerW;
+    snap->providerPowerW = s->ext.powerW;
+    wcsncpy(snap->sensorStatus, s->ext.status, _countof(snap->sensorStatus) - 1);
+    snap->sensorStatus[_countof(snap->sensorStatus) - 1] = 0;
+
+    snap->hasSensors = (snap->cpuTempC >= 0.0f) || (snap->fanRpm >= 0.0f) || s->ext.hasPowerW;
+    return snap->hasSensors;
+}
+
+static void sensors_shutdown(void *state)
+{
+    SensorsState *s = (SensorsState *)state;
+    WmiSensors_Shutdown(&s->wmi);
+    free(s);
+}
+
+static const CollectorOps kSensorsCollector = {
+    L"sensors", sensors_init, sensors_sample, sensors_shutdown,
+    COLLECTOR_SECTION_SENSORS,
+    2.0, 0.375,
+};
+
+// ---------------------------------------------------------------------------
+// Process table (Toolhelp + PSAPI + IP Helper)
+
+static bool procs_init(void **outState, CollectorSnapshot *snap)
+{
+    *outState = NULL;
+    return snap->procs != NULL;
+}
+
+static bool procs_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)state;
+    (void)dt;
+    ProcTable_Sample(snap->procs);
+    snap->hasProcs = true;
+    return true;
+}
+
+static const CollectorOps kProcsCollector = {
+    L"procs", procs_init, procs_sample, NULL,
+    COLLECTOR_SECTION_PROCS,
+    1.0, 0.125,
+};
+
+// ---------------------------------------------------------------------------
+// Memory + commit
+
+static bool memory_init(void **outState, CollectorSnapshot *snap)
+{
+    (void)snap;
+    *outState = NULL;
+    return true;
+}
+
+static bool memory_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)state;
+    (void)dt;
+
+    MEMORYSTATUSEX ms;
+    ZeroMemory(&ms, sizeof(ms));
+    ms.dwLength = sizeof(ms);
+    snap->hasMemory = GlobalMemoryStatusEx(&ms) ? true : false;
+    if (snap->hasMemory) {
+        snap->memTotalPhysBytes = (uint64_t)ms.ullTotalPhys;
+        snap->memAvailPhysBytes = (uint64_t)ms.ullAvailPhys;
+    }
+
+    PERFORMANCE_INFORMATION pi;
+    ZeroMemory(&pi, sizeof(pi));
+    pi.cb = sizeof(pi);
+    snap->hasCommit = GetPerformanceInfo(&pi, sizeof(pi)) ? true : false;
+    if (snap->hasCommit) {
+        const uint64_t pageSize = (uint64_t)pi.PageSize;
+        snap->commitTotalBytes = (uint64_t)pi.CommitTotal * pageSize;
+        snap->commitLimitBytes = (uint64_t)pi.CommitLimit * pageSize;
+    }
+
+    return snap->hasMemory || snap->hasCommit;
+}
+
+static const CollectorOps kMemoryCollector = {
+    L"memory", memory_init, memory_sample, NULL,
+    COLLECTOR_SECTION_MEMORY,
+    0.5, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+// GPU (DXGI + PDH GPU Engine/Adapter Memory)
+
+typedef struct GpuState {
+    GpuPerfState *gpu;
+    const wchar_t **engineNames; // length = engineCount
+    float *enginePct;            // length = engineCount
+    uint32_t engineCount;
+} GpuState;
+
+static void gpu_publish(GpuState *g, const GpuPerfSample *gs, CollectorSnapshot *snap)
+{
+    snap->hasGpuAdapter = gs->hasAdapter;
+    if (gs->hasAdapter) {
+        wcsncpy(snap->gpuAdapterName, gs->adapterName, _countof(snap->gpuAdapterName) - 1);
+        snap->gpuAdapterName[_countof(snap->gpuAdapterName) - 1] = 0;
+    } else {
+        snap->gpuAdapterName[0] = 0;
+    }
+    snap->gpuVendorId = gs->vendorId;
+    snap->gpuDedicatedVideoMemoryBytes = gs->dedicatedVideoMemoryBytes;
+    snap->gpuSharedSystemMemoryBytes = gs->sharedSystemMemoryBytes;
+
+    snap->hasGpuMemory = gs->hasMemoryCounters;
+    snap->gpuDedicatedUsageBytes = gs->dedicatedUsageBytes;
+    snap->gpuDedicatedLimitBytes = gs->dedicatedLimitBytes;
+    snap->gpuSharedUsageBytes = gs->sharedUsageBytes;
+    snap->gpuSharedLimitBytes = gs->sharedLimitBytes;
+
+    snap->hasGpuEngines = gs->hasEngineCounters && g->engineNames && gs->engineTypeCount == g->engineCount;
+    if (snap->hasGpuEngines) {
+        for (uint32_t i = 0; i < g->engineCount; i++) {
+            g->engineNames[i] = gs->engineTypes[i].name ? gs->engineTypes[i].name : L"Engine";
+            g->enginePct[i] = gs->engineTypes[i].utilizationPct;
+        }
+    }
+}
+
+static bool gpu_init(void **outState, CollectorSnapshot *snap)
+{
+    GpuState *g = (GpuState *)calloc(1, sizeof(GpuState));
+    if (!g) return false;
+
+    if (GpuPerf_Init(&g->gpu)) {
+        // Prime once to discover engine type count.
+        GpuPerfSample gs;
+        if (GpuPerf_TrySample(g->gpu, &gs) && gs.hasEngineCounters && gs.engineTypeCount > 0) {
+            g->engineNames = (const wchar_t **)calloc(gs.engineTypeCount, sizeof(*g->engineNames));
+            g->enginePct = (float *)calloc(gs.engineTypeCount, sizeof(float));
+            if (g->engineNames && g->enginePct) {
+                g->engineCount = gs.engineTypeCount;
+            } else {
+                free((void *)g->engineNames);
+                free(g->enginePct);
+                g->engineNames = NULL;
+                g->enginePct = NULL;
+            }
+            gpu_publish(g, &gs, snap);
+        }
+    }
+
+    if (!g->gpu) {
+        free(g);
+        return false;
+    }
+
+    snap->gpuPresent = true;
+    snap->gpuEngineCount = g->engineCount;
+    snap->gpuEngineNames = g->engineNames;
+    snap->gpuEnginePct = g->enginePct;
+
+    *outState = g;
+    return true;
+}
+
+static bool gpu_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)dt;
+    GpuState *g = (GpuState *)state;
+
+    GpuPerfSample gs;
+    snap->hasGpu = GpuPerf_TrySample(g->gpu, &gs);
+    if (snap->hasGpu) {
+        gpu_publish(g, &gs, snap);
+    }
+    return snap->hasGpu;
+}
+
+static void gpu_shutdown(void *state)
+{
+    GpuState *g = (GpuState *)state;
+    GpuPerf_Shutdown(g->gpu);
+    free((void *)g->engineNames);
+    free(g->enginePct);
+    free(g);
+}
+
+static const CollectorOps kGpuCollector = {
+    L"gpu", gpu_init, gpu_sample, gpu_shutdown,
+    COLLECTOR_SECTION_GPU,
+    0.5, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+
+static const CollectorOps *const kDefaultCollectors[] = {
+    &kPdhCollector,
+    &kPowerCollector,
+    &kEtwCollector,
+    &kSensorsCollector,
+    &kProcsCollector,
+    &kMemoryCollector,
+    &kGpuCollector,
+};
+
+const CollectorOps *const *Collector_PlatformDefaults(uint32_t *outCount)
+{
+    if (outCount) *outCount = (uint32_t)_countof(kDefaultCollectors);
+    return kDefaultCollectors;
+}
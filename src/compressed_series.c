@@ -0,0 +1,390 @@
+#include "compressed_series.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "self_stats.h"
+#include "sys_thread.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Worst-case sample: 4 + 32 timestamp bits, 2 + 5 + 5 + 32 value bits.
+#define CSERIES_MAX_SAMPLE_BITS 80u
+#define CSERIES_CHUNK_BITS (CSERIES_CHUNK_BYTES * 8u)
+
+static volatile uint32_t g_nextId;
+
+static uint32_t clz32(uint32_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanReverse(&idx, v);
+    return 31u - (uint32_t)idx;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_clz(v);
+#else
+    uint32_t n = 0;
+    while (!(v & 0x80000000u)) {
+        v <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static uint32_t ctz32(uint32_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward(&idx, v);
+    return (uint32_t)idx;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctz(v);
+#else
+    uint32_t n = 0;
+    while (!(v & 1u)) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static uint32_t float_bits(float v)
+{
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    return u;
+}
+
+static float bits_float(uint32_t u)
+{
+    float v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+
+// MSB-first bit stream within one chunk; bytes are cleared as they are first touched.
+static void put_bits(uint8_t *buf, uint32_t *pos, uint64_t v, uint32_t n)
+{
+    while (n > 0) {
+        const uint32_t used = *pos & 7u;
+        const uint32_t room = 8u - used;
+        const uint32_t take = (n < room) ? n : room;
+        const uint32_t part = (uint32_t)(v >> (n - take)) & ((1u << take) - 1u);
+        uint8_t *b = &buf[*pos >> 3];
+        if (used == 0) *b = 0;
+        *b |= (uint8_t)(part << (room - take));
+        *pos += take;
+        n -= take;
+    }
+}
+
+static uint64_t get_bits(const uint8_t *buf, uint32_t *pos, uint32_t n)
+{
+    uint64_t v = 0;
+    while (n > 0) {
+        const uint32_t used = *pos & 7u;
+        const uint32_t room = 8u - used;
+        const uint32_t take = (n < room) ? n : room;
+        const uint32_t part = ((uint32_t)buf[*pos >> 3] >> (room - take)) & ((1u << take) - 1u);
+        v = (v << take) | part;
+        *pos += take;
+        n -= take;
+    }
+    return v;
+}
+
+static int64_t sign_extend(uint64_t v, uint32_t n)
+{
+    const uint64_t m = 1ull << (n - 1u);
+    return (int64_t)((v ^ m) - m);
+}
+
+static uint32_t slot_of(const CompressedSeries *s, uint32_t age) // age 0 = newest chunk
+{
+    return (s->head - 1u - age) & (s->chunkCap - 1u);
+}
+
+static bool alloc_ring(CompressedSeries *s, uint32_t chunkCap)
+{
+    s->data = (uint8_t *)malloc((size_t)chunkCap * CSERIES_CHUNK_BYTES);
+    s->chunks = (CSeriesChunk *)calloc(chunkCap, sizeof(CSeriesChunk));
+    if (!s->data || !s->chunks) {
+        free(s->data);
+        free(s->chunks);
+        s->data = NULL;
+        s->chunks = NULL;
+        return false;
+    }
+    SelfStats_NoteAlloc();
+    s->chunkCap = chunkCap;
+    return true;
+}
+
+bool CompressedSeries_Init(CompressedSeries *s, int64_t retention, float quantum, uint32_t initialChunks)
+{
+    memset(s, 0, sizeof(*s));
+    uint32_t cap = 1;
+    while (cap < initialChunks && cap < CSERIES_MAX_CHUNKS) {
+        cap <<= 1;
+    }
+    if (!alloc_ring(s, cap)) {
+        return false;
+    }
+    s->retention = retention;
+    s->quantum = quantum;
+    s->id = Atomic_AddU32(&g_nextId, 1u);
+    if (s->id == 0) {
+        s->id = Atomic_AddU32(&g_nextId, 1u);
+    }
+    return true;
+}
+
+void CompressedSeries_Shutdown(CompressedSeries *s)
+{
+    if (!s) return;
+    free(s->data);
+    free(s->chunks);
+    memset(s, 0, sizeof(*s));
+}
+
+// Doubles the ring, moving the live chunks to slots 0..count-1 (oldest first).
+static bool grow(CompressedSeries *s)
+{
+    CompressedSeries bigger;
+    memset(&bigger, 0, sizeof(bigger));
+    if (s->chunkCap >= CSERIES_MAX_CHUNKS || !alloc_ring(&bigger, s->chunkCap * 2u)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < s->chunkCount; i++) {
+        const uint32_t from = slot_of(s, s->chunkCount - 1u - i);
+        bigger.chunks[i] = s->chunks[from];
+        memcpy(bigger.data + (size_t)i * CSERIES_CHUNK_BYTES, s->data + (size_t)from * CSERIES_CHUNK_BYTES,
+               (s->chunks[from].bits + 7u) / 8u);
+    }
+    free(s->data);
+    free(s->chunks);
+    s->data = bigger.data;
+    s->chunks = bigger.chunks;
+    s->chunkCap = bigger.chunkCap;
+    s->head = s->chunkCount;
+    s->id = Atomic_AddU32(&g_nextId, 1u); // slots moved: copies must start over
+    return true;
+}
+
+static void open_chunk(CompressedSeries *s, uint32_t bits, int64_t t)
+{
+    // Drop chunks that ended before the retention span, then make room.
+    while (s->chunkCount > 0 && s->chunks[slot_of(s, s->chunkCount - 1u)].tLast < t - s->retention) {
+        s->chunkCount--;
+    }
+    if (s->chunkCount == s->chunkCap && !grow(s)) {
+        s->chunkCount--; // at the size limit: overwrite the oldest
+    }
+
+    const uint32_t slot = s->head;
+    s->head = (s->head + 1u) & (s->chunkCap - 1u);
+    s->chunkCount++;
+    s->chunksOpened++;
+
+    CSeriesChunk *c = &s->chunks[slot];
+    c->t0 = t;
+    c->tLast = t;
+    c->count = 1;
+    c->bits = 0;
+    put_bits(s->data + (size_t)slot * CSERIES_CHUNK_BYTES, &c->bits, bits, 32u);
+
+    s->prevT = t;
+    s->prevDelta = 0;
+    s->prevValue = bits;
+    s->prevLeading = 32u;
+    s->prevTrailing = 0;
+}
+
+void CompressedSeries_Push(CompressedSeries *s, float v, int64_t t)
+{
+    if (!s || !s->data) return;
+
+    if (s->quantum > 0.0f) {
+        v = roundf(v / s->quantum) * s->quantum;
+    }
+    const uint32_t bits = float_bits(v);
+    s->pushes++;
+
+    const int64_t delta = t - s->prevT;
+    const int64_t dod = delta - s->prevDelta;
+    CSeriesChunk *c = (s->chunkCount > 0) ? &s->chunks[slot_of(s, 0)] : NULL;
+    if (!c || c->bits + CSERIES_MAX_SAMPLE_BITS > CSERIES_CHUNK_BITS || delta < 0 ||
+        dod < INT32_MIN || dod > INT32_MAX) {
+        open_chunk(s, bits, t);
+        return;
+    }
+
+    uint8_t *buf = s->data + (size_t)slot_of(s, 0) * CSERIES_CHUNK_BYTES;
+    if (dod == 0) {
+        put_bits(buf, &c->bits, 0x0u, 1u);
+    } else if (dod >= -64 && dod <= 63) {
+        put_bits(buf, &c->bits, 0x2u, 2u);
+        put_bits(buf, &c->bits, (uint64_t)dod, 7u);
+    } else if (dod >= -256 && dod <= 255) {
+        put_bits(buf, &c->bits, 0x6u, 3u);
+        put_bits(buf, &c->bits, (uint64_t)dod, 9u);
+    } else if (dod >= -2048 && dod <= 2047) {
+        put_bits(buf, &c->bits, 0xEu, 4u);
+        put_bits(buf, &c->bits, (uint64_t)dod, 12u);
+    } else {
+        put_bits(buf, &c->bits, 0xFu, 4u);
+        put_bits(buf, &c->bits, (uint64_t)dod, 32u);
+    }
+
+    const uint32_t x = bits ^ s->prevValue;
+    if (x == 0) {
+        put_bits(buf, &c->bits, 0x0u, 1u);
+    } else {
+        const uint32_t lead = clz32(x);
+        const uint32_t trail = ctz32(x);
+        if (s->prevLeading < 32u && lead >= s->prevLeading && trail >= s->prevTrailing) {
+            put_bits(buf, &c->bits, 0x2u, 2u);
+            put_bits(buf, &c->bits, x >> s->prevTrailing, 32u - s->prevLeading - s->prevTrailing);
+        } else {
+            const uint32_t sig = 32u - lead - trail;
+            put_bits(buf, &c->bits, 0x3u, 2u);
+            put_bits(buf, &c->bits, lead, 5u);
+            put_bits(buf, &c->bits, sig - 1u, 5u);
+            put_bits(buf, &c->bits, x >> trail, sig);
+            s->prevLeading = lead;
+            s->prevTrailing = trail;
+        }
+    }
+
+    c->count++;
+    c->tLast = t;
+    s->prevT = t;
+    s->prevDelta = delta;
+    s->prevValue = bits;
+}
+
+static void copy_chunk(CompressedSeries *dst, const CompressedSeries *src, uint32_t slot)
+{
+    dst->chunks[slot] = src->chunks[slot];
+    memcpy(dst->data + (size_t)slot * CSERIES_CHUNK_BYTES, src->data + (size_t)slot * CSERIES_CHUNK_BYTES,
+           (src->chunks[slot].bits + 7u) / 8u);
+}
+
+bool CompressedSeries_CopyFrom(CompressedSeries *dst, const CompressedSeries *src)
+{
+    if (!dst || !src || !src->data) return false;
+
+    // dst's newest chunk may have grown since; everything opened after it is new.
+    const bool incremental = dst->data && dst->id == src->id && dst->chunkCap == src->chunkCap &&
+                             dst->chunksOpened > 0 && dst->chunksOpened <= src->chunksOpened &&
+                             src->chunksOpened - dst->chunksOpened < src->chunkCount;
+    if (incremental) {
+        const uint32_t fresh = (uint32_t)(src->chunksOpened - dst->chunksOpened) + 1u;
+        for (uint32_t age = 0; age < fresh; age++) {
+            copy_chunk(dst, src, slot_of(src, age));
+        }
+    } else {
+        if (dst->chunkCap != src->chunkCap || !dst->data) {
+            CompressedSeries_Shutdown(dst);
+            if (!alloc_ring(dst, src->chunkCap)) {
+                return false;
+            }
+        }
+        for (uint32_t age = 0; age < src->chunkCount; age++) {
+            copy_chunk(dst, src, slot_of(src, age));
+        }
+    }
+
+    uint8_t *data = dst->data;
+    CSeriesChunk *chunks = dst->chunks;
+    *dst = *src;
+    dst->data = data;
+    dst->chunks = chunks;
+    return true;
+}
+
+uint64_t CompressedSeries_SampleCount(const CompressedSeries *s)
+{
+    uint64_t n = 0;
+    for (uint32_t age = 0; s && s->data && age < s->chunkCount; age++) {
+        n += s->chunks[slot_of(s, age)].count;
+    }
+    return n;
+}
+
+uint64_t CompressedSeries_Bytes(const CompressedSeries *s)
+{
+    uint64_t n = 0;
+    for (uint32_t age = 0; s && s->data && age < s->chunkCount; age++) {
+        n += (s->chunks[slot_of(s, age)].bits + 7u) / 8u;
+    }
+    return n;
+}
+
+void SeriesCursor_Begin(SeriesCursor *c, const CompressedSeries *s)
+{
+    memset(c, 0, sizeof(*c));
+    c->s = s;
+}
+
+bool SeriesCursor_Next(SeriesCursor *c, int64_t *t, float *v)
+{
+    const CompressedSeries *s = c->s;
+    if (!s || !s->data) return false;
+
+    for (;;) {
+        if (c->chunk >= s->chunkCount) return false;
+        const uint32_t slot = slot_of(s, s->chunkCount - 1u - c->chunk);
+        const CSeriesChunk *ch = &s->chunks[slot];
+        if (c->sample >= ch->count) {
+            c->chunk++;
+            c->sample = 0;
+            c->bitPos = 0;
+            continue;
+        }
+
+        const uint8_t *buf = s->data + (size_t)slot * CSERIES_CHUNK_BYTES;
+        if (c->sample == 0) {
+            c->t = ch->t0;
+            c->delta = 0;
+            c->value = (uint32_t)get_bits(buf, &c->bitPos, 32u);
+            c->leading = 32u;
+            c->trailing = 0;
+        } else {
+            int64_t dod = 0;
+            if (get_bits(buf, &c->bitPos, 1u)) {
+                if (!get_bits(buf, &c->bitPos, 1u)) {
+                    dod = sign_extend(get_bits(buf, &c->bitPos, 7u), 7u);
+                } else if (!get_bits(buf, &c->bitPos, 1u)) {
+                    dod = sign_extend(get_bits(buf, &c->bitPos, 9u), 9u);
+                } else if (!get_bits(buf, &c->bitPos, 1u)) {
+                    dod = sign_extend(get_bits(buf, &c->bitPos, 12u), 12u);
+                } else {
+                    dod = sign_extend(get_bits(buf, &c->bitPos, 32u), 32u);
+                }
+            }
+            c->delta += dod;
+            c->t += c->delta;
+
+            if (get_bits(buf, &c->bitPos, 1u)) {
+                if (get_bits(buf, &c->bitPos, 1u)) {
+                    c->leading = (uint32_t)get_bits(buf, &c->bitPos, 5u);
+                    const uint32_t sig = (uint32_t)get_bits(buf, &c->bitPos, 5u) + 1u;
+                    c->trailing = 32u - c->leading - sig;
+                }
+                const uint32_t sig = 32u - c->leading - c->trailing;
+                c->value ^= (uint32_t)get_bits(buf, &c->bitPos, sig) << c->trailing;
+            }
+        }
+
+        c->sample++;
+        if (t) *t = c->t;
+        if (v) *v = bits_float(c->value);
+        return true;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Compressed long-term history for one float series (Gorilla-style).
+//
+// Samples are appended to fixed-size chunks: timestamps as delta-of-delta in
+// variable-width buckets (one bit when the period is steady), values as the XOR with
+// the previous value, reusing the previous leading/trailing-zero window when the new
+// one fits inside it (one bit when the value repeats). A chunk is sealed once the next
+// sample might not fit and is never written again, which is what lets
+// CompressedSeries_CopyFrom ship only the open chunk and chunks sealed since.
+//
+// Chunks that end before newest time - retention are dropped; the chunk ring grows on
+// demand until it spans the retention. Values may be quantized to a power-of-two step
+// before encoding (usage in 1/8 % steps, ...): fewer significant mantissa bits mean
+// shorter XOR payloads. Read back oldest first with a SeriesCursor, one sample at a
+// time, without materializing the series.
+
+#define CSERIES_CHUNK_BYTES 256u
+#define CSERIES_MAX_CHUNKS (1u << 20)
+
+typedef struct CSeriesChunk {
+    int64_t t0;     // first sample's time
+    int64_t tLast;  // newest sample's time
+    uint32_t count; // samples
+    uint32_t bits;  // encoded length
+} CSeriesChunk;
+
+typedef struct CompressedSeries {
+    uint8_t *data;        // chunkCap * CSERIES_CHUNK_BYTES
+    CSeriesChunk *chunks; // per slot
+    uint32_t chunkCap;    // power of two
+    uint32_t chunkCount;  // live chunks; the newest one is open
+    uint32_t head;        // slot of the next chunk to open
+    int64_t retention;    // in the caller's time units
+    float quantum;        // 0 = lossless
+
+    // Encoder state of the open chunk (Monitor only).
+    int64_t prevT;
+    int64_t prevDelta;
+    uint32_t prevValue;    // IEEE bits
+    uint32_t prevLeading;  // XOR window; 32 = none yet
+    uint32_t prevTrailing;
+
+    uint32_t id;           // unique per init; copies carry their source's id
+    uint64_t chunksOpened; // ever opened
+    uint64_t pushes;
+} CompressedSeries;
+
+typedef struct SeriesCursor {
+    const CompressedSeries *s;
+    uint32_t chunk;  // 0 = oldest live chunk
+    uint32_t sample; // within the chunk
+    uint32_t bitPos;
+    int64_t t;
+    int64_t delta;
+    uint32_t value;
+    uint32_t leading;
+    uint32_t trailing;
+} SeriesCursor;
+
+// retention and every t pushed are in the same (caller-chosen) time unit. quantum should
+// be a power of two (or 0).
+bool CompressedSeries_Init(CompressedSeries *s, int64_t retention, float quantum, uint32_t initialChunks);
+void CompressedSeries_Shutdown(CompressedSeries *s);
+// Samples must arrive in non-decreasing time order.
+void CompressedSeries_Push(CompressedSeries *s, float v, int64_t t);
+
+// Copies src into dst, reallocating when the ring size differs. When dst is an earlier
+// copy of src only the chunks written since are copied.
+bool CompressedSeries_CopyFrom(CompressedSeries *dst, const CompressedSeries *src);
+
+uint64_t CompressedSeries_SampleCount(const CompressedSeries *s);
+// Encoded bytes held (live chunks, rounded up to whole bytes).
+uint64_t CompressedSeries_Bytes(const CompressedSeries *s);
+
+void SeriesCursor_Begin(SeriesCursor *c, const CompressedSeries *s);
+// Next sample, oldest first; false at the end.
+bool SeriesCursor_Next(SeriesCursor *c, int64_t *t, float *v);
@@ -0,0 +1,164 @@
+#include "core_history.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "self_stats.h"
+#include "sys_thread.h"
+
+static volatile uint32_t g_nextId;
+
+uint32_t CoreHistory_Stride(uint32_t cores)
+{
+    const uint32_t perLine = CORE_HISTORY_ALIGN / (uint32_t)sizeof(float);
+    return (cores + perLine - 1u) / perLine * perLine;
+}
+
+static void init_cursor(CoreHistory *h, uint32_t cores, uint32_t capacity, uint32_t slots)
+{
+    h->cores = cores;
+    h->cap = capacity;
+    h->mask = slots - 1u;
+    h->id = Atomic_AddU32(&g_nextId, 1u);
+    if (h->id == 0) {
+        h->id = Atomic_AddU32(&g_nextId, 1u);
+    }
+}
+
+bool CoreHistory_Init(CoreHistory *h, uint32_t cores, uint32_t capacity)
+{
+    memset(h, 0, sizeof(*h));
+    if (cores == 0 || capacity == 0) {
+        return false;
+    }
+
+    const uint32_t slots = RingBuf_StorageSlots(capacity);
+    h->stride = CoreHistory_Stride(cores);
+    const size_t dataBytes = (size_t)slots * h->stride * sizeof(float);
+    const size_t tsBytes = (size_t)slots * sizeof(int64_t);
+    h->block = calloc(1, dataBytes + tsBytes + CORE_HISTORY_ALIGN);
+    if (!h->block) {
+        memset(h, 0, sizeof(*h));
+        return false;
+    }
+    SelfStats_NoteAlloc();
+
+    const uintptr_t base = ((uintptr_t)h->block + CORE_HISTORY_ALIGN - 1u) & ~(uintptr_t)(CORE_HISTORY_ALIGN - 1u);
+    h->data = (float *)base;
+    h->ts = (int64_t *)(base + dataBytes);
+    init_cursor(h, cores, capacity, slots);
+    return true;
+}
+
+bool CoreHistory_InitBorrowed(CoreHistory *h, uint32_t cores, uint32_t capacity, float *data, int64_t *ts)
+{
+    memset(h, 0, sizeof(*h));
+    if (cores == 0 || capacity == 0 || !data || !ts) {
+        return false;
+    }
+    h->data = data;
+    h->ts = ts;
+    h->stride = CoreHistory_Stride(cores);
+    init_cursor(h, cores, capacity, RingBuf_StorageSlots(capacity));
+    return true;
+}
+
+void CoreHistory_Shutdown(CoreHistory *h)
+{
+    if (!h) return;
+    free(h->block);
+    memset(h, 0, sizeof(*h));
+}
+
+void CoreHistory_Push(CoreHistory *h, const float *values, int64_t t)
+{
+    if (!h || !h->data || !values) {
+        return;
+    }
+    memcpy(h->data + (size_t)h->head * h->stride, values, (size_t)h->cores * sizeof(float));
+    h->ts[h->head] = t;
+    h->head = (h->head + 1u) & h->mask;
+    h->pushes++;
+    if (h->count < h->cap) {
+        h->count++;
+    }
+}
+
+// Copies n rows starting at row `from`, wrapping at the end of storage.
+static void copy_rows(CoreHistory *dst, const CoreHistory *src, uint32_t from, uint32_t n)
+{
+    while (n > 0) {
+        const uint32_t run = (n < src->mask + 1u - from) ? n : src->mask + 1u - from;
+        memcpy(dst->data + (size_t)from * src->stride, src->data + (size_t)from * src->stride,
+               (size_t)run * src->stride * sizeof(float));
+        memcpy(dst->ts + from, src->ts + from, (size_t)run * sizeof(int64_t));
+        n -= run;
+        from = 0;
+    }
+}
+
+bool CoreHistory_CopyFrom(CoreHistory *dst, const CoreHistory *src)
+{
+    if (!dst || !src) {
+        return false;
+    }
+    if (dst->cap != src->cap || dst->cores != src->cores || !dst->data) {
+        CoreHistory_Shutdown(dst);
+        if (!src->data) {
+            return true;
+        }
+        if (!CoreHistory_Init(dst, src->cores, src->cap)) {
+            return false;
+        }
+    }
+
+    const uint32_t slots = src->mask + 1u;
+    const uint64_t fresh = src->pushes - dst->pushes;
+    if (dst->id == src->id && dst->pushes <= src->pushes && fresh < slots) {
+        copy_rows(dst, src, (src->head - (uint32_t)fresh) & src->mask, (uint32_t)fresh);
+    } else {
+        copy_rows(dst, src, 0, slots);
+    }
+    dst->count = src->count;
+    dst->head = src->head;
+    dst->id = src->id;
+    dst->pushes = src->pushes;
+    return true;
+}
+
+static uint32_t oldest_row(const CoreHistory *h, uint32_t i)
+{
+    return (h->head - h->count + i) & h->mask;
+}
+
+const float *CoreHistory_Row(const CoreHistory *h, uint32_t i)
+{
+    if (!h || !h->data || i >= h->count) {
+        return NULL;
+    }
+    return h->data + (size_t)oldest_row(h, i) * h->stride;
+}
+
+int64_t CoreHistory_RowTime(const CoreHistory *h, uint32_t i)
+{
+    if (!h || !h->ts || i >= h->count) {
+        return 0;
+    }
+    return h->ts[oldest_row(h, i)];
+}
+
+uint32_t CoreHistory_GetColumn(const CoreHistory *h, uint32_t core, RingBufSpans *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->stride = h ? h->stride : 1u;
+    if (!h || !h->data || h->count == 0 || core >= h->cores) {
+        return 0;
+    }
+    const uint32_t start = oldest_row(h, 0);
+    const uint32_t tail = h->mask + 1u - start;
+    out->a = h->data + (size_t)start * h->stride + core;
+    out->aCount = (h->count < tail) ? h->count : tail;
+    out->b = h->data + core;
+    out->bCount = h->count - out->aCount;
+    return h->count;
+}
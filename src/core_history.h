@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ringbuf.h"
+
+// Per-core usage history as one time-major matrix.
+//
+// A row holds one sample of every logical processor and is padded to a whole number of
+// cache lines; all rows and their timestamps share a single allocation and form a ring of
+// power-of-two length like RingBufF. Pushing a sample is one contiguous row write, a row
+// (every core at one time) is a plain array, and a core's history is a strided column
+// served as RingBufSpans without copying.
+
+#define CORE_HISTORY_ALIGN 64u
+
+typedef struct CoreHistory {
+    void *block;     // the single allocation behind data and ts (NULL when borrowed)
+    float *data;     // (mask + 1) rows of stride floats, CORE_HISTORY_ALIGN-aligned
+    int64_t *ts;     // sample time (Qpc_Now() ticks) per row
+    uint32_t cores;
+    uint32_t stride; // floats per row: cores rounded up to a cache line
+    uint32_t cap;    // logical capacity in rows
+    uint32_t mask;   // storage rows - 1
+    uint32_t count;
+    uint32_t head;   // next row to write
+    uint32_t id;     // unique per init; copies carry their source's id
+    uint64_t pushes;
+} CoreHistory;
+
+bool CoreHistory_Init(CoreHistory *h, uint32_t cores, uint32_t capacity);
+// Like CoreHistory_Init on caller-owned storage (a mapped history file): data holds
+// RingBuf_StorageSlots(capacity) rows of CoreHistory_Stride(cores) floats, ts one time per
+// row. The history starts empty; Shutdown leaves the storage alone.
+bool CoreHistory_InitBorrowed(CoreHistory *h, uint32_t cores, uint32_t capacity, float *data, int64_t *ts);
+uint32_t CoreHistory_Stride(uint32_t cores);
+void CoreHistory_Shutdown(CoreHistory *h);
+
+// Appends one row: values[0..cores) sampled at t.
+void CoreHistory_Push(CoreHistory *h, const float *values, int64_t t);
+
+// Copies src into dst, reallocating when the shape differs. When dst is an earlier copy
+// of src only the rows pushed since are copied.
+bool CoreHistory_CopyFrom(CoreHistory *dst, const CoreHistory *src);
+
+// i-th oldest row (cores values), or NULL if i >= count.
+const float *CoreHistory_Row(const CoreHistory *h, uint32_t i);
+int64_t CoreHistory_RowTime(const CoreHistory *h, uint32_t i);
+
+// One core's history, oldest first, as strided spans into the matrix. Returns the count.
+uint32_t CoreHistory_GetColumn(const CoreHistory *h, uint32_t core, RingBufSpans *out);
@@ -0,0 +1,52 @@
+#include "etw_kernel.h"
+
+// Kernel event classification, kept free of Windows headers so it can be benchmarked
+// off Windows. Values mirror EVENT_TRACE_FLAG_* (evntrace.h) and the classic kernel
+// opcodes; kernel keywords generally mirror the session's EnableFlags.
+
+#define KW_PROCESS 0x00000001ull
+#define KW_THREAD 0x00000002ull
+#define KW_IMAGE_LOAD 0x00000004ull
+#define KW_SYSTEMCALL 0x00000080ull
+#define KW_DISK_IO 0x00000100ull
+#define KW_DISK_FILE_IO 0x00000200ull
+#define KW_DISPATCHER 0x00000800ull
+#define KW_MEMORY_PAGE_FAULTS 0x00001000ull
+#define KW_NETWORK_TCPIP 0x00010000ull
+#define KW_REGISTRY 0x00020000ull
+#define KW_PROFILE 0x01000000ull
+#define KW_FILE_IO 0x02000000ull
+#define KW_FILE_IO_INIT 0x04000000ull
+
+#define OPCODE_CSWITCH 36u
+#define OPCODE_DPC 50u
+#define OPCODE_ISR 51u
+
+uint32_t EtwKernel_Classify(uint64_t keyword, uint8_t opcode)
+{
+    uint32_t cats = 0;
+
+    if (keyword & KW_THREAD) cats |= ETW_CAT_BIT(ETW_CAT_THREAD);
+    if (keyword & KW_PROCESS) cats |= ETW_CAT_BIT(ETW_CAT_PROCESS);
+    if (keyword & KW_IMAGE_LOAD) cats |= ETW_CAT_BIT(ETW_CAT_IMAGE_LOAD);
+    if (keyword & KW_DISPATCHER) cats |= ETW_CAT_BIT(ETW_CAT_DISPATCHER);
+    if (keyword & KW_SYSTEMCALL) cats |= ETW_CAT_BIT(ETW_CAT_SYSCALL);
+    if (keyword & KW_PROFILE) cats |= ETW_CAT_BIT(ETW_CAT_PROFILE);
+    if (keyword & KW_MEMORY_PAGE_FAULTS) cats |= ETW_CAT_BIT(ETW_CAT_PAGE_FAULT);
+    if (keyword & (KW_FILE_IO | KW_FILE_IO_INIT)) cats |= ETW_CAT_BIT(ETW_CAT_FILE_IO);
+    if (keyword & (KW_DISK_IO | KW_DISK_FILE_IO)) cats |= ETW_CAT_BIT(ETW_CAT_DISK_IO);
+    if (keyword & KW_NETWORK_TCPIP) cats |= ETW_CAT_BIT(ETW_CAT_TCPIP);
+    if (keyword & KW_REGISTRY) cats |= ETW_CAT_BIT(ETW_CAT_REGISTRY);
+
+    if (cats == 0) cats |= ETW_CAT_BIT(ETW_CAT_OTHER);
+
+    if (opcode == OPCODE_CSWITCH) {
+        cats |= ETW_CAT_BIT(ETW_CAT_CSWITCH);
+    } else if (opcode == OPCODE_ISR) {
+        cats |= ETW_CAT_BIT(ETW_CAT_ISR);
+    } else if (opcode == OPCODE_DPC) {
+        cats |= ETW_CAT_BIT(ETW_CAT_DPC);
+    }
+
+    return cats;
+}
@@ -16,17 +16,6 @@
 #define COBJMACROS
 #endif
 
-// Some MinGW SDKs omit these classic opcodes.
-#ifndef EVENT_TRACE_TYPE_CSWITCH
-#define EVENT_TRACE_TYPE_CSWITCH 36
-#endif
-#ifndef EVENT_TRACE_TYPE_DPC
-#define EVENT_TRACE_TYPE_DPC 50
-#endif
-#ifndef EVENT_TRACE_TYPE_ISR
-#define EVENT_TRACE_TYPE_ISR 51
-#endif
-
 #ifndef ERROR_PRIVILEGE_NOT_HELD
 #define ERROR_PRIVILEGE_NOT_HELD 1314
 #endif
@@ -89,65 +78,24 @@ static void on_event_record(EVENT_RECORD *rec)
     const UCHAR op = rec->EventHeader.EventDescriptor.Opcode; // opcode
 
     // Category classification (best-effort): kernel keywords generally mirror EnableFlags.
-    const ULONGLONG kw = rec->EventHeader.EventDescriptor.Keyword;
-    bool classified = false;
-
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_THREAD) {
-        InterlockedIncrement64((volatile LONG64 *)&k->threadCount);
-        classified = true;
-    }
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_PROCESS) {
-        InterlockedIncrement64((volatile LONG64 *)&k->processCount);
-        classified = true;
-    }
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_IMAGE_LOAD) {
-        InterlockedIncrement64((volatile LONG64 *)&k->imageLoadCount);
-        classified = true;
-    }
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_DISPATCHER) {
-        InterlockedIncrement64((volatile LONG64 *)&k->dispatcherCount);
-        classified = true;
-    }
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_SYSTEMCALL) {
-        InterlockedIncrement64((volatile LONG64 *)&k->syscallCount);
-        classified = true;
-    }
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_PROFILE) {
-        InterlockedIncrement64((volatile LONG64 *)&k->profileCount);
-        classified = true;
-    }
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_MEMORY_PAGE_FAULTS) {
-        InterlockedIncrement64((volatile LONG64 *)&k->pageFaultCount);
-        classified = true;
-    }
-    if (kw & ((ULONGLONG)EVENT_TRACE_FLAG_FILE_IO | (ULONGLONG)EVENT_TRACE_FLAG_FILE_IO_INIT)) {
-        InterlockedIncrement64((volatile LONG64 *)&k->fileIoCount);
-        classified = true;
-    }
-    if (kw & ((ULONGLONG)EVENT_TRACE_FLAG_DISK_IO | (ULONGLONG)EVENT_TRACE_FLAG_DISK_FILE_IO)) {
-        InterlockedIncrement64((volatile LONG64 *)&k->diskIoCount);
-        classified = true;
-    }
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_NETWORK_TCPIP) {
-        InterlockedIncrement64((volatile LONG64 *)&k->tcpipCount);
-        classified = true;
-    }
-    if (kw & (ULONGLONG)EVENT_TRACE_FLAG_REGISTRY) {
-        InterlockedIncrement64((volatile LONG64 *)&k->registryCount);
-        classified = true;
-    }
-
-    if (op == EVENT_TRACE_TYPE_CSWITCH) {
-        InterlockedIncrement64((volatile LONG64 *)&k->cswitchCount);
-    } else if (op == EVENT_TRACE_TYPE_ISR) {
-        InterlockedIncrement64((volatile LONG64 *)&k->isrCount);
-    } else if (op == EVENT_TRACE_TYPE_DPC) {
-        InterlockedIncrement64((volatile LONG64 *)&k->dpcCount);
-    }
-
-    if (!classified) {
-        InterlockedIncrement64((volatile LONG64 *)&k->otherCount);
-    }
+    const uint32_t cats = EtwKernel_Classify((uint64_t)rec->EventHeader.EventDescriptor.Keyword, (uint8_t)op);
+
+    if (cats & ETW_CAT_BIT(ETW_CAT_THREAD)) InterlockedIncrement64((volatile LONG64 *)&k->threadCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_PROCESS)) InterlockedIncrement64((volatile LONG64 *)&k->processCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_IMAGE_LOAD)) InterlockedIncrement64((volatile LONG64 *)&k->imageLoadCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_DISPATCHER)) InterlockedIncrement64((volatile LONG64 *)&k->dispatcherCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_SYSCALL)) InterlockedIncrement64((volatile LONG64 *)&k->syscallCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_PROFILE)) InterlockedIncrement64((volatile LONG64 *)&k->profileCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_PAGE_FAULT)) InterlockedIncrement64((volatile LONG64 *)&k->pageFaultCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_FILE_IO)) InterlockedIncrement64((volatile LONG64 *)&k->fileIoCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_DISK_IO)) InterlockedIncrement64((volatile LONG64 *)&k->diskIoCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_TCPIP)) InterlockedIncrement64((volatile LONG64 *)&k->tcpipCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_REGISTRY)) InterlockedIncrement64((volatile LONG64 *)&k->registryCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_OTHER)) InterlockedIncrement64((volatile LONG64 *)&k->otherCount);
+
+    if (cats & ETW_CAT_BIT(ETW_CAT_CSWITCH)) InterlockedIncrement64((volatile LONG64 *)&k->cswitchCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_ISR)) InterlockedIncrement64((volatile LONG64 *)&k->isrCount);
+    if (cats & ETW_CAT_BIT(ETW_CAT_DPC)) InterlockedIncrement64((volatile LONG64 *)&k->dpcCount);
 }
 
 static DWORD WINAPI etw_thread_main(LPVOID param)
@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <wchar.h>
 
 typedef struct EtwRates {
     double cswitchPerSec;
@@ -23,6 +24,30 @@ typedef struct EtwRates {
     double otherPerSec;
 } EtwRates;
 
+// Counter categories for kernel events. A single event can land in several keyword
+// categories (plus at most one of CSWITCH/ISR/DPC by opcode); OTHER is set when no
+// keyword category matched.
+typedef enum EtwCategory {
+    ETW_CAT_THREAD = 0,
+    ETW_CAT_PROCESS,
+    ETW_CAT_IMAGE_LOAD,
+    ETW_CAT_DISPATCHER,
+    ETW_CAT_SYSCALL,
+    ETW_CAT_PROFILE,
+    ETW_CAT_PAGE_FAULT,
+    ETW_CAT_FILE_IO,
+    ETW_CAT_DISK_IO,
+    ETW_CAT_TCPIP,
+    ETW_CAT_REGISTRY,
+    ETW_CAT_OTHER,
+    ETW_CAT_CSWITCH,
+    ETW_CAT_ISR,
+    ETW_CAT_DPC,
+    ETW_CAT_COUNT
+} EtwCategory;
+
+#define ETW_CAT_BIT(c) (1u << (c))
+
 typedef struct EtwKernel {
     bool ok;
 
@@ -85,3 +110,7 @@ void EtwKernel_GetStatusText(const EtwKernel *k, wchar_t *out, uint32_t outCount
 
 // Computes rates from counter deltas over dt, and updates internal baselines.
 void EtwKernel_ComputeRates(EtwKernel *k, double dt, EtwRates *out);
+
+// Classifies a kernel event by EventDescriptor.Keyword/Opcode into ETW_CAT_BIT() flags.
+// Pure function (etw_classify.c) so it builds off Windows for CCM_bench.
+uint32_t EtwKernel_Classify(uint64_t keyword, uint8_t opcode);
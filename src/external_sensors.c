@@ -66,51 +66,6 @@ static bool overlapped_read_some(HANDLE h, void *buf, DWORD cap, DWORD timeoutMs
     return ok ? true : false;
 }
 
-static bool parse_kv_lines(const char *buf, uint32_t len, ExternalSensorsSample *out)
-{
-    if (!buf || !out) return false;
-
-    // Make a local, NUL-terminated copy for simple parsing.
-    char tmp[1024];
-    if (len >= sizeof(tmp)) len = (uint32_t)(sizeof(tmp) - 1);
-    memcpy(tmp, buf, len);
-    tmp[len] = 0;
-
-    bool any = false;
-
-    char *ctx = NULL;
-    for (char *line = strtok_s(tmp, "\n\r", &ctx); line; line = strtok_s(NULL, "\n\r", &ctx)) {
-        while (*line == ' ' || *line == '\t') line++;
-        if (*line == 0) continue;
-
-        char *eq = strchr(line, '=');
-        if (!eq) continue;
-        *eq = 0;
-        const char *key = line;
-        const char *val = eq + 1;
-
-        if (_stricmp(key, "tempC") == 0) {
-            out->cpuTempC = (float)atof(val);
-            out->hasCpuTempC = true;
-            any = true;
-        } else if (_stricmp(key, "powerW") == 0) {
-            out->powerW = (double)atof(val);
-            out->hasPowerW = true;
-            any = true;
-        } else if (_stricmp(key, "fanRpm") == 0) {
-            out->fanRpm = (float)atof(val);
-            out->hasFanRpm = true;
-            any = true;
-        } else if (_stricmp(key, "status") == 0) {
-            // Allows a provider to respond without any sensor keys.
-            // CCM will treat this as a successful provider round-trip.
-            any = true;
-        }
-    }
-
-    return any;
-}
-
 bool ExternalSensors_TrySample(ExternalSensorsSample *out)
 {
     if (!out) return false;
@@ -169,7 +124,7 @@ bool ExternalSensors_TrySample(ExternalSensorsSample *out)
         return false;
     }
 
-    if (!parse_kv_lines(resp, (uint32_t)got, out)) {
+    if (!ExternalSensors_ParseResponse(resp, (uint32_t)got, out)) {
         wcscpy_s(out->status, (uint32_t)(sizeof(out->status) / sizeof(out->status[0])), L"N/A (provider parse)");
         return false;
     }
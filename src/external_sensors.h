@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <wchar.h>
 
 // Optional external sensor provider.
 //
@@ -35,3 +36,7 @@ typedef struct ExternalSensorsSample {
 } ExternalSensorsSample;
 
 bool ExternalSensors_TrySample(ExternalSensorsSample *out);
+
+// Parses a provider response (key=value lines) into out; keys are case-insensitive.
+// Returns true if any known key was present. Does not touch out->status.
+bool ExternalSensors_ParseResponse(const char *buf, uint32_t len, ExternalSensorsSample *out);
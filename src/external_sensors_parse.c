@@ -0,0 +1,71 @@
+#include "external_sensors.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Portable half of the external sensor client: response parsing only (no pipe I/O),
+// so it also builds off Windows for CCM_bench.
+
+static bool key_equals(const char *key, const char *want)
+{
+    for (;; key++, want++) {
+        char a = *key;
+        char b = *want;
+        if (a >= 'A' && a <= 'Z') a = (char)(a - 'A' + 'a');
+        if (b >= 'A' && b <= 'Z') b = (char)(b - 'A' + 'a');
+        if (a != b) return false;
+        if (a == 0) return true;
+    }
+}
+
+bool ExternalSensors_ParseResponse(const char *buf, uint32_t len, ExternalSensorsSample *out)
+{
+    if (!buf || !out) return false;
+
+    // Make a local, NUL-terminated copy for simple parsing.
+    char tmp[1024];
+    if (len >= sizeof(tmp)) len = (uint32_t)(sizeof(tmp) - 1);
+    memcpy(tmp, buf, len);
+    tmp[len] = 0;
+
+    bool any = false;
+
+    char *next = tmp;
+    while (*next) {
+        char *line = next;
+        const size_t lineLen = strcspn(line, "\n\r");
+        next = line + lineLen;
+        if (*next) {
+            *next++ = 0;
+        }
+
+        while (*line == ' ' || *line == '\t') line++;
+        if (*line == 0) continue;
+
+        char *eq = strchr(line, '=');
+        if (!eq) continue;
+        *eq = 0;
+        const char *key = line;
+        const char *val = eq + 1;
+
+        if (key_equals(key, "tempC")) {
+            out->cpuTempC = (float)atof(val);
+            out->hasCpuTempC = true;
+            any = true;
+        } else if (key_equals(key, "powerW")) {
+            out->powerW = (double)atof(val);
+            out->hasPowerW = true;
+            any = true;
+        } else if (key_equals(key, "fanRpm")) {
+            out->fanRpm = (float)atof(val);
+            out->hasFanRpm = true;
+            any = true;
+        } else if (key_equals(key, "status")) {
+            // Allows a provider to respond without any sensor keys.
+            // CCM will treat this as a successful provider round-trip.
+            any = true;
+        }
+    }
+
+    return any;
+}
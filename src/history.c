@@ -0,0 +1,113 @@
+#include "history.h"
+
+#include <string.h>
+
+static void tier_shutdown(HistTier *t)
+{
+    RingBuf_Shutdown(&t->mean);
+    RingBuf_Shutdown(&t->min);
+    RingBuf_Shutdown(&t->max);
+    WindowStats_Shutdown(&t->peakWindow);
+    memset(t, 0, sizeof(*t));
+}
+
+bool HistRollup_Init(HistRollup *h, const HistTierSpec *specs, uint32_t tierCount, double qpcFreq,
+                     bool trackPeak)
+{
+    memset(h, 0, sizeof(*h));
+    if (!specs || tierCount > HIST_TIER_MAX || qpcFreq <= 0.0) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < tierCount; i++) {
+        HistTier *t = &h->tiers[i];
+        t->bucketTicks = (int64_t)(specs[i].bucketSec * qpcFreq);
+        if (t->bucketTicks <= 0 ||
+            !RingBuf_Init(&t->mean, specs[i].buckets) ||
+            !RingBuf_InitUntimed(&t->min, specs[i].buckets) ||
+            !RingBuf_InitUntimed(&t->max, specs[i].buckets) ||
+            (trackPeak && !WindowStats_Init(&t->peakWindow, specs[i].buckets))) {
+            h->tierCount = i + 1u;
+            HistRollup_Shutdown(h);
+            return false;
+        }
+    }
+    h->tierCount = tierCount;
+    return true;
+}
+
+void HistRollup_Shutdown(HistRollup *h)
+{
+    if (!h) return;
+    for (uint32_t i = 0; i < h->tierCount; i++) {
+        tier_shutdown(&h->tiers[i]);
+    }
+    memset(h, 0, sizeof(*h));
+}
+
+// Folds an aggregate (count samples, their sum, min and max, taken at t) into tier i,
+// closing the open bucket first if t falls in a later one.
+static void tier_add(HistRollup *h, uint32_t i, int64_t t, uint32_t count, double sum, float mn, float mx)
+{
+    HistTier *tier = &h->tiers[i];
+    const int64_t bucket = t / tier->bucketTicks;
+
+    if (tier->accCount > 0 && bucket != tier->openBucket) {
+        const int64_t start = tier->openBucket * tier->bucketTicks;
+        RingBuf_PushAt(&tier->mean, (float)(tier->accSum / (double)tier->accCount), start);
+        RingBuf_Push(&tier->min, tier->accMin);
+        RingBuf_Push(&tier->max, tier->accMax);
+        if (tier->peakWindow.values) {
+            WindowStats_Push(&tier->peakWindow, tier->accMax);
+            tier->peakMax = WindowStats_Max(&tier->peakWindow);
+        }
+        if (i + 1u < h->tierCount) {
+            tier_add(h, i + 1u, start, tier->accCount, tier->accSum, tier->accMin, tier->accMax);
+        }
+        tier->accCount = 0;
+    }
+
+    if (tier->accCount == 0) {
+        tier->openBucket = bucket;
+        tier->accSum = 0.0;
+        tier->accMin = mn;
+        tier->accMax = mx;
+    }
+    tier->accCount += count;
+    tier->accSum += sum;
+    if (mn < tier->accMin) tier->accMin = mn;
+    if (mx > tier->accMax) tier->accMax = mx;
+}
+
+void HistRollup_Push(HistRollup *h, float v, int64_t t)
+{
+    if (!h || h->tierCount == 0) return;
+    tier_add(h, 0, t, 1u, (double)v, v, v);
+}
+
+bool HistRollup_CopyFrom(HistRollup *dst, const HistRollup *src)
+{
+    if (!dst || !src) return false;
+
+    if (dst->tierCount != src->tierCount) {
+        HistRollup_Shutdown(dst);
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < src->tierCount; i++) {
+        HistTier *d = &dst->tiers[i];
+        const HistTier *s = &src->tiers[i];
+        ok = RingBuf_CopyFrom(&d->mean, &s->mean) && ok;
+        ok = RingBuf_CopyFrom(&d->min, &s->min) && ok;
+        ok = RingBuf_CopyFrom(&d->max, &s->max) && ok;
+        d->bucketTicks = s->bucketTicks;
+        d->peakMax = s->peakMax;
+        d->openBucket = s->openBucket;
+        d->accCount = s->accCount;
+        d->accSum = s->accSum;
+        d->accMin = s->accMin;
+        d->accMax = s->accMax;
+    }
+    dst->tierCount = src->tierCount;
+    return ok;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ringbuf.h"
+#include "window_stats.h"
+
+// Multi-resolution history.
+//
+// A series' raw samples live in a RingBufF (tier 0, e.g. 240 samples at 4 Hz). A HistRollup
+// adds coarser tiers behind it: each tier closes fixed-length time buckets and keeps the
+// bucket's min, max and mean, then feeds the closed bucket into the next tier (for example
+// 1 s buckets for an hour, then 1 min buckets for a day). Spikes survive as bucket maxima,
+// and memory is fixed by the tier specs regardless of how long the app runs.
+//
+// Buckets are aligned to multiples of the bucket length on the Qpc_Now() clock. A bucket
+// is closed by the first sample of a later bucket; periods without samples leave no
+// buckets behind.
+
+#define HIST_TIER_MAX 4u
+
+typedef struct HistTierSpec {
+    double bucketSec;
+    uint32_t buckets; // kept per tier
+} HistTierSpec;
+
+typedef struct HistTier {
+    RingBufF mean; // stamped with the bucket start
+    RingBufF min;
+    RingBufF max;
+    int64_t bucketTicks;
+
+    // Largest bucket maximum currently in the tier (graph autoscale); tracked only when
+    // the rollup was initialized with trackPeak.
+    WindowStats peakWindow;
+    float peakMax;
+
+    // Open bucket: aggregate of raw samples (or closed buckets of the tier above).
+    int64_t openBucket; // bucket index (t / bucketTicks); valid when accCount > 0
+    uint32_t accCount;  // raw samples
+    double accSum;
+    float accMin;
+    float accMax;
+} HistTier;
+
+typedef struct HistRollup {
+    HistTier tiers[HIST_TIER_MAX];
+    uint32_t tierCount;
+} HistRollup;
+
+// Tiers must be ordered by increasing bucket length. qpcFreq converts bucket lengths to
+// Qpc_Now() ticks. trackPeak maintains HistTier.peakMax (a sliding max over the tier).
+bool HistRollup_Init(HistRollup *h, const HistTierSpec *specs, uint32_t tierCount, double qpcFreq,
+                     bool trackPeak);
+void HistRollup_Shutdown(HistRollup *h);
+
+// Adds a raw sample taken at t (Qpc_Now() ticks).
+void HistRollup_Push(HistRollup *h, float v, int64_t t);
+
+// Copies src into dst (see RingBuf_CopyFrom: repeated copies only move new buckets).
+// Peak tracking state stays with src; dst gets peakMax only.
+bool HistRollup_CopyFrom(HistRollup *dst, const HistRollup *src);
@@ -0,0 +1,173 @@
+#include "history_file.h"
+
+#include <string.h>
+
+#include "qpc.h"
+
+static const char kMagic[8] = {'C', 'C', 'M', 'H', 'I', 'S', 'T', 0};
+
+#define REGION_ALIGN 64u
+
+static uint64_t align_up(uint64_t v)
+{
+    return (v + REGION_ALIGN - 1u) & ~(uint64_t)(REGION_ALIGN - 1u);
+}
+
+static uint64_t region_bytes(const HistorySeriesSpec *spec)
+{
+    const uint64_t slots = RingBuf_StorageSlots(spec->cap);
+    const uint64_t stride = spec->width ? CoreHistory_Stride(spec->width) : 1u;
+    return align_up(slots * stride * sizeof(float)) + slots * sizeof(int64_t);
+}
+
+static bool header_matches(const HistoryFileHeader *h, const HistorySeriesSpec *specs, uint32_t count,
+                           double qpcFreq, int64_t now, const uint8_t *bootId)
+{
+    if (memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != HISTORY_FILE_VERSION ||
+        h->seriesCount != count || h->qpcFreq != qpcFreq || h->savedQpc > now ||
+        memcmp(h->bootId, bootId, sizeof(h->bootId)) != 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const HistoryFileSeries *e = &h->series[i];
+        if (e->cap != specs[i].cap || e->width != specs[i].width || e->count > e->cap ||
+            e->head >= RingBuf_StorageSlots(e->cap)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HistoryFile_Open(HistoryFile *hf, FILE *f, const HistorySeriesSpec *specs, uint32_t count,
+                      double qpcFreq, int64_t now)
+{
+    memset(hf, 0, sizeof(*hf));
+    if (!f) return false;
+    if (count == 0 || count > HISTORY_FILE_MAX_SERIES) {
+        fclose(f);
+        return false;
+    }
+
+    uint64_t offsets[HISTORY_FILE_MAX_SERIES];
+    uint64_t size = align_up(sizeof(HistoryFileHeader));
+    for (uint32_t i = 0; i < count; i++) {
+        offsets[i] = size;
+        size += align_up(region_bytes(&specs[i]));
+    }
+    if (size > (uint64_t)SIZE_MAX || !SysMap_Open(&hf->map, f, (size_t)size)) {
+        return false; // SysMap_Open closed f
+    }
+
+    // Without a boot identifier the timestamps cannot be trusted across restarts.
+    uint8_t bootId[16];
+    const bool knownBoot = Qpc_BootId(bootId);
+
+    hf->hdr = (HistoryFileHeader *)hf->map.base;
+    hf->restored = knownBoot && header_matches(hf->hdr, specs, count, qpcFreq, now, bootId);
+    if (!hf->restored) {
+        memset(hf->hdr, 0, sizeof(*hf->hdr));
+        memcpy(hf->hdr->magic, kMagic, sizeof(kMagic));
+        hf->hdr->version = HISTORY_FILE_VERSION;
+        hf->hdr->seriesCount = count;
+        hf->hdr->qpcFreq = qpcFreq;
+        hf->hdr->savedQpc = now;
+        memcpy(hf->hdr->bootId, bootId, sizeof(bootId));
+        for (uint32_t i = 0; i < count; i++) {
+            hf->hdr->series[i].cap = specs[i].cap;
+            hf->hdr->series[i].width = specs[i].width;
+        }
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        hf->hdr->series[i].offset = offsets[i]; // layout is derived, never trusted from disk
+    }
+    return true;
+}
+
+static float *region_data(HistoryFile *hf, uint32_t index)
+{
+    return (float *)((uint8_t *)hf->map.base + hf->hdr->series[index].offset);
+}
+
+static int64_t *region_ts(HistoryFile *hf, uint32_t index)
+{
+    const HistoryFileSeries *e = &hf->hdr->series[index];
+    const uint64_t slots = RingBuf_StorageSlots(e->cap);
+    const uint64_t stride = e->width ? CoreHistory_Stride(e->width) : 1u;
+    return (int64_t *)((uint8_t *)hf->map.base + e->offset + align_up(slots * stride * sizeof(float)));
+}
+
+// Drops leading samples newer than the newest one: slots overwritten after the last flush.
+static uint32_t trim_unflushed(const int64_t *ts, uint32_t head, uint32_t count, uint32_t mask)
+{
+    if (count == 0) return 0;
+    const int64_t newest = ts[(head - 1u) & mask];
+    while (count > 1 && ts[(head - count) & mask] > newest) {
+        count--;
+    }
+    return count;
+}
+
+uint32_t HistoryFile_BindRing(HistoryFile *hf, uint32_t index, RingBufF *rb)
+{
+    if (!hf || !hf->hdr || index >= hf->hdr->seriesCount || hf->hdr->series[index].width != 0) {
+        return 0;
+    }
+    const HistoryFileSeries *e = &hf->hdr->series[index];
+    RingBuf_Shutdown(rb);
+    if (!RingBuf_InitBorrowed(rb, e->cap, region_data(hf, index), region_ts(hf, index))) {
+        return 0;
+    }
+    hf->rings[index] = rb;
+    if (!hf->restored) return 0;
+
+    rb->head = e->head;
+    rb->count = trim_unflushed(rb->ts, e->head, e->count, rb->mask);
+    rb->pushes = e->pushes;
+    return rb->count;
+}
+
+uint32_t HistoryFile_BindCores(HistoryFile *hf, uint32_t index, CoreHistory *h)
+{
+    if (!hf || !hf->hdr || index >= hf->hdr->seriesCount || hf->hdr->series[index].width == 0) {
+        return 0;
+    }
+    const HistoryFileSeries *e = &hf->hdr->series[index];
+    CoreHistory_Shutdown(h);
+    if (!CoreHistory_InitBorrowed(h, e->width, e->cap, region_data(hf, index), region_ts(hf, index))) {
+        return 0;
+    }
+    hf->cores[index] = h;
+    if (!hf->restored) return 0;
+
+    h->head = e->head;
+    h->count = trim_unflushed(h->ts, e->head, e->count, h->mask);
+    h->pushes = e->pushes;
+    return h->count;
+}
+
+void HistoryFile_Flush(HistoryFile *hf, int64_t now)
+{
+    if (!hf || !hf->hdr) return;
+    for (uint32_t i = 0; i < hf->hdr->seriesCount; i++) {
+        HistoryFileSeries *e = &hf->hdr->series[i];
+        if (hf->rings[i]) {
+            e->head = hf->rings[i]->head;
+            e->count = hf->rings[i]->count;
+            e->pushes = hf->rings[i]->pushes;
+        } else if (hf->cores[i]) {
+            e->head = hf->cores[i]->head;
+            e->count = hf->cores[i]->count;
+            e->pushes = hf->cores[i]->pushes;
+        }
+    }
+    hf->hdr->savedQpc = now;
+    SysMap_Flush(&hf->map);
+}
+
+void HistoryFile_Close(HistoryFile *hf, int64_t now)
+{
+    if (!hf) return;
+    HistoryFile_Flush(hf, now);
+    SysMap_Close(&hf->map);
+    memset(hf, 0, sizeof(*hf));
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "core_history.h"
+#include "ringbuf.h"
+#include "sys_map.h"
+
+// Memory-mapped history file: raw histories that survive a restart.
+//
+// Layout: a fixed header with a table of series, then one 64-byte-aligned region per
+// series holding its float slots and timestamps exactly as RingBufF/CoreHistory lay them
+// out. The rings are initialized on top of the mapping (RingBuf_InitBorrowed), so every
+// push writes the file in place with no serialization step. Ring cursors live in the
+// rings and reach the table only at HistoryFile_Flush, which also starts an asynchronous
+// write-back; between flushes the cost is the page cache's.
+//
+// A file whose shape differs (series count, capacities, core count), that was saved during
+// another boot (Qpc_BootId; QPC restarts at boot) or whose samples lie in the future of the
+// current clock is reinitialized. Samples
+// pushed after the last flush were written in place but are not covered by the saved
+// cursor; they overwrote the oldest slots, which binding trims away.
+
+#define HISTORY_FILE_VERSION 2u
+#define HISTORY_FILE_MAX_SERIES 16u
+
+typedef struct HistorySeriesSpec {
+    uint32_t cap;   // logical capacity in samples
+    uint32_t width; // 0 = RingBufF, else CoreHistory with this many cores
+} HistorySeriesSpec;
+
+// On-disk series table entry.
+typedef struct HistoryFileSeries {
+    uint32_t cap;
+    uint32_t width;
+    uint32_t head;
+    uint32_t count;
+    uint64_t pushes;
+    uint64_t offset; // region start from the beginning of the file
+} HistoryFileSeries;
+
+typedef struct HistoryFileHeader {
+    char magic[8]; // "CCMHIST\0"
+    uint32_t version;
+    uint32_t seriesCount;
+    double qpcFreq;
+    int64_t savedQpc; // time of the last flush
+    uint8_t bootId[16]; // Qpc_BootId of the boot the timestamps count from
+    HistoryFileSeries series[HISTORY_FILE_MAX_SERIES];
+} HistoryFileHeader;
+
+typedef struct HistoryFile {
+    SysMap map;
+    HistoryFileHeader *hdr;
+    bool restored; // the file held a matching history when opened
+
+    // Bound series (cursors copied into the table on flush).
+    RingBufF *rings[HISTORY_FILE_MAX_SERIES];
+    CoreHistory *cores[HISTORY_FILE_MAX_SERIES];
+} HistoryFile;
+
+// Maps f (opened for binary read/write, e.g. "r+b" falling back to "w+b"; the HistoryFile
+// owns it) sized for the given series. now/qpcFreq decide whether the contents are usable.
+bool HistoryFile_Open(HistoryFile *hf, FILE *f, const HistorySeriesSpec *specs, uint32_t count,
+                      double qpcFreq, int64_t now);
+
+// Re-initializes rb (width-0 series) or h (width > 0) on the series' region, restoring
+// the saved samples when the file was restored. Returns the number of samples restored.
+uint32_t HistoryFile_BindRing(HistoryFile *hf, uint32_t index, RingBufF *rb);
+uint32_t HistoryFile_BindCores(HistoryFile *hf, uint32_t index, CoreHistory *h);
+
+// Saves the bound cursors and starts writing dirty pages back.
+void HistoryFile_Flush(HistoryFile *hf, int64_t now);
+// Flushes, then unmaps and closes the file. Call before shutting the bound series down;
+// they must not be pushed afterwards.
+void HistoryFile_Close(HistoryFile *hf, int64_t now);
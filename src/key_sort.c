@@ -0,0 +1,276 @@
+#include "key_sort.h"
+
+#include <string.h>
+
+#include "sys_thread.h"
+
+#define SORT_SMALL 32u
+#define SORT_MAX_POP 8u
+
+uint32_t SortKey_Float(float f)
+{
+    if (f == 0.0f || f != f) f = 0.0f;
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+static void swap_keys(SortKey *a, SortKey *b)
+{
+    const SortKey t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void insertion_sort(SortKey *keys, uint32_t n)
+{
+    for (uint32_t i = 1; i < n; i++) {
+        const SortKey x = keys[i];
+        uint32_t j = i;
+        while (j > 0 && SortKey_Cmp(&keys[j - 1], &x) > 0) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = x;
+    }
+}
+
+static uint8_t key_byte(const SortKey *k, uint32_t digit)
+{
+    // Digits 0-7 are lo's bytes, 8-15 hi's, least significant first.
+    const uint64_t w = (digit < 8u) ? k->lo : k->hi;
+    return (uint8_t)(w >> ((digit & 7u) * 8u));
+}
+
+// LSD radix sort, one pass per key byte that is not the same in every key. All sixteen
+// histograms come from a single read of the input.
+static void radix_sort(SortKey *keys, uint32_t n, SortKey *scratch)
+{
+    static const uint32_t kDigits = 16u;
+    uint32_t counts[16][256];
+    memset(counts, 0, sizeof(counts));
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t d = 0; d < kDigits; d++) {
+            counts[d][key_byte(&keys[i], d)]++;
+        }
+    }
+
+    SortKey *src = keys;
+    SortKey *dst = scratch;
+    for (uint32_t d = 0; d < kDigits; d++) {
+        if (counts[d][key_byte(&keys[0], d)] == n) continue; // every key shares this byte
+
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < 256u; b++) {
+            const uint32_t c = counts[d][b];
+            counts[d][b] = sum;
+            sum += c;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            dst[counts[d][key_byte(&src[i], d)]++] = src[i];
+        }
+        SortKey *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != keys) {
+        memcpy(keys, src, (size_t)n * sizeof(SortKey));
+    }
+}
+
+static void merge(const SortKey *a, uint32_t na, const SortKey *b, uint32_t nb, SortKey *out)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t w = 0;
+    while (i < na && j < nb) {
+        out[w++] = (SortKey_Cmp(&b[j], &a[i]) < 0) ? b[j++] : a[i++];
+    }
+    memcpy(&out[w], &a[i], (size_t)(na - i) * sizeof(SortKey));
+    w += na - i;
+    memcpy(&out[w], &b[j], (size_t)(nb - j) * sizeof(SortKey));
+}
+
+typedef struct SortChunk {
+    SortKey *keys;
+    SortKey *scratch;
+    uint32_t n;
+} SortChunk;
+
+static uint32_t sort_chunk_main(void *arg)
+{
+    SortChunk *c = (SortChunk *)arg;
+    radix_sort(c->keys, c->n, c->scratch);
+    return 0;
+}
+
+// Radix-sorts up to KEY_SORT_MAX_THREADS chunks concurrently (the calling thread takes the
+// first), then merges neighbouring runs pairwise until one is left.
+static void parallel_sort(SortKey *keys, uint32_t n, SortKey *scratch, uint32_t threads)
+{
+    SortChunk chunks[KEY_SORT_MAX_THREADS];
+    SysThread workers[KEY_SORT_MAX_THREADS];
+    uint32_t start[KEY_SORT_MAX_THREADS + 1];
+    for (uint32_t t = 0; t <= threads; t++) {
+        start[t] = (uint32_t)(((uint64_t)n * t) / threads);
+    }
+    for (uint32_t t = 0; t < threads; t++) {
+        chunks[t].keys = keys + start[t];
+        chunks[t].scratch = scratch + start[t];
+        chunks[t].n = start[t + 1] - start[t];
+        workers[t].handle = NULL;
+        if (t > 0 && !SysThread_Start(&workers[t], sort_chunk_main, &chunks[t])) {
+            (void)sort_chunk_main(&chunks[t]); // no thread: sort it here
+        }
+    }
+    (void)sort_chunk_main(&chunks[0]);
+    for (uint32_t t = 1; t < threads; t++) {
+        SysThread_Join(&workers[t]);
+    }
+
+    SortKey *src = keys;
+    SortKey *dst = scratch;
+    for (uint32_t width = 1; width < threads; width *= 2u) {
+        for (uint32_t t = 0; t < threads; t += 2u * width) {
+            const uint32_t a = start[t];
+            const uint32_t m = start[(t + width < threads) ? t + width : threads];
+            const uint32_t b = start[(t + 2u * width < threads) ? t + 2u * width : threads];
+            merge(src + a, m - a, src + m, b - m, dst + a);
+        }
+        SortKey *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != keys) {
+        memcpy(keys, src, (size_t)n * sizeof(SortKey));
+    }
+}
+
+static void sort_full(SortKey *keys, uint32_t n, SortKey *scratch)
+{
+    if (n <= SORT_SMALL) {
+        insertion_sort(keys, n);
+        return;
+    }
+    if (n >= KEY_SORT_PARALLEL_MIN) {
+        uint32_t threads = SysThread_CpuCount();
+        if (threads > KEY_SORT_MAX_THREADS) threads = KEY_SORT_MAX_THREADS;
+        if (threads > n / (KEY_SORT_PARALLEL_MIN / 2u)) threads = n / (KEY_SORT_PARALLEL_MIN / 2u);
+        if (threads > 1) {
+            parallel_sort(keys, n, scratch, threads);
+            return;
+        }
+    }
+    radix_sort(keys, n, scratch);
+}
+
+// Nearly-sorted input (the previous order with a few keys changed) in O(n + d log d) for d
+// keys out of place: those go to scratch, are sorted there and merged back. Returns false,
+// with keys permuted, once more than a quarter would move.
+//
+// A key below the last kept one either rose or follows keys that sank. A short run of
+// kept keys above it that it would fit under means they sank; those are set aside
+// instead. Otherwise the key itself is.
+static bool sort_nearly_sorted(SortKey *keys, uint32_t n, SortKey *scratch)
+{
+    const uint32_t cap = n / 4u;
+    SortKey *aside = scratch;
+    uint32_t kept = 0;
+    uint32_t d = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const SortKey x = keys[i];
+        uint32_t pop = 0;
+        bool rose = false;
+        if (kept > 0 && SortKey_Cmp(&keys[kept - 1], &x) > 0) {
+            pop = 1;
+            while (pop < kept && pop <= SORT_MAX_POP && SortKey_Cmp(&keys[kept - pop - 1], &x) > 0) {
+                pop++;
+            }
+            rose = pop > SORT_MAX_POP;
+        }
+
+        if (d + (rose ? 1u : pop) > cap) {
+            // The i - kept == d free slots take the set-aside keys back.
+            memcpy(&keys[kept], aside, (size_t)d * sizeof(SortKey));
+            return false;
+        }
+        if (rose) {
+            aside[d++] = x;
+            continue;
+        }
+        kept -= pop;
+        memcpy(&aside[d], &keys[kept], (size_t)pop * sizeof(SortKey));
+        d += pop;
+        keys[kept++] = x;
+    }
+    if (d == 0) return true;
+
+    // The rest of scratch past the set-aside keys is free for sorting them.
+    sort_full(aside, d, scratch + d);
+    uint32_t w = n;
+    uint32_t a = kept;
+    while (d > 0) {
+        if (a > 0 && SortKey_Cmp(&keys[a - 1], &aside[d - 1]) > 0) {
+            keys[--w] = keys[--a];
+        } else {
+            keys[--w] = aside[--d];
+        }
+    }
+    return true;
+}
+
+void KeySort_Sort(SortKey *keys, uint32_t n, SortKey *scratch)
+{
+    if (!keys || n < 2) return;
+    if (n <= SORT_SMALL) {
+        insertion_sort(keys, n);
+        return;
+    }
+    if (!sort_nearly_sorted(keys, n, scratch)) {
+        sort_full(keys, n, scratch);
+    }
+}
+
+void KeySort_SelectFirst(SortKey *keys, uint32_t n, uint32_t k, SortKey *scratch)
+{
+    if (!keys || k == 0 || k >= n) return;
+
+    // Quickselect with median-of-three pivots. Sorting what is left of the range (small, or
+    // the pivots kept splitting badly) puts the boundary at k just the same.
+    uint32_t lo = 0;
+    uint32_t hi = n; // the boundary at k lies within [lo, hi)
+    uint32_t budget = 16;
+    for (uint32_t m = n; m > 1; m >>= 1) {
+        budget += 2;
+    }
+
+    while (hi - lo > SORT_SMALL && budget-- > 0) {
+        const uint32_t mid = lo + (hi - lo) / 2u;
+        if (SortKey_Cmp(&keys[mid], &keys[lo]) < 0) swap_keys(&keys[mid], &keys[lo]);
+        if (SortKey_Cmp(&keys[hi - 1], &keys[lo]) < 0) swap_keys(&keys[hi - 1], &keys[lo]);
+        if (SortKey_Cmp(&keys[hi - 1], &keys[mid]) < 0) swap_keys(&keys[hi - 1], &keys[mid]);
+
+        // keys[lo] <= pivot <= keys[hi - 1] bound both scans.
+        swap_keys(&keys[mid], &keys[hi - 2]);
+        const SortKey pivot = keys[hi - 2];
+        uint32_t i = lo;
+        uint32_t j = hi - 2;
+        for (;;) {
+            while (SortKey_Cmp(&keys[++i], &pivot) < 0) {
+            }
+            while (SortKey_Cmp(&pivot, &keys[--j]) < 0) {
+            }
+            if (i >= j) break;
+            swap_keys(&keys[i], &keys[j]);
+        }
+        swap_keys(&keys[i], &keys[hi - 2]);
+
+        if (i == k || i + 1u == k) return;
+        if (i > k) {
+            hi = i;
+        } else {
+            lo = i + 1u;
+        }
+    }
+    sort_full(keys + lo, hi - lo, scratch);
+}
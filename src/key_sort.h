@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Sorting by precomputed fixed-width keys. Each entry pairs a 128-bit unsigned key with
+// the index of the record it stands for; callers encode their whole ordering, tie-breakers
+// included, into the key, so sorting is integer work with no comparator callback and no
+// shared state. Any number of threads may sort (different arrays) at once.
+//
+// KeySort_Sort first tries the nearly-sorted path (rows whose keys moved are set aside,
+// sorted and merged back), then LSD radix sort over the key bytes that actually differ.
+// Inputs of KEY_SORT_PARALLEL_MIN entries or more are radix-sorted in chunks on worker
+// threads and merged.
+
+#ifndef KEY_SORT_PARALLEL_MIN
+#define KEY_SORT_PARALLEL_MIN 32768u
+#endif
+#define KEY_SORT_MAX_THREADS 8u
+
+typedef struct SortKey {
+    uint64_t hi;
+    uint64_t lo;
+    uint32_t index;
+} SortKey;
+
+static inline int SortKey_Cmp(const SortKey *a, const SortKey *b)
+{
+    if (a->hi != b->hi) return (a->hi < b->hi) ? -1 : 1;
+    if (a->lo != b->lo) return (a->lo < b->lo) ? -1 : 1;
+    return 0;
+}
+
+// Order-preserving map of a float onto unsigned integers (-0 and NaN map like 0).
+uint32_t SortKey_Float(float f);
+
+// Sorts keys ascending; scratch must hold n entries. Equal keys keep no particular order.
+void KeySort_Sort(SortKey *keys, uint32_t n, SortKey *scratch);
+
+// Moves the k smallest keys into keys[0, k), in no particular order. scratch as above.
+void KeySort_SelectFirst(SortKey *keys, uint32_t n, uint32_t k, SortKey *scratch);
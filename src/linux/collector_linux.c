@@ -0,0 +1,484 @@
+#include "../collector.h"
+
+#include "procfs.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef _countof
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+// Linux collectors backed by /proc and /sys. They fill the same CollectorSnapshot
+// fields as the Windows backend; the PDH system rates map as follows:
+//   context switches/sec  <- /proc/stat ctxt
+//   interrupts/sec        <- /proc/stat intr (first column = total)
+//   DPCs/sec              <- /proc/stat softirq (closest analog)
+//   processor queue len   <- /proc/stat procs_running
+
+// ---------------------------------------------------------------------------
+// /proc/stat: CPU usage + system rates
+
+typedef struct CpuTimes {
+    uint64_t total;
+    uint64_t idle; // idle + iowait
+} CpuTimes;
+
+typedef struct CpuState {
+    uint32_t logicalCount;
+    CpuTimes prevTotal;
+    CpuTimes *prevCore; // length = logicalCount
+    uint64_t prevCtxt;
+    uint64_t prevIntr;
+    uint64_t prevSoftirq;
+    bool primed;
+
+    char *buf;
+    size_t bufCap;
+} CpuState;
+
+static const char *parse_cpu_times(const char *p, CpuTimes *out)
+{
+    // user nice system idle iowait irq softirq steal
+    uint64_t v[8] = {0};
+    for (int i = 0; i < 8; i++) {
+        char *end = NULL;
+        const unsigned long long x = strtoull(p, &end, 10);
+        if (end == p) break;
+        v[i] = (uint64_t)x;
+        p = end;
+    }
+    out->total = v[0] + v[1] + v[2] + v[3] + v[4] + v[5] + v[6] + v[7];
+    out->idle = v[3] + v[4];
+    return p;
+}
+
+static float usage_pct(const CpuTimes *prev, const CpuTimes *cur)
+{
+    if (cur->total <= prev->total) return 0.0f;
+    const uint64_t dTotal = cur->total - prev->total;
+    const uint64_t dIdle = (cur->idle >= prev->idle) ? (cur->idle - prev->idle) : 0;
+    const uint64_t busy = (dTotal > dIdle) ? (dTotal - dIdle) : 0;
+    return (float)(100.0 * (double)busy / (double)dTotal);
+}
+
+static double rate_per_sec(uint64_t prev, uint64_t cur, double dt)
+{
+    if (dt <= 0.0 || cur < prev) return 0.0;
+    return (double)(cur - prev) / dt;
+}
+
+static bool cpu_init(void **outState, CollectorSnapshot *snap)
+{
+    CpuState *s = (CpuState *)calloc(1, sizeof(CpuState));
+    if (!s) return false;
+
+    s->logicalCount = snap->logicalCount;
+    s->prevCore = (CpuTimes *)calloc(s->logicalCount ? s->logicalCount : 1, sizeof(CpuTimes));
+    if (!s->prevCore) {
+        free(s);
+        return false;
+    }
+
+    *outState = s;
+    return true;
+}
+
+static bool cpu_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    CpuState *s = (CpuState *)state;
+
+    size_t len = 0;
+    if (!Procfs_ReadFile("/proc/stat", &s->buf, &s->bufCap, &len)) {
+        snap->hasCpu = false;
+        return false;
+    }
+
+    uint64_t ctxt = 0;
+    uint64_t intr = 0;
+    uint64_t softirq = 0;
+    uint64_t running = 0;
+
+    char *save = NULL;
+    for (char *line = strtok_r(s->buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        if (strncmp(line, "cpu", 3) == 0) {
+            CpuTimes t;
+            if (line[3] == ' ') {
+                parse_cpu_times(line + 3, &t);
+                if (s->primed) snap->totalCpu = usage_pct(&s->prevTotal, &t);
+                s->prevTotal = t;
+            } else {
+                char *end = NULL;
+                const unsigned long idx = strtoul(line + 3, &end, 10);
+                if (end == line + 3 || idx >= s->logicalCount) continue;
+                parse_cpu_times(end, &t);
+                snap->coreCpu[idx] = s->primed ? usage_pct(&s->prevCore[idx], &t) : 0.0f;
+                s->prevCore[idx] = t;
+            }
+        } else if (strncmp(line, "ctxt ", 5) == 0) {
+            ctxt = strtoull(line + 5, NULL, 10);
+        } else if (strncmp(line, "intr ", 5) == 0) {
+            intr = strtoull(line + 5, NULL, 10);
+        } else if (strncmp(line, "softirq ", 8) == 0) {
+            softirq = strtoull(line + 8, NULL, 10);
+        } else if (strncmp(line, "procs_running ", 14) == 0) {
+            running = strtoull(line + 14, NULL, 10);
+        }
+    }
+
+    if (s->primed) {
+        snap->rates.contextSwitchesPerSec = rate_per_sec(s->prevCtxt, ctxt, dt);
+        snap->rates.interruptsPerSec = rate_per_sec(s->prevIntr, intr, dt);
+        snap->rates.dpcsPerSec = rate_per_sec(s->prevSoftirq, softirq, dt);
+    }
+    snap->rates.processorQueueLength = (double)running;
+
+    s->prevCtxt = ctxt;
+    s->prevIntr = intr;
+    s->prevSoftirq = softirq;
+
+    // Like PDH rate counters, the first sample only establishes a baseline.
+    snap->hasCpu = s->primed;
+    s->primed = true;
+    return snap->hasCpu;
+}
+
+static void cpu_shutdown(void *state)
+{
+    CpuState *s = (CpuState *)state;
+    free(s->prevCore);
+    free(s->buf);
+    free(s);
+}
+
+static const CollectorOps kCpuCollector = {
+    L"procstat", cpu_init, cpu_sample, cpu_shutdown,
+    COLLECTOR_SECTION_CPU,
+    0.25, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+// cpufreq: per-core current/max MHz
+
+static bool cpufreq_init(void **outState, CollectorSnapshot *snap)
+{
+    *outState = NULL;
+
+    uint64_t khz = 0;
+    return snap->logicalCount > 0 &&
+           Procfs_ReadU64("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", &khz);
+}
+
+static bool cpufreq_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)state;
+    (void)dt;
+
+    bool any = false;
+    for (uint32_t i = 0; i < snap->logicalCount; i++) {
+        char path[96];
+        uint64_t khz = 0;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/scaling_cur_freq", (unsigned)i);
+        if (Procfs_ReadU64(path, &khz)) {
+            snap->coreMHz[i] = (float)((double)khz / 1000.0);
+            any = true;
+        }
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/cpuinfo_max_freq", (unsigned)i);
+        if (Procfs_ReadU64(path, &khz)) {
+            snap->coreMaxMHz[i] = (float)((double)khz / 1000.0);
+        }
+    }
+    return any;
+}
+
+static const CollectorOps kCpuFreqCollector = {
+    L"cpufreq", cpufreq_init, cpufreq_sample, NULL,
+    COLLECTOR_SECTION_CPU_FREQ,
+    0.25, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+// /proc/meminfo: physical memory + commit
+
+typedef struct MemState {
+    char *buf;
+    size_t bufCap;
+} MemState;
+
+static bool meminfo_init(void **outState, CollectorSnapshot *snap)
+{
+    (void)snap;
+    MemState *s = (MemState *)calloc(1, sizeof(MemState));
+    if (!s) return false;
+    *outState = s;
+    return true;
+}
+
+static bool meminfo_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)dt;
+    MemState *s = (MemState *)state;
+
+    size_t len = 0;
+    if (!Procfs_ReadFile("/proc/meminfo", &s->buf, &s->bufCap, &len)) {
+        snap->hasMemory = false;
+        snap->hasCommit = false;
+        return false;
+    }
+
+    uint64_t totalKb = 0, availKb = 0, committedKb = 0, limitKb = 0;
+    bool hasTotal = false, hasAvail = false, hasCommitted = false, hasLimit = false;
+
+    char *save = NULL;
+    for (char *line = strtok_r(s->buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        char *colon = strchr(line, ':');
+        if (!colon) continue;
+        *colon = 0;
+        const uint64_t v = strtoull(colon + 1, NULL, 10);
+
+        if (strcmp(line, "MemTotal") == 0) {
+            totalKb = v;
+            hasTotal = true;
+        } else if (strcmp(line, "MemAvailable") == 0) {
+            availKb = v;
+            hasAvail = true;
+        } else if (strcmp(line, "Committed_AS") == 0) {
+            committedKb = v;
+            hasCommitted = true;
+        } else if (strcmp(line, "CommitLimit") == 0) {
+            limitKb = v;
+            hasLimit = true;
+        }
+    }
+
+    snap->hasMemory = hasTotal && hasAvail;
+    if (snap->hasMemory) {
+        snap->memTotalPhysBytes = totalKb * 1024ull;
+        snap->memAvailPhysBytes = availKb * 1024ull;
+    }
+
+    snap->hasCommit = hasCommitted && hasLimit;
+    if (snap->hasCommit) {
+        snap->commitTotalBytes = committedKb * 1024ull;
+        snap->commitLimitBytes = limitKb * 1024ull;
+    }
+
+    return snap->hasMemory || snap->hasCommit;
+}
+
+static void meminfo_shutdown(void *state)
+{
+    MemState *s = (MemState *)state;
+    free(s->buf);
+    free(s);
+}
+
+static const CollectorOps kMemInfoCollector = {
+    L"meminfo", meminfo_init, meminfo_sample, meminfo_shutdown,
+    COLLECTOR_SECTION_MEMORY,
+    0.5, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+// /proc/diskstats: per-disk throughput (whole disks from /sys/block)
+
+typedef struct DiskState {
+    uint32_t count;
+    char (*devs)[32];
+    wchar_t (*names)[32];
+    const wchar_t **namePtrs;
+    uint64_t *prevReadSectors;
+    uint64_t *prevWriteSectors;
+    double *readBytesPerSec;
+    double *writeBytesPerSec;
+    bool primed;
+
+    char *buf;
+    size_t bufCap;
+} DiskState;
+
+static bool disk_is_virtual(const char *name)
+{
+    return strlen(name) >= sizeof(((DiskState *)0)->devs[0]) ||
+           strncmp(name, "loop", 4) == 0 || strncmp(name, "ram", 3) == 0 ||
+           strncmp(name, "zram", 4) == 0 || strncmp(name, "dm-", 3) == 0;
+}
+
+static void disk_free(DiskState *s)
+{
+    free(s->devs);
+    free(s->names);
+    free((void *)s->namePtrs);
+    free(s->prevReadSectors);
+    free(s->prevWriteSectors);
+    free(s->readBytesPerSec);
+    free(s->writeBytesPerSec);
+    free(s->buf);
+    free(s);
+}
+
+static bool disk_init(void **outState, CollectorSnapshot *snap)
+{
+    DIR *dir = opendir("/sys/block");
+    if (!dir) return false;
+
+    uint32_t count = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.' || disk_is_virtual(de->d_name)) continue;
+        count++;
+    }
+
+    DiskState *s = (DiskState *)calloc(1, sizeof(DiskState));
+    if (!s) {
+        closedir(dir);
+        return false;
+    }
+
+    const uint32_t cap = count ? count : 1;
+    s->devs = calloc(cap, sizeof(*s->devs));
+    s->names = calloc(cap, sizeof(*s->names));
+    s->namePtrs = (const wchar_t **)calloc(cap, sizeof(*s->namePtrs));
+    s->prevReadSectors = (uint64_t *)calloc(cap, sizeof(uint64_t));
+    s->prevWriteSectors = (uint64_t *)calloc(cap, sizeof(uint64_t));
+    s->readBytesPerSec = (double *)calloc(cap, sizeof(double));
+    s->writeBytesPerSec = (double *)calloc(cap, sizeof(double));
+    if (!s->devs || !s->names || !s->namePtrs || !s->prevReadSectors || !s->prevWriteSectors ||
+        !s->readBytesPerSec || !s->writeBytesPerSec) {
+        closedir(dir);
+        disk_free(s);
+        return false;
+    }
+
+    rewinddir(dir);
+    while ((de = readdir(dir)) != NULL && s->count < count) {
+        if (de->d_name[0] == '.' || disk_is_virtual(de->d_name)) continue;
+        memcpy(s->devs[s->count], de->d_name, strlen(de->d_name) + 1);
+        Procfs_Widen(s->names[s->count], _countof(s->names[0]), de->d_name, strlen(de->d_name));
+        s->namePtrs[s->count] = s->names[s->count];
+        s->count++;
+    }
+    closedir(dir);
+
+    if (s->count > 0) {
+        snap->diskCount = s->count;
+        snap->diskNames = s->namePtrs;
+        snap->diskReadBytesPerSec = s->readBytesPerSec;
+        snap->diskWriteBytesPerSec = s->writeBytesPerSec;
+    }
+
+    *outState = s;
+    return true;
+}
+
+static int disk_find(const DiskState *s, const char *dev)
+{
+    for (uint32_t i = 0; i < s->count; i++) {
+        if (strcmp(s->devs[i], dev) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static bool disk_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    DiskState *s = (DiskState *)state;
+
+    size_t len = 0;
+    if (!Procfs_ReadFile("/proc/diskstats", &s->buf, &s->bufCap, &len)) {
+        snap->hasPerDisk = false;
+        snap->rates.hasDisk = false;
+        return false;
+    }
+
+    double totalRead = 0.0;
+    double totalWrite = 0.0;
+
+    char *save = NULL;
+    for (char *line = strtok_r(s->buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        unsigned major = 0, minor = 0;
+        char dev[32];
+        unsigned long long rdIos, rdMerges, rdSectors, rdTicks, wrIos, wrMerges, wrSectors;
+        if (sscanf(line, "%u %u %31s %llu %llu %llu %llu %llu %llu %llu",
+                   &major, &minor, dev, &rdIos, &rdMerges, &rdSectors, &rdTicks, &wrIos, &wrMerges, &wrSectors) != 10) {
+            continue;
+        }
+
+        const int i = disk_find(s, dev);
+        if (i < 0) continue;
+
+        // diskstats sectors are always 512 bytes regardless of the device's sector size.
+        if (s->primed && dt > 0.0) {
+            s->readBytesPerSec[i] = rate_per_sec(s->prevReadSectors[i], (uint64_t)rdSectors, dt) * 512.0;
+            s->writeBytesPerSec[i] = rate_per_sec(s->prevWriteSectors[i], (uint64_t)wrSectors, dt) * 512.0;
+        }
+        s->prevReadSectors[i] = (uint64_t)rdSectors;
+        s->prevWriteSectors[i] = (uint64_t)wrSectors;
+
+        totalRead += s->readBytesPerSec[i];
+        totalWrite += s->writeBytesPerSec[i];
+    }
+
+    s->primed = true;
+
+    snap->hasPerDisk = s->count > 0;
+    snap->rates.hasDisk = true;
+    snap->rates.diskReadBytesPerSec = totalRead;
+    snap->rates.diskWriteBytesPerSec = totalWrite;
+    return true;
+}
+
+static void disk_shutdown(void *state)
+{
+    disk_free((DiskState *)state);
+}
+
+static const CollectorOps kDiskCollector = {
+    L"diskstats", disk_init, disk_sample, disk_shutdown,
+    COLLECTOR_SECTION_DISK,
+    0.5, 0.0,
+};
+
+// ---------------------------------------------------------------------------
+// Process table (/proc/<pid>/stat)
+
+static bool procs_init(void **outState, CollectorSnapshot *snap)
+{
+    *outState = NULL;
+    return snap->procs != NULL;
+}
+
+static bool procs_sample(void *state, double dt, CollectorSnapshot *snap)
+{
+    (void)state;
+    (void)dt;
+    ProcTable_Sample(snap->procs);
+    snap->hasProcs = true;
+    return true;
+}
+
+static const CollectorOps kProcsCollector = {
+    L"procs", procs_init, procs_sample, NULL,
+    COLLECTOR_SECTION_PROCS,
+    1.0, 0.125,
+};
+
+// ---------------------------------------------------------------------------
+
+static const CollectorOps *const kDefaultCollectors[] = {
+    &kCpuCollector,
+    &kCpuFreqCollector,
+    &kProcsCollector,
+    &kMemInfoCollector,
+    &kDiskCollector,
+};
+
+const CollectorOps *const *Collector_PlatformDefaults(uint32_t *outCount)
+{
+    if (outCount) *outCount = (uint32_t)_countof(kDefaultCollectors);
+    return kDefaultCollectors;
+}
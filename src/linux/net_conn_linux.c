@@ -0,0 +1,434 @@
+#include "../net_conn.h"
+
+#include "procfs.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../self_stats.h"
+
+// Linux NetConns_Refresh: /proc/net/{tcp,tcp6,udp,udp6} list the sockets of the network
+// namespace with their inode but no owner; the owner is the process holding a
+// "socket:[inode]" link in /proc/<pid>/fd. Reading every fd of every process each refresh
+// would cost more than the rest of sampling, so the inode -> pid map is kept between
+// refreshes and only the sockets it does not know yet are looked for:
+//   - in the processes whose fds were never read (new processes, one read each);
+//   - then, while some remain unresolved, in up to NET_FD_SCAN_BUDGET other processes,
+//     round-robin in ascending PID order (sockets opened by processes already read).
+// A socket still unresolved once the round-robin has gone all the way around from where it
+// stood when the socket was first looked for (one in another PID namespace, or of a
+// process whose fds cannot be read) is not looked for again; processes started meanwhile
+// were read as new ones. Sockets that closed drop out of the map, since it is rebuilt from
+// each listing.
+
+#ifndef NET_FD_SCAN_BUDGET
+#define NET_FD_SCAN_BUDGET 64u
+#endif
+
+// Where procfs is read from; the tests point it at a tree of their own.
+#ifndef NET_PROC_ROOT
+#define NET_PROC_ROOT "/proc"
+#endif
+
+#define INODE_NONE UINT32_MAX
+// Map values with this bit are sockets without a known owner: the round-robin cursor when
+// it was first looked for, with SEARCH_WRAPPED once the round-robin has since gone past the
+// highest PID; NOT_FOUND once it is no longer looked for (UNOWNED | NOT_FOUND is not
+// INODE_NONE, and PIDs stay far below SEARCH_FROM).
+#define UNOWNED 0x80000000u
+#define SEARCH_WRAPPED 0x40000000u
+#define SEARCH_FROM 0x3FFFFFFFu
+#define NOT_FOUND 0x7FFFFFFEu
+
+// Open-addressing map from socket inode (never 0) to a 32-bit value, at most half full.
+typedef struct InodeMap {
+    uint64_t *inodes; // 0 = empty slot
+    uint32_t *values;
+    uint32_t mask;
+} InodeMap;
+
+typedef struct NetLinux {
+    char *buf; // file contents
+    size_t bufCap;
+    uint64_t *connInodes; // per NetConns.conns entry
+    uint32_t *connSearch; // per entry: the search state of an unowned socket, as in the map
+    uint32_t connInodeCap;
+    InodeMap known;  // inode -> pid or UNOWNED | search state, from the previous listing
+    InodeMap wanted; // inode -> conn index, the sockets no map entry resolved
+    uint32_t unresolved;
+    bool wrapped; // this refresh's round-robin went past the highest PID
+    bool swept;   // this refresh's round-robin went over every process
+
+    uint32_t *pids; // processes of the last /proc walk, in ascending order
+    uint32_t pidCount;
+    uint32_t pidCap;
+    PidIndex scanned[2]; // pids whose fds have been read; [cur] is current
+    uint32_t cur;
+    uint32_t cursor; // round-robin position: the lowest PID it reads next
+} NetLinux;
+
+static uint32_t inode_hash(uint64_t inode)
+{
+    return (uint32_t)((inode * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static bool map_reset(InodeMap *m, uint32_t n)
+{
+    uint32_t slots = 64u;
+    while (slots < n * 2u) {
+        if (slots > (UINT32_MAX / 2u)) return false;
+        slots *= 2u;
+    }
+    if (!m->inodes || slots > m->mask + 1u) {
+        uint64_t *inodes = (uint64_t *)malloc((size_t)slots * sizeof(uint64_t));
+        uint32_t *values = (uint32_t *)malloc((size_t)slots * sizeof(uint32_t));
+        if (!inodes || !values) {
+            free(inodes);
+            free(values);
+            return false;
+        }
+        SelfStats_NoteAlloc();
+        free(m->inodes);
+        free(m->values);
+        m->inodes = inodes;
+        m->values = values;
+        m->mask = slots - 1u;
+    }
+    memset(m->inodes, 0, ((size_t)m->mask + 1u) * sizeof(uint64_t));
+    return true;
+}
+
+// The caller sized the map for every insert since the reset.
+static void map_put(InodeMap *m, uint64_t inode, uint32_t value)
+{
+    uint32_t i = inode_hash(inode) & m->mask;
+    while (m->inodes[i] != 0 && m->inodes[i] != inode) {
+        i = (i + 1u) & m->mask;
+    }
+    m->inodes[i] = inode;
+    m->values[i] = value;
+}
+
+static uint32_t map_get(const InodeMap *m, uint64_t inode)
+{
+    if (!m->inodes) return INODE_NONE;
+    uint32_t i = inode_hash(inode) & m->mask;
+    while (m->inodes[i] != 0) {
+        if (m->inodes[i] == inode) return m->values[i];
+        i = (i + 1u) & m->mask;
+    }
+    return INODE_NONE;
+}
+
+static void map_free(InodeMap *m)
+{
+    free(m->inodes);
+    free(m->values);
+    memset(m, 0, sizeof(*m));
+}
+
+static void free_backend(void *p)
+{
+    NetLinux *nl = (NetLinux *)p;
+    if (!nl) return;
+    free(nl->buf);
+    free(nl->connInodes);
+    free(nl->connSearch);
+    free(nl->pids);
+    map_free(&nl->known);
+    map_free(&nl->wanted);
+    PidIndex_Shutdown(&nl->scanned[0]);
+    PidIndex_Shutdown(&nl->scanned[1]);
+    free(nl);
+}
+
+static bool parse_hex(const char **p, uint32_t digits, uint32_t *out)
+{
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < digits; i++) {
+        const char c = (*p)[i];
+        uint32_t d;
+        if (c >= '0' && c <= '9') d = (uint32_t)(c - '0');
+        else if (c >= 'A' && c <= 'F') d = (uint32_t)(c - 'A' + 10);
+        else if (c >= 'a' && c <= 'f') d = (uint32_t)(c - 'a' + 10);
+        else return false;
+        v = (v << 4) | d;
+    }
+    *p += digits;
+    *out = v;
+    return true;
+}
+
+static const char *skip_field(const char *p)
+{
+    while (*p == ' ') p++;
+    while (*p && *p != ' ' && *p != '\n') p++;
+    return p;
+}
+
+// "ADDR:PORT": the address is printed as the 32-bit words the kernel holds (network byte
+// order in memory) in host order, so storing the parsed words back gives the bytes.
+static bool parse_endpoint(const char **p, uint8_t family, uint8_t *addr, uint16_t *port)
+{
+    while (**p == ' ') (*p)++;
+    const uint32_t words = (family == 4) ? 1u : 4u;
+    for (uint32_t w = 0; w < words; w++) {
+        uint32_t v;
+        if (!parse_hex(p, 8u, &v)) return false;
+        memcpy(addr + w * 4u, &v, sizeof(v));
+    }
+    uint32_t v;
+    if (**p != ':') return false;
+    (*p)++;
+    if (!parse_hex(p, 4u, &v)) return false;
+    *port = (uint16_t)v;
+    return true;
+}
+
+static bool add_inode(NetConns *nc, NetLinux *nl, uint64_t inode)
+{
+    if (nc->count > nl->connInodeCap) {
+        uint32_t cap = nl->connInodeCap ? nl->connInodeCap : 256u;
+        while (cap < nc->count) cap *= 2u;
+        uint64_t *p = (uint64_t *)realloc(nl->connInodes, (size_t)cap * sizeof(uint64_t));
+        if (!p) return false;
+        SelfStats_NoteAlloc();
+        nl->connInodes = p;
+        uint32_t *s = (uint32_t *)realloc(nl->connSearch, (size_t)cap * sizeof(uint32_t));
+        if (!s) return false;
+        SelfStats_NoteAlloc();
+        nl->connSearch = s;
+        nl->connInodeCap = cap;
+    }
+    nl->connInodes[nc->count - 1u] = inode;
+    nl->connSearch[nc->count - 1u] = 0;
+    return true;
+}
+
+// One /proc/net table: sl local remote st queues timers retransmits uid timeout inode.
+static bool read_table(NetConns *nc, NetLinux *nl, const char *path, uint8_t proto, uint8_t family)
+{
+    size_t len = 0;
+    if (!Procfs_ReadFile(path, &nl->buf, &nl->bufCap, &len)) return false;
+
+    const char *line = strchr(nl->buf, '\n'); // header
+    while (line && *++line) {
+        const char *p = skip_field(line); // sl
+        NetConn c;
+        memset(&c, 0, sizeof(c));
+        uint8_t local[16];
+        uint16_t localPort;
+        uint32_t st;
+        if (!parse_endpoint(&p, family, local, &localPort) || !parse_endpoint(&p, family, c.remote, &c.remotePort)) {
+            line = strchr(line, '\n');
+            continue;
+        }
+        while (*p == ' ') p++;
+        if (!parse_hex(&p, 2u, &st)) st = 0;
+        for (int f = 0; f < 5; f++) {
+            p = skip_field(p); // queues, timers, retransmits, uid, timeout
+        }
+        const uint64_t inode = strtoull(p, NULL, 10);
+
+        c.proto = proto;
+        c.family = family;
+        if (st == 0x01) c.state = NET_STATE_ESTABLISHED;
+        else if (st == 0x0A && proto == NET_PROTO_TCP) c.state = NET_STATE_LISTEN;
+        else c.state = NET_STATE_OTHER;
+
+        // Sockets in TIME_WAIT belong to no process (inode 0).
+        const uint32_t before = nc->count;
+        if (inode != 0) {
+            NetConns_Add(nc, &c);
+            if (nc->count != before && !add_inode(nc, nl, inode)) nc->count = before;
+        }
+        line = strchr(line, '\n');
+    }
+    return true;
+}
+
+// Reads /proc/<pid>/fd and assigns the wanted sockets found there to pid.
+static void scan_fds(NetConns *nc, NetLinux *nl, uint32_t pid)
+{
+    char path[sizeof(NET_PROC_ROOT) + 24];
+    snprintf(path, sizeof(path), NET_PROC_ROOT "/%u/fd", (unsigned)pid);
+    DIR *dir = opendir(path); // fails for other users' processes unless privileged
+    if (!dir) return;
+
+    const int dfd = dirfd(dir);
+    struct dirent *de;
+    while (nl->unresolved > 0 && (de = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)de->d_name[0])) continue;
+        char target[64];
+        const ssize_t n = readlinkat(dfd, de->d_name, target, sizeof(target) - 1);
+        if (n <= 8 || memcmp(target, "socket:[", 8) != 0) continue;
+        target[n] = 0;
+
+        const uint64_t inode = strtoull(target + 8, NULL, 10);
+        const uint32_t ci = map_get(&nl->wanted, inode);
+        if (ci == INODE_NONE || nc->conns[ci].pid != 0) continue;
+        nc->conns[ci].pid = pid;
+        nl->unresolved--;
+    }
+    closedir(dir);
+}
+
+static int cmp_pid(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool list_pids(NetLinux *nl)
+{
+    DIR *dir = opendir(NET_PROC_ROOT);
+    if (!dir) return false;
+    nl->pidCount = 0;
+    bool sorted = true; // procfs lists PIDs in ascending order
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)de->d_name[0])) continue;
+        const uint32_t pid = (uint32_t)strtoul(de->d_name, NULL, 10);
+        if (pid == 0) continue;
+        if (nl->pidCount == nl->pidCap) {
+            const uint32_t cap = nl->pidCap ? nl->pidCap * 2u : 512u;
+            uint32_t *p = (uint32_t *)realloc(nl->pids, (size_t)cap * sizeof(uint32_t));
+            if (!p) break;
+            SelfStats_NoteAlloc();
+            nl->pids = p;
+            nl->pidCap = cap;
+        }
+        if (nl->pidCount > 0 && nl->pids[nl->pidCount - 1u] > pid) sorted = false;
+        nl->pids[nl->pidCount++] = pid;
+    }
+    closedir(dir);
+    if (!sorted) qsort(nl->pids, nl->pidCount, sizeof(uint32_t), cmp_pid);
+    return true;
+}
+
+// Finds the owners of the sockets the known map did not resolve.
+static void resolve_wanted(NetConns *nc, NetLinux *nl)
+{
+    if (!list_pids(nl)) return;
+
+    const PidIndex *was = &nl->scanned[nl->cur];
+    PidIndex *now = &nl->scanned[nl->cur ^ 1u];
+    if (!PidIndex_Reset(now, nl->pidCount)) return;
+
+    // Processes never read first. The new index holds the live processes read before (0)
+    // and those read now (1); one left out is still unread.
+    for (uint32_t i = 0; i < nl->pidCount; i++) {
+        const uint32_t pid = nl->pids[i];
+        if (PidIndex_FindPid(was, pid) != PID_INDEX_NONE) {
+            (void)PidIndex_Insert(now, pid, 0, 0u);
+        } else if (nl->unresolved > 0) {
+            scan_fds(nc, nl, pid);
+            (void)PidIndex_Insert(now, pid, 0, 1u);
+        }
+    }
+
+    // Then a bounded round-robin over the others, from the first PID at the cursor on.
+    uint32_t lo = 0;
+    uint32_t hi = nl->pidCount;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2u;
+        if (nl->pids[mid] < nl->cursor) lo = mid + 1u;
+        else hi = mid;
+    }
+    uint32_t budget = NET_FD_SCAN_BUDGET;
+    uint32_t k = 0;
+    for (; k < nl->pidCount && budget > 0 && nl->unresolved > 0; k++) {
+        uint32_t i = lo + k;
+        if (i >= nl->pidCount) {
+            i -= nl->pidCount;
+            if (i == 0) nl->wrapped = true;
+        }
+        if (PidIndex_FindPid(now, nl->pids[i]) != 0u) continue; // read above, or unread
+        scan_fds(nc, nl, nl->pids[i]);
+        budget--;
+        nl->cursor = nl->pids[i] + 1u;
+    }
+    nl->swept = (k == nl->pidCount);
+    nl->cur ^= 1u;
+}
+
+// The search state of a socket still unresolved after this refresh: NOT_FOUND once the
+// round-robin has been all the way around since the search started.
+static uint32_t search_next(const NetLinux *nl, uint32_t search)
+{
+    if (search == NOT_FOUND || nl->swept) return NOT_FOUND;
+    bool wrapped = (search & SEARCH_WRAPPED) != 0;
+    if (nl->wrapped) {
+        if (wrapped) return NOT_FOUND;
+        wrapped = true;
+    }
+    const uint32_t from = search & SEARCH_FROM;
+    if (wrapped && nl->cursor >= from) return NOT_FOUND;
+    return (wrapped ? SEARCH_WRAPPED : 0u) | from;
+}
+
+void NetConns_Refresh(NetConns *nc, int64_t nowQpc)
+{
+    if (!nc) return;
+    if (!nc->backend) {
+        nc->backend = calloc(1, sizeof(NetLinux));
+        if (!nc->backend) {
+            NetConns_Fail(nc, nowQpc);
+            return;
+        }
+        SelfStats_NoteAlloc();
+        nc->freeBackend = free_backend;
+    }
+    NetLinux *nl = (NetLinux *)nc->backend;
+
+    // The v6 tables are missing when IPv6 is disabled.
+    NetConns_Begin(nc);
+    bool any = read_table(nc, nl, NET_PROC_ROOT "/net/tcp", NET_PROTO_TCP, 4);
+    any |= read_table(nc, nl, NET_PROC_ROOT "/net/tcp6", NET_PROTO_TCP, 6);
+    any |= read_table(nc, nl, NET_PROC_ROOT "/net/udp", NET_PROTO_UDP, 4);
+    any |= read_table(nc, nl, NET_PROC_ROOT "/net/udp6", NET_PROTO_UDP, 6);
+
+    // Owners from the previous listing, then look for the rest; a socket new to the map
+    // is looked for from where the round-robin stands.
+    nl->unresolved = 0;
+    nl->wrapped = false;
+    nl->swept = false;
+    const uint32_t from = nl->cursor & SEARCH_FROM;
+    if (!any || !map_reset(&nl->wanted, nc->count)) {
+        NetConns_Fail(nc, nowQpc);
+        return;
+    }
+    for (uint32_t i = 0; i < nc->count; i++) {
+        const uint64_t inode = nl->connInodes[i];
+        const uint32_t v = map_get(&nl->known, inode);
+        if (v == INODE_NONE || ((v & UNOWNED) && (v & ~UNOWNED) != NOT_FOUND)) {
+            nl->connSearch[i] = (v == INODE_NONE) ? from : (v & ~UNOWNED);
+            if (map_get(&nl->wanted, inode) == INODE_NONE) {
+                map_put(&nl->wanted, inode, i);
+                nl->unresolved++;
+            }
+        } else if (v & UNOWNED) {
+            nl->connSearch[i] = NOT_FOUND;
+        } else {
+            nc->conns[i].pid = v;
+        }
+    }
+    if (nl->unresolved > 0) {
+        resolve_wanted(nc, nl);
+    }
+
+    // The map for the next refresh holds the sockets listed now.
+    if (map_reset(&nl->known, nc->count)) {
+        for (uint32_t i = 0; i < nc->count; i++) {
+            uint32_t v = nc->conns[i].pid;
+            if (v == 0) v = UNOWNED | search_next(nl, nl->connSearch[i]);
+            map_put(&nl->known, nl->connInodes[i], v);
+        }
+    }
+    NetConns_End(nc, nowQpc);
+}
@@ -0,0 +1,378 @@
+#include "../proc_table.h"
+
+#include "../qpc.h"
+#include "procfs.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifndef _countof
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+// Linux ProcTable_Sample: walks /proc/<pid>/stat, probing processes on the walk threads.
+// CPU times are converted from clock ticks to 100ns units so the shared CPU% math
+// (process delta / system delta) matches the Windows backend.
+//
+// The handle cache keeps each process's stat file open: it is the only file read every
+// sample, and a descriptor of /proc/<pid>/stat stays bound to that process (reads fail
+// with ESRCH once it exits, even if the PID is reused), so a cached one is re-read with
+// pread and never confused with a newer process.
+
+static uint64_t get_system_total_time_100ns(void)
+{
+    char buf[512];
+    if (Procfs_ReadSmall("/proc/stat", buf, sizeof(buf)) <= 0) {
+        return 0;
+    }
+    if (strncmp(buf, "cpu ", 4) != 0) {
+        return 0;
+    }
+
+    // user nice system idle iowait irq softirq steal (guest time is already in user/nice)
+    uint64_t total = 0;
+    const char *p = buf + 4;
+    for (int i = 0; i < 8; i++) {
+        char *end = NULL;
+        const unsigned long long v = strtoull(p, &end, 10);
+        if (end == p) break;
+        total += (uint64_t)v;
+        p = end;
+    }
+    return Procfs_TicksTo100ns(total);
+}
+
+// uid -> user name. getpwuid_r reads /etc/passwd (or asks NSS) on every call; processes
+// run under a handful of uids. Only the sampler thread samples (the walk threads only
+// read uids; names are looked up while merging).
+#define UID_CACHE_CAP 32u
+
+typedef struct UidName {
+    uid_t uid;
+    wchar_t name[96];
+} UidName;
+
+static UidName s_uidCache[UID_CACHE_CAP];
+static uint32_t s_uidCacheCount;
+static uint32_t s_uidCacheNext; // round-robin victim once full
+
+static void lookup_uid_name(uid_t uid, wchar_t *out, size_t outCount)
+{
+    for (uint32_t i = 0; i < s_uidCacheCount; i++) {
+        if (s_uidCache[i].uid == uid) {
+            wcsncpy(out, s_uidCache[i].name, outCount - 1);
+            out[outCount - 1] = 0;
+            return;
+        }
+    }
+
+    const uint32_t slot = (s_uidCacheCount < UID_CACHE_CAP) ? s_uidCacheCount++ : (s_uidCacheNext++ % UID_CACHE_CAP);
+    UidName *e = &s_uidCache[slot];
+    e->uid = uid;
+
+    char pwbuf[1024];
+    struct passwd pw;
+    struct passwd *res = NULL;
+    if (getpwuid_r(uid, &pw, pwbuf, sizeof(pwbuf), &res) == 0 && res && res->pw_name) {
+        Procfs_Widen(e->name, _countof(e->name), res->pw_name, strlen(res->pw_name));
+    } else {
+        swprintf(e->name, _countof(e->name), L"%u", (unsigned)uid);
+    }
+    wcsncpy(out, e->name, outCount - 1);
+    out[outCount - 1] = 0;
+}
+
+// Owner uid of a process: the real uid on the Uid: line of /proc/<pid>/status. The owner
+// of the /proc/<pid> files is not it: procfs reports root for non-dumpable processes
+// (ssh-agent, setuid children). Read once per process, on first sight.
+static bool get_process_uid(uint32_t pid, uid_t *out)
+{
+    char path[64];
+    char buf[1024];
+    snprintf(path, sizeof(path), "/proc/%u/status", (unsigned)pid);
+    if (Procfs_ReadSmall(path, buf, sizeof(buf)) <= 0) {
+        return false;
+    }
+    const char *p = strstr(buf, "\nUid:");
+    if (!p) {
+        return false;
+    }
+    char *end = NULL;
+    const unsigned long uid = strtoul(p + 5, &end, 10);
+    if (end == p + 5) {
+        return false;
+    }
+    *out = (uid_t)uid;
+    return true;
+}
+
+static void close_stat_fd(intptr_t handle)
+{
+    close((int)handle);
+}
+
+// How many stat descriptors the cache may hold. Raises the soft descriptor limit toward
+// the hard one first (the default soft limit of 1024 fits only a few hundred processes)
+// and leaves headroom for everything else the process opens.
+#define PROC_FD_HEADROOM 1024u
+
+static uint32_t handle_budget(void)
+{
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) {
+        return 0;
+    }
+    const rlim_t want = (rlim_t)PROC_HANDLE_CACHE_CAP + PROC_FD_HEADROOM;
+    if (rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < want) {
+        struct rlimit raised = rl;
+        raised.rlim_cur = (rl.rlim_max == RLIM_INFINITY || rl.rlim_max > want) ? want : rl.rlim_max;
+        if (raised.rlim_cur > rl.rlim_cur && setrlimit(RLIMIT_NOFILE, &raised) == 0) {
+            rl = raised;
+        }
+    }
+    if (rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur >= want) {
+        return PROC_HANDLE_CACHE_CAP;
+    }
+    return (rl.rlim_cur > 2u * PROC_FD_HEADROOM) ? (uint32_t)(rl.rlim_cur - PROC_FD_HEADROOM) : (uint32_t)(rl.rlim_cur / 4u);
+}
+
+// Executable path into text; PROC_WALK_NO_TEXT when unreadable.
+static uint32_t get_process_path(uint32_t pid, ProcWalkText *text)
+{
+    char link[64];
+    snprintf(link, sizeof(link), "/proc/%u/exe", (unsigned)pid);
+    char target[MAX_PATH * 4];
+    const ssize_t n = readlink(link, target, sizeof(target) - 1);
+    if (n <= 0) {
+        return PROC_WALK_NO_TEXT;
+    }
+    wchar_t path[MAX_PATH];
+    Procfs_Widen(path, _countof(path), target, (size_t)n);
+    return ProcWalkText_Add(text, path, (uint32_t)wcslen(path));
+}
+
+// What the walk reads about one process, merged into its row afterwards.
+typedef struct LinuxProbe {
+    uint32_t pid;
+    uint32_t keep; // slow-tier PrevPidTime entry whose last row stands (PID_INDEX_NONE: probe)
+    int statFd;    // newly opened stat descriptor holding a cache slot for the merge (-1)
+    bool ok;       // stat was read (false: exited since listed)
+    bool hasAttrs; // the probe read path and owner (first sight of the process)
+    bool hasUid;
+    uint8_t thread; // walk text holding the strings
+    uint32_t nameText;
+    uint32_t pathText;
+    uid_t uid;
+    uint64_t ticks; // utime + stime
+    uint64_t createTime;
+    uint64_t rssBytes;
+} LinuxProbe;
+
+// Parses /proc/<pid>/stat into the probe.
+static bool parse_process_stat(LinuxProbe *pr, const char *buf, ProcWalkText *text, uint64_t pageSize)
+{
+    ProcfsStat st;
+    if (!Procfs_ParseStat(buf, &st)) {
+        return false;
+    }
+    wchar_t name[64];
+    Procfs_Widen(name, _countof(name), st.comm, st.commLen);
+    pr->nameText = ProcWalkText_Add(text, name, (uint32_t)wcslen(name));
+
+    pr->rssBytes = st.rssPages * pageSize;
+    pr->createTime = Procfs_TicksTo100ns(st.startTicks); // since boot; only compared, never shown
+    pr->ticks = st.ticks;
+    return true;
+}
+
+typedef struct LinuxWalk {
+    ProcTable *pt;
+    LinuxProbe *probes;
+    uint64_t pageSize;
+} LinuxWalk;
+
+static void probe_processes(void *ctx, uint32_t first, uint32_t end, ProcWalkText *text)
+{
+    const LinuxWalk *w = (const LinuxWalk *)ctx;
+    ProcTable *pt = w->pt;
+    for (uint32_t i = first; i < end; i++) {
+        LinuxProbe *pr = &w->probes[i];
+        pr->thread = (uint8_t)(text - pt->walkText);
+        if (pr->keep != PID_INDEX_NONE) continue;
+
+        // A cached descriptor that fails belongs to a process that has exited; the listed
+        // PID is then a newer process, opened afresh (the stale descriptor is closed when
+        // its entry leaves the table).
+        char buf[1024];
+        int fd = -1;
+        const intptr_t cached = ProcTable_CachedHandle(pt, pr->pid);
+        if (cached == PROC_HANDLE_NONE || Procfs_ReadSmallFd((int)cached, buf, sizeof(buf)) <= 0) {
+            char path[64];
+            snprintf(path, sizeof(path), "/proc/%u/stat", (unsigned)pr->pid);
+            fd = open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0 || Procfs_ReadSmallFd(fd, buf, sizeof(buf)) <= 0) {
+                if (fd >= 0) close(fd);
+                continue;
+            }
+        }
+        pr->ok = parse_process_stat(pr, buf, text, w->pageSize);
+
+        // The executable and owner are fixed for the life of the process: read them once.
+        if (pr->ok) {
+            const uint32_t pidx = PidIndex_Find(&pt->prevIndex, pr->pid, pr->createTime);
+            if (pidx == PID_INDEX_NONE || !pt->prev[pidx].hasAttrs) {
+                pr->pathText = get_process_path(pr->pid, text);
+                pr->hasUid = get_process_uid(pr->pid, &pr->uid);
+                pr->hasAttrs = true;
+            }
+        }
+
+        if (fd >= 0) {
+            if (pr->ok && ProcTable_HandleReserve(pt)) {
+                pr->statFd = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+}
+
+// Closes the descriptors of probes [first, count) the merge did not get to.
+static void drop_probe_fds(ProcTable *pt, const LinuxProbe *probes, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < count; i++) {
+        if (probes[i].statFd >= 0) {
+            close(probes[i].statFd);
+            ProcTable_HandleRelease(pt);
+        }
+    }
+}
+
+static uint32_t intern_text(ProcTable *pt, const LinuxProbe *pr, uint32_t offset)
+{
+    if (offset == PROC_WALK_NO_TEXT) return STR_POOL_EMPTY;
+    return StrPool_Intern(&pt->strings, ProcWalkText_Get(&pt->walkText[pr->thread], offset));
+}
+
+// Lists the numeric /proc entries into probes; returns how many.
+static uint32_t list_processes(ProcTable *pt, DIR *dir)
+{
+    uint32_t count = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)de->d_name[0])) continue;
+
+        const uint32_t pid = (uint32_t)strtoul(de->d_name, NULL, 10);
+        if (pid == 0) continue;
+
+        LinuxProbe *probes = (LinuxProbe *)ProcTable_WalkProbes(pt, count + 1u, sizeof(LinuxProbe));
+        if (!probes) {
+            // Out of memory; keep partial list.
+            break;
+        }
+        memset(&probes[count], 0, sizeof(LinuxProbe));
+        probes[count].pid = pid;
+        probes[count].keep = ProcTable_SlowTier(pt, pid);
+        probes[count].statFd = -1;
+        probes[count].nameText = PROC_WALK_NO_TEXT;
+        probes[count].pathText = PROC_WALK_NO_TEXT;
+        count++;
+    }
+    return count;
+}
+
+void ProcTable_Sample(ProcTable *pt)
+{
+    if (!pt) return;
+    if (!pt->closeHandle) {
+        pt->closeHandle = close_stat_fd;
+        pt->handleCap = handle_budget();
+    }
+
+    const uint64_t sysTotal = get_system_total_time_100ns();
+
+    const int64_t now = Qpc_Now();
+    if (NetConns_RefreshDue(&pt->net, now)) {
+        NetConns_Refresh(&pt->net, now);
+    }
+
+    DIR *dir = opendir("/proc");
+    if (!dir) {
+        pt->prevSysTotal100ns = sysTotal;
+        ProcTable_PrevFail(pt);
+        return;
+    }
+
+    ProcTable_PrevBegin(pt);
+    ProcTable_WalkBegin(pt);
+    const uint32_t count = list_processes(pt, dir);
+    closedir(dir);
+
+    // Probe (stat, and the attributes of new processes) in parallel, merge in list order.
+    static long s_pageSize = 0;
+    if (s_pageSize <= 0) {
+        s_pageSize = sysconf(_SC_PAGESIZE);
+        if (s_pageSize <= 0) s_pageSize = 4096;
+    }
+    LinuxWalk walk = {pt, (LinuxProbe *)pt->walkProbes, (uint64_t)s_pageSize};
+    ProcTable_Walk(pt, count, probe_processes, &walk);
+
+    pt->rowCount = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const LinuxProbe *pr = &walk.probes[i];
+        if (!pr->ok && pr->keep == PID_INDEX_NONE) {
+            // Exited between readdir and open.
+            continue;
+        }
+
+        if (!ProcTable_EnsureRows(pt, pt->rowCount + 1)) {
+            // Out of memory; keep partial list.
+            drop_probe_fds(pt, walk.probes, i, count);
+            break;
+        }
+
+        ProcRow r;
+        if (pr->keep != PID_INDEX_NONE) {
+            ProcTable_PrevKeep(pt, pr->keep, &r);
+            ProcTable_FillNet(pt, &r);
+            pt->rows[pt->rowCount++] = r;
+            continue;
+        }
+
+        memset(&r, 0, sizeof(r));
+        r.pid = pr->pid;
+        r.nameId = intern_text(pt, pr, pr->nameText);
+        r.workingSetBytes = pr->rssBytes;
+        r.createTime = pr->createTime;
+
+        const uint64_t procTotal = Procfs_TicksTo100ns(pr->ticks);
+        const uint32_t pidx = ProcTable_PrevFindOrAdd(pt, pr->pid, r.createTime);
+        r.cpuPct = ProcTable_PrevCpu(pt, pidx, procTotal, sysTotal);
+        if (pr->statFd >= 0) ProcTable_KeepHandle(pt, pidx, pr->statFd);
+
+        if (!pt->prev[pidx].hasAttrs) {
+            wchar_t owner[96];
+            owner[0] = 0;
+            if (pr->hasUid) lookup_uid_name(pr->uid, owner, _countof(owner));
+            pt->prev[pidx].pathId = intern_text(pt, pr, pr->hasAttrs ? pr->pathText : PROC_WALK_NO_TEXT);
+            pt->prev[pidx].ownerId = StrPool_Intern(&pt->strings, owner);
+            pt->prev[pidx].hasAttrs = true;
+        }
+        r.pathId = pt->prev[pidx].pathId;
+        r.ownerId = pt->prev[pidx].ownerId;
+
+        ProcTable_FillNet(pt, &r);
+
+        pt->rows[pt->rowCount++] = r;
+    }
+
+    pt->prevSysTotal100ns = sysTotal;
+    ProcTable_PrevEnd(pt);
+}
@@ -0,0 +1,155 @@
+#include "../proc_watch.h"
+
+#include "procfs.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../self_stats.h"
+
+// Linux watch source. At watch rates a stat-tick CPU time (10 ms at the usual CLK_TCK)
+// would quantize CPU% to a few steps, so CPU time comes from the process CPU clock
+// (clock_getcpuclockid: all threads, ns resolution). The rest is read from files kept open
+// for the life of the watch, re-read from offset 0 each tick:
+//   - statm: resident pages (working set). Its descriptor stays bound to the process and
+//     fails with ESRCH once it exits, which also rules out a CPU clock reading taken from
+//     a reused PID;
+//   - io: rchar + wchar, every byte read and written (the Windows transfer counts);
+//   - task/*/status: voluntary + nonvoluntary context switches, per thread in procfs, so
+//     summed over the threads listed by the kept task directory.
+
+typedef struct LinuxWatch {
+    clockid_t clock;
+    bool hasClock;
+    int statmFd;
+    int statFd; // CPU time fallback when the CPU clock is unavailable
+    int ioFd;
+    DIR *tasks;
+    uint64_t pageSize;
+} LinuxWatch;
+
+static uint64_t field_after(const char *buf, const char *key)
+{
+    const char *p = strstr(buf, key);
+    return p ? strtoull(p + strlen(key), NULL, 10) : 0;
+}
+
+static bool read_ctx_switches(LinuxWatch *lw, uint64_t *out)
+{
+    rewinddir(lw->tasks);
+    const int dirFd = dirfd(lw->tasks);
+    uint64_t sum = 0;
+    uint32_t threads = 0;
+    char buf[2048];
+    const struct dirent *de;
+    while ((de = readdir(lw->tasks)) != NULL) {
+        if (de->d_name[0] < '0' || de->d_name[0] > '9') continue;
+        char path[sizeof(de->d_name) + 8];
+        snprintf(path, sizeof(path), "%s/status", de->d_name);
+        const int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue; // thread exited since the listing
+        const long n = Procfs_ReadSmallFd(fd, buf, sizeof(buf));
+        close(fd);
+        if (n <= 0) continue;
+        sum += field_after(buf, "\nvoluntary_ctxt_switches:") + field_after(buf, "\nnonvoluntary_ctxt_switches:");
+        threads++;
+    }
+    *out = sum;
+    return threads > 0;
+}
+
+static void close_watch(void *source)
+{
+    LinuxWatch *lw = (LinuxWatch *)source;
+    if (!lw) return;
+    if (lw->statmFd >= 0) close(lw->statmFd);
+    if (lw->statFd >= 0) close(lw->statFd);
+    if (lw->ioFd >= 0) close(lw->ioFd);
+    if (lw->tasks) closedir(lw->tasks);
+    free(lw);
+}
+
+static void *open_watch(uint32_t pid, uint64_t *outCreateTime)
+{
+    LinuxWatch *lw = (LinuxWatch *)calloc(1, sizeof(*lw));
+    if (!lw) return NULL;
+    SelfStats_NoteAlloc();
+    lw->statmFd = -1;
+    lw->ioFd = -1;
+    lw->pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+    lw->statFd = open(path, O_RDONLY | O_CLOEXEC);
+    char buf[1024];
+    ProcfsStat st;
+    if (lw->statFd < 0 || Procfs_ReadSmallFd(lw->statFd, buf, sizeof(buf)) <= 0 || !Procfs_ParseStat(buf, &st)) {
+        close_watch(lw);
+        return NULL;
+    }
+    *outCreateTime = Procfs_TicksTo100ns(st.startTicks); // as the process table keys the row
+
+    snprintf(path, sizeof(path), "/proc/%u/statm", pid);
+    lw->statmFd = open(path, O_RDONLY | O_CLOEXEC);
+    snprintf(path, sizeof(path), "/proc/%u/io", pid);
+    lw->ioFd = open(path, O_RDONLY | O_CLOEXEC); // needs ptrace access; may be refused
+    snprintf(path, sizeof(path), "/proc/%u/task", pid);
+    lw->tasks = opendir(path);
+    if (lw->statmFd < 0) {
+        close_watch(lw);
+        return NULL;
+    }
+
+    struct timespec ts;
+    lw->hasClock = (clock_getcpuclockid((pid_t)pid, &lw->clock) == 0 && clock_gettime(lw->clock, &ts) == 0);
+    if (lw->hasClock) {
+        close(lw->statFd);
+        lw->statFd = -1;
+    }
+    return lw;
+}
+
+static bool read_watch(void *source, ProcWatchReading *out)
+{
+    LinuxWatch *lw = (LinuxWatch *)source;
+    char buf[512];
+
+    if (lw->hasClock) {
+        struct timespec ts;
+        if (clock_gettime(lw->clock, &ts) != 0) return false;
+        out->cpuTime100ns = ((uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec) / 100u;
+    } else {
+        ProcfsStat st;
+        if (Procfs_ReadSmallFd(lw->statFd, buf, sizeof(buf)) <= 0 || !Procfs_ParseStat(buf, &st)) {
+            return false;
+        }
+        out->cpuTime100ns = Procfs_TicksTo100ns(st.ticks);
+    }
+
+    // After the clock: a failure here means the process is gone, whatever the clock read.
+    if (Procfs_ReadSmallFd(lw->statmFd, buf, sizeof(buf)) <= 0) return false;
+    const char *p = buf;
+    (void)strtoull(p, (char **)&p, 10); // size
+    out->workingSetBytes = strtoull(p, NULL, 10) * lw->pageSize;
+
+    if (lw->ioFd >= 0 && Procfs_ReadSmallFd(lw->ioFd, buf, sizeof(buf)) > 0) {
+        out->ioBytes = field_after(buf, "rchar:") + field_after(buf, "\nwchar:");
+        out->hasIo = true;
+    }
+    if (lw->tasks) {
+        out->hasCtx = read_ctx_switches(lw, &out->ctxSwitches);
+    }
+    return true;
+}
+
+static const ProcWatchOps s_ops = {open_watch, read_watch, close_watch, NULL};
+
+const ProcWatchOps *ProcWatch_PlatformOps(void)
+{
+    return &s_ops;
+}
@@ -0,0 +1,154 @@
+#include "procfs.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+
+#include "../self_stats.h"
+#include "../sys_thread.h"
+
+bool Procfs_ReadFile(const char *path, char **buf, size_t *cap, size_t *outLen)
+{
+    if (outLen) *outLen = 0;
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    if (!*buf || *cap < 4096) {
+        const size_t newCap = (*cap < 4096) ? 4096 : *cap;
+        char *p = (char *)realloc(*buf, newCap);
+        if (!p) {
+            close(fd);
+            return false;
+        }
+        *buf = p;
+        *cap = newCap;
+        SelfStats_NoteAlloc();
+    }
+
+    // procfs files report size 0, so read until EOF and grow as needed.
+    size_t len = 0;
+    for (;;) {
+        if (len + 1 >= *cap) {
+            const size_t newCap = *cap * 2;
+            char *p = (char *)realloc(*buf, newCap);
+            if (!p) {
+                close(fd);
+                return false;
+            }
+            *buf = p;
+            *cap = newCap;
+            SelfStats_NoteAlloc();
+        }
+
+        const ssize_t n = read(fd, *buf + len, *cap - len - 1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            return false;
+        }
+        if (n == 0) break;
+        len += (size_t)n;
+    }
+
+    close(fd);
+    (*buf)[len] = 0;
+    if (outLen) *outLen = len;
+    return true;
+}
+
+long Procfs_ReadSmall(const char *path, char *buf, size_t cap)
+{
+    if (!buf || cap == 0) return -1;
+    buf[0] = 0;
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t n;
+    do {
+        n = read(fd, buf, cap - 1);
+    } while (n < 0 && errno == EINTR);
+    close(fd);
+
+    if (n < 0) return -1;
+    buf[n] = 0;
+    return (long)n;
+}
+
+long Procfs_ReadSmallFd(int fd, char *buf, size_t cap)
+{
+    if (!buf || cap == 0 || fd < 0) return -1;
+    buf[0] = 0;
+
+    ssize_t n;
+    do {
+        n = pread(fd, buf, cap - 1, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) return -1;
+    buf[n] = 0;
+    return (long)n;
+}
+
+bool Procfs_ReadU64(const char *path, uint64_t *out)
+{
+    char buf[64];
+    if (Procfs_ReadSmall(path, buf, sizeof(buf)) <= 0) return false;
+
+    char *end = NULL;
+    const unsigned long long v = strtoull(buf, &end, 10);
+    if (end == buf) return false;
+    *out = (uint64_t)v;
+    return true;
+}
+
+void Procfs_Widen(wchar_t *dst, size_t dstCount, const char *src, size_t srcLen)
+{
+    if (!dst || dstCount == 0) return;
+    size_t i = 0;
+    for (; i + 1 < dstCount && i < srcLen && src[i]; i++) {
+        dst[i] = (wchar_t)(unsigned char)src[i];
+    }
+    dst[i] = 0;
+}
+
+bool Procfs_ParseStat(const char *buf, ProcfsStat *out)
+{
+    const char *open = strchr(buf, '(');
+    const char *close = strrchr(buf, ')');
+    if (!open || !close || close < open) return false;
+    memset(out, 0, sizeof(*out));
+    out->comm = open + 1;
+    out->commLen = (size_t)(close - open - 1);
+
+    // Fields after comm start at 3 (state).
+    const char *p = close + 1;
+    for (int field = 3; field <= 24 && *p; field++) {
+        while (*p == ' ') p++;
+        const char *tok = p;
+        while (*p && *p != ' ') p++;
+
+        if (field == 14 || field == 15) out->ticks += strtoull(tok, NULL, 10);
+        else if (field == 22) out->startTicks = strtoull(tok, NULL, 10);
+        else if (field == 24) out->rssPages = strtoull(tok, NULL, 10);
+    }
+    return true;
+}
+
+static volatile uint32_t s_tickTo100ns; // 0 until first use
+
+uint64_t Procfs_TicksTo100ns(uint64_t ticks)
+{
+    uint32_t scale = Atomic_LoadU32(&s_tickTo100ns);
+    if (scale == 0) {
+        long clkTck = sysconf(_SC_CLK_TCK);
+        if (clkTck <= 0) clkTck = 100;
+        scale = (uint32_t)(10000000ull / (uint64_t)clkTck);
+        Atomic_StoreU32(&s_tickTo100ns, scale);
+    }
+    return ticks * scale;
+}
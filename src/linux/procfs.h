@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Small helpers for reading procfs/sysfs text files without stdio buffering.
+
+// Reads a whole file into a growable buffer (*buf/*cap are reused across calls).
+// The result is NUL-terminated; returns false on open/read/alloc failure.
+bool Procfs_ReadFile(const char *path, char **buf, size_t *cap, size_t *outLen);
+
+// Reads up to cap-1 bytes of a small file into buf (NUL-terminated). Returns bytes read, or -1.
+long Procfs_ReadSmall(const char *path, char *buf, size_t cap);
+// Same, from the start of an open file: procfs regenerates a file read at offset 0, so a
+// descriptor kept open re-reads current contents.
+long Procfs_ReadSmallFd(int fd, char *buf, size_t cap);
+
+// Reads a single unsigned integer from a sysfs-style file.
+bool Procfs_ReadU64(const char *path, uint64_t *out);
+
+// The fields of /proc/<pid>/stat the collectors use. comm may hold spaces and parens, so
+// the fields after it are located from the last ')'.
+typedef struct ProcfsStat {
+    const char *comm; // into the parsed text, commLen bytes, not terminated
+    size_t commLen;
+    uint64_t ticks;      // utime + stime (fields 14 and 15)
+    uint64_t startTicks; // starttime (field 22), since boot
+    uint64_t rssPages;   // rss (field 24)
+} ProcfsStat;
+
+bool Procfs_ParseStat(const char *buf, ProcfsStat *out);
+
+// Clock ticks (CLK_TCK) to 100ns units, the scale the shared CPU math uses on every
+// platform. Safe from any thread.
+uint64_t Procfs_TicksTo100ns(uint64_t ticks);
+
+// Copies a UTF-8/ASCII byte string into a wide buffer (bytes >= 0x80 are kept as-is).
+void Procfs_Widen(wchar_t *dst, size_t dstCount, const char *src, size_t srcLen);
@@ -1,6 +1,8 @@
 #include <windows.h>
 
 #include <shellapi.h>
+#include <stdlib.h>
+#include <wchar.h>
 
 #include "app.h"
 
@@ -85,23 +87,58 @@ static void maybe_prompt_elevation(HINSTANCE hInstance, PWSTR lpCmdLine)
     // If the user cancels UAC, just continue non-elevated.
 }
 
+// --record FILE / --replay FILE [--replay-speed X] / --export-history FILE / --history-file FILE.
+// Unknown arguments are ignored.
+static void parse_options(wchar_t **argv, int argc, AppOptions *opts)
+{
+    opts->recordPath = NULL;
+    opts->replayPath = NULL;
+    opts->replaySpeed = 1.0;
+    opts->exportPath = NULL;
+    opts->historyPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (wcscmp(argv[i], L"--record") == 0 && i + 1 < argc) {
+            opts->recordPath = argv[++i];
+        } else if (wcscmp(argv[i], L"--replay") == 0 && i + 1 < argc) {
+            opts->replayPath = argv[++i];
+        } else if (wcscmp(argv[i], L"--replay-speed") == 0 && i + 1 < argc) {
+            opts->replaySpeed = _wtof(argv[++i]);
+        } else if (wcscmp(argv[i], L"--export-history") == 0 && i + 1 < argc) {
+            opts->exportPath = argv[++i];
+        } else if (wcscmp(argv[i], L"--history-file") == 0 && i + 1 < argc) {
+            opts->historyPath = argv[++i];
+        }
+    }
+}
+
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdLine, int nCmdShow)
 {
     (void)hPrevInstance;
 
-    maybe_prompt_elevation(hInstance, lpCmdLine);
+    int argc = 0;
+    wchar_t **argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    AppOptions opts;
+    parse_options(argv, argv ? argc : 0, &opts);
+
+    // Replaying a capture touches no OS counters, so elevation buys nothing.
+    if (!opts.replayPath) {
+        maybe_prompt_elevation(hInstance, lpCmdLine);
 
-    // If we are elevated, try enabling privileges needed by ETW/process control.
-    // (If not elevated, this is harmless and just fails.)
-    try_enable_common_privileges();
+        // If we are elevated, try enabling privileges needed by ETW/process control.
+        // (If not elevated, this is harmless and just fails.)
+        try_enable_common_privileges();
+    }
 
     App app;
-    if (!App_Init(&app, hInstance)) {
+    if (!App_Init(&app, hInstance, &opts)) {
+        LocalFree(argv);
         return 1;
     }
 
     App_Show(&app, nCmdShow);
     int exitCode = App_Run(&app);
     App_Shutdown(&app);
+    LocalFree(argv);
     return exitCode;
 }
@@ -0,0 +1,1155 @@
+#include "monitor.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "qpc.h"
+#include "record.h"
+
+// Rollup tiers behind the raw histories: 1 s buckets for an hour, then 1 min for a day.
+static const HistTierSpec kSeriesTiers[MONITOR_ROLLUP_TIERS] = {{1.0, 3600u}, {60.0, 1440u}};
+// Per-core: 5 s for an hour, then 5 min for a day (~30 KB per logical processor).
+static const HistTierSpec kCoreTiers[MONITOR_ROLLUP_TIERS] = {{5.0, 720u}, {300.0, 288u}};
+
+// Archive quantization steps (powers of two): 1/8 % for usage, 1/64 MB/s for disks.
+#define ARCHIVE_PCT_QUANTUM 0.125f
+#define ARCHIVE_MBPS_QUANTUM 0.015625f
+
+static void shutdown_series_array(RingBufF *arr, uint32_t count)
+{
+    if (!arr) return;
+    for (uint32_t i = 0; i < count; i++) {
+        RingBuf_Shutdown(&arr[i]);
+    }
+}
+
+static void shutdown_rollup_array(HistRollup *arr, uint32_t count)
+{
+    if (!arr) return;
+    for (uint32_t i = 0; i < count; i++) {
+        HistRollup_Shutdown(&arr[i]);
+    }
+}
+
+static void shutdown_archive_array(CompressedSeries *arr, uint32_t count)
+{
+    if (!arr) return;
+    for (uint32_t i = 0; i < count; i++) {
+        CompressedSeries_Shutdown(&arr[i]);
+    }
+}
+
+static bool init_archive(CompressedSeries *s, float quantum)
+{
+    return CompressedSeries_Init(s, (int64_t)MONITOR_ARCHIVE_SEC * 1000, quantum, 16u);
+}
+
+static int64_t archive_time(const Monitor *m, int64_t t)
+{
+    return (int64_t)((double)t * 1000.0 / m->qpcFreq);
+}
+
+// Raw sample into the series' ring, its rollup tiers and its window statistics.
+static void push_series(RingBufF *raw, HistRollup *rollup, WindowStats *window, float v, int64_t t)
+{
+    RingBuf_PushAt(raw, v, t);
+    HistRollup_Push(rollup, v, t);
+    WindowStats_Push(window, v);
+}
+
+static void shutdown_disk_series(DiskSeries *d)
+{
+    RingBuf_Shutdown(&d->readMBpsHistory);
+    RingBuf_Shutdown(&d->writeMBpsHistory);
+    WindowStats_Shutdown(&d->readWindow);
+    WindowStats_Shutdown(&d->writeWindow);
+    CompressedSeries_Shutdown(&d->readArchive);
+    CompressedSeries_Shutdown(&d->writeArchive);
+}
+
+static bool init_gpu_engine_series(Monitor *m, uint32_t histCap)
+{
+    m->gpuEnginePctHistory = NULL;
+    m->gpuEngineTypeCount = 0;
+
+    const uint32_t n = m->snap.gpuEngineCount;
+    if (n == 0) return true;
+
+    m->gpuEnginePctHistory = (RingBufF *)calloc(n, sizeof(RingBufF));
+    if (!m->gpuEnginePctHistory) return true; // best-effort
+
+    bool ok = true;
+    for (uint32_t i = 0; i < n; i++) {
+        ok = ok && RingBuf_Init(&m->gpuEnginePctHistory[i], histCap);
+    }
+    if (!ok) {
+        shutdown_series_array(m->gpuEnginePctHistory, n);
+        free(m->gpuEnginePctHistory);
+        m->gpuEnginePctHistory = NULL;
+        return true;
+    }
+
+    m->gpuEngineTypeCount = n;
+
+    // Archives are optional on top of the histories.
+    m->gpuEngineArchive = (CompressedSeries *)calloc(n, sizeof(CompressedSeries));
+    if (m->gpuEngineArchive) {
+        for (uint32_t i = 0; i < n && ok; i++) {
+            ok = init_archive(&m->gpuEngineArchive[i], ARCHIVE_PCT_QUANTUM);
+        }
+        if (!ok) {
+            shutdown_archive_array(m->gpuEngineArchive, n);
+            free(m->gpuEngineArchive);
+            m->gpuEngineArchive = NULL;
+        } else {
+            m->gpuEngineArchiveCount = n;
+        }
+    }
+    return true;
+}
+
+static void init_disk_series(Monitor *m, uint32_t histCap)
+{
+    m->disks = NULL;
+    m->diskCount = 0;
+
+    const CollectorSnapshot *s = &m->snap;
+    if (s->diskCount == 0 || !s->diskNames) return;
+
+    m->disks = (DiskSeries *)calloc(s->diskCount, sizeof(*m->disks));
+    if (!m->disks) return;
+
+    bool ok = true;
+    for (uint32_t i = 0; i < s->diskCount; i++) {
+        const wchar_t *nm = s->diskNames[i] ? s->diskNames[i] : L"Disk";
+        wcsncpy(m->disks[i].name, nm, (sizeof(m->disks[i].name) / sizeof(m->disks[i].name[0])) - 1);
+        m->disks[i].name[(sizeof(m->disks[i].name) / sizeof(m->disks[i].name[0])) - 1] = 0;
+
+        ok = ok && RingBuf_Init(&m->disks[i].readMBpsHistory, histCap);
+        ok = ok && RingBuf_Init(&m->disks[i].writeMBpsHistory, histCap);
+        ok = ok && WindowStats_Init(&m->disks[i].readWindow, histCap);
+        ok = ok && WindowStats_Init(&m->disks[i].writeWindow, histCap);
+        ok = ok && init_archive(&m->disks[i].readArchive, ARCHIVE_MBPS_QUANTUM);
+        ok = ok && init_archive(&m->disks[i].writeArchive, ARCHIVE_MBPS_QUANTUM);
+    }
+
+    if (!ok) {
+        for (uint32_t i = 0; i < s->diskCount; i++) {
+            shutdown_disk_series(&m->disks[i]);
+        }
+        free(m->disks);
+        m->disks = NULL;
+        return;
+    }
+
+    m->diskCount = s->diskCount;
+}
+
+static void shutdown_device_series(Monitor *m)
+{
+    shutdown_series_array(m->gpuEnginePctHistory, m->gpuEngineTypeCount);
+    free(m->gpuEnginePctHistory);
+    m->gpuEnginePctHistory = NULL;
+    m->gpuEngineTypeCount = 0;
+    shutdown_archive_array(m->gpuEngineArchive, m->gpuEngineArchiveCount);
+    free(m->gpuEngineArchive);
+    m->gpuEngineArchive = NULL;
+    m->gpuEngineArchiveCount = 0;
+
+    if (m->disks) {
+        for (uint32_t i = 0; i < m->diskCount; i++) {
+            shutdown_disk_series(&m->disks[i]);
+        }
+    }
+    free(m->disks);
+    m->disks = NULL;
+    m->diskCount = 0;
+}
+
+void Monitor_InitDeviceSeries(Monitor *m)
+{
+    if (!m) return;
+    shutdown_device_series(m);
+    init_disk_series(m, m->histCap);
+    init_gpu_engine_series(m, m->histCap);
+}
+
+bool Monitor_Init(Monitor *m, uint32_t logicalCount, uint32_t histCap,
+                  const CollectorOps *const *collectors, uint32_t collectorCount)
+{
+    memset(m, 0, sizeof(*m));
+
+    m->logicalCount = logicalCount ? logicalCount : 1;
+    m->histCap = histCap;
+
+    ProcTable_Init(&m->procTable);
+    ProcView_Init(&m->procView);
+    SelfStats_Init(&m->self);
+
+    m->coreUsage = (float *)calloc(m->logicalCount, sizeof(float));
+    m->coreMHz = (float *)calloc(m->logicalCount, sizeof(float));
+    m->coreMaxMHz = (float *)calloc(m->logicalCount, sizeof(float));
+    m->prevCoreMHz = (float *)calloc(m->logicalCount, sizeof(float));
+    m->coreUsageRollup = (HistRollup *)calloc(m->logicalCount, sizeof(HistRollup));
+    m->coreUsageArchive = (CompressedSeries *)calloc(m->logicalCount, sizeof(CompressedSeries));
+    m->coreArchivedPushes = (uint64_t *)calloc(m->logicalCount, sizeof(uint64_t));
+    if (!m->coreUsage || !m->coreMHz || !m->coreMaxMHz || !m->prevCoreMHz || !m->coreUsageRollup ||
+        !m->coreUsageArchive || !m->coreArchivedPushes) {
+        return false;
+    }
+
+    if (!RingBuf_Init(&m->totalUsageHistory, histCap)) {
+        return false;
+    }
+    if (!RingBuf_Init(&m->memUsedPctHistory, histCap)) {
+        return false;
+    }
+    if (!RingBuf_Init(&m->commitUsedPctHistory, histCap)) {
+        return false;
+    }
+    if (!RingBuf_Init(&m->diskReadMBpsHistory, histCap)) {
+        return false;
+    }
+    if (!RingBuf_Init(&m->diskWriteMBpsHistory, histCap)) {
+        return false;
+    }
+    if (!RingBuf_Init(&m->gpuDedicatedUsedMBHistory, histCap)) {
+        return false;
+    }
+    if (!RingBuf_Init(&m->gpuSharedUsedMBHistory, histCap)) {
+        return false;
+    }
+    if (!CoreHistory_Init(&m->coreUsageHistory, m->logicalCount, histCap)) {
+        return false;
+    }
+
+    const double freq = Qpc_Freq();
+    m->qpcFreq = freq;
+    if (!WindowStats_Init(&m->totalUsageWindow, histCap) ||
+        !WindowStats_Init(&m->memUsedPctWindow, histCap) ||
+        !WindowStats_Init(&m->commitUsedPctWindow, histCap) ||
+        !WindowStats_Init(&m->diskReadMBpsWindow, histCap) ||
+        !WindowStats_Init(&m->diskWriteMBpsWindow, histCap) ||
+        !WindowStats_Init(&m->gpuDedicatedUsedMBWindow, histCap) ||
+        !WindowStats_Init(&m->gpuSharedUsedMBWindow, histCap)) {
+        return false;
+    }
+    if (!HistRollup_Init(&m->totalUsageRollup, kSeriesTiers, MONITOR_ROLLUP_TIERS, freq, true) ||
+        !HistRollup_Init(&m->memUsedPctRollup, kSeriesTiers, MONITOR_ROLLUP_TIERS, freq, true) ||
+        !HistRollup_Init(&m->commitUsedPctRollup, kSeriesTiers, MONITOR_ROLLUP_TIERS, freq, true) ||
+        !HistRollup_Init(&m->diskReadMBpsRollup, kSeriesTiers, MONITOR_ROLLUP_TIERS, freq, true) ||
+        !HistRollup_Init(&m->diskWriteMBpsRollup, kSeriesTiers, MONITOR_ROLLUP_TIERS, freq, true) ||
+        !HistRollup_Init(&m->gpuDedicatedUsedMBRollup, kSeriesTiers, MONITOR_ROLLUP_TIERS, freq, true) ||
+        !HistRollup_Init(&m->gpuSharedUsedMBRollup, kSeriesTiers, MONITOR_ROLLUP_TIERS, freq, true)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < m->logicalCount; i++) {
+        if (!HistRollup_Init(&m->coreUsageRollup[i], kCoreTiers, MONITOR_ROLLUP_TIERS, freq, false) ||
+            !init_archive(&m->coreUsageArchive[i], ARCHIVE_PCT_QUANTUM)) {
+            return false;
+        }
+    }
+
+    // Collectors write straight into the Monitor's per-core arrays and process table.
+    m->snap.logicalCount = m->logicalCount;
+    m->snap.coreCpu = m->coreUsage;
+    m->snap.coreMHz = m->coreMHz;
+    m->snap.coreMaxMHz = m->coreMaxMHz;
+    m->snap.procs = &m->procTable;
+    m->snap.cpuTempC = -1.0f;
+    m->snap.fanRpm = -1.0f;
+
+    if (collectorCount > 0 && collectors) {
+        m->collectorState = (void **)calloc(collectorCount, sizeof(void *));
+        m->collectorOk = (bool *)calloc(collectorCount, sizeof(bool));
+        m->collectorPeriodSec = (double *)calloc(collectorCount, sizeof(double));
+        m->collectorLastQpc = (int64_t *)calloc(collectorCount, sizeof(int64_t));
+        m->collectorStage = (uint32_t *)calloc(collectorCount, sizeof(uint32_t));
+        if (!m->collectorState || !m->collectorOk || !m->collectorPeriodSec || !m->collectorLastQpc || !m->collectorStage ||
+            !Schedule_Init(&m->schedule, collectorCount)) {
+            return false;
+        }
+        m->collectors = collectors;
+        m->collectorCount = collectorCount;
+
+        for (uint32_t i = 0; i < collectorCount; i++) {
+            const CollectorOps *c = collectors[i];
+            if (!c || !c->init || !c->sample) continue;
+            // Best-effort: a source that can't open (no PDH, no GPU, no ETW) just stays off.
+            m->collectorOk[i] = c->init(&m->collectorState[i], &m->snap);
+            m->collectorStage[i] = UINT32_MAX;
+            if (m->collectorOk[i]) {
+                wchar_t stageName[32];
+                swprintf(stageName, sizeof(stageName) / sizeof(stageName[0]), L"collect %ls", c->name ? c->name : L"?");
+                m->collectorStage[i] = SelfStats_AddStage(&m->self, stageName);
+            }
+        }
+    }
+
+    m->stageApply = SelfStats_AddStage(&m->self, L"apply");
+    m->stageProcSort = SelfStats_AddStage(&m->self, L"proc sort");
+    m->stageProcView = SelfStats_AddStage(&m->self, L"proc view rebuild");
+    m->stageTick = SelfStats_AddStage(&m->self, L"tick total");
+    m->stageRecord = SelfStats_AddStage(&m->self, L"record");
+
+    // Per-device series depend on the shape published by collector init.
+    Monitor_InitDeviceSeries(m);
+
+    return true;
+}
+
+void Monitor_Shutdown(Monitor *m)
+{
+    if (!m) return;
+
+    if (m->historyFile) {
+        HistoryFile_Close(m->historyFile, Qpc_Now());
+        free(m->historyFile);
+    }
+
+    for (uint32_t i = 0; i < m->collectorCount; i++) {
+        const CollectorOps *c = m->collectors[i];
+        if (m->collectorOk[i] && c && c->shutdown) {
+            c->shutdown(m->collectorState[i]);
+        }
+    }
+    free(m->collectorState);
+    free(m->collectorOk);
+    free(m->collectorPeriodSec);
+    free(m->collectorLastQpc);
+    free(m->collectorStage);
+    Schedule_Shutdown(&m->schedule);
+
+    ProcView_Shutdown(&m->procView);
+    ProcTable_Shutdown(&m->procTable);
+
+    CoreHistory_Shutdown(&m->coreUsageHistory);
+    RingBuf_Shutdown(&m->totalUsageHistory);
+    RingBuf_Shutdown(&m->memUsedPctHistory);
+    RingBuf_Shutdown(&m->commitUsedPctHistory);
+    RingBuf_Shutdown(&m->diskReadMBpsHistory);
+    RingBuf_Shutdown(&m->diskWriteMBpsHistory);
+
+    RingBuf_Shutdown(&m->gpuDedicatedUsedMBHistory);
+    RingBuf_Shutdown(&m->gpuSharedUsedMBHistory);
+    shutdown_device_series(m);
+
+    shutdown_rollup_array(m->coreUsageRollup, m->logicalCount);
+    free(m->coreUsageRollup);
+    shutdown_archive_array(m->coreUsageArchive, m->logicalCount);
+    free(m->coreUsageArchive);
+    free(m->coreArchivedPushes);
+    HistRollup_Shutdown(&m->totalUsageRollup);
+    HistRollup_Shutdown(&m->memUsedPctRollup);
+    HistRollup_Shutdown(&m->commitUsedPctRollup);
+    HistRollup_Shutdown(&m->diskReadMBpsRollup);
+    HistRollup_Shutdown(&m->diskWriteMBpsRollup);
+    HistRollup_Shutdown(&m->gpuDedicatedUsedMBRollup);
+    HistRollup_Shutdown(&m->gpuSharedUsedMBRollup);
+    WindowStats_Shutdown(&m->totalUsageWindow);
+    WindowStats_Shutdown(&m->memUsedPctWindow);
+    WindowStats_Shutdown(&m->commitUsedPctWindow);
+    WindowStats_Shutdown(&m->diskReadMBpsWindow);
+    WindowStats_Shutdown(&m->diskWriteMBpsWindow);
+    WindowStats_Shutdown(&m->gpuDedicatedUsedMBWindow);
+    WindowStats_Shutdown(&m->gpuSharedUsedMBWindow);
+
+    free(m->coreUsage);
+    free(m->coreMHz);
+    free(m->coreMaxMHz);
+    free(m->prevCoreMHz);
+
+    memset(m, 0, sizeof(*m));
+}
+
+// Raw histories kept in the history file, after the per-core matrix (series 0).
+typedef struct PersistedSeries {
+    RingBufF *raw;
+    HistRollup *rollup;
+    WindowStats *window;
+} PersistedSeries;
+
+#define PERSISTED_SERIES 7u
+
+static void persisted_series(Monitor *m, PersistedSeries out[PERSISTED_SERIES])
+{
+    const PersistedSeries list[PERSISTED_SERIES] = {
+        {&m->totalUsageHistory, &m->totalUsageRollup, &m->totalUsageWindow},
+        {&m->memUsedPctHistory, &m->memUsedPctRollup, &m->memUsedPctWindow},
+        {&m->commitUsedPctHistory, &m->commitUsedPctRollup, &m->commitUsedPctWindow},
+        {&m->diskReadMBpsHistory, &m->diskReadMBpsRollup, &m->diskReadMBpsWindow},
+        {&m->diskWriteMBpsHistory, &m->diskWriteMBpsRollup, &m->diskWriteMBpsWindow},
+        {&m->gpuDedicatedUsedMBHistory, &m->gpuDedicatedUsedMBRollup, &m->gpuDedicatedUsedMBWindow},
+        {&m->gpuSharedUsedMBHistory, &m->gpuSharedUsedMBRollup, &m->gpuSharedUsedMBWindow},
+    };
+    memcpy(out, list, sizeof(list));
+}
+
+bool Monitor_AttachHistoryFile(Monitor *m, FILE *f, int64_t now)
+{
+    if (!m || m->historyFile) {
+        if (f) fclose(f);
+        return false;
+    }
+
+    PersistedSeries series[PERSISTED_SERIES];
+    persisted_series(m, series);
+    HistorySeriesSpec specs[1u + PERSISTED_SERIES];
+    specs[0].cap = m->histCap;
+    specs[0].width = m->logicalCount;
+    for (uint32_t i = 0; i < PERSISTED_SERIES; i++) {
+        specs[1u + i].cap = m->histCap;
+        specs[1u + i].width = 0;
+    }
+
+    HistoryFile *hf = (HistoryFile *)calloc(1, sizeof(*hf));
+    if (!hf) {
+        if (f) fclose(f);
+        return false;
+    }
+    SelfStats_NoteAlloc();
+    if (!HistoryFile_Open(hf, f, specs, 1u + PERSISTED_SERIES, m->qpcFreq, now)) {
+        free(hf);
+        return false;
+    }
+    m->historyFile = hf;
+
+    // Restored samples also rebuild what is derived from them.
+    const uint32_t rows = HistoryFile_BindCores(hf, 0, &m->coreUsageHistory);
+    for (uint32_t r = 0; r < rows; r++) {
+        const float *row = CoreHistory_Row(&m->coreUsageHistory, r);
+        const int64_t t = CoreHistory_RowTime(&m->coreUsageHistory, r);
+        for (uint32_t i = 0; i < m->logicalCount; i++) {
+            HistRollup_Push(&m->coreUsageRollup[i], row[i], t);
+        }
+    }
+    for (uint32_t i = 0; i < m->logicalCount; i++) {
+        const RingBufF *mean = &m->coreUsageRollup[i].tiers[MONITOR_TIER_HOUR].mean;
+        for (uint32_t k = 0; k < mean->count; k++) {
+            CompressedSeries_Push(&m->coreUsageArchive[i], RingBuf_GetOldest(mean, k),
+                                  archive_time(m, RingBuf_GetOldestTime(mean, k)));
+        }
+        m->coreArchivedPushes[i] = mean->pushes;
+    }
+    for (uint32_t i = 0; i < PERSISTED_SERIES; i++) {
+        const uint32_t n = HistoryFile_BindRing(hf, 1u + i, series[i].raw);
+        for (uint32_t k = 0; k < n; k++) {
+            const float v = RingBuf_GetOldest(series[i].raw, k);
+            HistRollup_Push(series[i].rollup, v, RingBuf_GetOldestTime(series[i].raw, k));
+            WindowStats_Push(series[i].window, v);
+        }
+    }
+    m->totalUsageMin = WindowStats_Min(&m->totalUsageWindow);
+    m->totalUsageMax = WindowStats_Max(&m->totalUsageWindow);
+    return true;
+}
+
+void Monitor_FlushHistoryFile(Monitor *m, int64_t now)
+{
+    if (m && m->historyFile) {
+        HistoryFile_Flush(m->historyFile, now);
+    }
+}
+
+uint32_t Monitor_Collect(Monitor *m, double dt)
+{
+    if (!m) return 0;
+    uint32_t sections = 0;
+    for (uint32_t i = 0; i < m->collectorCount; i++) {
+        if (!m->collectorOk[i]) continue;
+        const CollectorOps *c = m->collectors[i];
+        const SelfTimer t = SelfStats_Begin();
+        (void)c->sample(m->collectorState[i], dt, &m->snap);
+        SelfStats_End(&m->self, m->collectorStage[i], &t);
+        sections |= c->sections;
+    }
+    return sections;
+}
+
+// The rows in the ordered window (what the UI shows, plus its scroll margin) and the
+// selection stay at the process walk's full refresh rate.
+static void keep_shown_rows_fast(Monitor *m)
+{
+    uint32_t n = 0;
+    const ProcRow *rows = ProcView_Rows(&m->procView, &m->procTable, &n);
+    const uint32_t sorted = ProcView_SortedCount(&m->procView, &m->procTable);
+    if (sorted < n) n = sorted;
+    for (uint32_t i = 0; i < n; i++) {
+        ProcTable_KeepFast(&m->procTable, rows[i].pid);
+    }
+    ProcTable_KeepFast(&m->procTable, m->procView.settings.selectedPid);
+}
+
+void Monitor_RefreshProcView(Monitor *m)
+{
+    if (!m) return;
+
+    // Keep display sorted according to UI state.
+    if (!m->procView.settings.stacked) {
+        const SelfTimer t = SelfStats_Begin();
+        ProcTable_Sort(&m->procTable, m->procView.settings.sortKey, m->procView.settings.sortAsc,
+                       m->procView.settings.sortDepth);
+        SelfStats_End(&m->self, m->stageProcSort, &t);
+    }
+
+    // Build stacked/grouped view if enabled (and sort the view rows).
+    const SelfTimer t = SelfStats_Begin();
+    ProcView_Rebuild(&m->procView, &m->procTable);
+    SelfStats_End(&m->self, m->stageProcView, &t);
+    m->procViewGen++;
+
+    keep_shown_rows_fast(m);
+}
+
+static void apply_cpu_usage(Monitor *m, int64_t t)
+{
+    const CollectorSnapshot *s = &m->snap;
+
+    if (s->hasCpu) {
+        m->totalUsage = s->totalCpu;
+    }
+
+    push_series(&m->totalUsageHistory, &m->totalUsageRollup, &m->totalUsageWindow, m->totalUsage, t);
+    m->totalUsageMin = WindowStats_Min(&m->totalUsageWindow);
+    m->totalUsageMax = WindowStats_Max(&m->totalUsageWindow);
+    CoreHistory_Push(&m->coreUsageHistory, m->coreUsage, t);
+    for (uint32_t i = 0; i < m->logicalCount; i++) {
+        HistRollup_Push(&m->coreUsageRollup[i], m->coreUsage[i], t);
+
+        // Archive each closed hour-tier bucket's mean.
+        const RingBufF *mean = &m->coreUsageRollup[i].tiers[MONITOR_TIER_HOUR].mean;
+        CompressedSeries *archive = &m->coreUsageArchive[i];
+        if (mean->pushes != m->coreArchivedPushes[i] && mean->count > 0) {
+            CompressedSeries_Push(archive, RingBuf_GetOldest(mean, mean->count - 1u),
+                                  archive_time(m, RingBuf_GetOldestTime(mean, mean->count - 1u)));
+            m->coreArchivedPushes[i] = mean->pushes;
+        }
+    }
+}
+
+static void apply_cpu_freq(Monitor *m, double dt)
+{
+    // Frequency change events (best-effort): count core MHz changes between samples.
+    uint32_t changes = 0;
+    for (uint32_t i = 0; i < m->logicalCount; i++) {
+        const float prev = m->prevCoreMHz[i];
+        const float cur = m->coreMHz[i];
+        if (prev > 0.0f && cur > 0.0f && prev != cur) {
+            changes++;
+        }
+        m->prevCoreMHz[i] = cur;
+    }
+    m->freqChangeCount = changes;
+    m->freqChangesPerSec = (dt > 0.0) ? ((double)changes / dt) : 0.0;
+
+    // Throttling estimate: cores running significantly below their max.
+    uint32_t thr = 0;
+    uint32_t denom = 0;
+    for (uint32_t i = 0; i < m->logicalCount; i++) {
+        const float maxM = m->coreMaxMHz[i];
+        const float curM = m->coreMHz[i];
+        if (maxM > 0.0f && curM > 0.0f) {
+            denom++;
+            const float ratio = curM / maxM;
+            if (ratio < 0.95f) {
+                thr++;
+            }
+        }
+    }
+    m->throttlePct = (denom > 0) ? (100.0f * (float)thr / (float)denom) : 0.0f;
+}
+
+static void apply_memory(Monitor *m, int64_t t)
+{
+    const CollectorSnapshot *s = &m->snap;
+
+    if (s->hasMemory) {
+        m->memTotalPhysBytes = s->memTotalPhysBytes;
+        m->memAvailPhysBytes = s->memAvailPhysBytes;
+        const uint64_t used = (m->memTotalPhysBytes > m->memAvailPhysBytes) ? (m->memTotalPhysBytes - m->memAvailPhysBytes) : 0;
+        m->memUsedPct = (m->memTotalPhysBytes > 0) ? (100.0f * (float)((double)used / (double)m->memTotalPhysBytes)) : 0.0f;
+        push_series(&m->memUsedPctHistory, &m->memUsedPctRollup, &m->memUsedPctWindow, m->memUsedPct, t);
+    }
+
+    if (s->hasCommit) {
+        m->commitTotalBytes = s->commitTotalBytes;
+        m->commitLimitBytes = s->commitLimitBytes;
+        m->commitUsedPct = (m->commitLimitBytes > 0) ? (100.0f * (float)((double)m->commitTotalBytes / (double)m->commitLimitBytes)) : 0.0f;
+        push_series(&m->commitUsedPctHistory, &m->commitUsedPctRollup, &m->commitUsedPctWindow, m->commitUsedPct, t);
+    }
+}
+
+static void apply_disks(Monitor *m, int64_t t)
+{
+    const CollectorSnapshot *s = &m->snap;
+
+    if (s->hasPerDisk && s->diskCount > 0 && m->disks && m->diskCount == s->diskCount &&
+        s->diskReadBytesPerSec && s->diskWriteBytesPerSec) {
+        for (uint32_t i = 0; i < m->diskCount; i++) {
+            const double rMBps = s->diskReadBytesPerSec[i] / (1024.0 * 1024.0);
+            const double wMBps = s->diskWriteBytesPerSec[i] / (1024.0 * 1024.0);
+            m->disks[i].readMBps = rMBps;
+            m->disks[i].writeMBps = wMBps;
+            RingBuf_PushAt(&m->disks[i].readMBpsHistory, (float)rMBps, t);
+            RingBuf_PushAt(&m->disks[i].writeMBpsHistory, (float)wMBps, t);
+            WindowStats_Push(&m->disks[i].readWindow, (float)rMBps);
+            WindowStats_Push(&m->disks[i].writeWindow, (float)wMBps);
+            CompressedSeries_Push(&m->disks[i].readArchive, (float)rMBps, archive_time(m, t));
+            CompressedSeries_Push(&m->disks[i].writeArchive, (float)wMBps, archive_time(m, t));
+        }
+
+        // Also keep a legacy _Total fallback series updated (useful on layouts)
+        m->diskReadMBps = s->rates.hasDisk ? (s->rates.diskReadBytesPerSec / (1024.0 * 1024.0)) : 0.0;
+        m->diskWriteMBps = s->rates.hasDisk ? (s->rates.diskWriteBytesPerSec / (1024.0 * 1024.0)) : 0.0;
+        push_series(&m->diskReadMBpsHistory, &m->diskReadMBpsRollup, &m->diskReadMBpsWindow, (float)m->diskReadMBps, t);
+        push_series(&m->diskWriteMBpsHistory, &m->diskWriteMBpsRollup, &m->diskWriteMBpsWindow, (float)m->diskWriteMBps, t);
+    } else if (s->rates.hasDisk) {
+        m->diskReadMBps = s->rates.diskReadBytesPerSec / (1024.0 * 1024.0);
+        m->diskWriteMBps = s->rates.diskWriteBytesPerSec / (1024.0 * 1024.0);
+        push_series(&m->diskReadMBpsHistory, &m->diskReadMBpsRollup, &m->diskReadMBpsWindow, (float)m->diskReadMBps, t);
+        push_series(&m->diskWriteMBpsHistory, &m->diskWriteMBpsRollup, &m->diskWriteMBpsWindow, (float)m->diskWriteMBps, t);
+    } else {
+        m->diskReadMBps = 0.0;
+        m->diskWriteMBps = 0.0;
+        push_series(&m->diskReadMBpsHistory, &m->diskReadMBpsRollup, &m->diskReadMBpsWindow, 0.0f, t);
+        push_series(&m->diskWriteMBpsHistory, &m->diskWriteMBpsRollup, &m->diskWriteMBpsWindow, 0.0f, t);
+    }
+}
+
+static void apply_gpu(Monitor *m, int64_t t)
+{
+    const CollectorSnapshot *s = &m->snap;
+    if (!s->gpuPresent) return;
+
+    if (s->hasGpu) {
+        if (s->hasGpuMemory) {
+            m->gpuDedicatedUsedMB = (double)s->gpuDedicatedUsageBytes / (1024.0 * 1024.0);
+            m->gpuDedicatedLimitMB = (double)s->gpuDedicatedLimitBytes / (1024.0 * 1024.0);
+            m->gpuSharedUsedMB = (double)s->gpuSharedUsageBytes / (1024.0 * 1024.0);
+            m->gpuSharedLimitMB = (double)s->gpuSharedLimitBytes / (1024.0 * 1024.0);
+        } else {
+            m->gpuDedicatedUsedMB = 0.0;
+            m->gpuDedicatedLimitMB = 0.0;
+            m->gpuSharedUsedMB = 0.0;
+            m->gpuSharedLimitMB = 0.0;
+        }
+
+        push_series(&m->gpuDedicatedUsedMBHistory, &m->gpuDedicatedUsedMBRollup, &m->gpuDedicatedUsedMBWindow, (float)m->gpuDedicatedUsedMB, t);
+        push_series(&m->gpuSharedUsedMBHistory, &m->gpuSharedUsedMBRollup, &m->gpuSharedUsedMBWindow, (float)m->gpuSharedUsedMB, t);
+
+        if (s->hasGpuEngines && s->gpuEnginePct && m->gpuEnginePctHistory && m->gpuEngineTypeCount == s->gpuEngineCount) {
+            for (uint32_t i = 0; i < m->gpuEngineTypeCount; i++) {
+                RingBuf_PushAt(&m->gpuEnginePctHistory[i], s->gpuEnginePct[i], t);
+            }
+            for (uint32_t i = 0; i < m->gpuEngineArchiveCount; i++) {
+                CompressedSeries_Push(&m->gpuEngineArchive[i], s->gpuEnginePct[i], archive_time(m, t));
+            }
+        }
+    } else {
+        push_series(&m->gpuDedicatedUsedMBHistory, &m->gpuDedicatedUsedMBRollup, &m->gpuDedicatedUsedMBWindow, 0.0f, t);
+        push_series(&m->gpuSharedUsedMBHistory, &m->gpuSharedUsedMBRollup, &m->gpuSharedUsedMBWindow, 0.0f, t);
+        if (m->gpuEnginePctHistory) {
+            for (uint32_t i = 0; i < m->gpuEngineTypeCount; i++) {
+                RingBuf_PushAt(&m->gpuEnginePctHistory[i], 0.0f, t);
+            }
+            for (uint32_t i = 0; i < m->gpuEngineArchiveCount; i++) {
+                CompressedSeries_Push(&m->gpuEngineArchive[i], 0.0f, archive_time(m, t));
+            }
+        }
+    }
+}
+
+void Monitor_Apply(Monitor *m, uint32_t sections, int64_t t, double dt)
+{
+    if (!m) return;
+
+    const SelfTimer timer = SelfStats_Begin();
+
+    if (sections & COLLECTOR_SECTION_CPU) {
+        apply_cpu_usage(m, t);
+    }
+    if (sections & COLLECTOR_SECTION_CPU_FREQ) {
+        apply_cpu_freq(m, dt);
+    }
+
+    if ((sections & COLLECTOR_SECTION_PROCS) && m->snap.hasProcs) {
+        Monitor_RefreshProcView(m);
+    }
+
+    if (sections & COLLECTOR_SECTION_MEMORY) {
+        apply_memory(m, t);
+    }
+    if (sections & COLLECTOR_SECTION_DISK) {
+        apply_disks(m, t);
+    }
+    if (sections & COLLECTOR_SECTION_GPU) {
+        apply_gpu(m, t);
+    }
+
+    SelfStats_End(&m->self, m->stageApply, &timer);
+}
+
+static void record_tick(Monitor *m, uint32_t sections, int64_t t, double dt)
+{
+    if (!m->recorder) return;
+    const SelfTimer timer = SelfStats_Begin();
+    Recorder_WriteTick(m->recorder, &m->snap, sections, t, dt);
+    SelfStats_End(&m->self, m->stageRecord, &timer);
+}
+
+void Monitor_Sample(Monitor *m, double dt)
+{
+    const uint32_t sections = Monitor_Collect(m, dt);
+    const int64_t t = Qpc_Now();
+    record_tick(m, sections, t, dt);
+    Monitor_Apply(m, sections, t, dt);
+}
+
+// ---------------------------------------------------------------------------
+// Multi-rate schedule
+
+static int64_t seconds_to_qpc(const Monitor *m, double sec)
+{
+    const int64_t ticks = (int64_t)(sec * m->qpcFreq);
+    return (ticks > 0) ? ticks : 1;
+}
+
+void Monitor_StartSchedule(Monitor *m, double basePeriodSec, int64_t now)
+{
+    if (!m) return;
+
+    m->qpcFreq = Qpc_Freq();
+    m->lastFreqApplyQpc = now;
+    Schedule_Clear(&m->schedule);
+
+    for (uint32_t i = 0; i < m->collectorCount; i++) {
+        if (!m->collectorOk[i]) continue;
+        const CollectorOps *c = m->collectors[i];
+        m->collectorPeriodSec[i] = (c->periodSec > 0.0) ? c->periodSec : basePeriodSec;
+        m->collectorLastQpc[i] = now;
+        const int64_t phase = (c->phaseSec > 0.0) ? (int64_t)(c->phaseSec * m->qpcFreq) : 0;
+        (void)Schedule_Push(&m->schedule, i, now + phase);
+    }
+}
+
+uint32_t Monitor_Tick(Monitor *m, int64_t now)
+{
+    if (!m) return 0;
+
+    const SelfTimer tick = SelfStats_Begin();
+    uint32_t sections = 0;
+    ScheduleEntry e;
+    while (Schedule_PopDue(&m->schedule, now, &e)) {
+        const uint32_t i = e.id;
+        const CollectorOps *c = m->collectors[i];
+        const double dt = Qpc_Seconds(now - m->collectorLastQpc[i], m->qpcFreq);
+        m->collectorLastQpc[i] = now;
+
+        const SelfTimer t = SelfStats_Begin();
+        (void)c->sample(m->collectorState[i], dt, &m->snap);
+        SelfStats_End(&m->self, m->collectorStage[i], &t);
+        sections |= c->sections;
+
+        // Stay on the collector's phase grid; if a deadline was missed entirely
+        // (suspend, slow WMI), skip ahead instead of sampling in a burst.
+        const int64_t period = seconds_to_qpc(m, m->collectorPeriodSec[i]);
+        int64_t next = e.due + period;
+        if (next <= now) {
+            next = now + period;
+        }
+        (void)Schedule_Push(&m->schedule, i, next);
+    }
+
+    if (sections) {
+        double dt = 0.0;
+        if (sections & COLLECTOR_SECTION_CPU_FREQ) {
+            dt = Qpc_Seconds(now - m->lastFreqApplyQpc, m->qpcFreq);
+            m->lastFreqApplyQpc = now;
+        }
+        record_tick(m, sections, now, dt);
+        Monitor_Apply(m, sections, now, dt);
+        SelfStats_End(&m->self, m->stageTick, &tick);
+    }
+    return sections;
+}
+
+int64_t Monitor_NextDueQpc(const Monitor *m, int64_t now)
+{
+    ScheduleEntry e;
+    if (!m || !Schedule_Peek(&m->schedule, &e)) {
+        return now;
+    }
+    return e.due;
+}
+
+// ---------------------------------------------------------------------------
+// Frame capture (sampler thread -> UI)
+
+static bool ensure_cap(void **p, uint32_t *cap, uint32_t want, size_t elemSize)
+{
+    if (want <= *cap && (*p || want == 0)) return true;
+    uint32_t newCap = *cap ? *cap : 64;
+    while (newCap < want) newCap *= 2u;
+    void *np = realloc(*p, (size_t)newCap * elemSize);
+    if (!np) return false;
+    SelfStats_NoteAlloc();
+    *p = np;
+    *cap = newCap;
+    return true;
+}
+
+static bool capture_series_array(RingBufF **dst, uint32_t *dstCount, const RingBufF *src, uint32_t count)
+{
+    if (*dstCount != count) {
+        shutdown_series_array(*dst, *dstCount);
+        free(*dst);
+        *dst = NULL;
+        *dstCount = 0;
+        if (count == 0 || !src) return true;
+
+        *dst = (RingBufF *)calloc(count, sizeof(RingBufF));
+        if (!*dst) return false;
+        *dstCount = count;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < count; i++) {
+        ok = RingBuf_CopyFrom(&(*dst)[i], &src[i]) && ok;
+    }
+    return ok;
+}
+
+static bool capture_rollup_array(HistRollup **dst, uint32_t *dstCount, const HistRollup *src, uint32_t count)
+{
+    if (*dstCount != count) {
+        shutdown_rollup_array(*dst, *dstCount);
+        free(*dst);
+        *dst = NULL;
+        *dstCount = 0;
+        if (count == 0 || !src) return true;
+
+        *dst = (HistRollup *)calloc(count, sizeof(HistRollup));
+        if (!*dst) return false;
+        *dstCount = count;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < count; i++) {
+        ok = HistRollup_CopyFrom(&(*dst)[i], &src[i]) && ok;
+    }
+    return ok;
+}
+
+static bool capture_archive_array(CompressedSeries **dst, uint32_t *dstCount, const CompressedSeries *src,
+                                  uint32_t count)
+{
+    if (*dstCount != count) {
+        shutdown_archive_array(*dst, *dstCount);
+        free(*dst);
+        *dst = NULL;
+        *dstCount = 0;
+        if (count == 0 || !src) return true;
+
+        *dst = (CompressedSeries *)calloc(count, sizeof(CompressedSeries));
+        if (!*dst) return false;
+        *dstCount = count;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < count; i++) {
+        ok = CompressedSeries_CopyFrom(&(*dst)[i], &src[i]) && ok;
+    }
+    return ok;
+}
+
+static bool capture_disks(MonitorFrame *f, const Monitor *m)
+{
+    if (f->diskCount != m->diskCount) {
+        for (uint32_t i = 0; i < f->diskCount; i++) {
+            shutdown_disk_series(&f->disks[i]);
+        }
+        free(f->disks);
+        f->disks = NULL;
+        f->diskCount = 0;
+        if (m->diskCount == 0 || !m->disks) return true;
+
+        f->disks = (DiskSeries *)calloc(m->diskCount, sizeof(DiskSeries));
+        if (!f->disks) return false;
+        f->diskCount = m->diskCount;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < f->diskCount; i++) {
+        DiskSeries *d = &f->disks[i];
+        const DiskSeries *s = &m->disks[i];
+        memcpy(d->name, s->name, sizeof(d->name));
+        d->readMBps = s->readMBps;
+        d->writeMBps = s->writeMBps;
+        WindowStats_Summarize(&s->readWindow, &d->readStats);
+        WindowStats_Summarize(&s->writeWindow, &d->writeStats);
+        ok = RingBuf_CopyFrom(&d->readMBpsHistory, &s->readMBpsHistory) && ok;
+        ok = RingBuf_CopyFrom(&d->writeMBpsHistory, &s->writeMBpsHistory) && ok;
+        ok = CompressedSeries_CopyFrom(&d->readArchive, &s->readArchive) && ok;
+        ok = CompressedSeries_CopyFrom(&d->writeArchive, &s->writeArchive) && ok;
+    }
+    return ok;
+}
+
+static bool capture_per_core(MonitorFrame *f, const Monitor *m)
+{
+    if (f->logicalCount != m->logicalCount || !f->coreUsage) {
+        free(f->coreUsage);
+        free(f->coreMHz);
+        free(f->coreMaxMHz);
+        f->coreUsage = (float *)calloc(m->logicalCount, sizeof(float));
+        f->coreMHz = (float *)calloc(m->logicalCount, sizeof(float));
+        f->coreMaxMHz = (float *)calloc(m->logicalCount, sizeof(float));
+        if (!f->coreUsage || !f->coreMHz || !f->coreMaxMHz) {
+            free(f->coreUsage);
+            free(f->coreMHz);
+            free(f->coreMaxMHz);
+            f->coreUsage = f->coreMHz = f->coreMaxMHz = NULL;
+            CoreHistory_Shutdown(&f->coreUsageHistory);
+            shutdown_rollup_array(f->coreUsageRollup, f->logicalCount);
+            free(f->coreUsageRollup);
+            f->coreUsageRollup = NULL;
+            shutdown_archive_array(f->coreUsageArchive, f->logicalCount);
+            free(f->coreUsageArchive);
+            f->coreUsageArchive = NULL;
+            f->logicalCount = 0;
+            return false;
+        }
+    }
+
+    memcpy(f->coreUsage, m->coreUsage, (size_t)m->logicalCount * sizeof(float));
+    memcpy(f->coreMHz, m->coreMHz, (size_t)m->logicalCount * sizeof(float));
+    memcpy(f->coreMaxMHz, m->coreMaxMHz, (size_t)m->logicalCount * sizeof(float));
+
+    uint32_t rollupCount = f->logicalCount;
+    uint32_t archiveCount = f->coreUsageArchive ? f->logicalCount : 0;
+    bool ok = CoreHistory_CopyFrom(&f->coreUsageHistory, &m->coreUsageHistory);
+    ok = capture_rollup_array(&f->coreUsageRollup, &rollupCount, m->coreUsageRollup, m->logicalCount) && ok;
+    ok = capture_archive_array(&f->coreUsageArchive, &archiveCount, m->coreUsageArchive, m->logicalCount) && ok;
+    if (archiveCount != rollupCount) {
+        shutdown_archive_array(f->coreUsageArchive, archiveCount);
+        free(f->coreUsageArchive);
+        f->coreUsageArchive = NULL;
+    }
+    f->logicalCount = rollupCount;
+    return ok;
+}
+
+static bool capture_procs(MonitorFrame *f, const Monitor *m)
+{
+    const ProcView *sv = &m->procView;
+    ProcView *dv = &f->procView;
+
+    // The process walk runs slower than the CPU counters; most frames already hold
+    // the current view.
+    if (f->procViewGen == m->procViewGen && f->procViewGen != 0) {
+        return true;
+    }
+    f->procViewGen = 0;
+
+    dv->settings = sv->settings;
+    f->procCount = m->procTable.rowCount;
+
+    // Flat view reads the table rows; stacked view reads its own rows. Both name their
+    // strings in the table's pool, which mostly only gains strings between copies.
+    const uint32_t tableRows = sv->settings.stacked ? 0 : m->procTable.rowCount;
+    bool ok = StrPool_CopyFrom(&f->procTable.strings, &m->procTable.strings) &&
+              ensure_cap((void **)&f->procTable.rows, &f->procTable.rowCap, tableRows, sizeof(ProcRow)) &&
+              ensure_cap((void **)&dv->rows, &dv->rowCap, sv->rowCount, sizeof(ProcRow)) &&
+              ensure_cap((void **)&dv->groups, &dv->groupCap, sv->groupCount, sizeof(ProcGroupIndex)) &&
+              ensure_cap((void **)&dv->members, &dv->memberCap, sv->memberCount, sizeof(uint32_t));
+    if (!ok) {
+        f->procTable.rowCount = 0;
+        dv->rowCount = 0;
+        dv->groupCount = 0;
+        dv->memberCount = 0;
+        return false;
+    }
+
+    if (tableRows) memcpy(f->procTable.rows, m->procTable.rows, (size_t)tableRows * sizeof(ProcRow));
+    f->procTable.rowCount = tableRows;
+    f->procTable.sortedCount = tableRows ? m->procTable.sortedCount : 0;
+
+    if (sv->rowCount) memcpy(dv->rows, sv->rows, (size_t)sv->rowCount * sizeof(ProcRow));
+    if (sv->groupCount) memcpy(dv->groups, sv->groups, (size_t)sv->groupCount * sizeof(ProcGroupIndex));
+    if (sv->memberCount) memcpy(dv->members, sv->members, (size_t)sv->memberCount * sizeof(uint32_t));
+    dv->rowCount = sv->rowCount;
+    dv->sortedCount = sv->sortedCount;
+    dv->groupCount = sv->groupCount;
+    dv->memberCount = sv->memberCount;
+    ProcTable_IndexRows(&f->procTable);
+    ProcView_IndexRows(dv);
+    f->procViewGen = m->procViewGen;
+    return true;
+}
+
+bool MonitorFrame_Capture(MonitorFrame *f, const Monitor *m)
+{
+    if (!f || !m) return false;
+
+    bool ok = true;
+
+    f->snap = m->snap;
+    f->snap.coreCpu = NULL;
+    f->snap.coreMHz = NULL;
+    f->snap.coreMaxMHz = NULL;
+    f->snap.diskNames = NULL;
+    f->snap.diskReadBytesPerSec = NULL;
+    f->snap.diskWriteBytesPerSec = NULL;
+    f->snap.gpuEnginePct = NULL;
+    f->snap.procs = NULL;
+    f->snap.gpuEngineNames = NULL;
+    if (m->snap.gpuEngineCount > 0 && m->snap.gpuEngineNames) {
+        const wchar_t **names = (const wchar_t **)realloc((void *)f->gpuEngineNameBuf, m->snap.gpuEngineCount * sizeof(*names));
+        if (names) {
+            memcpy((void *)names, (const void *)m->snap.gpuEngineNames, m->snap.gpuEngineCount * sizeof(*names));
+            f->gpuEngineNameBuf = names;
+            f->snap.gpuEngineNames = names;
+        } else {
+            f->snap.gpuEngineCount = 0;
+            f->snap.hasGpuEngines = false;
+            ok = false;
+        }
+    }
+
+    ok = capture_per_core(f, m) && ok;
+
+    ok = RingBuf_CopyFrom(&f->totalUsageHistory, &m->totalUsageHistory) && ok;
+    ok = RingBuf_CopyFrom(&f->memUsedPctHistory, &m->memUsedPctHistory) && ok;
+    ok = RingBuf_CopyFrom(&f->commitUsedPctHistory, &m->commitUsedPctHistory) && ok;
+    ok = RingBuf_CopyFrom(&f->gpuDedicatedUsedMBHistory, &m->gpuDedicatedUsedMBHistory) && ok;
+    ok = RingBuf_CopyFrom(&f->gpuSharedUsedMBHistory, &m->gpuSharedUsedMBHistory) && ok;
+    ok = RingBuf_CopyFrom(&f->diskReadMBpsHistory, &m->diskReadMBpsHistory) && ok;
+    ok = RingBuf_CopyFrom(&f->diskWriteMBpsHistory, &m->diskWriteMBpsHistory) && ok;
+    ok = HistRollup_CopyFrom(&f->totalUsageRollup, &m->totalUsageRollup) && ok;
+    ok = HistRollup_CopyFrom(&f->memUsedPctRollup, &m->memUsedPctRollup) && ok;
+    ok = HistRollup_CopyFrom(&f->commitUsedPctRollup, &m->commitUsedPctRollup) && ok;
+    ok = HistRollup_CopyFrom(&f->gpuDedicatedUsedMBRollup, &m->gpuDedicatedUsedMBRollup) && ok;
+    ok = HistRollup_CopyFrom(&f->gpuSharedUsedMBRollup, &m->gpuSharedUsedMBRollup) && ok;
+    ok = HistRollup_CopyFrom(&f->diskReadMBpsRollup, &m->diskReadMBpsRollup) && ok;
+    ok = HistRollup_CopyFrom(&f->diskWriteMBpsRollup, &m->diskWriteMBpsRollup) && ok;
+    WindowStats_Summarize(&m->totalUsageWindow, &f->totalUsageStats);
+    WindowStats_Summarize(&m->memUsedPctWindow, &f->memUsedPctStats);
+    WindowStats_Summarize(&m->commitUsedPctWindow, &f->commitUsedPctStats);
+    WindowStats_Summarize(&m->gpuDedicatedUsedMBWindow, &f->gpuDedicatedUsedMBStats);
+    WindowStats_Summarize(&m->gpuSharedUsedMBWindow, &f->gpuSharedUsedMBStats);
+    WindowStats_Summarize(&m->diskReadMBpsWindow, &f->diskReadMBpsStats);
+    WindowStats_Summarize(&m->diskWriteMBpsWindow, &f->diskWriteMBpsStats);
+    ok = capture_series_array(&f->gpuEnginePctHistory, &f->gpuEngineTypeCount,
+                              m->gpuEnginePctHistory, m->gpuEngineTypeCount) && ok;
+    ok = capture_archive_array(&f->gpuEngineArchive, &f->gpuEngineArchiveCount,
+                               m->gpuEngineArchive, m->gpuEngineArchiveCount) && ok;
+    ok = capture_disks(f, m) && ok;
+
+    f->totalUsage = m->totalUsage;
+    f->totalUsageMin = m->totalUsageMin;
+    f->totalUsageMax = m->totalUsageMax;
+    f->freqChangeCount = m->freqChangeCount;
+    f->freqChangesPerSec = m->freqChangesPerSec;
+    f->throttlePct = m->throttlePct;
+
+    f->memTotalPhysBytes = m->memTotalPhysBytes;
+    f->memAvailPhysBytes = m->memAvailPhysBytes;
+    f->commitTotalBytes = m->commitTotalBytes;
+    f->commitLimitBytes = m->commitLimitBytes;
+    f->memUsedPct = m->memUsedPct;
+    f->commitUsedPct = m->commitUsedPct;
+    f->diskReadMBps = m->diskReadMBps;
+    f->diskWriteMBps = m->diskWriteMBps;
+
+    f->gpuDedicatedUsedMB = m->gpuDedicatedUsedMB;
+    f->gpuDedicatedLimitMB = m->gpuDedicatedLimitMB;
+    f->gpuSharedUsedMB = m->gpuSharedUsedMB;
+    f->gpuSharedLimitMB = m->gpuSharedLimitMB;
+
+    ok = capture_procs(f, m) && ok;
+
+    memcpy(&f->self, &m->self, sizeof(f->self));
+    return ok;
+}
+
+void MonitorFrame_Shutdown(MonitorFrame *f)
+{
+    if (!f) return;
+
+    CoreHistory_Shutdown(&f->coreUsageHistory);
+    shutdown_rollup_array(f->coreUsageRollup, f->logicalCount);
+    free(f->coreUsageRollup);
+    shutdown_archive_array(f->coreUsageArchive, f->coreUsageArchive ? f->logicalCount : 0);
+    free(f->coreUsageArchive);
+    free(f->coreUsage);
+    free(f->coreMHz);
+    free(f->coreMaxMHz);
+
+    RingBuf_Shutdown(&f->totalUsageHistory);
+    RingBuf_Shutdown(&f->memUsedPctHistory);
+    RingBuf_Shutdown(&f->commitUsedPctHistory);
+    RingBuf_Shutdown(&f->gpuDedicatedUsedMBHistory);
+    RingBuf_Shutdown(&f->gpuSharedUsedMBHistory);
+    RingBuf_Shutdown(&f->diskReadMBpsHistory);
+    RingBuf_Shutdown(&f->diskWriteMBpsHistory);
+    HistRollup_Shutdown(&f->totalUsageRollup);
+    HistRollup_Shutdown(&f->memUsedPctRollup);
+    HistRollup_Shutdown(&f->commitUsedPctRollup);
+    HistRollup_Shutdown(&f->gpuDedicatedUsedMBRollup);
+    HistRollup_Shutdown(&f->gpuSharedUsedMBRollup);
+    HistRollup_Shutdown(&f->diskReadMBpsRollup);
+    HistRollup_Shutdown(&f->diskWriteMBpsRollup);
+    shutdown_series_array(f->gpuEnginePctHistory, f->gpuEngineTypeCount);
+    free(f->gpuEnginePctHistory);
+    shutdown_archive_array(f->gpuEngineArchive, f->gpuEngineArchiveCount);
+    free(f->gpuEngineArchive);
+
+    for (uint32_t i = 0; i < f->diskCount; i++) {
+        shutdown_disk_series(&f->disks[i]);
+    }
+    free(f->disks);
+
+    ProcTable_Shutdown(&f->procTable);
+    ProcView_Shutdown(&f->procView);
+    free((void *)f->gpuEngineNameBuf);
+
+    memset(f, 0, sizeof(*f));
+}
+
+static void export_series(FILE *out, const wchar_t *kind, const wchar_t *name, uint32_t index,
+                          const CompressedSeries *s, double refMs)
+{
+    SeriesCursor c;
+    SeriesCursor_Begin(&c, s);
+    int64_t t = 0;
+    float v = 0.0f;
+    while (SeriesCursor_Next(&c, &t, &v)) {
+        if (name) {
+            fprintf(out, "%ls %ls,%.3f,%g\n", kind, name, ((double)t - refMs) / 1000.0, (double)v);
+        } else {
+            fprintf(out, "%ls %u,%.3f,%g\n", kind, index, ((double)t - refMs) / 1000.0, (double)v);
+        }
+    }
+}
+
+bool MonitorFrame_ExportArchive(const MonitorFrame *f, FILE *out)
+{
+    if (!f || !out) return false;
+
+    const double refMs = (double)f->sampleQpc * 1000.0 / Qpc_Freq();
+    fprintf(out, "series,seconds,value\n");
+    if (f->coreUsageArchive) {
+        for (uint32_t i = 0; i < f->logicalCount; i++) {
+            export_series(out, L"cpu", NULL, i, &f->coreUsageArchive[i], refMs);
+        }
+    }
+    for (uint32_t i = 0; i < f->diskCount; i++) {
+        export_series(out, L"disk read MB/s", f->disks[i].name, i, &f->disks[i].readArchive, refMs);
+        export_series(out, L"disk write MB/s", f->disks[i].name, i, &f->disks[i].writeArchive, refMs);
+    }
+    for (uint32_t i = 0; i < f->gpuEngineArchiveCount; i++) {
+        const wchar_t *nm = (f->snap.gpuEngineNames && i < f->snap.gpuEngineCount) ? f->snap.gpuEngineNames[i] : NULL;
+        export_series(out, L"gpu", nm, i, &f->gpuEngineArchive[i], refMs);
+    }
+    return ferror(out) == 0;
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <wchar.h>
+
+#include "collector.h"
+#include "compressed_series.h"
+#include "core_history.h"
+#include "history.h"
+#include "history_file.h"
+#include "proc_table.h"
+#include "proc_view.h"
+#include "ringbuf.h"
+#include "schedule.h"
+#include "self_stats.h"
+#include "window_stats.h"
+
+struct Recorder;
+
+// Rollup tiers kept behind every raw history: 0 spans the last hour, 1 the last day.
+#define MONITOR_ROLLUP_TIERS 2u
+#define MONITOR_TIER_HOUR 0u
+#define MONITOR_TIER_DAY 1u
+
+// Compressed archive (compressed_series.h) behind the per-core, per-disk and per-GPU-engine
+// series: a day of per-core hour-tier bucket means and of every disk and engine sample.
+// Archive timestamps are Qpc_Now() in milliseconds.
+#define MONITOR_ARCHIVE_SEC 86400u
+
+// Portable sampling engine: runs the collectors, then derives everything the UI shows
+// (histories, min/max, frequency changes, throttling, disk/GPU series, process view).
+// Contains no OS calls, so it runs unchanged on Windows, on Linux and in benchmarks.
+
+typedef struct DiskSeries {
+    wchar_t name[128];
+    RingBufF readMBpsHistory;
+    RingBufF writeMBpsHistory;
+    WindowStats readWindow; // Monitor only
+    WindowStats writeWindow;
+    WindowSummary readStats; // MonitorFrame only (filled by MonitorFrame_Capture)
+    WindowSummary writeStats;
+    CompressedSeries readArchive;
+    CompressedSeries writeArchive;
+    double readMBps;
+    double writeMBps;
+} DiskSeries;
+
+typedef struct Monitor {
+    // Collectors, sampled in order into snap.
+    const CollectorOps *const *collectors;
+    void **collectorState;
+    bool *collectorOk;
+    uint32_t collectorCount;
+
+    // Per-collector schedule (Monitor_StartSchedule / Monitor_Tick).
+    double *collectorPeriodSec;
+    int64_t *collectorLastQpc;
+    Schedule schedule;
+    double qpcFreq;
+    int64_t lastFreqApplyQpc;
+
+    // Self-instrumentation (sampler thread): one stage per collector plus the
+    // derived work below.
+    SelfStats self;
+    uint32_t *collectorStage;
+    uint32_t stageApply;
+    uint32_t stageProcSort;
+    uint32_t stageProcView;
+    uint32_t stageTick;
+    uint32_t stageRecord;
+
+    // Optional capture of every tick's raw collector output (record.h); not owned.
+    struct Recorder *recorder;
+
+    // Optional memory-mapped backing of the raw histories (Monitor_AttachHistoryFile).
+    HistoryFile *historyFile;
+
+    // Latest raw readings.
+    CollectorSnapshot snap;
+
+    uint32_t logicalCount;
+    uint32_t histCap;
+
+    // History: total usage + per-core usage
+    RingBufF totalUsageHistory;
+    CoreHistory coreUsageHistory; // all cores, one row per sample
+
+    // Memory + storage history
+    RingBufF memUsedPctHistory;
+    RingBufF commitUsedPctHistory;
+
+    // GPU history (best-effort)
+    RingBufF gpuDedicatedUsedMBHistory;
+    RingBufF gpuSharedUsedMBHistory;
+    RingBufF *gpuEnginePctHistory; // length = gpuEngineTypeCount
+    uint32_t gpuEngineTypeCount;
+
+    DiskSeries *disks;
+    uint32_t diskCount;
+
+    // Fallback (if per-disk counters aren't available)
+    RingBufF diskReadMBpsHistory;
+    RingBufF diskWriteMBpsHistory;
+
+    // Long-range tiers behind the histories above (history.h). Per-core series use
+    // coarser tiers than the totals to keep many-core machines bounded.
+    HistRollup totalUsageRollup;
+    HistRollup *coreUsageRollup;
+    HistRollup memUsedPctRollup;
+    HistRollup commitUsedPctRollup;
+    HistRollup gpuDedicatedUsedMBRollup;
+    HistRollup gpuSharedUsedMBRollup;
+    HistRollup diskReadMBpsRollup;
+    HistRollup diskWriteMBpsRollup;
+
+    // Day-long compressed archives (MONITOR_ARCHIVE_SEC); disks keep theirs in DiskSeries.
+    CompressedSeries *coreUsageArchive; // length = logicalCount
+    uint64_t *coreArchivedPushes;       // per core: hour-tier mean pushes already archived
+    CompressedSeries *gpuEngineArchive; // length = gpuEngineArchiveCount
+    uint32_t gpuEngineArchiveCount;
+
+    // Sliding-window statistics over the same samples as the raw histories.
+    WindowStats totalUsageWindow;
+    WindowStats memUsedPctWindow;
+    WindowStats commitUsedPctWindow;
+    WindowStats gpuDedicatedUsedMBWindow;
+    WindowStats gpuSharedUsedMBWindow;
+    WindowStats diskReadMBpsWindow;
+    WindowStats diskWriteMBpsWindow;
+
+    // Latest derived values
+    float totalUsage;
+    float totalUsageMin; // over the history window
+    float totalUsageMax;
+    float *coreUsage;
+    float *coreMHz;
+    float *coreMaxMHz;
+
+    float *prevCoreMHz;
+    uint32_t freqChangeCount;
+    double freqChangesPerSec;
+    float throttlePct;
+
+    // Memory + storage (latest)
+    uint64_t memTotalPhysBytes;
+    uint64_t memAvailPhysBytes;
+    uint64_t commitTotalBytes;
+    uint64_t commitLimitBytes;
+    float memUsedPct;
+    float commitUsedPct;
+    double diskReadMBps;
+    double diskWriteMBps;
+
+    // GPU (latest, best-effort)
+    double gpuDedicatedUsedMB;
+    double gpuDedicatedLimitMB;
+    double gpuSharedUsedMB;
+    double gpuSharedLimitMB;
+
+    // Process table + (optionally stacked) view
+    ProcTable procTable;
+    ProcView procView;
+    uint32_t procViewGen; // bumped by Monitor_RefreshProcView
+} Monitor;
+
+// Immutable copy of everything the UI reads from a Monitor, published by the sampler
+// thread (sampler.h). Field names match Monitor so readers can switch between them.
+typedef struct MonitorFrame {
+    uint64_t seq;      // publish counter (0 = not yet published)
+    int64_t sampleQpc; // Qpc_Now() when the sample finished
+    double collectMs;  // time spent in Monitor_Sample for this frame
+
+    // Latest raw readings. Pointers into collector/Monitor memory are cleared;
+    // gpuEngineNames points at frame-owned storage.
+    CollectorSnapshot snap;
+
+    uint32_t logicalCount;
+
+    RingBufF totalUsageHistory;
+    CoreHistory coreUsageHistory;
+    RingBufF memUsedPctHistory;
+    RingBufF commitUsedPctHistory;
+    RingBufF gpuDedicatedUsedMBHistory;
+    RingBufF gpuSharedUsedMBHistory;
+    RingBufF *gpuEnginePctHistory;
+    uint32_t gpuEngineTypeCount;
+    DiskSeries *disks;
+    uint32_t diskCount;
+    RingBufF diskReadMBpsHistory;
+    RingBufF diskWriteMBpsHistory;
+
+    HistRollup totalUsageRollup;
+    HistRollup *coreUsageRollup; // length = logicalCount
+    HistRollup memUsedPctRollup;
+    HistRollup commitUsedPctRollup;
+    HistRollup gpuDedicatedUsedMBRollup;
+    HistRollup gpuSharedUsedMBRollup;
+    HistRollup diskReadMBpsRollup;
+    HistRollup diskWriteMBpsRollup;
+
+    CompressedSeries *coreUsageArchive; // length = logicalCount
+    CompressedSeries *gpuEngineArchive;
+    uint32_t gpuEngineArchiveCount;
+
+    // Summaries of the Monitor's WindowStats as of this frame.
+    WindowSummary totalUsageStats;
+    WindowSummary memUsedPctStats;
+    WindowSummary commitUsedPctStats;
+    WindowSummary gpuDedicatedUsedMBStats;
+    WindowSummary gpuSharedUsedMBStats;
+    WindowSummary diskReadMBpsStats;
+    WindowSummary diskWriteMBpsStats;
+
+    float totalUsage;
+    float totalUsageMin;
+    float totalUsageMax;
+    float *coreUsage;
+    float *coreMHz;
+    float *coreMaxMHz;
+    uint32_t freqChangeCount;
+    double freqChangesPerSec;
+    float throttlePct;
+
+    uint64_t memTotalPhysBytes;
+    uint64_t memAvailPhysBytes;
+    uint64_t commitTotalBytes;
+    uint64_t commitLimitBytes;
+    float memUsedPct;
+    float commitUsedPct;
+    double diskReadMBps;
+    double diskWriteMBps;
+
+    double gpuDedicatedUsedMB;
+    double gpuDedicatedLimitMB;
+    double gpuSharedUsedMB;
+    double gpuSharedLimitMB;
+
+    // Process view. procTable only carries rows when the view is flat (not stacked);
+    // procCount is always the number of running processes.
+    ProcTable procTable;
+    ProcView procView;
+    uint32_t procCount;
+    uint32_t procViewGen;
+
+    SelfStats self; // sampler-side stage histograms as of this frame
+
+    const wchar_t **gpuEngineNameBuf; // backing store for snap.gpuEngineNames
+} MonitorFrame;
+
+// histCap = raw samples kept per series; older data is kept by the rollup tiers.
+// Collectors that fail to init are skipped.
+bool Monitor_Init(Monitor *m, uint32_t logicalCount, uint32_t histCap,
+                  const CollectorOps *const *collectors, uint32_t collectorCount);
+void Monitor_Shutdown(Monitor *m);
+
+// (Re)creates the per-disk and per-GPU-engine series from the shape in m->snap.
+// Monitor_Init calls it after collector init; replay calls it after publishing the
+// recorded shape.
+void Monitor_InitDeviceSeries(Monitor *m);
+
+// Moves the raw CPU, memory, disk-total and GPU-memory histories onto a memory-mapped
+// history file (history_file.h; f opened for binary read/write, owned from here on) and
+// continues from the samples it holds, feeding them to the rollups and window statistics
+// too. Call after Monitor_Init, before the first sample. Returns false if f can't be mapped.
+bool Monitor_AttachHistoryFile(Monitor *m, FILE *f, int64_t now);
+// Saves the history file's ring cursors and starts its write-back (no-op without one).
+void Monitor_FlushHistoryFile(Monitor *m, int64_t now);
+
+// Runs every collector into m->snap; returns the CollectorSection mask refreshed.
+uint32_t Monitor_Collect(Monitor *m, double dt);
+
+// Derives histories and latest values for the given CollectorSection mask from m->snap
+// (no OS calls). t = sample time stamped into the histories; dt = seconds since the
+// CPU frequency section was last applied (frequency change rate).
+void Monitor_Apply(Monitor *m, uint32_t sections, int64_t t, double dt);
+
+// Monitor_Collect + Monitor_Apply for all collectors at once (benchmarks, replay).
+void Monitor_Sample(Monitor *m, double dt);
+
+// Arms the per-collector schedule at time now. Collectors without their own period
+// run every basePeriodSec.
+void Monitor_StartSchedule(Monitor *m, double basePeriodSec, int64_t now);
+
+// Runs the collectors that are due at now and applies what they refreshed.
+// Returns the CollectorSection mask applied (0 = nothing was due).
+uint32_t Monitor_Tick(Monitor *m, int64_t now);
+
+// Time of the next collector deadline (now if nothing is scheduled).
+int64_t Monitor_NextDueQpc(const Monitor *m, int64_t now);
+
+// Re-sorts/re-groups the process view after a UI state change (sort key, stacking, expansion).
+void Monitor_RefreshProcView(Monitor *m);
+
+// Deep-copies m into f, reusing f's allocations. Returns false on allocation failure
+// (f is then left partially updated but consistent to read).
+bool MonitorFrame_Capture(MonitorFrame *f, const Monitor *m);
+void MonitorFrame_Shutdown(MonitorFrame *f);
+
+// Writes every archive in f as CSV (series,seconds,value; seconds relative to the frame's
+// sample, so <= 0), decoding one sample at a time. Returns false on a write error.
+bool MonitorFrame_ExportArchive(const MonitorFrame *f, FILE *out);
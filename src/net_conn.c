@@ -0,0 +1,344 @@
+#include "net_conn.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "qpc.h"
+#include "self_stats.h"
+
+static uint32_t grown_cap(uint32_t cap, uint32_t want, uint32_t initial)
+{
+    uint32_t n = cap ? cap : initial;
+    while (n < want) {
+        if (n > (UINT32_MAX / 2u)) return want;
+        n *= 2u;
+    }
+    return n;
+}
+
+static bool resize(void **buf, uint32_t n, size_t elemSize)
+{
+    void *p = realloc(*buf, (size_t)n * elemSize);
+    if (!p) return false;
+    SelfStats_NoteAlloc();
+    *buf = p;
+    return true;
+}
+
+static bool is_v4_mapped(const uint8_t *a)
+{
+    static const uint8_t kPrefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    return memcmp(a, kPrefix, sizeof(kPrefix)) == 0;
+}
+
+static bool is_remote_v4(const uint8_t *a)
+{
+    if (a[0] == 127) return false; // 127.0.0.0/8 loopback
+    return (a[0] | a[1] | a[2] | a[3]) != 0;
+}
+
+bool NetConns_IsRemote(const NetConn *c)
+{
+    if (!c) return false;
+    if (c->family == 4) return is_remote_v4(c->remote);
+    if (is_v4_mapped(c->remote)) return is_remote_v4(c->remote + 12);
+
+    static const uint8_t kLoopback[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    if (memcmp(c->remote, kLoopback, sizeof(kLoopback)) == 0) return false;
+    for (uint32_t i = 0; i < 16u; i++) {
+        if (c->remote[i] != 0) return true;
+    }
+    return false;
+}
+
+// Appends to out[*len] while there is room (the terminator included).
+static void put_text(wchar_t *out, uint32_t outCount, uint32_t *len, const char *s)
+{
+    for (; *s && *len + 1u < outCount; s++) {
+        out[(*len)++] = (wchar_t)*s;
+    }
+}
+
+static void put_uint(wchar_t *out, uint32_t outCount, uint32_t *len, uint32_t v, uint32_t base)
+{
+    static const char kDigits[] = "0123456789abcdef";
+    char tmp[12];
+    uint32_t n = 0;
+    do {
+        tmp[n++] = kDigits[v % base];
+        v /= base;
+    } while (v != 0);
+    char s[12];
+    for (uint32_t i = 0; i < n; i++) {
+        s[i] = tmp[n - 1u - i];
+    }
+    s[n] = 0;
+    put_text(out, outCount, len, s);
+}
+
+static void put_v4(wchar_t *out, uint32_t outCount, uint32_t *len, const uint8_t *a)
+{
+    for (uint32_t i = 0; i < 4u; i++) {
+        if (i) put_text(out, outCount, len, ".");
+        put_uint(out, outCount, len, a[i], 10u);
+    }
+}
+
+static void put_v6(wchar_t *out, uint32_t outCount, uint32_t *len, const uint8_t *a)
+{
+    if (is_v4_mapped(a)) {
+        put_text(out, outCount, len, "::ffff:");
+        put_v4(out, outCount, len, a + 12);
+        return;
+    }
+
+    uint32_t groups[8];
+    for (uint32_t i = 0; i < 8u; i++) {
+        groups[i] = ((uint32_t)a[i * 2u] << 8) | a[i * 2u + 1u];
+    }
+    // The longest run of two or more zero groups (the first of equal runs) becomes "::".
+    uint32_t zeroStart = 8u;
+    uint32_t zeroLen = 1u;
+    for (uint32_t i = 0; i < 8u;) {
+        if (groups[i] != 0) {
+            i++;
+            continue;
+        }
+        uint32_t j = i;
+        while (j < 8u && groups[j] == 0) j++;
+        if (j - i > zeroLen) {
+            zeroStart = i;
+            zeroLen = j - i;
+        }
+        i = j;
+    }
+
+    for (uint32_t i = 0; i < 8u; i++) {
+        if (i == zeroStart) {
+            put_text(out, outCount, len, "::");
+            i += zeroLen - 1u;
+            continue;
+        }
+        if (i && i != zeroStart + zeroLen) put_text(out, outCount, len, ":");
+        put_uint(out, outCount, len, groups[i], 16u);
+    }
+}
+
+uint32_t NetConns_FormatEndpoint(const NetConn *c, wchar_t *out, uint32_t outCount)
+{
+    if (!out || outCount == 0) return 0;
+    uint32_t len = 0;
+    if (c) {
+        if (c->family == 4) {
+            put_v4(out, outCount, &len, c->remote);
+        } else {
+            put_text(out, outCount, &len, "[");
+            put_v6(out, outCount, &len, c->remote);
+            put_text(out, outCount, &len, "]");
+        }
+        put_text(out, outCount, &len, ":");
+        put_uint(out, outCount, &len, c->remotePort, 10u);
+    }
+    out[len] = 0;
+    return len;
+}
+
+// FNV-1a over family, address and port; never 0 (0 marks sockets without a remote).
+static uint32_t endpoint_hash(const NetConn *c)
+{
+    uint32_t h = 2166136261u;
+    const uint32_t n = (c->family == 4) ? 4u : 16u;
+    h = (h ^ c->family) * 16777619u;
+    for (uint32_t i = 0; i < n; i++) {
+        h = (h ^ c->remote[i]) * 16777619u;
+    }
+    h = (h ^ (c->remotePort & 0xFFu)) * 16777619u;
+    h = (h ^ (c->remotePort >> 8)) * 16777619u;
+    return h | 1u;
+}
+
+static uint16_t sat_inc(uint16_t v)
+{
+    return (v < UINT16_MAX) ? (uint16_t)(v + 1u) : v;
+}
+
+void NetConns_Init(NetConns *nc)
+{
+    if (!nc) return;
+    memset(nc, 0, sizeof(*nc));
+    (void)StrPool_Init(&nc->endpoints);
+    nc->refreshSec = NET_CONNS_REFRESH_SEC;
+}
+
+void NetConns_Shutdown(NetConns *nc)
+{
+    if (!nc) return;
+    if (nc->freeBackend) nc->freeBackend(nc->backend);
+    free(nc->conns);
+    free(nc->pids);
+    free(nc->keys);
+    PidIndex_Shutdown(&nc->pidIndex);
+    StrPool_Shutdown(&nc->endpoints);
+    memset(nc, 0, sizeof(*nc));
+}
+
+bool NetConns_RefreshDue(const NetConns *nc, int64_t nowQpc)
+{
+    if (!nc) return false;
+    if (!nc->refreshed && !nc->failed) return true;
+    return Qpc_Seconds(nowQpc - nc->lastQpc, Qpc_Freq()) >= nc->refreshSec;
+}
+
+void NetConns_Begin(NetConns *nc)
+{
+    if (nc) nc->count = 0;
+}
+
+void NetConns_Add(NetConns *nc, const NetConn *c)
+{
+    if (!nc || !c) return;
+    if (nc->count == nc->cap) {
+        const uint32_t cap = grown_cap(nc->cap, nc->count + 1u, 256u);
+        if (cap <= nc->count || !resize((void **)&nc->conns, cap, sizeof(NetConn))) return;
+        nc->cap = cap;
+    }
+    nc->conns[nc->count++] = *c;
+}
+
+// Puts the endpoint (first listed at conn index first) into the top list, ordered by
+// connection count, then by first listing.
+static void note_remote(uint32_t *top, uint16_t *topCounts, uint32_t *topFirst, uint8_t *topCount, uint32_t first,
+                        uint16_t count)
+{
+    uint32_t i = *topCount;
+    if (i == NET_CONNS_TOP_REMOTES) {
+        const uint32_t last = i - 1u;
+        if (count < topCounts[last] || (count == topCounts[last] && first > topFirst[last])) return;
+        i = last;
+    } else {
+        (*topCount)++;
+    }
+    while (i > 0 && (count > topCounts[i - 1u] || (count == topCounts[i - 1u] && first < topFirst[i - 1u]))) {
+        top[i] = top[i - 1u];
+        topCounts[i] = topCounts[i - 1u];
+        topFirst[i] = topFirst[i - 1u];
+        i--;
+    }
+    top[i] = first;
+    topCounts[i] = count;
+    topFirst[i] = first;
+}
+
+// Stats of one PID's sockets, keys[0, n) (sorted: sockets without a remote first, then
+// one run per endpoint).
+static void fold_pid(NetConns *nc, const SortKey *keys, uint32_t n, NetPidStats *st)
+{
+    uint32_t top[NET_CONNS_TOP_REMOTES];
+    uint16_t topCounts[NET_CONNS_TOP_REMOTES];
+    uint32_t topFirst[NET_CONNS_TOP_REMOTES];
+    uint8_t topCount = 0;
+
+    for (uint32_t i = 0; i < n;) {
+        const NetConn *c = &nc->conns[keys[i].index];
+        if (c->proto == NET_PROTO_UDP) st->udp = sat_inc(st->udp);
+        else if (c->state == NET_STATE_LISTEN) st->listen = sat_inc(st->listen);
+        else st->tcp = sat_inc(st->tcp);
+        if ((uint32_t)keys[i].hi == 0) {
+            i++;
+            continue;
+        }
+
+        // One endpoint: the run of equal keys, first listed first (lo is the conn index).
+        uint32_t j = i + 1u;
+        uint16_t conns = 1;
+        while (j < n && keys[j].hi == keys[i].hi) {
+            const NetConn *m = &nc->conns[keys[j].index];
+            if (m->proto == NET_PROTO_UDP) st->udp = sat_inc(st->udp);
+            else st->tcp = sat_inc(st->tcp);
+            conns = sat_inc(conns);
+            j++;
+        }
+        st->remoteConns = (uint16_t)((st->remoteConns > UINT16_MAX - conns) ? UINT16_MAX : st->remoteConns + conns);
+        note_remote(top, topCounts, topFirst, &topCount, keys[i].index, conns);
+        i = j;
+    }
+
+    for (uint8_t k = 0; k < topCount; k++) {
+        wchar_t text[64];
+        const uint32_t len = NetConns_FormatEndpoint(&nc->conns[top[k]], text, (uint32_t)(sizeof(text) / sizeof(text[0])));
+        st->remoteIds[k] = StrPool_InternN(&nc->endpoints, text, len);
+        st->remoteCounts[k] = topCounts[k];
+    }
+    st->remoteCount = topCount;
+}
+
+void NetConns_End(NetConns *nc, int64_t nowQpc)
+{
+    if (!nc) return;
+    nc->lastQpc = nowQpc;
+    nc->refreshed = true;
+    nc->failed = false;
+    nc->pidCount = 0;
+    StrPool_Reset(&nc->endpoints);
+
+    const uint32_t n = nc->count;
+    if (n > nc->keyCap / 2u) {
+        const uint32_t cap = grown_cap(nc->keyCap, n * 2u, 512u);
+        if (!resize((void **)&nc->keys, cap, sizeof(SortKey))) {
+            nc->count = 0;
+            (void)PidIndex_Reset(&nc->pidIndex, 0);
+            return;
+        }
+        nc->keyCap = cap;
+    }
+
+    // By PID, then endpoint (hash; 0 for sockets counted but not ranked), then listing
+    // order. Two endpoints of one process whose hashes collide count as one.
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const NetConn *c = &nc->conns[i];
+        if (c->pid == 0) continue; // System Idle / orphaned sockets (TIME_WAIT)
+        const bool ranked = c->proto == NET_PROTO_TCP && c->state == NET_STATE_ESTABLISHED && NetConns_IsRemote(c);
+        SortKey *k = &nc->keys[m++];
+        k->hi = ((uint64_t)c->pid << 32) | (ranked ? endpoint_hash(c) : 0u);
+        k->lo = i;
+        k->index = i;
+    }
+    KeySort_Sort(nc->keys, m, nc->keys + n);
+
+    for (uint32_t i = 0; i < m;) {
+        const uint32_t pid = (uint32_t)(nc->keys[i].hi >> 32);
+        uint32_t j = i + 1u;
+        while (j < m && (uint32_t)(nc->keys[j].hi >> 32) == pid) j++;
+
+        if (nc->pidCount == nc->pidCap) {
+            const uint32_t cap = grown_cap(nc->pidCap, nc->pidCount + 1u, 64u);
+            if (cap <= nc->pidCount || !resize((void **)&nc->pids, cap, sizeof(NetPidStats))) break;
+            nc->pidCap = cap;
+        }
+        NetPidStats *st = &nc->pids[nc->pidCount++];
+        memset(st, 0, sizeof(*st));
+        st->pid = pid;
+        fold_pid(nc, nc->keys + i, j - i, st);
+        i = j;
+    }
+
+    (void)PidIndex_Reset(&nc->pidIndex, nc->pidCount);
+    for (uint32_t i = 0; i < nc->pidCount; i++) {
+        (void)PidIndex_Insert(&nc->pidIndex, nc->pids[i].pid, 0, i);
+    }
+}
+
+void NetConns_Fail(NetConns *nc, int64_t nowQpc)
+{
+    if (!nc) return;
+    nc->lastQpc = nowQpc;
+    nc->failed = true;
+}
+
+const NetPidStats *NetConns_Find(const NetConns *nc, uint32_t pid)
+{
+    if (!nc || nc->pidCount == 0) return NULL;
+    const uint32_t i = PidIndex_FindPid(&nc->pidIndex, pid);
+    return (i < nc->pidCount) ? &nc->pids[i] : NULL;
+}
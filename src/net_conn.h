@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#include "key_sort.h"
+#include "pid_index.h"
+#include "str_pool.h"
+
+// Connection table: the TCP and UDP sockets of the system (IPv4 and IPv6) indexed by
+// owning PID, with per-process connection counts and the remote endpoints each process
+// talks to most. The platform backend lists the sockets (NetConns_Refresh); the index is
+// rebuilt from that list in one sorted pass and answers per-process lookups in O(1).
+//
+// Listing sockets costs more than a process sample on busy machines, so the table runs
+// at its own rate: NetConns_RefreshDue tells the process sampler when the last listing
+// is older than refreshSec, and every sample in between reuses it.
+
+#ifndef NET_CONNS_TOP_REMOTES
+#define NET_CONNS_TOP_REMOTES 4u
+#endif
+#ifndef NET_CONNS_REFRESH_SEC
+#define NET_CONNS_REFRESH_SEC 2.0
+#endif
+
+typedef enum NetProto {
+    NET_PROTO_TCP = 0,
+    NET_PROTO_UDP,
+} NetProto;
+
+typedef enum NetState {
+    NET_STATE_OTHER = 0, // TCP handshakes and teardowns, unconnected UDP
+    NET_STATE_ESTABLISHED,
+    NET_STATE_LISTEN,
+} NetState;
+
+// One socket as the backend lists it. Addresses are in network byte order; an IPv4
+// address takes the first four bytes.
+typedef struct NetConn {
+    uint32_t pid;
+    uint8_t proto;  // NetProto
+    uint8_t family; // 4 or 6
+    uint8_t state;  // NetState
+    uint16_t remotePort;
+    uint8_t remote[16];
+} NetConn;
+
+typedef struct NetPidStats {
+    uint32_t pid;
+    uint16_t tcp;        // TCP connections, listening sockets excluded
+    uint16_t listen;     // listening TCP sockets
+    uint16_t udp;        // UDP sockets
+    uint16_t remoteConns; // established TCP connections to non-loopback endpoints
+    // The endpoints with the most of those connections (ids into NetConns.endpoints,
+    // most connections first, ties by first listed).
+    uint32_t remoteIds[NET_CONNS_TOP_REMOTES];
+    uint16_t remoteCounts[NET_CONNS_TOP_REMOTES];
+    uint8_t remoteCount;
+} NetPidStats;
+
+typedef struct NetConns {
+    // The last listing; backends append with NetConns_Add between Begin and End.
+    NetConn *conns;
+    uint32_t count;
+    uint32_t cap;
+
+    NetPidStats *pids; // one per PID owning a socket, in PID order
+    uint32_t pidCount;
+    uint32_t pidCap;
+    PidIndex pidIndex; // pid -> pids[]
+    StrPool endpoints; // formatted remote endpoints of the top lists
+
+    SortKey *keys; // index scratch: keys and radix scratch, 2 * count
+    uint32_t keyCap;
+
+    double refreshSec;
+    int64_t lastQpc;
+    bool refreshed; // a listing has been indexed
+    bool failed;    // the last listing could not be read (the previous one is kept)
+
+    // Backend state kept between refreshes (buffers, caches); freed through freeBackend.
+    void *backend;
+    void (*freeBackend)(void *backend);
+} NetConns;
+
+void NetConns_Init(NetConns *nc);
+void NetConns_Shutdown(NetConns *nc);
+
+// True when no listing has been taken yet or the last one is refreshSec old.
+bool NetConns_RefreshDue(const NetConns *nc, int64_t nowQpc);
+
+// Lists the sockets and rebuilds the index. Implemented per platform
+// (net_conn_win.c, linux/net_conn_linux.c). On failure the previous index is kept.
+void NetConns_Refresh(NetConns *nc, int64_t nowQpc);
+
+// Builders for the backends. Add drops the socket when out of memory. Fail ends a
+// refresh that could not list the sockets: the previous index stays, and the next
+// attempt waits for the next period.
+void NetConns_Begin(NetConns *nc);
+void NetConns_Add(NetConns *nc, const NetConn *c);
+void NetConns_End(NetConns *nc, int64_t nowQpc);
+void NetConns_Fail(NetConns *nc, int64_t nowQpc);
+
+// Stats of the process, or NULL when it owns no socket.
+const NetPidStats *NetConns_Find(const NetConns *nc, uint32_t pid);
+
+// Writes "a.b.c.d:port" or "[v6]:port" (RFC 5952 text: lower case, the longest run of
+// zero groups compressed, IPv4-mapped addresses in dotted form). Returns the length.
+uint32_t NetConns_FormatEndpoint(const NetConn *c, wchar_t *out, uint32_t outCount);
+
+// Not loopback and not the unspecified address.
+bool NetConns_IsRemote(const NetConn *c);
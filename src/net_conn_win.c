@@ -0,0 +1,155 @@
+#include "net_conn.h"
+
+// Winsock must be included before windows.h to avoid older winsock.h conflicts.
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <windows.h>
+
+#include <iphlpapi.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "self_stats.h"
+
+// Windows NetConns_Refresh: the owner-PID variants of the IP Helper TCP and UDP tables,
+// IPv4 and IPv6. The table buffer is kept between refreshes and only regrown when a
+// table outgrows it.
+
+typedef struct NetWin {
+    void *buf;
+    DWORD bufSize;
+} NetWin;
+
+static void free_backend(void *p)
+{
+    NetWin *nw = (NetWin *)p;
+    if (!nw) return;
+    free(nw->buf);
+    free(nw);
+}
+
+// Fetches one table into nw->buf. The size can grow between the two calls, so retry a
+// few times.
+static bool get_table(NetWin *nw, bool tcp, ULONG family)
+{
+    for (int attempt = 0; attempt < 4; attempt++) {
+        DWORD size = nw->bufSize;
+        const DWORD rc = tcp ? GetExtendedTcpTable(nw->buf, &size, FALSE, family, TCP_TABLE_OWNER_PID_ALL, 0)
+                             : GetExtendedUdpTable(nw->buf, &size, FALSE, family, UDP_TABLE_OWNER_PID, 0);
+        if (rc == NO_ERROR) return nw->buf != NULL;
+        if (rc != ERROR_INSUFFICIENT_BUFFER) return false;
+
+        size += size / 4u; // headroom for sockets opened meanwhile
+        void *p = realloc(nw->buf, size);
+        if (!p) return false;
+        SelfStats_NoteAlloc();
+        nw->buf = p;
+        nw->bufSize = size;
+    }
+    return false;
+}
+
+static uint8_t tcp_state(DWORD s)
+{
+    if (s == MIB_TCP_STATE_ESTAB) return NET_STATE_ESTABLISHED;
+    if (s == MIB_TCP_STATE_LISTEN) return NET_STATE_LISTEN;
+    return NET_STATE_OTHER;
+}
+
+static uint32_t read_tcp4(NetConns *nc, NetWin *nw)
+{
+    if (!get_table(nw, true, AF_INET)) return 0;
+    const MIB_TCPTABLE_OWNER_PID *tab = (const MIB_TCPTABLE_OWNER_PID *)nw->buf;
+    for (DWORD i = 0; i < tab->dwNumEntries; i++) {
+        const MIB_TCPROW_OWNER_PID *r = &tab->table[i];
+        NetConn c;
+        memset(&c, 0, sizeof(c));
+        c.pid = r->dwOwningPid;
+        c.proto = NET_PROTO_TCP;
+        c.family = 4;
+        c.state = tcp_state(r->dwState);
+        c.remotePort = ntohs((u_short)r->dwRemotePort);
+        memcpy(c.remote, &r->dwRemoteAddr, 4); // network byte order
+        NetConns_Add(nc, &c);
+    }
+    return 1;
+}
+
+static uint32_t read_tcp6(NetConns *nc, NetWin *nw)
+{
+    if (!get_table(nw, true, AF_INET6)) return 0;
+    const MIB_TCP6TABLE_OWNER_PID *tab = (const MIB_TCP6TABLE_OWNER_PID *)nw->buf;
+    for (DWORD i = 0; i < tab->dwNumEntries; i++) {
+        const MIB_TCP6ROW_OWNER_PID *r = &tab->table[i];
+        NetConn c;
+        memset(&c, 0, sizeof(c));
+        c.pid = r->dwOwningPid;
+        c.proto = NET_PROTO_TCP;
+        c.family = 6;
+        c.state = tcp_state(r->dwState);
+        c.remotePort = ntohs((u_short)r->dwRemotePort);
+        memcpy(c.remote, r->ucRemoteAddr, 16);
+        NetConns_Add(nc, &c);
+    }
+    return 1;
+}
+
+// UDP tables carry no remote endpoint; the sockets only count.
+static uint32_t read_udp(NetConns *nc, NetWin *nw, ULONG family)
+{
+    if (!get_table(nw, false, family)) return 0;
+    DWORD n;
+    const BYTE *rows;
+    size_t stride;
+    if (family == AF_INET) {
+        const MIB_UDPTABLE_OWNER_PID *tab = (const MIB_UDPTABLE_OWNER_PID *)nw->buf;
+        n = tab->dwNumEntries;
+        rows = (const BYTE *)tab->table;
+        stride = sizeof(MIB_UDPROW_OWNER_PID);
+    } else {
+        const MIB_UDP6TABLE_OWNER_PID *tab = (const MIB_UDP6TABLE_OWNER_PID *)nw->buf;
+        n = tab->dwNumEntries;
+        rows = (const BYTE *)tab->table;
+        stride = sizeof(MIB_UDP6ROW_OWNER_PID);
+    }
+    for (DWORD i = 0; i < n; i++) {
+        const BYTE *row = rows + (size_t)i * stride;
+        NetConn c;
+        memset(&c, 0, sizeof(c));
+        c.pid = (family == AF_INET) ? ((const MIB_UDPROW_OWNER_PID *)row)->dwOwningPid
+                                    : ((const MIB_UDP6ROW_OWNER_PID *)row)->dwOwningPid;
+        c.proto = NET_PROTO_UDP;
+        c.family = (family == AF_INET) ? 4 : 6;
+        c.state = NET_STATE_OTHER;
+        NetConns_Add(nc, &c);
+    }
+    return 1;
+}
+
+void NetConns_Refresh(NetConns *nc, int64_t nowQpc)
+{
+    if (!nc) return;
+    if (!nc->backend) {
+        nc->backend = calloc(1, sizeof(NetWin));
+        if (!nc->backend) {
+            NetConns_Fail(nc, nowQpc);
+            return;
+        }
+        SelfStats_NoteAlloc();
+        nc->freeBackend = free_backend;
+    }
+    NetWin *nw = (NetWin *)nc->backend;
+
+    NetConns_Begin(nc);
+    uint32_t tables = read_tcp4(nc, nw);
+    tables += read_tcp6(nc, nw);
+    tables += read_udp(nc, nw, AF_INET);
+    tables += read_udp(nc, nw, AF_INET6);
+    if (tables == 0) {
+        NetConns_Fail(nc, nowQpc);
+        return;
+    }
+    NetConns_End(nc, nowQpc);
+}
@@ -5,22 +5,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-typedef struct PdhRates {
-    double contextSwitchesPerSec;
-    double interruptsPerSec;
-    double dpcsPerSec;
-
-    double processorQueueLength;
-
-    // Best-effort disk throughput (legacy: _Total)
-    double diskReadBytesPerSec;
-    double diskWriteBytesPerSec;
-    bool hasDisk;
-
-    // Optional, requires a power meter provider.
-    double powerWatts;
-    bool hasPowerWatts;
-} PdhRates;
+#include "collector.h" // PdhRates
 
 typedef struct PdhSample {
     float totalCpu;
@@ -0,0 +1,111 @@
+#include "pid_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "self_stats.h"
+
+#define PID_INDEX_MIN_SLOTS 64u
+
+static uint32_t pid_hash(uint32_t pid)
+{
+    // Fibonacci hashing: PIDs are small multiples of 4 on Windows, so the low bits alone
+    // would leave three quarters of the table unused.
+    return (uint32_t)(((uint64_t)pid * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static void clear_slots(PidIndexSlot *slots, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        slots[i].value = PID_INDEX_NONE;
+    }
+}
+
+static void place(PidIndexSlot *slots, uint32_t mask, const PidIndexSlot *e)
+{
+    uint32_t i = pid_hash(e->pid) & mask;
+    while (slots[i].value != PID_INDEX_NONE) {
+        i = (i + 1u) & mask;
+    }
+    slots[i] = *e;
+}
+
+// Resizes to at least 2 * n slots, keeping the current entries.
+static bool grow(PidIndex *ix, uint32_t n)
+{
+    uint32_t slots = PID_INDEX_MIN_SLOTS;
+    while (slots < n * 2u) {
+        if (slots > (UINT32_MAX / 2u)) return false;
+        slots *= 2u;
+    }
+    if (ix->slots && slots <= ix->mask + 1u) return true;
+
+    PidIndexSlot *p = (PidIndexSlot *)malloc((size_t)slots * sizeof(*p));
+    if (!p) return false;
+    SelfStats_NoteAlloc();
+    clear_slots(p, slots);
+    if (ix->slots) {
+        for (uint32_t i = 0; i <= ix->mask; i++) {
+            if (ix->slots[i].value != PID_INDEX_NONE) {
+                place(p, slots - 1u, &ix->slots[i]);
+            }
+        }
+        free(ix->slots);
+    }
+    ix->slots = p;
+    ix->mask = slots - 1u;
+    return true;
+}
+
+void PidIndex_Shutdown(PidIndex *ix)
+{
+    if (!ix) return;
+    free(ix->slots);
+    memset(ix, 0, sizeof(*ix));
+}
+
+bool PidIndex_Reset(PidIndex *ix, uint32_t n)
+{
+    ix->count = 0;
+    if (ix->slots) {
+        clear_slots(ix->slots, ix->mask + 1u);
+    }
+    return grow(ix, n);
+}
+
+bool PidIndex_Insert(PidIndex *ix, uint32_t pid, uint64_t createTime, uint32_t value)
+{
+    if (!ix->slots || ix->count + 1u > (ix->mask + 1u) / 2u) {
+        if (ix->count >= UINT32_MAX / 2u || !grow(ix, ix->count + 1u)) return false;
+    }
+    const PidIndexSlot e = {pid, value, createTime};
+    place(ix->slots, ix->mask, &e);
+    ix->count++;
+    return true;
+}
+
+uint32_t PidIndex_Find(const PidIndex *ix, uint32_t pid, uint64_t createTime)
+{
+    if (!ix->slots) return PID_INDEX_NONE;
+    uint32_t i = pid_hash(pid) & ix->mask;
+    while (ix->slots[i].value != PID_INDEX_NONE) {
+        if (ix->slots[i].pid == pid && ix->slots[i].createTime == createTime) {
+            return ix->slots[i].value;
+        }
+        i = (i + 1u) & ix->mask;
+    }
+    return PID_INDEX_NONE;
+}
+
+uint32_t PidIndex_FindPid(const PidIndex *ix, uint32_t pid)
+{
+    if (!ix->slots) return PID_INDEX_NONE;
+    uint32_t i = pid_hash(pid) & ix->mask;
+    while (ix->slots[i].value != PID_INDEX_NONE) {
+        if (ix->slots[i].pid == pid) {
+            return ix->slots[i].value;
+        }
+        i = (i + 1u) & ix->mask;
+    }
+    return PID_INDEX_NONE;
+}
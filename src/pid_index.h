@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Open-addressing hash from (pid, creation time) to a caller-defined slot number (a row
+// or state-array index). Linear probing over a power-of-two table kept at most half
+// full; there is no removal, owners rebuild the index when their array is compacted or
+// reordered, which they do once per sample anyway.
+//
+// The probe sequence depends on the pid alone, so a lookup by pid only (rows of one
+// sample, where pids are unique) and an exact lookup (state that must not survive PID
+// reuse) share the same table.
+
+#define PID_INDEX_NONE UINT32_MAX
+
+typedef struct PidIndexSlot {
+    uint32_t pid;
+    uint32_t value; // PID_INDEX_NONE = empty
+    uint64_t createTime;
+} PidIndexSlot;
+
+typedef struct PidIndex {
+    PidIndexSlot *slots;
+    uint32_t mask;  // slots - 1 (0 when unallocated)
+    uint32_t count; // entries inserted since the last reset
+} PidIndex;
+
+void PidIndex_Shutdown(PidIndex *ix);
+
+// Empties the index and makes room for n entries without regrowing.
+bool PidIndex_Reset(PidIndex *ix, uint32_t n);
+
+// Inserts an entry; the caller guarantees the key is not present yet. Fails only when the
+// table is full and cannot grow (the entry is then not indexed).
+bool PidIndex_Insert(PidIndex *ix, uint32_t pid, uint64_t createTime, uint32_t value);
+
+// Value for (pid, createTime), or PID_INDEX_NONE.
+uint32_t PidIndex_Find(const PidIndex *ix, uint32_t pid, uint64_t createTime);
+
+// Value of the first entry with this pid, or PID_INDEX_NONE.
+uint32_t PidIndex_FindPid(const PidIndex *ix, uint32_t pid);
@@ -0,0 +1,227 @@
+#include "proc_group.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+
+#include "self_stats.h"
+
+#define GROUP_NONE UINT32_MAX
+
+enum {
+    MIXED_NAME = 1u,
+    MIXED_OWNER = 2u,
+    MIXED_PATH = 4u,
+};
+
+static uint32_t key_of(const ProcRow *r, ProcGroupKey key)
+{
+    switch (key) {
+    case PROC_GROUP_OWNER: return r->ownerId;
+    case PROC_GROUP_PATH: return r->pathId;
+    case PROC_GROUP_NAME:
+    default: return r->nameId;
+    }
+}
+
+// FNV-1a over folded code units; the text is folded already or folded here.
+static uint32_t hash_folded(const wchar_t *s, bool fold)
+{
+    uint32_t h = 2166136261u;
+    for (; *s; s++) {
+        h ^= fold ? (uint32_t)towlower((wint_t)*s) : (uint32_t)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t grown_cap(uint32_t cap, uint32_t want, uint32_t initial)
+{
+    uint32_t n = cap ? cap : initial;
+    while (n < want) {
+        if (n > (UINT32_MAX / 2u)) return want;
+        n *= 2u;
+    }
+    return n;
+}
+
+static bool resize(void **buf, uint32_t n, size_t elemSize)
+{
+    void *p = realloc(*buf, (size_t)n * elemSize);
+    if (!p) return false;
+    SelfStats_NoteAlloc();
+    *buf = p;
+    return true;
+}
+
+// Room for one more group, with the slot table at most half full.
+static bool ensure_group(ProcGroupBy *g)
+{
+    const uint32_t want = g->groupCount + 1u;
+    if (want > g->groupCap) {
+        const uint32_t cap = grown_cap(g->groupCap, want, 64u);
+        if (!resize((void **)&g->groups, cap, sizeof(ProcGroupAgg))) return false;
+        g->groupCap = cap;
+    }
+    if (g->slots && want * 2u <= g->mask + 1u) return true;
+
+    const uint32_t n = grown_cap(g->slots ? g->mask + 1u : 0, want * 2u, 128u);
+    uint32_t *slots = (uint32_t *)calloc(n, sizeof(uint32_t));
+    if (!slots) return false;
+    SelfStats_NoteAlloc();
+    free(g->slots);
+    g->slots = slots;
+    g->mask = n - 1u;
+    for (uint32_t gi = 0; gi < g->groupCount; gi++) {
+        uint32_t i = g->groups[gi].hash & g->mask;
+        while (g->slots[i] != 0) {
+            i = (i + 1u) & g->mask;
+        }
+        g->slots[i] = gi + 1u;
+    }
+    return true;
+}
+
+// Group of string id, created (with row as its first member) when new.
+static uint32_t find_or_add(ProcGroupBy *g, const StrPool *strings, uint32_t id, const ProcRow *row, uint32_t rowIndex)
+{
+    if (!ensure_group(g)) return GROUP_NONE;
+    const uint32_t h = hash_folded(StrPool_GetFolded(strings, id), false);
+    uint32_t i = h & g->mask;
+    while (g->slots[i] != 0) {
+        const uint32_t gi = g->slots[i] - 1u;
+        if (g->groups[gi].hash == h && StrPool_CompareFolded(strings, g->groups[gi].keyId, id) == 0) {
+            return gi;
+        }
+        i = (i + 1u) & g->mask;
+    }
+
+    const uint32_t gi = g->groupCount++;
+    ProcGroupAgg *a = &g->groups[gi];
+    memset(a, 0, sizeof(*a));
+    a->keyId = id;
+    a->leader = rowIndex;
+    a->nameId = row->nameId;
+    a->ownerId = row->ownerId;
+    a->pathId = row->pathId;
+    a->hash = h;
+    g->slots[i] = gi + 1u;
+    return gi;
+}
+
+static void note_same(uint8_t *mixed, uint8_t bit, const StrPool *strings, uint32_t have, uint32_t id)
+{
+    if (!(*mixed & bit) && StrPool_CompareFolded(strings, have, id) != 0) {
+        *mixed |= bit;
+    }
+}
+
+void ProcGroupBy_Shutdown(ProcGroupBy *g)
+{
+    if (!g) return;
+    free(g->groups);
+    free(g->members);
+    free(g->rowGroup);
+    free(g->idGroup);
+    free(g->slots);
+    memset(g, 0, sizeof(*g));
+}
+
+bool ProcGroupBy_Run(ProcGroupBy *g, const ProcRow *rows, uint32_t count, const StrPool *strings, ProcGroupKey key)
+{
+    if (!g) return false;
+    g->groupCount = 0;
+    if (g->slots) {
+        memset(g->slots, 0, ((size_t)g->mask + 1u) * sizeof(uint32_t));
+    }
+    if (!rows || count == 0 || !strings) return true;
+
+    if (count > g->rowCap) {
+        const uint32_t cap = grown_cap(g->rowCap, count, 256u);
+        if (!resize((void **)&g->members, cap, sizeof(uint32_t)) ||
+            !resize((void **)&g->rowGroup, cap, sizeof(uint32_t))) {
+            return false;
+        }
+        g->rowCap = cap;
+    }
+    const uint32_t ids = strings->count;
+    if (ids > g->idCap) {
+        const uint32_t cap = grown_cap(g->idCap, ids, 1024u);
+        if (!resize((void **)&g->idGroup, cap, sizeof(uint32_t))) return false;
+        g->idCap = cap;
+    }
+    for (uint32_t i = 0; i < ids; i++) {
+        g->idGroup[i] = GROUP_NONE;
+    }
+
+    // Rows sharing a string id share a group, so the folded text is hashed and compared
+    // once per distinct id rather than once per row.
+    for (uint32_t i = 0; i < count; i++) {
+        const ProcRow *r = &rows[i];
+        g->rowGroup[i] = GROUP_NONE;
+        if (r->pid == 0) continue;
+
+        uint32_t id = key_of(r, key);
+        if (id >= ids) id = STR_POOL_EMPTY;
+        uint32_t gi = g->idGroup[id];
+        if (gi == GROUP_NONE) {
+            gi = find_or_add(g, strings, id, r, i);
+            if (gi == GROUP_NONE) {
+                g->groupCount = 0;
+                return false;
+            }
+            g->idGroup[id] = gi;
+        }
+        g->rowGroup[i] = gi;
+
+        ProcGroupAgg *a = &g->groups[gi];
+        a->memberCount++;
+        a->cpuSum += r->cpuPct;
+        a->memSum += r->workingSetBytes;
+        if (r->hasNet) a->anyNet = true;
+        if (r->pid < rows[a->leader].pid) a->leader = i;
+        note_same(&a->mixed, MIXED_NAME, strings, a->nameId, r->nameId);
+        note_same(&a->mixed, MIXED_OWNER, strings, a->ownerId, r->ownerId);
+        note_same(&a->mixed, MIXED_PATH, strings, a->pathId, r->pathId);
+    }
+
+    // Lay the members out group by group (a counting sort on the group of each row).
+    uint32_t start = 0;
+    for (uint32_t gi = 0; gi < g->groupCount; gi++) {
+        ProcGroupAgg *a = &g->groups[gi];
+        a->memberStart = start;
+        start += a->memberCount;
+        a->memberCount = 0;
+        if (a->mixed & MIXED_NAME) a->nameId = STR_POOL_EMPTY;
+        if (a->mixed & MIXED_OWNER) a->ownerId = STR_POOL_EMPTY;
+        if (a->mixed & MIXED_PATH) a->pathId = STR_POOL_EMPTY;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t gi = g->rowGroup[i];
+        if (gi == GROUP_NONE) continue;
+        ProcGroupAgg *a = &g->groups[gi];
+        g->members[a->memberStart + a->memberCount++] = i;
+    }
+    return true;
+}
+
+uint32_t ProcGroupBy_Find(const ProcGroupBy *g, const StrPool *strings, const wchar_t *text)
+{
+    if (!g || !g->slots || !strings || !text) return GROUP_NONE;
+    const uint32_t h = hash_folded(text, true);
+    uint32_t i = h & g->mask;
+    while (g->slots[i] != 0) {
+        const uint32_t gi = g->slots[i] - 1u;
+        if (g->groups[gi].hash == h) {
+            const wchar_t *k = StrPool_GetFolded(strings, g->groups[gi].keyId);
+            const wchar_t *t = text;
+            while (*k && (wchar_t)towlower((wint_t)*t) == *k) {
+                k++;
+                t++;
+            }
+            if (*k == 0 && *t == 0) return gi;
+        }
+        i = (i + 1u) & g->mask;
+    }
+    return GROUP_NONE;
+}
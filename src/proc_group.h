@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#include "proc_table.h"
+
+// Hashed group-by over process rows: one pass puts each row in the group of its key
+// column (string columns compare case-insensitively, through the pool's folded text) and
+// folds it into that group's aggregates. Buffers are kept between runs, so regrouping a
+// table of about the same size allocates nothing.
+
+typedef enum ProcGroupKey {
+    PROC_GROUP_NAME = 0,
+    PROC_GROUP_OWNER,
+    PROC_GROUP_PATH,
+} ProcGroupKey;
+
+typedef struct ProcGroupAgg {
+    uint32_t keyId;       // key column of the group's first row
+    uint32_t leader;      // row with the lowest PID
+    uint32_t memberStart; // members of the group: ProcGroupBy.members[memberStart, +memberCount)
+    uint32_t memberCount;
+    float cpuSum;
+    uint64_t memSum;
+    bool anyNet;
+    // Value every member shares (case-insensitively), else STR_POOL_EMPTY.
+    uint32_t nameId;
+    uint32_t ownerId;
+    uint32_t pathId;
+
+    uint32_t hash;  // of the folded key text
+    uint8_t mixed;  // columns seen to differ (run-internal)
+} ProcGroupAgg;
+
+typedef struct ProcGroupBy {
+    ProcGroupAgg *groups; // in order of first appearance
+    uint32_t groupCount;
+    uint32_t groupCap;
+    uint32_t *members;    // row indices, grouped, each group in row order
+    uint32_t *rowGroup;   // per row: its group (UINT32_MAX for none)
+    uint32_t rowCap;
+    uint32_t *idGroup;    // per string id: its group, filled as ids turn up
+    uint32_t idCap;
+    uint32_t *slots;      // open-addressing table of group + 1 by hash (0 = empty)
+    uint32_t mask;
+} ProcGroupBy;
+
+void ProcGroupBy_Shutdown(ProcGroupBy *g);
+
+// Groups rows[0, count) by key. Rows with PID 0 (the idle process) join no group. Returns
+// false, with no groups, when out of memory.
+bool ProcGroupBy_Run(ProcGroupBy *g, const ProcRow *rows, uint32_t count, const StrPool *strings, ProcGroupKey key);
+
+// Index of the group whose key equals text case-insensitively, or UINT32_MAX.
+uint32_t ProcGroupBy_Find(const ProcGroupBy *g, const StrPool *strings, const wchar_t *text);
@@ -1,361 +1,536 @@
 #include "proc_table.h"
 
-// Winsock must be included before windows.h to avoid older winsock.h conflicts.
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
-#include <windows.h>
-
-#include <tlhelp32.h>
-#include <psapi.h>
-#include <iphlpapi.h>
-
 #include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
 #include <wchar.h>
 
-#ifndef _countof
-#define _countof(a) (sizeof(a) / sizeof((a)[0]))
-#endif
+#include "self_stats.h"
+#include "sys_thread.h"
 
-static uint64_t ft_to_u64(FILETIME ft)
+static bool is_string_key(ProcSortKey key)
 {
-    ULARGE_INTEGER u;
-    u.LowPart = ft.dwLowDateTime;
-    u.HighPart = ft.dwHighDateTime;
-    return (uint64_t)u.QuadPart;
+    return key == PROC_SORT_OWNER || key == PROC_SORT_NET || key == PROC_SORT_NAME || key == PROC_SORT_PATH;
 }
 
-static void safe_wcpy(wchar_t *dst, size_t dstCount, const wchar_t *src)
+static uint32_t row_string(const ProcRow *r, ProcSortKey key)
 {
-    if (!dst || dstCount == 0) return;
-    if (!src) {
-        dst[0] = 0;
-        return;
+    switch (key) {
+    case PROC_SORT_OWNER: return r->ownerId;
+    case PROC_SORT_NET: return r->hasNet ? r->netRemoteId : STR_POOL_EMPTY;
+    case PROC_SORT_NAME: return r->nameId;
+    case PROC_SORT_PATH: return r->pathId;
+    default: return STR_POOL_EMPTY;
     }
-#ifdef _MSC_VER
-    wcscpy_s(dst, dstCount, src);
-#else
-    wcsncpy(dst, src, dstCount - 1);
-    dst[dstCount - 1] = 0;
-#endif
 }
 
-static void get_process_owner(HANDLE hProcess, wchar_t *out, size_t outCount)
+// Sorts ids (in keys[i].index) whose folded text matched up to depth units, keyed by the
+// eight units from depth on (StrPool_CollateKey). Runs still equal are re-keyed eight
+// units further until they are down to one string or their strings ended: an MSD radix
+// sort on the folded text, so each string is read about as far as it shares a prefix.
+static void sort_by_text(SortKey *keys, uint32_t n, uint32_t depth, const StrPool *strings, SortKey *scratch)
 {
-    if (!out || outCount == 0) return;
-    out[0] = 0;
-
-    HANDLE hToken = NULL;
-    if (!OpenProcessToken(hProcess, TOKEN_QUERY, &hToken)) {
-        return;
-    }
-
-    DWORD len = 0;
-    GetTokenInformation(hToken, TokenUser, NULL, 0, &len);
-    if (len == 0) {
-        CloseHandle(hToken);
-        return;
+    KeySort_Sort(keys, n, scratch);
+    for (uint32_t i = 0; i < n;) {
+        uint32_t j = i + 1u;
+        while (j < n && SortKey_Cmp(&keys[j], &keys[i]) == 0) {
+            j++;
+        }
+        // A unit left of 0 means the strings go on past these eight.
+        if (j - i > 1u && (keys[i].lo & 0xFFFFu) != 0 && depth < UINT32_MAX - 16u) {
+            for (uint32_t k = i; k < j; k++) {
+                keys[k].hi = StrPool_CollateKey(strings, keys[k].index, depth + 8u);
+                keys[k].lo = StrPool_CollateKey(strings, keys[k].index, depth + 12u);
+            }
+            sort_by_text(keys + i, j - i, depth + 8u, strings, scratch);
+        }
+        i = j;
     }
+}
 
-    TOKEN_USER *tu = (TOKEN_USER *)malloc(len);
-    if (!tu) {
-        CloseHandle(hToken);
-        return;
+// String columns sort by rank: the distinct strings the rows use, in case-insensitive
+// order, numbered so that strings comparing equal share a rank. The pool folded and
+// prefix-keyed each string when it was interned, so ordering them is integer sorting.
+// Fills rank[id] (strings->count entries) for the ids the rows use; keys must hold
+// 2 * count entries.
+static void rank_strings(const ProcRow *rows, uint32_t count, ProcSortKey key, const StrPool *strings, uint32_t *rank,
+                         SortKey *keys)
+{
+    const uint32_t ids = strings->count;
+    for (uint32_t i = 0; i < ids; i++) {
+        rank[i] = UINT32_MAX;
     }
-
-    if (!GetTokenInformation(hToken, TokenUser, tu, len, &len)) {
-        free(tu);
-        CloseHandle(hToken);
-        return;
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t id = row_string(&rows[i], key);
+        if (id != STR_POOL_EMPTY && id < ids && rank[id] == UINT32_MAX) {
+            rank[id] = 0;
+            keys[m].hi = StrPool_CollateKey(strings, id, 0);
+            keys[m].lo = StrPool_CollateKey(strings, id, 4u);
+            keys[m].index = id;
+            m++;
+        }
     }
 
-    wchar_t name[64];
-    wchar_t domain[64];
-    DWORD cchName = (DWORD)_countof(name);
-    DWORD cchDomain = (DWORD)_countof(domain);
-    SID_NAME_USE use;
-    if (LookupAccountSidW(NULL, tu->User.Sid, name, &cchName, domain, &cchDomain, &use)) {
-        wchar_t tmp[96];
-#ifdef _MSC_VER
-        swprintf(tmp, _countof(tmp), L"%s\\%s", domain, name);
-#else
-    swprintf(tmp, _countof(tmp), L"%ls\\%ls", domain, name);
-#endif
-        safe_wcpy(out, outCount, tmp);
+    sort_by_text(keys, m, 0, strings, keys + m);
+    uint32_t r = 0;
+    for (uint32_t i = 0; i < m; i++) {
+        if (i > 0 && StrPool_CompareFolded(strings, keys[i - 1].index, keys[i].index) != 0) r++;
+        rank[keys[i].index] = r;
     }
-
-    free(tu);
-    CloseHandle(hToken);
 }
 
-static void get_process_path(HANDLE hProcess, wchar_t *out, size_t outCount)
+// Encodes the row order as 128-bit keys: the column, then the tie-breakers CPU desc and
+// PID asc, the whole key inverted for a descending sort.
+static void build_keys(const ProcRow *rows, uint32_t count, ProcSortKey key, bool ascending, const uint32_t *rank,
+                       uint32_t rankCount, SortKey *keys)
 {
-    if (!out || outCount == 0) return;
-    out[0] = 0;
-
-    DWORD sz = (DWORD)outCount;
-    // QueryFullProcessImageNameW is in kernel32.
-    if (!QueryFullProcessImageNameW(hProcess, 0, out, &sz)) {
-        out[0] = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const ProcRow *r = &rows[i];
+        const uint32_t cpu = SortKey_Float(r->cpuPct);
+        const uint64_t tail = ((uint64_t)(uint32_t)~cpu << 32) | r->pid;
+        uint64_t hi = 0;
+        uint64_t lo = tail;
+        switch (key) {
+        case PROC_SORT_CPU:
+            lo = ((uint64_t)cpu << 32) | r->pid;
+            break;
+        case PROC_SORT_PID:
+            hi = r->pid;
+            break;
+        case PROC_SORT_MEM:
+            hi = r->workingSetBytes;
+            break;
+        default: {
+            // Empty strings sort last.
+            const uint32_t id = row_string(r, key);
+            hi = (id == STR_POOL_EMPTY) ? UINT64_MAX : (id < rankCount) ? rank[id] : id;
+            break;
+        }
+        }
+        keys[i].hi = ascending ? hi : ~hi;
+        keys[i].lo = ascending ? lo : ~lo;
+        keys[i].index = i;
     }
 }
 
-typedef struct PidNet {
-    uint32_t pid;
-    wchar_t remote[64];
-    bool has;
-} PidNet;
-
-static bool is_internet_remote_ipv4(uint32_t addr_be)
-{
-    // addr_be is network byte order.
-    const uint32_t addr = ntohl(addr_be);
-    if (addr == 0) return false;
-    // 127.0.0.0/8 loopback
-    if ((addr & 0xFF000000u) == 0x7F000000u) return false;
-    return true;
-}
-
-static int pidnet_find(PidNet *arr, uint32_t n, uint32_t pid)
+// Writes rows to out in key order (the first limit of them at least, when limit != 0).
+// keys holds 2 * count entries; work strings->count ids for a string column.
+static void sort_rows(const ProcRow *rows, uint32_t count, const StrPool *strings, ProcSortKey key, bool ascending,
+                      uint32_t limit, SortKey *keys, uint32_t *work, ProcRow *out)
 {
-    for (uint32_t i = 0; i < n; i++) {
-        if (arr[i].pid == pid) return (int)i;
-    }
-    return -1;
-}
-
-static uint32_t build_pid_net_map(PidNet *out, uint32_t outCap)
-{
-    if (!out || outCap == 0) return 0;
-
-    uint32_t count = 0;
-
-    // TCP IPv4
-    DWORD size = 0;
-    GetExtendedTcpTable(NULL, &size, FALSE, AF_INET, TCP_TABLE_OWNER_PID_ALL, 0);
-    if (size > 0) {
-        void *buf = malloc(size);
-        if (buf) {
-            if (GetExtendedTcpTable(buf, &size, FALSE, AF_INET, TCP_TABLE_OWNER_PID_ALL, 0) == NO_ERROR) {
-                MIB_TCPTABLE_OWNER_PID *tab = (MIB_TCPTABLE_OWNER_PID *)buf;
-                for (DWORD i = 0; i < tab->dwNumEntries; i++) {
-                    const MIB_TCPROW_OWNER_PID *r = &tab->table[i];
-                    if (r->dwState != MIB_TCP_STATE_ESTAB) continue;
-                    if (!is_internet_remote_ipv4(r->dwRemoteAddr)) continue;
-
-                    const uint32_t pid = r->dwOwningPid;
-                    if (pid == 0) continue;
-
-                    if (pidnet_find(out, count, pid) >= 0) continue;
-                    if (count >= outCap) break;
-
-                    IN_ADDR a;
-                    a.S_un.S_addr = r->dwRemoteAddr;
-                    wchar_t ip[64];
-                    ip[0] = 0;
-                    InetNtopW(AF_INET, &a, ip, (DWORD)_countof(ip));
-                    const uint16_t port = ntohs((uint16_t)r->dwRemotePort);
-
-                    out[count].pid = pid;
-                    out[count].has = true;
-#ifdef _MSC_VER
-                    swprintf(out[count].remote, _countof(out[count].remote), L"%s:%u", ip, (unsigned)port);
-#else
-                    swprintf(out[count].remote, _countof(out[count].remote), L"%ls:%u", ip, (unsigned)port);
-#endif
-                    count++;
-                }
-            }
-            free(buf);
-        }
+    const bool ranked = is_string_key(key) && strings && work;
+    if (ranked) {
+        rank_strings(rows, count, key, strings, work, keys);
     }
+    build_keys(rows, count, key, ascending, work, ranked ? strings->count : 0, keys);
 
-    return count;
+    SortKey *scratch = keys + count;
+    uint32_t n = count;
+    if (limit != 0 && limit < count) {
+        KeySort_SelectFirst(keys, count, limit, scratch);
+        n = limit;
+    }
+    KeySort_Sort(keys, n, scratch);
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = rows[keys[i].index];
+    }
 }
 
-static uint64_t get_process_total_time_100ns(HANDLE hProcess)
+static void emit_delta(ProcTable *pt, ProcDeltaKind kind, uint8_t columns, uint32_t pid, uint64_t createTime)
 {
-    FILETIME ct, et, kt, ut;
-    if (!GetProcessTimes(hProcess, &ct, &et, &kt, &ut)) {
-        return 0;
+    if (pt->deltaCount == pt->deltaCap) {
+        const uint32_t newCap = pt->deltaCap ? (pt->deltaCap * 2u) : 256u;
+        void *p = (newCap > pt->deltaCap) ? realloc(pt->deltas, (size_t)newCap * sizeof(ProcDelta)) : NULL;
+        if (!p) {
+            pt->deltaLost = true;
+            return;
+        }
+        SelfStats_NoteAlloc();
+        pt->deltas = (ProcDelta *)p;
+        pt->deltaCap = newCap;
     }
-    return ft_to_u64(kt) + ft_to_u64(ut);
+    ProcDelta *d = &pt->deltas[pt->deltaCount++];
+    d->pid = pid;
+    d->kind = (uint8_t)kind;
+    d->columns = columns;
+    d->createTime = createTime;
 }
 
-static uint64_t get_system_total_time_100ns(void)
+static uint8_t changed_columns(const ProcRow *a, const ProcRow *b)
 {
-    FILETIME idle, kernel, user;
-    if (!GetSystemTimes(&idle, &kernel, &user)) {
-        return 0;
+    uint8_t c = 0;
+    if (a->cpuPct != b->cpuPct) c |= PROC_COL_CPU;
+    if (a->workingSetBytes != b->workingSetBytes) c |= PROC_COL_MEM;
+    if (a->nameId != b->nameId) c |= PROC_COL_NAME;
+    if (a->pathId != b->pathId) c |= PROC_COL_PATH;
+    if (a->ownerId != b->ownerId) c |= PROC_COL_OWNER;
+    if (a->hasNet != b->hasNet || (a->hasNet && (a->netRemoteId != b->netRemoteId || a->netConns != b->netConns))) {
+        c |= PROC_COL_NET;
     }
-    return ft_to_u64(kernel) + ft_to_u64(user);
+    return c;
 }
 
-static int row_cmp_cpu_desc(const void *a, const void *b)
+// Closes the sample's delta stream; a stream with records missing skips a number.
+static void end_deltas(ProcTable *pt)
 {
-    const ProcRow *ra = (const ProcRow *)a;
-    const ProcRow *rb = (const ProcRow *)b;
-    if (ra->cpuPct < rb->cpuPct) return 1;
-    if (ra->cpuPct > rb->cpuPct) return -1;
-    // tie-breaker: memory
-    if (ra->workingSetBytes < rb->workingSetBytes) return 1;
-    if (ra->workingSetBytes > rb->workingSetBytes) return -1;
-    return 0;
+    pt->deltaSeq += pt->deltaLost ? 2u : 1u;
+    pt->deltaLost = false;
 }
 
-static int wcmp_insensitive(const wchar_t *a, const wchar_t *b)
+void ProcTable_PrevBegin(ProcTable *pt)
 {
-    if (!a) a = L"";
-    if (!b) b = L"";
-#ifdef _MSC_VER
-    return _wcsicmp(a, b);
-#else
-    return wcsicmp(a, b);
-#endif
+    pt->deltaCount = 0;
+    for (uint32_t i = 0; i < pt->prevCount; i++) {
+        pt->prev[i].seen = false;
+        pt->prev[i].refreshed = false;
+    }
 }
 
-static int row_cmp_string(const wchar_t *a, const wchar_t *b)
+static void index_prev(ProcTable *pt)
 {
-    // Empty strings sort last.
-    const bool aEmpty = (!a || a[0] == 0);
-    const bool bEmpty = (!b || b[0] == 0);
-    if (aEmpty && bEmpty) return 0;
-    if (aEmpty) return 1;
-    if (bEmpty) return -1;
-    return wcmp_insensitive(a, b);
-}
-
-typedef struct SortCtx {
-    ProcSortKey key;
-    bool asc;
-} SortCtx;
-
-static SortCtx g_sortCtx;
-
-static int row_cmp_ctx(const void *a, const void *b)
-{
-    const ProcRow *ra = (const ProcRow *)a;
-    const ProcRow *rb = (const ProcRow *)b;
-
-    int c = 0;
-    switch (g_sortCtx.key) {
-    case PROC_SORT_CPU:
-        if (ra->cpuPct < rb->cpuPct) c = -1;
-        else if (ra->cpuPct > rb->cpuPct) c = 1;
-        else c = 0;
-        break;
-    case PROC_SORT_PID:
-        if (ra->pid < rb->pid) c = -1;
-        else if (ra->pid > rb->pid) c = 1;
-        else c = 0;
-        break;
-    case PROC_SORT_MEM:
-        if (ra->workingSetBytes < rb->workingSetBytes) c = -1;
-        else if (ra->workingSetBytes > rb->workingSetBytes) c = 1;
-        else c = 0;
-        break;
-    case PROC_SORT_OWNER:
-        c = row_cmp_string(ra->owner, rb->owner);
-        break;
-    case PROC_SORT_NET:
-        c = row_cmp_string(ra->hasNet ? ra->netRemote : L"", rb->hasNet ? rb->netRemote : L"");
-        break;
-    case PROC_SORT_NAME:
-        c = row_cmp_string(ra->name, rb->name);
-        break;
-    case PROC_SORT_PATH:
-        c = row_cmp_string(ra->path, rb->path);
-        break;
-    default:
-        c = 0;
-        break;
-    }
-
-    // Tie-breakers: CPU desc then PID asc.
-    if (c == 0) {
-        if (ra->cpuPct < rb->cpuPct) c = 1;
-        else if (ra->cpuPct > rb->cpuPct) c = -1;
-        else {
-            if (ra->pid < rb->pid) c = -1;
-            else if (ra->pid > rb->pid) c = 1;
-            else c = 0;
-        }
-    }
-
-    if (!g_sortCtx.asc) {
-        c = -c;
+    if (!PidIndex_Reset(&pt->prevIndex, pt->prevCount)) return;
+    for (uint32_t i = 0; i < pt->prevCount; i++) {
+        (void)PidIndex_Insert(&pt->prevIndex, pt->prev[i].pid, pt->prev[i].createTime, i);
     }
-    return c;
 }
 
-static void prev_mark_all_unseen(ProcTable *pt)
+static void close_handle(ProcTable *pt, struct PrevPidTime *e)
 {
-    for (uint32_t i = 0; i < pt->prevCount; i++) {
-        pt->prev[i].seen = false;
-    }
+    if (e->handle == PROC_HANDLE_NONE) return;
+    if (pt->closeHandle) pt->closeHandle(e->handle);
+    e->handle = PROC_HANDLE_NONE;
+    ProcTable_HandleRelease(pt);
 }
 
-static uint32_t prev_find_or_add(ProcTable *pt, uint32_t pid)
+uint32_t ProcTable_PrevFindOrAdd(ProcTable *pt, uint32_t pid, uint64_t createTime)
 {
-    for (uint32_t i = 0; i < pt->prevCount; i++) {
-        if (pt->prev[i].pid == pid) {
-            pt->prev[i].seen = true;
-            return i;
-        }
+    const uint32_t found = PidIndex_Find(&pt->prevIndex, pid, createTime);
+    if (found != PID_INDEX_NONE) {
+        pt->prev[found].seen = true;
+        pt->prev[found].refreshed = true;
+        return found;
     }
 
+    // A process first seen now started, at the latest, after the previous sample.
+    const uint64_t sysStart = pt->prevInit ? pt->prevSysTotal100ns : 0u;
+
     if (pt->prevCount == pt->prevCap) {
         uint32_t newCap = pt->prevCap ? (pt->prevCap * 2) : 256;
         void *p = realloc(pt->prev, newCap * sizeof(*pt->prev));
         if (!p) {
-            // can't grow; reuse slot 0
+            // can't grow; reuse slot 0 (whose exit the delta stream then misses)
+            if (pt->prev[0].hasRow) pt->deltaLost = true;
+            close_handle(pt, &pt->prev[0]);
+            pt->prev[0].hasRow = false;
             pt->prev[0].pid = pid;
+            pt->prev[0].createTime = createTime;
             pt->prev[0].procTotal100ns = 0;
+            pt->prev[0].sysTotal100ns = sysStart;
             pt->prev[0].seen = true;
+            pt->prev[0].refreshed = true;
+            pt->prev[0].keepFast = false;
+            pt->prev[0].quietSamples = 0;
+            pt->prev[0].hasAttrs = false;
+            pt->prev[0].pathId = STR_POOL_EMPTY;
+            pt->prev[0].ownerId = STR_POOL_EMPTY;
+            index_prev(pt);
             return 0;
         }
+        SelfStats_NoteAlloc();
         pt->prev = (struct PrevPidTime *)p;
         pt->prevCap = newCap;
     }
 
     const uint32_t idx = pt->prevCount++;
     pt->prev[idx].pid = pid;
+    pt->prev[idx].createTime = createTime;
     pt->prev[idx].procTotal100ns = 0;
+    pt->prev[idx].sysTotal100ns = sysStart;
     pt->prev[idx].seen = true;
+    pt->prev[idx].refreshed = true;
+    pt->prev[idx].keepFast = false;
+    pt->prev[idx].quietSamples = 0;
+    pt->prev[idx].hasAttrs = false;
+    pt->prev[idx].pathId = STR_POOL_EMPTY;
+    pt->prev[idx].ownerId = STR_POOL_EMPTY;
+    pt->prev[idx].handle = PROC_HANDLE_NONE;
+    pt->prev[idx].hasRow = false;
+    (void)PidIndex_Insert(&pt->prevIndex, pid, createTime, idx);
     return idx;
 }
 
-static void prev_compact_unseen(ProcTable *pt)
+static bool ensure_buf(void **buf, uint32_t *cap, uint32_t want, size_t elemSize)
+{
+    if (want <= *cap) return true;
+    void *p = realloc(*buf, (size_t)want * elemSize);
+    if (!p) return false;
+    SelfStats_NoteAlloc();
+    *buf = p;
+    *cap = want;
+    return true;
+}
+
+static bool ensure_scratch(ProcSortScratch *s, uint32_t rows, uint32_t keys, uint32_t work)
 {
+    return ensure_buf((void **)&s->rows, &s->rowCap, rows, sizeof(ProcRow)) &&
+           ensure_buf((void **)&s->keys, &s->keyCap, keys, sizeof(SortKey)) &&
+           ensure_buf((void **)&s->work, &s->workCap, work, sizeof(uint32_t));
+}
+
+// The row index still maps each process to where the last sort (or sample) left it; lay
+// the new rows out in that order, unseen processes last, so the next sort starts from
+// nearly sorted input.
+static void seed_previous_order(ProcTable *pt)
+{
+    const uint32_t n = pt->rowCount;
+    const uint32_t old = pt->rowIndex.count;
+    if (n < 2 || old == 0 || n > UINT32_MAX - old) return;
+    if (!ensure_scratch(&pt->sort, n, 0, old + n)) return;
+
+    // slots[0, old): row now at each old position; slots[old, ...): rows not seen before.
+    uint32_t *slots = pt->sort.work;
+    for (uint32_t i = 0; i < old; i++) {
+        slots[i] = UINT32_MAX;
+    }
+    uint32_t fresh = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const uint32_t r = PidIndex_Find(&pt->rowIndex, pt->rows[i].pid, pt->rows[i].createTime);
+        if (r < old && slots[r] == UINT32_MAX) {
+            slots[r] = i;
+        } else {
+            slots[old + fresh++] = i;
+        }
+    }
+
+    // The reordered rows become the rows; the old ones the scratch.
+    ProcRow *out = pt->sort.rows;
+    uint32_t w = 0;
+    for (uint32_t i = 0; i < old + fresh; i++) {
+        if (slots[i] != UINT32_MAX) {
+            out[w++] = pt->rows[slots[i]];
+        }
+    }
+    const uint32_t outCap = pt->sort.rowCap;
+    pt->sort.rows = pt->rows;
+    pt->sort.rowCap = pt->rowCap;
+    pt->rows = out;
+    pt->rowCap = outCap;
+    pt->sortedCount = 0;
+}
+
+// Reports the rows of processes that had none last sample, and the columns that changed
+// in the others. Runs once the strings are final, so unchanged strings keep their ids.
+static void diff_rows(ProcTable *pt)
+{
+    for (uint32_t i = 0; i < pt->rowCount; i++) {
+        const ProcRow *r = &pt->rows[i];
+        const uint32_t p = PidIndex_Find(&pt->prevIndex, r->pid, r->createTime);
+        if (p >= pt->prevCount) {
+            emit_delta(pt, PROC_DELTA_STARTED, PROC_COL_ALL, r->pid, r->createTime);
+            continue;
+        }
+        struct PrevPidTime *e = &pt->prev[p];
+        if (!e->hasRow) {
+            emit_delta(pt, PROC_DELTA_STARTED, PROC_COL_ALL, r->pid, r->createTime);
+        } else {
+            const uint8_t c = changed_columns(&e->last, r);
+            if (c) emit_delta(pt, PROC_DELTA_CHANGED, c, r->pid, r->createTime);
+        }
+        if (e->refreshed) {
+            const bool quiet = e->hasRow && r->cpuPct == 0.0f && r->workingSetBytes == e->last.workingSetBytes;
+            e->quietSamples = quiet ? (uint8_t)(e->quietSamples + (e->quietSamples < UINT8_MAX)) : 0u;
+        }
+        e->last = *r;
+        e->hasRow = true;
+    }
+}
+
+void ProcTable_PrevEnd(ProcTable *pt)
+{
+    for (uint32_t r = 0; r < pt->prevCount; r++) {
+        if (pt->prev[r].hasRow && !pt->prev[r].seen) {
+            emit_delta(pt, PROC_DELTA_EXITED, 0, pt->prev[r].pid, pt->prev[r].createTime);
+        }
+    }
+
     uint32_t w = 0;
     for (uint32_t r = 0; r < pt->prevCount; r++) {
         if (pt->prev[r].seen) {
+            pt->prev[r].keepFast = false;
             if (w != r) {
                 pt->prev[w] = pt->prev[r];
             }
             w++;
+        } else {
+            close_handle(pt, &pt->prev[r]);
         }
     }
     pt->prevCount = w;
+    pt->prevInit = true;
+    pt->sampleSeq++;
+
+    // Compaction moved entries; the next sample looks them up at their new positions.
+    if (w != pt->prevIndex.count) {
+        index_prev(pt);
+    }
+    ProcTable_TrimStrings(pt);
+    diff_rows(pt);
+    end_deltas(pt);
+    seed_previous_order(pt);
+    ProcTable_IndexRows(pt);
+}
+
+void ProcTable_PrevFail(ProcTable *pt)
+{
+    pt->deltaCount = 0;
+    for (uint32_t i = 0; i < pt->prevCount; i++) {
+        if (pt->prev[i].hasRow) {
+            emit_delta(pt, PROC_DELTA_EXITED, 0, pt->prev[i].pid, pt->prev[i].createTime);
+            pt->prev[i].hasRow = false;
+        }
+    }
+    end_deltas(pt);
+    pt->rowCount = 0;
+    pt->sortedCount = 0;
+    pt->prevInit = true;
+}
+
+float ProcTable_PrevCpu(ProcTable *pt, uint32_t prevIndex, uint64_t procTotal, uint64_t sysTotal)
+{
+    struct PrevPidTime *e = &pt->prev[prevIndex];
+    const uint64_t procStart = e->procTotal100ns;
+    const uint64_t sysStart = e->sysTotal100ns;
+    e->procTotal100ns = procTotal;
+    e->sysTotal100ns = sysTotal;
+    if (sysStart == 0 || sysTotal <= sysStart || procTotal < procStart) return 0.0f;
+
+    const float pct = (float)((double)(procTotal - procStart) * 100.0 / (double)(sysTotal - sysStart));
+    return (pct > 100.0f) ? 100.0f : pct;
+}
+
+uint32_t ProcTable_SlowTier(const ProcTable *pt, uint32_t pid)
+{
+    if (pt->slowPeriod <= 1u || pt->sampleSeq % PROC_TIER_SWEEP_PERIOD == 0u) return PID_INDEX_NONE;
+    const uint32_t pidx = PidIndex_FindPid(&pt->prevIndex, pid);
+    if (pidx >= pt->prevCount) return PID_INDEX_NONE;
+    const struct PrevPidTime *e = &pt->prev[pidx];
+    if (!e->hasRow || e->keepFast || e->quietSamples < PROC_TIER_QUIET_SAMPLES) return PID_INDEX_NONE;
+
+    // Spread the slow tier's refreshes over its period instead of refreshing it all at once.
+    const uint32_t phase = (pid * 2654435761u) >> 16;
+    return ((pt->sampleSeq + phase) % pt->slowPeriod == 0u) ? PID_INDEX_NONE : pidx;
+}
+
+void ProcTable_PrevKeep(ProcTable *pt, uint32_t prevIndex, ProcRow *out)
+{
+    struct PrevPidTime *e = &pt->prev[prevIndex];
+    e->seen = true;
+    *out = e->last;
+}
+
+void ProcTable_KeepFast(ProcTable *pt, uint32_t pid)
+{
+    if (!pt || pid == 0) return;
+    const uint32_t pidx = PidIndex_FindPid(&pt->prevIndex, pid);
+    if (pidx < pt->prevCount) pt->prev[pidx].keepFast = true;
+}
+
+void ProcTable_FillNet(ProcTable *pt, ProcRow *r)
+{
+    const NetPidStats *ns = NetConns_Find(&pt->net, r->pid);
+    if (ns && ns->remoteCount > 0) {
+        r->hasNet = true;
+        r->netRemoteId = StrPool_Intern(&pt->strings, StrPool_Get(&pt->net.endpoints, ns->remoteIds[0]));
+        r->netConns = ns->remoteConns;
+    } else {
+        r->hasNet = false;
+        r->netRemoteId = STR_POOL_EMPTY;
+        r->netConns = 0;
+    }
+}
+
+static uint32_t remap_string(StrPool *dst, const StrPool *src, uint32_t *remap, uint32_t id)
+{
+    if (id == STR_POOL_EMPTY || id >= src->count) return STR_POOL_EMPTY;
+    if (remap[id] == STR_POOL_EMPTY) {
+        remap[id] = StrPool_Intern(dst, StrPool_Get(src, id));
+    }
+    return remap[id];
+}
+
+void ProcTable_TrimStrings(ProcTable *pt)
+{
+    // A row references at most four strings; rebuild once the pool holds several times
+    // what the live rows could use. Names, owners and paths mostly repeat, so in a steady
+    // state this only fires after enough processes or connections have come and gone.
+    const uint64_t live = 4u * ((uint64_t)pt->rowCount + pt->prevCount) + 1024u;
+    if ((uint64_t)pt->strings.count <= 4u * live) return;
+
+    StrPool fresh;
+    if (!StrPool_Init(&fresh)) return;
+    uint32_t *remap = (uint32_t *)calloc(pt->strings.count, sizeof(uint32_t));
+    if (!remap) {
+        StrPool_Shutdown(&fresh);
+        return;
+    }
+    SelfStats_NoteAlloc();
+
+    const StrPool *old = &pt->strings;
+    for (uint32_t i = 0; i < pt->rowCount; i++) {
+        ProcRow *r = &pt->rows[i];
+        r->nameId = remap_string(&fresh, old, remap, r->nameId);
+        r->pathId = remap_string(&fresh, old, remap, r->pathId);
+        r->ownerId = remap_string(&fresh, old, remap, r->ownerId);
+        r->netRemoteId = remap_string(&fresh, old, remap, r->netRemoteId);
+    }
+    for (uint32_t i = 0; i < pt->prevCount; i++) {
+        pt->prev[i].pathId = remap_string(&fresh, old, remap, pt->prev[i].pathId);
+        pt->prev[i].ownerId = remap_string(&fresh, old, remap, pt->prev[i].ownerId);
+        ProcRow *last = &pt->prev[i].last;
+        last->nameId = remap_string(&fresh, old, remap, last->nameId);
+        last->pathId = remap_string(&fresh, old, remap, last->pathId);
+        last->ownerId = remap_string(&fresh, old, remap, last->ownerId);
+        last->netRemoteId = remap_string(&fresh, old, remap, last->netRemoteId);
+    }
+
+    free(remap);
+    StrPool_Shutdown(&pt->strings);
+    pt->strings = fresh;
 }
 
 void ProcTable_Init(ProcTable *pt)
 {
     if (!pt) return;
     memset(pt, 0, sizeof(*pt));
+    (void)StrPool_Init(&pt->strings); // without it every string reads as empty
+    NetConns_Init(&pt->net);
+    WorkPool_Init(&pt->walkPool);
+    pt->slowPeriod = PROC_TIER_SLOW_PERIOD;
 }
 
 void ProcTable_Shutdown(ProcTable *pt)
 {
     if (!pt) return;
+    WorkPool_Shutdown(&pt->walkPool);
+    for (uint32_t i = 0; i < pt->prevCount; i++) {
+        close_handle(pt, &pt->prev[i]);
+    }
+    free(pt->walkProbes);
+    for (uint32_t i = 0; i < WORK_POOL_MAX_THREADS; i++) {
+        free(pt->walkText[i].chars);
+    }
     free(pt->prev);
     free(pt->rows);
+    ProcSortScratch_Free(&pt->sort);
+    free(pt->deltas);
+    PidIndex_Shutdown(&pt->prevIndex);
+    PidIndex_Shutdown(&pt->rowIndex);
+    StrPool_Shutdown(&pt->strings);
+    NetConns_Shutdown(&pt->net);
     memset(pt, 0, sizeof(*pt));
 }
 
-static bool proc_table_ensure_rows(ProcTable *pt, uint32_t want)
+bool ProcTable_EnsureRows(ProcTable *pt, uint32_t want)
 {
     if (!pt) return false;
     if (want <= pt->rowCap) return true;
@@ -372,112 +547,192 @@ static bool proc_table_ensure_rows(ProcTable *pt, uint32_t want)
 
     void *p = realloc(pt->rows, (size_t)newCap * sizeof(*pt->rows));
     if (!p) return false;
+    SelfStats_NoteAlloc();
     pt->rows = (ProcRow *)p;
     pt->rowCap = newCap;
     return true;
 }
 
-void ProcTable_Sample(ProcTable *pt)
+uint32_t ProcWalkText_Add(ProcWalkText *t, const wchar_t *s, uint32_t len)
 {
-    if (!pt) return;
-
-    const uint64_t sysTotal = get_system_total_time_100ns();
-    const uint64_t sysDelta = pt->prevInit ? (sysTotal - pt->prevSysTotal100ns) : 0;
-    pt->prevSysTotal100ns = sysTotal;
+    if (len > UINT32_MAX - 1u - t->count) return PROC_WALK_NO_TEXT;
+    const uint32_t want = t->count + len + 1u;
+    if (want > t->cap) {
+        uint32_t cap = t->cap ? t->cap : 4096u;
+        while (cap < want) {
+            if (cap > (UINT32_MAX / 2u)) {
+                cap = want;
+                break;
+            }
+            cap *= 2u;
+        }
+        wchar_t *p = (wchar_t *)realloc(t->chars, (size_t)cap * sizeof(wchar_t));
+        if (!p) return PROC_WALK_NO_TEXT;
+        SelfStats_NoteAlloc();
+        t->chars = p;
+        t->cap = cap;
+    }
+    const uint32_t offset = t->count;
+    wmemcpy(t->chars + offset, s, len);
+    t->chars[offset + len] = 0;
+    t->count = want;
+    return offset;
+}
 
-    PidNet nets[1024];
-    memset(nets, 0, sizeof(nets));
-    const uint32_t netCount = build_pid_net_map(nets, (uint32_t)_countof(nets));
+void ProcTable_WalkBegin(ProcTable *pt)
+{
+    for (uint32_t i = 0; i < WORK_POOL_MAX_THREADS; i++) {
+        pt->walkText[i].count = 0;
+    }
+}
 
-    HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (snap == INVALID_HANDLE_VALUE) {
-        pt->rowCount = 0;
-        pt->prevInit = true;
-        return;
+void *ProcTable_WalkProbes(ProcTable *pt, uint32_t count, size_t probeSize)
+{
+    if (probeSize == 0 || count > SIZE_MAX / probeSize) return NULL;
+    const size_t want = (size_t)count * probeSize;
+    if (want > pt->walkProbeBytes) {
+        size_t bytes = pt->walkProbeBytes ? pt->walkProbeBytes : (size_t)PROC_TABLE_INITIAL_CAP * probeSize;
+        while (bytes < want) {
+            bytes = (bytes > SIZE_MAX / 2u) ? want : bytes * 2u;
+        }
+        void *p = realloc(pt->walkProbes, bytes);
+        if (!p) return NULL;
+        SelfStats_NoteAlloc();
+        pt->walkProbes = p;
+        pt->walkProbeBytes = bytes;
     }
+    return pt->walkProbes;
+}
 
-    prev_mark_all_unseen(pt);
+typedef struct WalkRun {
+    ProcTable *pt;
+    uint32_t count;
+    ProcWalkFn fn;
+    void *ctx;
+} WalkRun;
 
-    PROCESSENTRY32W pe;
-    memset(&pe, 0, sizeof(pe));
-    pe.dwSize = sizeof(pe);
+static void walk_shard(void *ctx, uint32_t shard, uint32_t thread)
+{
+    const WalkRun *w = (const WalkRun *)ctx;
+    const uint32_t first = shard * PROC_WALK_SHARD;
+    const uint32_t end = (w->count - first > PROC_WALK_SHARD) ? first + PROC_WALK_SHARD : w->count;
+    w->fn(w->ctx, first, end, &w->pt->walkText[thread]);
+}
 
-    pt->rowCount = 0;
+void ProcTable_Walk(ProcTable *pt, uint32_t count, ProcWalkFn fn, void *ctx)
+{
+    if (!pt || !fn || count == 0) return;
+    // A pinned thread count is taken as is; the automatic one stays on the sampler thread
+    // for small walks.
+    uint32_t threads = pt->walkThreads;
+    if (threads == 0) {
+        threads = 1;
+        if (count >= PROC_WALK_PARALLEL_MIN) {
+            threads = SysThread_CpuCount();
+            if (threads > PROC_WALK_MAX_THREADS) threads = PROC_WALK_MAX_THREADS;
+        }
+    }
+    if (threads > WORK_POOL_MAX_THREADS) threads = WORK_POOL_MAX_THREADS;
+    WalkRun run = {pt, count, fn, ctx};
+    const uint32_t shards = (count + PROC_WALK_SHARD - 1u) / PROC_WALK_SHARD;
+    WorkPool_Run(&pt->walkPool, threads, shards, walk_shard, &run);
+}
 
-    if (Process32FirstW(snap, &pe)) {
-        do {
-            const uint32_t pid = (uint32_t)pe.th32ProcessID;
-            if (pid == 0) continue;
+intptr_t ProcTable_CachedHandle(const ProcTable *pt, uint32_t pid)
+{
+    if (pt->handleCap == 0) return PROC_HANDLE_NONE;
+    const uint32_t pidx = PidIndex_FindPid(&pt->prevIndex, pid);
+    return (pidx < pt->prevCount) ? pt->prev[pidx].handle : PROC_HANDLE_NONE;
+}
 
-            if (!proc_table_ensure_rows(pt, pt->rowCount + 1)) {
-                // Out of memory; keep partial list.
-                break;
-            }
+bool ProcTable_HandleReserve(ProcTable *pt)
+{
+    if (pt->handleCap == 0) return false;
+    if (Atomic_AddU32(&pt->handleCount, 1u) <= pt->handleCap) return true;
+    ProcTable_HandleRelease(pt);
+    return false;
+}
 
-            ProcRow r;
-            memset(&r, 0, sizeof(r));
-            r.pid = pid;
-            safe_wcpy(r.name, _countof(r.name), pe.szExeFile);
-
-            // Network
-            const int ni = pidnet_find(nets, netCount, pid);
-            if (ni >= 0) {
-                r.hasNet = true;
-                safe_wcpy(r.netRemote, _countof(r.netRemote), nets[ni].remote);
-            } else {
-                r.hasNet = false;
-                r.netRemote[0] = 0;
-            }
+void ProcTable_HandleRelease(ProcTable *pt)
+{
+    (void)Atomic_AddU32(&pt->handleCount, UINT32_MAX);
+}
 
-            // Open process (best-effort)
-            HANDLE hp = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-            if (hp) {
-                get_process_path(hp, r.path, _countof(r.path));
-                get_process_owner(hp, r.owner, _countof(r.owner));
-
-                // CPU% (requires GetProcessTimes)
-                const uint64_t procTotal = get_process_total_time_100ns(hp);
-                const uint32_t pidx = prev_find_or_add(pt, pid);
-                const uint64_t prevTotal = pt->prev[pidx].procTotal100ns;
-                pt->prev[pidx].procTotal100ns = procTotal;
-
-                if (pt->prevInit && sysDelta > 0 && procTotal >= prevTotal) {
-                    const uint64_t d = procTotal - prevTotal;
-                    r.cpuPct = (float)((double)d * 100.0 / (double)sysDelta);
-                    if (r.cpuPct < 0.0f) r.cpuPct = 0.0f;
-                    if (r.cpuPct > 100.0f) r.cpuPct = 100.0f;
-                } else {
-                    r.cpuPct = 0.0f;
-                }
-
-                // Memory (needs PROCESS_QUERY_INFORMATION on some systems; try broader if needed)
-                PROCESS_MEMORY_COUNTERS_EX pmc;
-                memset(&pmc, 0, sizeof(pmc));
-                pmc.cb = sizeof(pmc);
-                if (GetProcessMemoryInfo(hp, (PROCESS_MEMORY_COUNTERS *)&pmc, sizeof(pmc))) {
-                    r.workingSetBytes = (uint64_t)pmc.WorkingSetSize;
-                }
-
-                CloseHandle(hp);
-            } else {
-                // Still mark in prev map to allow later samples if we get permission.
-                (void)prev_find_or_add(pt, pid);
-            }
+void ProcTable_KeepHandle(ProcTable *pt, uint32_t prevIndex, intptr_t handle)
+{
+    if (handle == PROC_HANDLE_NONE) return;
+    struct PrevPidTime *e = &pt->prev[prevIndex];
+    if (e->handle == handle) return;
+    close_handle(pt, e);
+    e->handle = handle;
+}
+
+void ProcTable_IndexRows(ProcTable *pt)
+{
+    if (!pt) return;
+    if (!PidIndex_Reset(&pt->rowIndex, pt->rowCount)) return;
+    for (uint32_t i = 0; i < pt->rowCount; i++) {
+        if (!PidIndex_Insert(&pt->rowIndex, pt->rows[i].pid, pt->rows[i].createTime, i)) return;
+    }
+}
 
-            pt->rows[pt->rowCount++] = r;
-        } while (Process32NextW(snap, &pe));
+const ProcRow *ProcTable_FindRow(const ProcTable *pt, uint32_t pid)
+{
+    if (!pt || !pt->rows || pid == 0) return NULL;
+    if (pt->rowIndex.slots && pt->rowIndex.count == pt->rowCount) {
+        const uint32_t i = PidIndex_FindPid(&pt->rowIndex, pid);
+        return (i < pt->rowCount) ? &pt->rows[i] : NULL;
+    }
+    for (uint32_t i = 0; i < pt->rowCount; i++) {
+        if (pt->rows[i].pid == pid) return &pt->rows[i];
     }
+    return NULL;
+}
 
-    CloseHandle(snap);
+void ProcSortScratch_Free(ProcSortScratch *s)
+{
+    if (!s) return;
+    free(s->rows);
+    free(s->keys);
+    free(s->work);
+    memset(s, 0, sizeof(*s));
+}
 
-    prev_compact_unseen(pt);
-    pt->prevInit = true;
+bool ProcTable_SortRows(ProcRow *rows, uint32_t count, const StrPool *strings, ProcSortKey key, bool ascending,
+                        uint32_t limit, ProcSortScratch *scratch)
+{
+    if (!rows || count == 0 || count > UINT32_MAX / 2u) return true;
+    if (scratch) {
+        const uint32_t work = (is_string_key(key) && strings) ? strings->count : 0;
+        if (!ensure_scratch(scratch, count, 2u * count, work)) return false;
+        sort_rows(rows, count, strings, key, ascending, limit, scratch->keys, work ? scratch->work : NULL,
+                  scratch->rows);
+        memcpy(rows, scratch->rows, (size_t)count * sizeof(ProcRow));
+        return true;
+    }
+
+    const size_t work = (is_string_key(key) && strings) ? (size_t)strings->count : 0;
+    SortKey *keys = (SortKey *)malloc(2u * (size_t)count * sizeof(SortKey));
+    uint32_t *ids = work ? (uint32_t *)malloc(work * sizeof(uint32_t)) : NULL;
+    ProcRow *out = (ProcRow *)malloc((size_t)count * sizeof(ProcRow));
+    const bool ok = keys && out && (ids || !work);
+    if (ok) {
+        SelfStats_NoteAlloc();
+        sort_rows(rows, count, strings, key, ascending, limit, keys, ids, out);
+        memcpy(rows, out, (size_t)count * sizeof(ProcRow));
+    }
+    free(keys);
+    free(ids);
+    free(out);
+    return ok;
 }
 
-void ProcTable_Sort(ProcTable *pt, ProcSortKey key, bool ascending)
+void ProcTable_Sort(ProcTable *pt, ProcSortKey key, bool ascending, uint32_t limit)
 {
-    if (!pt || pt->rowCount == 0) return;
-    g_sortCtx.key = key;
-    g_sortCtx.asc = ascending;
-    qsort(pt->rows, pt->rowCount, sizeof(pt->rows[0]), row_cmp_ctx);
+    if (!pt || pt->rowCount == 0 || pt->rowCount > UINT32_MAX / 2u) return;
+    if (!ProcTable_SortRows(pt->rows, pt->rowCount, &pt->strings, key, ascending, limit, &pt->sort)) return;
+    pt->sortedCount = (limit != 0 && limit < pt->rowCount) ? limit : pt->rowCount;
+    if (pt->rowIndex.slots) {
+        ProcTable_IndexRows(pt);
+    }
 }
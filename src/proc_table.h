@@ -1,13 +1,59 @@
 #pragma once
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <wchar.h>
+#ifndef MAX_PATH
+#define MAX_PATH 260
+#endif
+#endif
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "key_sort.h"
+#include "net_conn.h"
+#include "pid_index.h"
+#include "str_pool.h"
+#include "work_pool.h"
+
 #ifndef PROC_TABLE_INITIAL_CAP
 #define PROC_TABLE_INITIAL_CAP 256
 #endif
 
+// Sharded process walk: processes per shard, the process count below which an automatic
+// walk (walkThreads 0) stays on the sampler thread, and the default thread count cap.
+#ifndef PROC_WALK_SHARD
+#define PROC_WALK_SHARD 32u
+#endif
+#ifndef PROC_WALK_PARALLEL_MIN
+#define PROC_WALK_PARALLEL_MIN 256u
+#endif
+#ifndef PROC_WALK_MAX_THREADS
+#define PROC_WALK_MAX_THREADS 4u
+#endif
+
+// Per-process handles the backends keep open between samples (at most; the Linux backend
+// lowers it to fit the descriptor limit).
+#ifndef PROC_HANDLE_CACHE_CAP
+#define PROC_HANDLE_CACHE_CAP 8192u
+#endif
+#define PROC_HANDLE_NONE ((intptr_t)-1)
+
+// Adaptive refresh (ProcTable_SlowTier): refreshes in a row without CPU use or working set
+// change before a process drops to the slow tier, the slow tier's period in samples
+// (ProcTable.slowPeriod's default), and the period of the full sweeps that refresh every
+// process regardless.
+#ifndef PROC_TIER_QUIET_SAMPLES
+#define PROC_TIER_QUIET_SAMPLES 5u
+#endif
+#ifndef PROC_TIER_SLOW_PERIOD
+#define PROC_TIER_SLOW_PERIOD 4u
+#endif
+#ifndef PROC_TIER_SWEEP_PERIOD
+#define PROC_TIER_SWEEP_PERIOD 30u
+#endif
+
 typedef enum ProcSortKey {
     PROC_SORT_CPU = 0,
     PROC_SORT_PID,
@@ -18,35 +64,158 @@ typedef enum ProcSortKey {
     PROC_SORT_PATH,
 } ProcSortKey;
 
+// One process (or, in a stacked view, one group). Only the fields sorting, grouping and
+// drawing touch per row live here; the strings are ids into the owning table's StrPool
+// (STR_POOL_EMPTY when unknown), so sorts and view copies move 48-byte records.
 typedef struct ProcRow {
     uint32_t pid;
     float cpuPct;
     uint64_t workingSetBytes;
+    uint64_t createTime; // process start in 100ns units (platform epoch); 0 if unknown
 
-    bool hasNet;
-    wchar_t netRemote[64];
+    uint32_t nameId;
+    uint32_t pathId;
+    uint32_t ownerId;
+    uint32_t netRemoteId; // meaningful when hasNet: the endpoint with most connections
 
-    wchar_t name[64];
-    wchar_t path[MAX_PATH];
-    wchar_t owner[96];
+    uint32_t groupSize; // stacked view group header: member count; 0 otherwise
+    bool hasNet;
+    bool groupMember; // stacked view: member row listed under its expanded group
+    uint16_t netConns; // established connections to remote endpoints (hasNet)
 } ProcRow;
 
+// Row columns, as flagged by a PROC_DELTA_CHANGED record.
+#define PROC_COL_CPU 0x01u
+#define PROC_COL_MEM 0x02u
+#define PROC_COL_NAME 0x04u
+#define PROC_COL_PATH 0x08u
+#define PROC_COL_OWNER 0x10u
+#define PROC_COL_NET 0x20u // hasNet, the remote endpoint or the connection count
+#define PROC_COL_ALL 0x3Fu
+
+typedef enum ProcDeltaKind {
+    PROC_DELTA_STARTED = 0,
+    PROC_DELTA_EXITED,
+    PROC_DELTA_CHANGED,
+} ProcDeltaKind;
+
+// One record of a sample's delta stream. The row of a STARTED or CHANGED process is
+// pt->rows' row for pid (ProcTable_FindRow); an EXITED one is gone.
+typedef struct ProcDelta {
+    uint32_t pid;
+    uint8_t kind;    // ProcDeltaKind
+    uint8_t columns; // PROC_COL_* that changed (PROC_COL_ALL when STARTED, 0 when EXITED)
+    uint64_t createTime;
+} ProcDelta;
+
+// Buffers ProcTable_SortRows keeps between calls: rows being reordered, sort keys, and
+// string ranks.
+typedef struct ProcSortScratch {
+    ProcRow *rows;
+    uint32_t rowCap;
+    SortKey *keys;
+    uint32_t keyCap;
+    uint32_t *work;
+    uint32_t workCap;
+} ProcSortScratch;
+
+void ProcSortScratch_Free(ProcSortScratch *s);
+
+// Text a walk thread read (names, paths), back to back; probes refer to it by offset.
+typedef struct ProcWalkText {
+    wchar_t *chars;
+    uint32_t count;
+    uint32_t cap;
+} ProcWalkText;
+
+#define PROC_WALK_NO_TEXT UINT32_MAX
+
+// Appends len characters and a terminator; returns the offset, or PROC_WALK_NO_TEXT when
+// out of memory.
+uint32_t ProcWalkText_Add(ProcWalkText *t, const wchar_t *s, uint32_t len);
+
+static inline const wchar_t *ProcWalkText_Get(const ProcWalkText *t, uint32_t offset)
+{
+    return (offset < t->count) ? t->chars + offset : L"";
+}
+
+// Probes processes [first, end) of a walk; text is the running thread's own.
+typedef void (*ProcWalkFn)(void *ctx, uint32_t first, uint32_t end, ProcWalkText *text);
+
 typedef struct ProcTable {
     ProcRow *rows;
     uint32_t rowCount;
     uint32_t rowCap;
+    PidIndex rowIndex;    // pid -> row; see ProcTable_IndexRows
+    StrPool strings;      // names, paths, owners and endpoints of rows and cached state
+    NetConns net;         // sockets by owning PID, refreshed at their own rate by the backends
+
+    // Sharded process walk (ProcTable_Walk): the backend's per-process probe records,
+    // filled in parallel, and each walk thread's text.
+    WorkPool walkPool;
+    uint32_t walkThreads; // threads a walk uses, the sampler's included, whatever its size (0 = auto)
+    void *walkProbes;
+    size_t walkProbeBytes;
+    ProcWalkText walkText[WORK_POOL_MAX_THREADS];
+
+    // Handle cache: the handle a backend opened for a live process stays in its
+    // PrevPidTime entry (handle) until the process leaves the table, so steady-state
+    // samples read instead of opening and closing. handleCount counts the cached handles
+    // and the walk's reservations; the backend sets handleCap (0 = no caching) and
+    // closeHandle on its first sample.
+    volatile uint32_t handleCount;
+    uint32_t handleCap;
+    void (*closeHandle)(intptr_t handle);
+
+    // Adaptive refresh: a process quiet for PROC_TIER_QUIET_SAMPLES refreshes is only
+    // refreshed every slowPeriod samples (staggered by PID; 0 or 1 = every sample) unless
+    // ProcTable_KeepFast asked for it, and every PROC_TIER_SWEEP_PERIOD samples all
+    // processes are. In between it keeps its last row. sampleSeq counts samples.
+    uint32_t slowPeriod;
+    uint32_t sampleSeq;
+    uint32_t sortedCount; // rows [0, sortedCount) are in display order (ProcTable_Sort)
 
-    // Previous sample state for CPU% (100ns units)
+    // Sort scratch (ProcTable_SortRows); the previous order while seeding also goes
+    // through it.
+    ProcSortScratch sort;
+
+    // What the last sample changed relative to the one before: exits first, then starts
+    // and changes in sample order. deltaSeq counts samples; a consumer that mirrored
+    // sample deltaSeq - 1 can apply the stream, any other has to re-read the rows. It
+    // skips a number when a stream is incomplete (out of memory).
+    ProcDelta *deltas;
+    uint32_t deltaCount;
+    uint32_t deltaCap;
+    uint32_t deltaSeq;
+    bool deltaLost;
+
+    // Previous sample state for CPU% (100ns units). The backends set prevSysTotal100ns
+    // once the sample's processes are merged.
     uint64_t prevSysTotal100ns;
     bool prevInit;
 
+    // Keyed by (pid, createTime) so a reused PID starts from fresh state. Also caches the
+    // attributes that never change for a live process; the backends fill them the first
+    // time they see it (hasAttrs) and copy them into the row on every later sample.
     struct PrevPidTime {
         uint32_t pid;
+        uint64_t createTime;
         uint64_t procTotal100ns;
+        uint64_t sysTotal100ns; // system CPU time at the last refresh (0 = none yet)
         bool seen;
+        bool refreshed;       // probed this sample (not kept from the last row)
+        bool keepFast;        // ProcTable_KeepFast since the last sample
+        uint8_t quietSamples; // refreshes in a row without CPU use or working set change
+        bool hasAttrs;
+        uint32_t pathId;
+        uint32_t ownerId;
+        intptr_t handle; // cached process handle (PROC_HANDLE_NONE), see handleCount
+        bool hasRow;  // last holds the row the previous sample produced
+        ProcRow last; // for the delta stream
     } *prev;
     uint32_t prevCount;
     uint32_t prevCap;
+    PidIndex prevIndex;
 } ProcTable;
 
 void ProcTable_Init(ProcTable *pt);
@@ -54,7 +223,87 @@ void ProcTable_Shutdown(ProcTable *pt);
 
 // Samples process list and fills pt->rows with top processes by CPU%.
 // Best-effort fields: path/owner/net may be empty if access is denied.
+// Implemented per platform (proc_table_win.c, linux/proc_table_linux.c).
 void ProcTable_Sample(ProcTable *pt);
 
-// Sorts pt->rows in-place.
-void ProcTable_Sort(ProcTable *pt, ProcSortKey key, bool ascending);
+// Sorts pt->rows (re-indexing them if the table keeps an index). With limit != 0
+// only the first limit rows are put in order (pt->sortedCount); the rest follow in no
+// particular order, every one of them sorting after those. ProcTable_Sample leaves the
+// rows in the previous sample's order, so re-sorting mostly only moves the rows whose
+// keys changed.
+//
+// Rows sort by precomputed integer keys (key_sort.h); string columns by each distinct
+// string's rank. Both functions are reentrant: the sampler may sort its table while the
+// UI sorts a copy of a view.
+void ProcTable_Sort(ProcTable *pt, ProcSortKey key, bool ascending, uint32_t limit);
+// Sorts rows whose string ids refer to strings (views over a table's rows). limit as above.
+// scratch, when not NULL, supplies the buffers; otherwise they are allocated for the call.
+// Returns false when out of memory (the rows are left as they were).
+bool ProcTable_SortRows(ProcRow *rows, uint32_t count, const StrPool *strings, ProcSortKey key, bool ascending,
+                        uint32_t limit, ProcSortScratch *scratch);
+
+// (Re)builds the pid -> row index. ProcTable_Sample does this itself; code that fills
+// pt->rows directly calls it afterwards. Tables without an index (temporary views over
+// borrowed rows) are still searchable, linearly.
+void ProcTable_IndexRows(ProcTable *pt);
+
+// Lookup by PID; NULL if not present. O(1) on an indexed table.
+const ProcRow *ProcTable_FindRow(const ProcTable *pt, uint32_t pid);
+
+// Rebuilds the string pool from the strings still referenced by rows and cached state
+// once dead ones (exited processes, closed connections) dominate it. Ids change.
+void ProcTable_TrimStrings(ProcTable *pt);
+
+// Helpers shared by the platform ProcTable_Sample implementations. PrevEnd drops the
+// state of processes not seen this sample, trims the strings, emits the delta stream,
+// puts the new rows in the order the previous ones were left in (new processes last) and
+// indexes them. PrevFail ends a sample that could not read the process list: no rows,
+// every process reported exited, CPU state kept for the next sample.
+bool ProcTable_EnsureRows(ProcTable *pt, uint32_t want);
+void ProcTable_PrevBegin(ProcTable *pt);
+uint32_t ProcTable_PrevFindOrAdd(ProcTable *pt, uint32_t pid, uint64_t createTime);
+void ProcTable_PrevEnd(ProcTable *pt);
+void ProcTable_PrevFail(ProcTable *pt);
+// Records a refreshed process's CPU time (100ns units) and returns its CPU% over the
+// interval since its own last refresh, which for a slow-tier process spans several
+// samples. sysTotal is the system CPU time of this sample.
+float ProcTable_PrevCpu(ProcTable *pt, uint32_t prevIndex, uint64_t procTotal, uint64_t sysTotal);
+// Fills the Net columns of a row from pt->net.
+void ProcTable_FillNet(ProcTable *pt, ProcRow *r);
+
+// The backends sample in three steps: list the processes into probe records (serial),
+// probe each one (ProcTable_Walk: open it, read times, memory and, for a process not seen
+// before, its attributes), then merge the probes into rows in list order (serial: string
+// interning and the PrevPidTime state). Probing is the per-process syscall work, so it is
+// what runs in parallel; probe functions may read pt->prev and pt->prevIndex but not
+// change them.
+//
+// WalkBegin empties the walk text. WalkProbes makes room for count probes of probeSize
+// bytes, keeping those already listed (NULL when out of memory). Walk probes [0, count)
+// in shards of PROC_WALK_SHARD, on walkThreads threads, or when that is 0, on several
+// threads once count reaches PROC_WALK_PARALLEL_MIN.
+void ProcTable_WalkBegin(ProcTable *pt);
+void *ProcTable_WalkProbes(ProcTable *pt, uint32_t count, size_t probeSize);
+void ProcTable_Walk(ProcTable *pt, uint32_t count, ProcWalkFn fn, void *ctx);
+
+// Handle cache, for the probes: CachedHandle is the handle kept for pid (the process it
+// refers to may have exited; its start time tells). A probe that opened a process
+// reserves a cache slot with HandleReserve and, if it got one, hands the handle to the
+// merge, which stores it with KeepHandle; a probe that ends up not passing it on calls
+// HandleRelease. A handle without a slot is closed by the probe as before.
+intptr_t ProcTable_CachedHandle(const ProcTable *pt, uint32_t pid);
+bool ProcTable_HandleReserve(ProcTable *pt);
+void ProcTable_HandleRelease(ProcTable *pt);
+void ProcTable_KeepHandle(ProcTable *pt, uint32_t prevIndex, intptr_t handle);
+
+// Adaptive refresh, while listing (sampler thread): SlowTier returns the PrevPidTime entry
+// of a listed pid that this sample need not probe, or PID_INDEX_NONE. The merge turns such
+// an entry back into a row with PrevKeep (the last row, the Net columns left to
+// ProcTable_FillNet). A Linux listing carries no start time, so a PID reused by a slow-tier
+// process shows the old row until that entry's next refresh.
+uint32_t ProcTable_SlowTier(const ProcTable *pt, uint32_t pid);
+void ProcTable_PrevKeep(ProcTable *pt, uint32_t prevIndex, ProcRow *out);
+
+// Keeps pid at the full refresh rate through the next sample (the rows on screen, the
+// selected process). Call after every sample.
+void ProcTable_KeepFast(ProcTable *pt, uint32_t pid);
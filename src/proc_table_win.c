@@ -0,0 +1,351 @@
+#include "proc_table.h"
+
+#include <windows.h>
+
+#include <tlhelp32.h>
+#include <psapi.h>
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "qpc.h"
+#include "self_stats.h"
+
+#ifndef _countof
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+static uint64_t ft_to_u64(FILETIME ft)
+{
+    ULARGE_INTEGER u;
+    u.LowPart = ft.dwLowDateTime;
+    u.HighPart = ft.dwHighDateTime;
+    return (uint64_t)u.QuadPart;
+}
+
+static void safe_wcpy(wchar_t *dst, size_t dstCount, const wchar_t *src)
+{
+    if (!dst || dstCount == 0) return;
+    if (!src) {
+        dst[0] = 0;
+        return;
+    }
+#ifdef _MSC_VER
+    wcscpy_s(dst, dstCount, src);
+#else
+    wcsncpy(dst, src, dstCount - 1);
+    dst[dstCount - 1] = 0;
+#endif
+}
+
+// SID -> "DOMAIN\user". LookupAccountSidW may ask a domain controller; processes run under
+// a handful of accounts, so a small table answers nearly every lookup. Failed lookups are
+// cached too (deleted accounts fail every time). Only the sampler thread samples (the walk
+// threads only read SIDs; names are looked up while merging).
+#define SID_CACHE_CAP 32u
+
+typedef struct SidName {
+    BYTE sid[SECURITY_MAX_SID_SIZE];
+    wchar_t name[96];
+} SidName;
+
+static SidName s_sidCache[SID_CACHE_CAP];
+static uint32_t s_sidCacheCount;
+static uint32_t s_sidCacheNext; // round-robin victim once full
+
+static void lookup_sid_name(PSID sid, wchar_t *out, size_t outCount)
+{
+    for (uint32_t i = 0; i < s_sidCacheCount; i++) {
+        if (EqualSid(sid, (PSID)s_sidCache[i].sid)) {
+            safe_wcpy(out, outCount, s_sidCache[i].name);
+            return;
+        }
+    }
+
+    wchar_t tmp[96];
+    tmp[0] = 0;
+    wchar_t name[64];
+    wchar_t domain[64];
+    DWORD cchName = (DWORD)_countof(name);
+    DWORD cchDomain = (DWORD)_countof(domain);
+    SID_NAME_USE use;
+    if (LookupAccountSidW(NULL, sid, name, &cchName, domain, &cchDomain, &use)) {
+#ifdef _MSC_VER
+        swprintf(tmp, _countof(tmp), L"%s\\%s", domain, name);
+#else
+        swprintf(tmp, _countof(tmp), L"%ls\\%ls", domain, name);
+#endif
+    }
+    safe_wcpy(out, outCount, tmp);
+
+    const DWORD len = GetLengthSid(sid);
+    if (len > sizeof(s_sidCache[0].sid)) return;
+    const uint32_t slot = (s_sidCacheCount < SID_CACHE_CAP) ? s_sidCacheCount++ : (s_sidCacheNext++ % SID_CACHE_CAP);
+    if (!CopySid(len, (PSID)s_sidCache[slot].sid, sid)) {
+        // Leave a SID that matches nothing rather than a stale name.
+        memset(s_sidCache[slot].sid, 0, sizeof(s_sidCache[slot].sid));
+    }
+    safe_wcpy(s_sidCache[slot].name, _countof(s_sidCache[slot].name), tmp);
+}
+
+// Copies the SID of the process's user into sid.
+static bool get_process_sid(HANDLE hProcess, BYTE *sid, DWORD sidSize)
+{
+    HANDLE hToken = NULL;
+    if (!OpenProcessToken(hProcess, TOKEN_QUERY, &hToken)) {
+        return false;
+    }
+
+    // TOKEN_USER plus the largest SID it can point at; no size probe, no allocation.
+    union {
+        TOKEN_USER tu;
+        BYTE bytes[sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE];
+    } info;
+    DWORD len = 0;
+    bool ok = false;
+    if (GetTokenInformation(hToken, TokenUser, &info, (DWORD)sizeof(info), &len)) {
+        ok = CopySid(sidSize, (PSID)sid, info.tu.User.Sid) != FALSE;
+    }
+    CloseHandle(hToken);
+    return ok;
+}
+
+static void get_process_path(HANDLE hProcess, wchar_t *out, size_t outCount)
+{
+    if (!out || outCount == 0) return;
+    out[0] = 0;
+
+    DWORD sz = (DWORD)outCount;
+    // QueryFullProcessImageNameW is in kernel32.
+    if (!QueryFullProcessImageNameW(hProcess, 0, out, &sz)) {
+        out[0] = 0;
+    }
+}
+
+static uint64_t get_process_total_time_100ns(HANDLE hProcess, uint64_t *outCreateTime)
+{
+    FILETIME ct, et, kt, ut;
+    if (!GetProcessTimes(hProcess, &ct, &et, &kt, &ut)) {
+        return 0;
+    }
+    *outCreateTime = ft_to_u64(ct);
+    return ft_to_u64(kt) + ft_to_u64(ut);
+}
+
+static uint64_t get_system_total_time_100ns(void)
+{
+    FILETIME idle, kernel, user;
+    if (!GetSystemTimes(&idle, &kernel, &user)) {
+        return 0;
+    }
+    return ft_to_u64(kernel) + ft_to_u64(user);
+}
+
+// What the walk reads about one process, merged into its row afterwards.
+typedef struct WinProbe {
+    uint32_t pid;
+    uint32_t keep; // slow-tier PrevPidTime entry whose last row stands (PID_INDEX_NONE: probe)
+    HANDLE handle; // newly opened, holding a cache slot for the merge (NULL)
+    bool opened;   // OpenProcess succeeded
+    bool hasAttrs; // the probe read path and owner (first sight of the process)
+    bool hasSid;
+    uint8_t thread;    // walk text holding the path
+    uint32_t nameText; // in walkText[0] (listed on the sampler thread)
+    uint32_t pathText;
+    uint64_t procTotal100ns;
+    uint64_t createTime;
+    uint64_t workingSetBytes;
+    BYTE sid[SECURITY_MAX_SID_SIZE];
+} WinProbe;
+
+typedef struct WinWalk {
+    ProcTable *pt;
+    WinProbe *probes;
+} WinWalk;
+
+static void probe_processes(void *ctx, uint32_t first, uint32_t end, ProcWalkText *text)
+{
+    const WinWalk *w = (const WinWalk *)ctx;
+    ProcTable *pt = w->pt;
+    for (uint32_t i = first; i < end; i++) {
+        WinProbe *pr = &w->probes[i];
+        pr->thread = (uint8_t)(text - pt->walkText);
+        if (pr->keep != PID_INDEX_NONE) continue;
+
+        // Open process (best-effort). A PID is not reused while a handle to its process is
+        // open, so a cached handle for a listed PID is still that process.
+        const intptr_t cached = ProcTable_CachedHandle(pt, pr->pid);
+        const bool fresh = (cached == PROC_HANDLE_NONE);
+        HANDLE hp = fresh ? OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pr->pid) : (HANDLE)cached;
+        if (!hp) continue;
+        pr->opened = true;
+
+        // CPU% (requires GetProcessTimes, which also yields the creation time key)
+        pr->procTotal100ns = get_process_total_time_100ns(hp, &pr->createTime);
+
+        // Path and owner are fixed for the life of the process: query them once.
+        const uint32_t pidx = PidIndex_Find(&pt->prevIndex, pr->pid, pr->createTime);
+        if (pidx == PID_INDEX_NONE || !pt->prev[pidx].hasAttrs) {
+            wchar_t path[MAX_PATH];
+            get_process_path(hp, path, _countof(path));
+            pr->pathText = ProcWalkText_Add(text, path, (uint32_t)wcslen(path));
+            pr->hasSid = get_process_sid(hp, pr->sid, (DWORD)sizeof(pr->sid));
+            pr->hasAttrs = true;
+        }
+
+        // Memory (needs PROCESS_QUERY_INFORMATION on some systems; try broader if needed)
+        PROCESS_MEMORY_COUNTERS_EX pmc;
+        memset(&pmc, 0, sizeof(pmc));
+        pmc.cb = sizeof(pmc);
+        if (GetProcessMemoryInfo(hp, (PROCESS_MEMORY_COUNTERS *)&pmc, sizeof(pmc))) {
+            pr->workingSetBytes = (uint64_t)pmc.WorkingSetSize;
+        }
+
+        if (fresh) {
+            if (ProcTable_HandleReserve(pt)) {
+                pr->handle = hp;
+            } else {
+                CloseHandle(hp);
+            }
+        }
+    }
+}
+
+static void close_process_handle(intptr_t handle)
+{
+    CloseHandle((HANDLE)handle);
+}
+
+// Closes the handles of probes [first, count) the merge did not get to.
+static void drop_probe_handles(ProcTable *pt, const WinProbe *probes, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < count; i++) {
+        if (probes[i].handle) {
+            CloseHandle(probes[i].handle);
+            ProcTable_HandleRelease(pt);
+        }
+    }
+}
+
+static uint32_t intern_text(ProcTable *pt, uint32_t thread, uint32_t offset)
+{
+    if (offset == PROC_WALK_NO_TEXT) return STR_POOL_EMPTY;
+    return StrPool_Intern(&pt->strings, ProcWalkText_Get(&pt->walkText[thread], offset));
+}
+
+// Lists the snapshot's processes into probes; returns how many.
+static uint32_t list_processes(ProcTable *pt, HANDLE snap)
+{
+    PROCESSENTRY32W pe;
+    memset(&pe, 0, sizeof(pe));
+    pe.dwSize = sizeof(pe);
+
+    uint32_t count = 0;
+    if (Process32FirstW(snap, &pe)) {
+        do {
+            const uint32_t pid = (uint32_t)pe.th32ProcessID;
+            if (pid == 0) continue;
+
+            WinProbe *probes = (WinProbe *)ProcTable_WalkProbes(pt, count + 1u, sizeof(WinProbe));
+            if (!probes) {
+                // Out of memory; keep partial list.
+                break;
+            }
+            WinProbe *pr = &probes[count++];
+            memset(pr, 0, offsetof(WinProbe, sid));
+            pr->pid = pid;
+            pr->keep = ProcTable_SlowTier(pt, pid);
+            pr->nameText = ProcWalkText_Add(&pt->walkText[0], pe.szExeFile, (uint32_t)wcslen(pe.szExeFile));
+            pr->pathText = PROC_WALK_NO_TEXT;
+        } while (Process32NextW(snap, &pe));
+    }
+    return count;
+}
+
+void ProcTable_Sample(ProcTable *pt)
+{
+    if (!pt) return;
+    if (!pt->closeHandle) {
+        pt->closeHandle = close_process_handle;
+        pt->handleCap = PROC_HANDLE_CACHE_CAP;
+    }
+
+    const uint64_t sysTotal = get_system_total_time_100ns();
+
+    const int64_t now = Qpc_Now();
+    if (NetConns_RefreshDue(&pt->net, now)) {
+        NetConns_Refresh(&pt->net, now);
+    }
+
+    HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snap == INVALID_HANDLE_VALUE) {
+        pt->prevSysTotal100ns = sysTotal;
+        ProcTable_PrevFail(pt);
+        return;
+    }
+
+    ProcTable_PrevBegin(pt);
+    ProcTable_WalkBegin(pt);
+    const uint32_t count = list_processes(pt, snap);
+    CloseHandle(snap);
+
+    // Probe (open, times, memory, and the attributes of new processes) in parallel, merge
+    // in snapshot order.
+    WinWalk walk = {pt, (WinProbe *)pt->walkProbes};
+    ProcTable_Walk(pt, count, probe_processes, &walk);
+
+    pt->rowCount = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const WinProbe *pr = &walk.probes[i];
+        if (!ProcTable_EnsureRows(pt, pt->rowCount + 1)) {
+            // Out of memory; keep partial list.
+            drop_probe_handles(pt, walk.probes, i, count);
+            break;
+        }
+
+        ProcRow r;
+        if (pr->keep != PID_INDEX_NONE) {
+            ProcTable_PrevKeep(pt, pr->keep, &r);
+            ProcTable_FillNet(pt, &r);
+            pt->rows[pt->rowCount++] = r;
+            continue;
+        }
+
+        memset(&r, 0, sizeof(r));
+        r.pid = pr->pid;
+        r.nameId = intern_text(pt, 0, pr->nameText);
+
+        ProcTable_FillNet(pt, &r);
+
+        if (pr->opened) {
+            r.createTime = pr->createTime;
+            r.workingSetBytes = pr->workingSetBytes;
+            const uint64_t procTotal = pr->procTotal100ns;
+            const uint32_t pidx = ProcTable_PrevFindOrAdd(pt, pr->pid, r.createTime);
+            r.cpuPct = ProcTable_PrevCpu(pt, pidx, procTotal, sysTotal);
+            if (pr->handle) ProcTable_KeepHandle(pt, pidx, (intptr_t)pr->handle);
+
+            if (!pt->prev[pidx].hasAttrs) {
+                wchar_t owner[96];
+                owner[0] = 0;
+                if (pr->hasSid) lookup_sid_name((PSID)pr->sid, owner, _countof(owner));
+                pt->prev[pidx].pathId = intern_text(pt, pr->thread, pr->hasAttrs ? pr->pathText : PROC_WALK_NO_TEXT);
+                pt->prev[pidx].ownerId = StrPool_Intern(&pt->strings, owner);
+                pt->prev[pidx].hasAttrs = true;
+            }
+            r.pathId = pt->prev[pidx].pathId;
+            r.ownerId = pt->prev[pidx].ownerId;
+        } else {
+            // Still mark in prev map to allow later samples if we get permission.
+            (void)ProcTable_PrevFindOrAdd(pt, pr->pid, 0);
+        }
+
+        pt->rows[pt->rowCount++] = r;
+    }
+
+    pt->prevSysTotal100ns = sysTotal;
+    ProcTable_PrevEnd(pt);
+}
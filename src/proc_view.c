@@ -0,0 +1,400 @@
+#include "proc_view.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <wchar.h>
+
+#include "self_stats.h"
+
+static int wcmp_insensitive(const wchar_t *a, const wchar_t *b)
+{
+    if (!a) a = L"";
+    if (!b) b = L"";
+#ifdef _MSC_VER
+    return _wcsicmp(a, b);
+#elif defined(_WIN32)
+    return wcsicmp(a, b);
+#else
+    return wcscasecmp(a, b);
+#endif
+}
+
+static bool ensure_proc_view_rows(ProcView *v, uint32_t want)
+{
+    if (!v) return false;
+    if (want <= v->rowCap) return true;
+    uint32_t newCap = v->rowCap ? (v->rowCap * 2u) : 256u;
+    while (newCap < want) {
+        if (newCap > (UINT32_MAX / 2u)) {
+            newCap = want;
+            break;
+        }
+        newCap *= 2u;
+    }
+    void *p = realloc(v->rows, (size_t)newCap * sizeof(*v->rows));
+    if (!p) return false;
+    SelfStats_NoteAlloc();
+    v->rows = (ProcRow *)p;
+    v->rowCap = newCap;
+    return true;
+}
+
+static bool ensure_proc_groups(ProcView *v, uint32_t want)
+{
+    if (!v) return false;
+    if (want <= v->groupCap) return true;
+    uint32_t newCap = v->groupCap ? (v->groupCap * 2u) : 64u;
+    while (newCap < want) {
+        if (newCap > (UINT32_MAX / 2u)) {
+            newCap = want;
+            break;
+        }
+        newCap *= 2u;
+    }
+    void *p = realloc(v->groups, (size_t)newCap * sizeof(*v->groups));
+    if (!p) return false;
+    SelfStats_NoteAlloc();
+    v->groups = (ProcGroupIndex *)p;
+    v->groupCap = newCap;
+    return true;
+}
+
+static bool ensure_proc_group_members(ProcView *v, uint32_t want)
+{
+    if (!v) return false;
+    if (want <= v->memberCap) return true;
+    uint32_t newCap = v->memberCap ? (v->memberCap * 2u) : 256u;
+    while (newCap < want) {
+        if (newCap > (UINT32_MAX / 2u)) {
+            newCap = want;
+            break;
+        }
+        newCap *= 2u;
+    }
+    void *p = realloc(v->members, (size_t)newCap * sizeof(*v->members));
+    if (!p) return false;
+    SelfStats_NoteAlloc();
+    v->members = (uint32_t *)p;
+    v->memberCap = newCap;
+    return true;
+}
+
+const ProcGroupIndex *ProcView_FindGroupByLeader(const ProcView *v, uint32_t leaderPid)
+{
+    if (!v || leaderPid == 0) return NULL;
+    for (uint32_t i = 0; i < v->groupCount; i++) {
+        if (v->groups[i].leaderPid == leaderPid) {
+            return &v->groups[i];
+        }
+    }
+    return NULL;
+}
+
+static int row_cmp_cpu_desc_local(const void *a, const void *b)
+{
+    const ProcRow *ra = (const ProcRow *)a;
+    const ProcRow *rb = (const ProcRow *)b;
+    if (ra->cpuPct < rb->cpuPct) return 1;
+    if (ra->cpuPct > rb->cpuPct) return -1;
+    if (ra->workingSetBytes < rb->workingSetBytes) return 1;
+    if (ra->workingSetBytes > rb->workingSetBytes) return -1;
+    if (ra->pid < rb->pid) return -1;
+    if (ra->pid > rb->pid) return 1;
+    return 0;
+}
+
+static void reverse_rows(ProcRow *rows, uint32_t n)
+{
+    for (uint32_t i = 0, j = n; i + 1u < j; i++, j--) {
+        const ProcRow t = rows[i];
+        rows[i] = rows[j - 1u];
+        rows[j - 1u] = t;
+    }
+}
+
+// Moves rows[0, k) behind rows[k, n), both keeping their order.
+static void rotate_rows(ProcRow *rows, uint32_t n, uint32_t k)
+{
+    reverse_rows(rows, k);
+    reverse_rows(rows + k, n - k);
+    reverse_rows(rows, n);
+}
+
+// Sorts view rows by the settings' key, the first limit of them at least (0 = all). Only
+// group headers are sorted; the expanded group's member rows, one block directly beneath
+// their header and already in CPU order, are kept there. A header row never sorts below
+// the view row it ends up at, so limit headers cover limit view rows. scratch as for
+// ProcTable_SortRows.
+static void order_rows(ProcRow *rows, uint32_t *count, const StrPool *strings, const ProcViewSettings *s,
+                       uint32_t limit, ProcSortScratch *scratch)
+{
+    const uint32_t n = *count;
+    uint32_t first = 0;
+    while (first < n && !rows[first].groupMember) {
+        first++;
+    }
+    uint32_t end = first;
+    while (end < n && rows[end].groupMember) {
+        end++;
+    }
+    if (first == n || first == 0) {
+        ProcTable_SortRows(rows, n, strings, s->sortKey, s->sortAsc, limit, scratch);
+        return;
+    }
+
+    // Park the member block at the end, sort the headers, then rotate the members back
+    // in behind their header.
+    const uint32_t leaderPid = rows[first - 1u].pid;
+    const uint32_t members = end - first;
+    const uint32_t headers = n - members;
+    rotate_rows(rows + first, n - first, members);
+    ProcTable_SortRows(rows, headers, strings, s->sortKey, s->sortAsc, limit, scratch);
+    for (uint32_t i = 0; i < headers; i++) {
+        if (rows[i].pid == leaderPid) {
+            rotate_rows(rows + i + 1u, n - i - 1u, headers - i - 1u);
+            return;
+        }
+    }
+    *count = headers; // the header is gone: drop its members
+}
+
+// Group of the expanded name. baseName holds a prefix of longer keys, which the hashed
+// lookup cannot match; those are looked for among the copied names.
+static uint32_t find_expanded_group(const ProcView *v, const StrPool *strings)
+{
+    const ProcViewSettings *s = &v->settings;
+    if (!s->hasExpanded || !s->expandedBaseName[0]) return UINT32_MAX;
+    const uint32_t gi = ProcGroupBy_Find(&v->grouping, strings, s->expandedBaseName);
+    const size_t maxLen = sizeof(s->expandedBaseName) / sizeof(s->expandedBaseName[0]) - 1u;
+    if (gi != UINT32_MAX || wcslen(s->expandedBaseName) < maxLen) return gi;
+    for (uint32_t i = 0; i < v->groupCount; i++) {
+        if (wcmp_insensitive(s->expandedBaseName, v->groups[i].baseName) == 0) return i;
+    }
+    return UINT32_MAX;
+}
+
+void ProcView_Rebuild(ProcView *v, const ProcTable *pt)
+{
+    if (!v || !pt) return;
+    v->sortedCount = 0;
+    v->rowCount = 0;
+    v->groupCount = 0;
+    v->memberCount = 0;
+    if (!v->settings.stacked || !pt->rows || pt->rowCount == 0) return;
+
+    const StrPool *strings = &pt->strings;
+    const ProcRow *raw = pt->rows;
+    ProcGroupBy *gb = &v->grouping;
+    if (!ProcGroupBy_Run(gb, raw, pt->rowCount, strings, v->settings.groupBy) || gb->groupCount == 0) return;
+
+    const ProcGroupAgg *last = &gb->groups[gb->groupCount - 1u];
+    const uint32_t memberTotal = last->memberStart + last->memberCount;
+    if (!ensure_proc_groups(v, gb->groupCount) || !ensure_proc_group_members(v, memberTotal)) return;
+
+    const size_t nameCap = sizeof(v->groups[0].baseName) / sizeof(v->groups[0].baseName[0]);
+    for (uint32_t gi = 0; gi < gb->groupCount; gi++) {
+        const ProcGroupAgg *a = &gb->groups[gi];
+        ProcGroupIndex *g = &v->groups[gi];
+        wcsncpy(g->baseName, StrPool_Get(strings, a->keyId), nameCap - 1u);
+        g->baseName[nameCap - 1u] = 0;
+        g->leaderPid = raw[a->leader].pid;
+        g->memberStart = a->memberStart;
+        g->memberCount = a->memberCount;
+        for (uint32_t k = 0; k < a->memberCount; k++) {
+            v->members[a->memberStart + k] = raw[gb->members[a->memberStart + k]].pid;
+        }
+    }
+    v->groupCount = gb->groupCount;
+    v->memberCount = memberTotal;
+
+    // The expanded group lists its members (bar the leader, whose PID the header row
+    // carries) directly beneath its header.
+    const uint32_t expanded = find_expanded_group(v, strings);
+    const uint32_t extra = (expanded != UINT32_MAX) ? gb->groups[expanded].memberCount - 1u : 0;
+    if (!ensure_proc_view_rows(v, v->groupCount + extra)) {
+        v->groupCount = 0;
+        v->memberCount = 0;
+        return;
+    }
+
+    for (uint32_t gi = 0; gi < gb->groupCount; gi++) {
+        const ProcGroupAgg *a = &gb->groups[gi];
+        const ProcRow *leader = &raw[a->leader];
+        ProcRow *vr = &v->rows[v->rowCount++];
+        memset(vr, 0, sizeof(*vr));
+        vr->pid = leader->pid;
+        vr->createTime = leader->createTime;
+        vr->cpuPct = a->cpuSum;
+        if (vr->cpuPct < 0.0f) vr->cpuPct = 0.0f;
+        if (vr->cpuPct > 100.0f) vr->cpuPct = 100.0f;
+        vr->workingSetBytes = a->memSum;
+
+        // Network endpoints are per-process; aggregated view doesn't try to summarize.
+        vr->hasNet = false;
+        vr->netRemoteId = STR_POOL_EMPTY;
+
+        // Shown as "name (count)" by ProcView_RowName: the group's name, or its key when
+        // grouped by another column and the names differ.
+        vr->nameId = (v->settings.groupBy == PROC_GROUP_NAME || a->nameId == STR_POOL_EMPTY) ? a->keyId : a->nameId;
+        vr->groupSize = a->memberCount;
+        vr->ownerId = a->ownerId;
+        vr->pathId = a->pathId;
+
+        if (gi != expanded || a->memberCount < 2) continue;
+        ProcRow *first = &v->rows[v->rowCount];
+        for (uint32_t k = 0; k < a->memberCount; k++) {
+            const uint32_t ri = gb->members[a->memberStart + k];
+            if (ri == a->leader) continue;
+            ProcRow *mr = &v->rows[v->rowCount++];
+            *mr = raw[ri];
+            // Visual hint: member rows are indented (ProcView_RowName).
+            mr->groupMember = true;
+        }
+        const size_t n = (size_t)(&v->rows[v->rowCount] - first);
+        if (n > 1) {
+            qsort(first, n, sizeof(ProcRow), row_cmp_cpu_desc_local);
+        }
+    }
+
+    order_rows(v->rows, &v->rowCount, strings, &v->settings, v->settings.sortDepth, &v->sortScratch);
+    v->sortedCount = (v->settings.sortDepth != 0 && v->settings.sortDepth < v->rowCount) ? v->settings.sortDepth
+                                                                                         : v->rowCount;
+    ProcView_IndexRows(v);
+}
+
+void ProcViewSettings_Init(ProcViewSettings *s)
+{
+    if (!s) return;
+    memset(s, 0, sizeof(*s));
+    s->stacked = true;
+    s->sortKey = PROC_SORT_CPU;
+    s->sortAsc = false;
+}
+
+void ProcView_Init(ProcView *v)
+{
+    if (!v) return;
+    memset(v, 0, sizeof(*v));
+    ProcViewSettings_Init(&v->settings);
+}
+
+void ProcView_Shutdown(ProcView *v)
+{
+    if (!v) return;
+    free(v->rows);
+    free(v->groups);
+    free(v->members);
+    PidIndex_Shutdown(&v->rowIndex);
+    ProcGroupBy_Shutdown(&v->grouping);
+    ProcSortScratch_Free(&v->sortScratch);
+    memset(v, 0, sizeof(*v));
+}
+
+const ProcRow *ProcView_Rows(const ProcView *v, const ProcTable *pt, uint32_t *outCount)
+{
+    if (outCount) *outCount = 0;
+    if (!v || !pt) return NULL;
+
+    if (v->settings.stacked) {
+        if (outCount) *outCount = v->rowCount;
+        return v->rows;
+    }
+
+    if (outCount) *outCount = pt->rowCount;
+    return pt->rows;
+}
+
+uint32_t ProcView_SortedCount(const ProcView *v, const ProcTable *pt)
+{
+    if (!v || !pt) return 0;
+    return v->settings.stacked ? v->sortedCount : pt->sortedCount;
+}
+
+bool ProcView_CopyOrdered(const ProcView *v, const ProcTable *pt, ProcRow *out, uint32_t count)
+{
+    uint32_t n = 0;
+    const ProcRow *rows = ProcView_Rows(v, pt, &n);
+    if (!rows || !out || count < n) return false;
+    memcpy(out, rows, (size_t)n * sizeof(ProcRow));
+
+    const uint32_t sorted = ProcView_SortedCount(v, pt);
+    if (sorted >= n) return true;
+    if (!v->settings.stacked) {
+        // Every row past the ordered prefix sorts after it; only the tail needs sorting.
+        ProcTable_SortRows(out + sorted, n - sorted, &pt->strings, v->settings.sortKey, v->settings.sortAsc, 0,
+                           NULL);
+    } else {
+        order_rows(out, &n, &pt->strings, &v->settings, 0, NULL);
+    }
+    return true;
+}
+
+void ProcView_RowName(const ProcRow *r, const StrPool *strings, wchar_t *out, size_t outCount)
+{
+    if (!out || outCount == 0) return;
+    out[0] = 0;
+    if (!r) return;
+    const wchar_t *name = StrPool_Get(strings, r->nameId);
+    if (r->groupSize > 1) {
+        swprintf(out, outCount, L"%ls (%u)", name, (unsigned)r->groupSize);
+    } else if (r->groupMember) {
+        swprintf(out, outCount, L"  %ls", name);
+    } else {
+        wcsncpy(out, name, outCount - 1);
+        out[outCount - 1] = 0;
+    }
+}
+
+void ProcView_RowNet(const ProcRow *r, const StrPool *strings, wchar_t *out, size_t outCount)
+{
+    if (!out || outCount == 0) return;
+    out[0] = 0;
+    if (!r || !r->hasNet) return;
+    const wchar_t *remote = StrPool_Get(strings, r->netRemoteId);
+    if (r->netConns > 1) {
+        swprintf(out, outCount, L"%ls (%u)", remote, (unsigned)r->netConns);
+    } else {
+        wcsncpy(out, remote, outCount - 1);
+        out[outCount - 1] = 0;
+    }
+}
+
+void ProcView_IndexRows(ProcView *v)
+{
+    if (!v) return;
+    if (!PidIndex_Reset(&v->rowIndex, v->rowCount)) return;
+    for (uint32_t i = 0; i < v->rowCount; i++) {
+        if (!PidIndex_Insert(&v->rowIndex, v->rows[i].pid, v->rows[i].createTime, i)) return;
+    }
+}
+
+const ProcRow *ProcView_FindRow(const ProcView *v, const ProcTable *pt, uint32_t pid)
+{
+    if (!v || !pt || pid == 0) return NULL;
+    if (!v->settings.stacked) {
+        return ProcTable_FindRow(pt, pid);
+    }
+    if (v->rowIndex.slots && v->rowIndex.count == v->rowCount) {
+        const uint32_t i = PidIndex_FindPid(&v->rowIndex, pid);
+        return (i < v->rowCount) ? &v->rows[i] : NULL;
+    }
+    for (uint32_t i = 0; i < v->rowCount; i++) {
+        if (v->rows[i].pid == pid) return &v->rows[i];
+    }
+    return NULL;
+}
+
+void ProcViewSettings_ToggleExpanded(ProcViewSettings *s, const wchar_t *baseName)
+{
+    if (!s || !baseName) return;
+    if (s->hasExpanded && wcmp_insensitive(s->expandedBaseName, baseName) == 0) {
+        s->hasExpanded = false;
+        s->expandedBaseName[0] = 0;
+    } else {
+        s->hasExpanded = true;
+        wcsncpy(s->expandedBaseName, baseName,
+                (uint32_t)(sizeof(s->expandedBaseName) / sizeof(s->expandedBaseName[0])) - 1);
+        s->expandedBaseName[(uint32_t)(sizeof(s->expandedBaseName) / sizeof(s->expandedBaseName[0])) - 1] = 0;
+    }
+}
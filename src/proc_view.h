@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "proc_group.h"
+#include "proc_table.h"
+
+// Process table view: optional stacked (grouped by executable name, or another column)
+// presentation of a ProcTable, with a single expanded group shown as indented member rows.
+
+typedef struct ProcGroupIndex {
+    wchar_t baseName[64]; // group key (the name, unless grouped by another column)
+    uint32_t leaderPid;
+    uint32_t memberStart;
+    uint32_t memberCount;
+} ProcGroupIndex;
+
+// UI-driven view state. Owned by the UI and handed to whoever rebuilds the view.
+typedef struct ProcViewSettings {
+    bool stacked;
+    ProcGroupKey groupBy; // stacked view: column the rows are grouped by
+    ProcSortKey sortKey;
+    bool sortAsc;
+    // Rows that must come out in order: the visible window plus some scroll margin, so
+    // the rest only has to be partitioned behind them. 0 = all.
+    uint32_t sortDepth;
+
+    // Stacked view: one expanded group at a time (accordion).
+    bool hasExpanded;
+    wchar_t expandedBaseName[64];
+
+    // The UI's selected process (0 = none); kept at the full refresh rate like the rows on
+    // screen (ProcTable_KeepFast).
+    uint32_t selectedPid;
+} ProcViewSettings;
+
+typedef struct ProcView {
+    ProcViewSettings settings;
+
+    // Stacked view rows (group headers + expanded members)
+    ProcRow *rows;
+    uint32_t rowCount;
+    uint32_t rowCap;
+    uint32_t sortedCount; // rows [0, sortedCount) are in display order
+    PidIndex rowIndex;    // pid -> row in rows
+
+    ProcGroupIndex *groups;
+    uint32_t groupCount;
+    uint32_t groupCap;
+    uint32_t *members;
+    uint32_t memberCount;
+    uint32_t memberCap;
+
+    // Rebuild scratch: grouping (indexing the table rows) and sorting.
+    ProcGroupBy grouping;
+    ProcSortScratch sortScratch;
+} ProcView;
+
+void ProcView_Init(ProcView *v);
+void ProcView_Shutdown(ProcView *v);
+
+// Rebuilds the stacked view from pt (no-op besides clearing when not stacked).
+void ProcView_Rebuild(ProcView *v, const ProcTable *pt);
+
+// Rows to display: the stacked view rows, or pt->rows when not stacked.
+const ProcRow *ProcView_Rows(const ProcView *v, const ProcTable *pt, uint32_t *outCount);
+
+// How many leading rows of ProcView_Rows are in display order (settings.sortDepth).
+uint32_t ProcView_SortedCount(const ProcView *v, const ProcTable *pt);
+
+// Copies the displayed rows into out (room for count rows) in full display order, finishing
+// the sort a limited sortDepth left partial. For copying or exporting every row.
+bool ProcView_CopyOrdered(const ProcView *v, const ProcTable *pt, ProcRow *out, uint32_t count);
+
+// The displayed row for pid (group header or member in stacked mode), or NULL. Hashed,
+// like ProcTable_FindRow; ProcView_Rebuild indexes the rows, copies re-index them.
+const ProcRow *ProcView_FindRow(const ProcView *v, const ProcTable *pt, uint32_t pid);
+void ProcView_IndexRows(ProcView *v);
+
+// Name column text: "name (count)" for a group header, indented for an expanded member.
+void ProcView_RowName(const ProcRow *r, const StrPool *strings, wchar_t *out, size_t outCount);
+
+// Net column text: the remote endpoint, with the connection count when there are more.
+void ProcView_RowNet(const ProcRow *r, const StrPool *strings, wchar_t *out, size_t outCount);
+
+const ProcGroupIndex *ProcView_FindGroupByLeader(const ProcView *v, uint32_t leaderPid);
+
+// Defaults: stacked, CPU descending, nothing expanded.
+void ProcViewSettings_Init(ProcViewSettings *s);
+
+// Accordion toggle: expands baseName, or collapses it if already expanded.
+void ProcViewSettings_ToggleExpanded(ProcViewSettings *s, const wchar_t *baseName);
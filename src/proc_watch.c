@@ -0,0 +1,314 @@
+#include "proc_watch.h"
+
+#include <string.h>
+
+#include "qpc.h"
+
+static void free_series(ProcWatch *w, ProcWatchSeries *s, ProcWatchSlot *slot)
+{
+    if (slot->source) {
+        w->ops->close(slot->source);
+    }
+    WindowStats_Shutdown(&slot->workingSetStats);
+    WindowStats_Shutdown(&slot->ioStats);
+    WindowStats_Shutdown(&slot->ctxStats);
+    memset(slot, 0, sizeof(*slot));
+    RingBuf_Shutdown(&s->cpuPct);
+    RingBuf_Shutdown(&s->workingSetMB);
+    RingBuf_Shutdown(&s->ioMBps);
+    RingBuf_Shutdown(&s->ctxPerSec);
+    memset(s, 0, sizeof(*s));
+}
+
+static void open_series(ProcWatch *w, uint32_t pid, ProcWatchSeries *s, ProcWatchSlot *slot)
+{
+    memset(s, 0, sizeof(*s));
+    memset(slot, 0, sizeof(*slot));
+    s->pid = pid;
+    const bool rings = RingBuf_Init(&s->cpuPct, w->histCap) && RingBuf_Init(&s->workingSetMB, w->histCap) &&
+                       RingBuf_Init(&s->ioMBps, w->histCap) && RingBuf_Init(&s->ctxPerSec, w->histCap) &&
+                       WindowStats_Init(&slot->workingSetStats, w->histCap) &&
+                       WindowStats_Init(&slot->ioStats, w->histCap) && WindowStats_Init(&slot->ctxStats, w->histCap);
+    slot->source = rings ? w->ops->open(pid, &s->createTime) : NULL;
+    s->failed = (slot->source == NULL);
+}
+
+// Brings the series in line with the requested pins. Sources are opened and closed here,
+// on the watch thread, so a slow open never stalls the UI; pids that stay keep their
+// series and source.
+static void apply_pins(ProcWatch *w)
+{
+    uint32_t want[PROC_WATCH_MAX];
+    uint32_t wantCount;
+    SysMutex_Lock(&w->lock);
+    const bool changed = (w->appliedSeq != w->wantSeq);
+    wantCount = w->wantCount;
+    memcpy(want, w->wantPids, sizeof(want));
+    w->appliedSeq = w->wantSeq;
+    SysMutex_Unlock(&w->lock);
+    if (!changed) return;
+
+    ProcWatchSeries next[PROC_WATCH_MAX];
+    ProcWatchSlot nextSlots[PROC_WATCH_MAX];
+    bool kept[PROC_WATCH_MAX] = {false};
+    for (uint32_t i = 0; i < wantCount; i++) {
+        uint32_t j = 0;
+        while (j < w->count && (kept[j] || w->series[j].pid != want[i])) j++;
+        if (j < w->count) {
+            next[i] = w->series[j];
+            nextSlots[i] = w->slots[j];
+            kept[j] = true;
+        } else {
+            open_series(w, want[i], &next[i], &nextSlots[i]);
+        }
+    }
+
+    ProcWatchSeries old[PROC_WATCH_MAX];
+    const uint32_t oldCount = w->count;
+    memcpy(old, w->series, sizeof(old));
+    SysMutex_Lock(&w->lock);
+    memcpy(w->series, next, sizeof(next[0]) * wantCount);
+    w->count = wantCount;
+    SysMutex_Unlock(&w->lock);
+
+    // Readers only see the series under the lock, so the dropped ones can go now.
+    for (uint32_t j = 0; j < oldCount; j++) {
+        if (!kept[j]) free_series(w, &old[j], &w->slots[j]);
+    }
+    memcpy(w->slots, nextSlots, sizeof(nextSlots[0]) * wantCount);
+    memset(&w->slots[wantCount], 0, sizeof(w->slots[0]) * (PROC_WATCH_MAX - wantCount));
+    memset(&w->series[wantCount], 0, sizeof(w->series[0]) * (PROC_WATCH_MAX - wantCount));
+}
+
+static float delta_per_sec(uint64_t cur, uint64_t prev, double dt)
+{
+    return (cur > prev) ? (float)((double)(cur - prev) / dt) : 0.0f;
+}
+
+// One tick: every source is read outside the lock, then all series are pushed at once.
+static void sample_all(ProcWatch *w, double freq)
+{
+    ProcWatchReading now[PROC_WATCH_MAX];
+    int64_t at[PROC_WATCH_MAX];
+    bool read[PROC_WATCH_MAX] = {false};
+    bool gone[PROC_WATCH_MAX] = {false};
+    for (uint32_t i = 0; i < w->count; i++) {
+        ProcWatchSlot *slot = &w->slots[i];
+        if (!slot->source) continue;
+        memset(&now[i], 0, sizeof(now[i]));
+        read[i] = w->ops->read(slot->source, &now[i]);
+        at[i] = Qpc_Now();
+        if (!read[i]) {
+            w->ops->close(slot->source);
+            slot->source = NULL;
+            gone[i] = true;
+        }
+    }
+
+    SysMutex_Lock(&w->lock);
+    for (uint32_t i = 0; i < w->count; i++) {
+        ProcWatchSeries *s = &w->series[i];
+        ProcWatchSlot *slot = &w->slots[i];
+        if (gone[i]) s->exited = true;
+        if (!read[i]) continue;
+
+        const ProcWatchReading *r = &now[i];
+        s->hasIo = r->hasIo;
+        s->hasCtx = r->hasCtx;
+        const float wsMB = (float)((double)r->workingSetBytes / (1024.0 * 1024.0));
+        RingBuf_PushAt(&s->workingSetMB, wsMB, at[i]);
+        WindowStats_Push(&slot->workingSetStats, wsMB);
+        s->workingSetPeakMB = WindowStats_Max(&slot->workingSetStats);
+        if (slot->hasLast) {
+            const double dt = Qpc_Seconds(at[i] - slot->lastQpc, freq);
+            if (dt > 0.0) {
+                const float cpu = delta_per_sec(r->cpuTime100ns, slot->last.cpuTime100ns, dt) /
+                                  1e7f * 100.0f / (float)w->cpuCount;
+                const float io = delta_per_sec(r->ioBytes, slot->last.ioBytes, dt) / (1024.0f * 1024.0f);
+                const float ctx = delta_per_sec(r->ctxSwitches, slot->last.ctxSwitches, dt);
+                RingBuf_PushAt(&s->cpuPct, (cpu > 100.0f) ? 100.0f : cpu, at[i]);
+                RingBuf_PushAt(&s->ioMBps, io, at[i]);
+                RingBuf_PushAt(&s->ctxPerSec, ctx, at[i]);
+                WindowStats_Push(&slot->ioStats, io);
+                WindowStats_Push(&slot->ctxStats, ctx);
+                s->ioPeakMBps = WindowStats_Max(&slot->ioStats);
+                s->ctxPeakPerSec = WindowStats_Max(&slot->ctxStats);
+            }
+        }
+        slot->last = *r;
+        slot->lastQpc = at[i];
+        slot->hasLast = true;
+    }
+    SysMutex_Unlock(&w->lock);
+}
+
+static uint32_t watch_main(void *arg)
+{
+    ProcWatch *w = (ProcWatch *)arg;
+    const double freq = Qpc_Freq();
+    const int64_t period = (int64_t)(freq / w->hz);
+    int64_t due = Qpc_Now();
+    bool fast = false;
+
+    while (!Atomic_LoadU32(&w->stop)) {
+        apply_pins(w);
+
+        uint32_t live = 0;
+        for (uint32_t i = 0; i < w->count; i++) {
+            if (w->slots[i].source) live++;
+        }
+        if ((live > 0) != fast && w->ops->fastTimer) {
+            fast = (live > 0);
+            w->ops->fastTimer(fast);
+        }
+        if (live == 0) {
+            (void)SysEvent_Wait(&w->wake, 0xFFFFFFFFu); // idle until a pin or stop
+            due = Qpc_Now();
+            continue;
+        }
+
+        // Deadline-paced: a late tick does not shift the ones after it, and ticks missed
+        // altogether are skipped rather than run back to back.
+        const int64_t now = Qpc_Now();
+        if (now >= due) {
+            sample_all(w, freq);
+            due += period;
+            if (due <= now) due = now + period;
+        }
+        const double remain = Qpc_Seconds(due - Qpc_Now(), freq);
+        if (remain > 0.0) {
+            (void)SysEvent_Wait(&w->wake, (uint32_t)(remain * 1000.0 + 0.999));
+        }
+    }
+
+    if (fast) w->ops->fastTimer(false);
+    return 0;
+}
+
+bool ProcWatch_Start(ProcWatch *w, const ProcWatchOps *ops, double hz, uint32_t histCap)
+{
+    memset(w, 0, sizeof(*w));
+    if (!ops || !ops->open || !ops->read || !ops->close) return false;
+    w->ops = ops;
+    w->hz = (hz < PROC_WATCH_MIN_HZ) ? PROC_WATCH_MIN_HZ : (hz > PROC_WATCH_MAX_HZ) ? PROC_WATCH_MAX_HZ : hz;
+    w->histCap = (histCap > 1u) ? histCap : PROC_WATCH_HISTORY;
+    w->cpuCount = SysThread_CpuCount();
+
+    if (!SysMutex_Init(&w->lock)) return false;
+    if (!SysEvent_Init(&w->wake)) {
+        SysMutex_Shutdown(&w->lock);
+        return false;
+    }
+    if (!SysThread_Start(&w->thread, watch_main, w)) {
+        SysEvent_Shutdown(&w->wake);
+        SysMutex_Shutdown(&w->lock);
+        return false;
+    }
+    w->started = true;
+    return true;
+}
+
+void ProcWatch_Stop(ProcWatch *w)
+{
+    if (!w->started) return;
+    Atomic_StoreU32(&w->stop, 1u);
+    SysEvent_Signal(&w->wake);
+    SysThread_Join(&w->thread);
+
+    for (uint32_t i = 0; i < w->count; i++) {
+        free_series(w, &w->series[i], &w->slots[i]);
+    }
+    w->count = 0;
+    SysEvent_Shutdown(&w->wake);
+    SysMutex_Shutdown(&w->lock);
+    w->started = false;
+}
+
+void ProcWatch_SetPids(ProcWatch *w, const uint32_t *pids, uint32_t count)
+{
+    if (!w->started) return;
+    SysMutex_Lock(&w->lock);
+    w->wantCount = 0;
+    for (uint32_t i = 0; i < count && w->wantCount < PROC_WATCH_MAX; i++) {
+        bool dup = (pids[i] == 0);
+        for (uint32_t j = 0; j < w->wantCount && !dup; j++) dup = (w->wantPids[j] == pids[i]);
+        if (!dup) w->wantPids[w->wantCount++] = pids[i];
+    }
+    w->wantSeq++;
+    SysMutex_Unlock(&w->lock);
+    SysEvent_Signal(&w->wake);
+}
+
+bool ProcWatch_Toggle(ProcWatch *w, uint32_t pid)
+{
+    if (!w->started || pid == 0) return false;
+    SysMutex_Lock(&w->lock);
+    uint32_t i = 0;
+    while (i < w->wantCount && w->wantPids[i] != pid) i++;
+    bool watched;
+    if (i < w->wantCount) {
+        memmove(&w->wantPids[i], &w->wantPids[i + 1], sizeof(w->wantPids[0]) * (w->wantCount - i - 1u));
+        w->wantCount--;
+        watched = false;
+    } else if (w->wantCount < PROC_WATCH_MAX) {
+        w->wantPids[w->wantCount++] = pid;
+        watched = true;
+    } else {
+        SysMutex_Unlock(&w->lock);
+        return false;
+    }
+    w->wantSeq++;
+    SysMutex_Unlock(&w->lock);
+    SysEvent_Signal(&w->wake);
+    return watched;
+}
+
+bool ProcWatch_Contains(ProcWatch *w, uint32_t pid)
+{
+    if (!w->started || pid == 0) return false;
+    SysMutex_Lock(&w->lock);
+    bool found = false;
+    for (uint32_t i = 0; i < w->wantCount && !found; i++) found = (w->wantPids[i] == pid);
+    SysMutex_Unlock(&w->lock);
+    return found;
+}
+
+uint32_t ProcWatch_Copy(ProcWatch *w, ProcWatchView *out)
+{
+    out->count = 0;
+    if (!w->started) return 0;
+    SysMutex_Lock(&w->lock);
+    out->hz = w->hz;
+    for (uint32_t i = 0; i < w->count; i++) {
+        const ProcWatchSeries *s = &w->series[i];
+        ProcWatchSeries *d = &out->series[i];
+        if (!RingBuf_CopyFrom(&d->cpuPct, &s->cpuPct) || !RingBuf_CopyFrom(&d->workingSetMB, &s->workingSetMB) ||
+            !RingBuf_CopyFrom(&d->ioMBps, &s->ioMBps) || !RingBuf_CopyFrom(&d->ctxPerSec, &s->ctxPerSec)) {
+            break;
+        }
+        d->pid = s->pid;
+        d->createTime = s->createTime;
+        d->failed = s->failed;
+        d->exited = s->exited;
+        d->hasIo = s->hasIo;
+        d->hasCtx = s->hasCtx;
+        d->workingSetPeakMB = s->workingSetPeakMB;
+        d->ioPeakMBps = s->ioPeakMBps;
+        d->ctxPeakPerSec = s->ctxPeakPerSec;
+        out->count = i + 1u;
+    }
+    SysMutex_Unlock(&w->lock);
+    return out->count;
+}
+
+void ProcWatchView_Free(ProcWatchView *v)
+{
+    for (uint32_t i = 0; i < PROC_WATCH_MAX; i++) {
+        ProcWatchSeries *s = &v->series[i];
+        RingBuf_Shutdown(&s->cpuPct);
+        RingBuf_Shutdown(&s->workingSetMB);
+        RingBuf_Shutdown(&s->ioMBps);
+        RingBuf_Shutdown(&s->ctxPerSec);
+    }
+    memset(v, 0, sizeof(*v));
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ringbuf.h"
+#include "sys_thread.h"
+#include "window_stats.h"
+
+// High-frequency watch list: a few pinned processes sampled at 20-100 Hz on a thread of
+// their own, apart from the process walk. Each watched process keeps its own source (a
+// process handle, open /proc files) and ring buffers of CPU%, working set, I/O rate and
+// context switch rate; the UI copies them out with ProcWatch_Copy. Nothing here touches
+// the process table, so pinning a process costs the table walk nothing.
+//
+// The reading itself is per platform (ProcWatchOps, from ProcWatch_PlatformOps), which
+// keeps this file free of OS calls like the rest of the engine.
+
+#define PROC_WATCH_MAX 4u
+#ifndef PROC_WATCH_DEFAULT_HZ
+#define PROC_WATCH_DEFAULT_HZ 50.0
+#endif
+#define PROC_WATCH_MIN_HZ 1.0
+#define PROC_WATCH_MAX_HZ 200.0
+// Samples kept per series (about 20 s at the default rate).
+#ifndef PROC_WATCH_HISTORY
+#define PROC_WATCH_HISTORY 1024u
+#endif
+
+// Cumulative counters of one process at one instant.
+typedef struct ProcWatchReading {
+    uint64_t cpuTime100ns; // user + kernel
+    uint64_t workingSetBytes;
+    uint64_t ioBytes;      // read + write transfers
+    uint64_t ctxSwitches;  // voluntary + involuntary, all threads
+    bool hasIo;
+    bool hasCtx;
+} ProcWatchReading;
+
+typedef struct ProcWatchOps {
+    // Opens pid for reading; NULL when it cannot be opened. outCreateTime gets the start
+    // time as the process table keys it.
+    void *(*open)(uint32_t pid, uint64_t *outCreateTime);
+    // False once the process has exited (or can no longer be read).
+    bool (*read)(void *source, ProcWatchReading *out);
+    void (*close)(void *source);
+    // Optional: asks for a fine scheduler tick while something is watched.
+    void (*fastTimer)(bool on);
+} ProcWatchOps;
+
+// Implemented per platform (proc_watch_win.c, linux/proc_watch_linux.c).
+const ProcWatchOps *ProcWatch_PlatformOps(void);
+
+typedef struct ProcWatchSeries {
+    uint32_t pid;
+    uint64_t createTime;
+    bool failed; // could not be opened
+    bool exited; // stopped being readable; the series end there
+    bool hasIo;
+    bool hasCtx;
+    RingBufF cpuPct;       // of all CPUs, like the process table
+    RingBufF workingSetMB;
+    RingBufF ioMBps;
+    RingBufF ctxPerSec;
+    // Peaks over the same samples, kept as they are pushed so drawing never scans the rings.
+    float workingSetPeakMB;
+    float ioPeakMBps;
+    float ctxPeakPerSec;
+} ProcWatchSeries;
+
+// A reader's copy of the watch list (ProcWatch_Copy).
+typedef struct ProcWatchView {
+    ProcWatchSeries series[PROC_WATCH_MAX];
+    uint32_t count;
+    double hz;
+} ProcWatchView;
+
+typedef struct ProcWatchSlot {
+    void *source;
+    ProcWatchReading last;
+    int64_t lastQpc;
+    bool hasLast;
+    WindowStats workingSetStats; // behind the series' peaks
+    WindowStats ioStats;
+    WindowStats ctxStats;
+} ProcWatchSlot;
+
+typedef struct ProcWatch {
+    const ProcWatchOps *ops;
+    double hz;
+    uint32_t histCap;
+    uint32_t cpuCount;
+
+    // The pins the UI asked for (ProcWatch_SetPids), applied by the watch thread.
+    uint32_t wantPids[PROC_WATCH_MAX];
+    uint32_t wantCount;
+    uint32_t wantSeq;
+
+    // The series, in pin order. The watch thread pushes under lock; readers copy under it.
+    ProcWatchSeries series[PROC_WATCH_MAX];
+    uint32_t count;
+
+    ProcWatchSlot slots[PROC_WATCH_MAX]; // watch thread only
+    uint32_t appliedSeq;
+
+    SysMutex lock;
+    SysThread thread;
+    SysEvent wake;
+    volatile uint32_t stop;
+    bool started;
+} ProcWatch;
+
+// Starts the watch thread (idle until something is pinned). hz is clamped to
+// [PROC_WATCH_MIN_HZ, PROC_WATCH_MAX_HZ]; histCap = samples per series.
+bool ProcWatch_Start(ProcWatch *w, const ProcWatchOps *ops, double hz, uint32_t histCap);
+void ProcWatch_Stop(ProcWatch *w);
+
+// Replaces the watch list (at most PROC_WATCH_MAX pids, zeros skipped). Series of pids
+// that stay keep their history.
+void ProcWatch_SetPids(ProcWatch *w, const uint32_t *pids, uint32_t count);
+// Adds pid, or removes it when already watched. Returns whether it is watched afterwards
+// (false also when the list is full).
+bool ProcWatch_Toggle(ProcWatch *w, uint32_t pid);
+bool ProcWatch_Contains(ProcWatch *w, uint32_t pid);
+
+// Copies the series into out, only the samples pushed since the previous copy when out
+// already mirrors them. Returns out->count.
+uint32_t ProcWatch_Copy(ProcWatch *w, ProcWatchView *out);
+void ProcWatchView_Free(ProcWatchView *v);
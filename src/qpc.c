@@ -0,0 +1,76 @@
+#include "qpc.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+int64_t Qpc_Now(void)
+{
+    LARGE_INTEGER li;
+    QueryPerformanceCounter(&li);
+    return (int64_t)li.QuadPart;
+}
+
+double Qpc_Freq(void)
+{
+    LARGE_INTEGER li;
+    QueryPerformanceFrequency(&li);
+    return (double)li.QuadPart;
+}
+
+bool Qpc_BootId(uint8_t id[16])
+{
+    memset(id, 0, 16);
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    ULARGE_INTEGER now;
+    now.LowPart = ft.dwLowDateTime;
+    now.HighPart = ft.dwHighDateTime;
+    const uint64_t sinceBoot = (uint64_t)GetTickCount64() * 10000u; // 100 ns units
+    const uint64_t bootMinute = ((uint64_t)now.QuadPart - sinceBoot) / 600000000u;
+    memcpy(id, &bootMinute, sizeof(bootMinute));
+    return true;
+}
+
+#else
+#include <stdio.h>
+#include <time.h>
+
+int64_t Qpc_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+}
+
+double Qpc_Freq(void)
+{
+    return 1e9;
+}
+
+bool Qpc_BootId(uint8_t id[16])
+{
+    memset(id, 0, 16);
+    FILE *f = fopen("/proc/sys/kernel/random/boot_id", "r");
+    if (!f) return false;
+    char text[64];
+    const bool read = fgets(text, sizeof(text), f) != NULL;
+    fclose(f);
+    if (!read) return false;
+
+    // A UUID: 32 hex digits, dashes in between.
+    uint32_t digits = 0;
+    for (const char *p = text; *p && digits < 32u; p++) {
+        uint8_t d;
+        if (*p >= '0' && *p <= '9') d = (uint8_t)(*p - '0');
+        else if (*p >= 'a' && *p <= 'f') d = (uint8_t)(*p - 'a' + 10);
+        else if (*p >= 'A' && *p <= 'F') d = (uint8_t)(*p - 'A' + 10);
+        else continue;
+        id[digits / 2u] = (uint8_t)((id[digits / 2u] << 4) | d);
+        digits++;
+    }
+    return digits == 32u;
+}
+
+#endif
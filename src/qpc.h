@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Monotonic high-resolution clock.
+// Windows: QueryPerformanceCounter ticks. Elsewhere: CLOCK_MONOTONIC nanoseconds.
+int64_t Qpc_Now(void);
+
+// Ticks per second for Qpc_Now().
+double Qpc_Freq(void);
+
+// Identifies the boot the clock counts from (it restarts at boot), so that timestamps
+// saved earlier can be told apart from ones of a previous boot. Linux: the kernel's
+// boot_id. Windows: the boot's wall-clock time to the minute (the wall clock and the
+// tick count drift apart by far less). False, with id zeroed, when unavailable.
+bool Qpc_BootId(uint8_t id[16]);
+
+static inline double Qpc_Seconds(int64_t delta, double freq)
+{
+    return (double)delta / freq;
+}
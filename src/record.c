@@ -0,0 +1,1102 @@
+#include "record.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "self_stats.h"
+
+#define RECORD_TYPE_SHAPE 1u
+#define RECORD_TYPE_TICK 2u
+
+#define RECORD_MAX_PAYLOAD (64u * 1024u * 1024u) // sanity bound when reading
+
+static const char kMagic[8] = {'C', 'C', 'M', 'R', 'E', 'C', 0, 0};
+
+// ---------------------------------------------------------------------------
+// Byte buffer
+
+static bool buf_reserve(RecordBuf *b, uint32_t extra)
+{
+    if (b->bad) return false;
+    if (extra > UINT32_MAX - b->len) {
+        b->bad = true;
+        return false;
+    }
+    const uint32_t want = b->len + extra;
+    if (want <= b->cap) return true;
+    uint32_t newCap = b->cap ? b->cap : 4096u;
+    while (newCap < want) {
+        if (newCap > (UINT32_MAX / 2u)) {
+            newCap = want;
+            break;
+        }
+        newCap *= 2u;
+    }
+    void *p = realloc(b->data, newCap);
+    if (!p) {
+        b->bad = true;
+        return false;
+    }
+    SelfStats_NoteAlloc();
+    b->data = (uint8_t *)p;
+    b->cap = newCap;
+    return true;
+}
+
+static void buf_free(RecordBuf *b)
+{
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+static void put_bytes(RecordBuf *b, const void *p, uint32_t n)
+{
+    if (!buf_reserve(b, n)) return;
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void put_u8(RecordBuf *b, uint8_t v)
+{
+    put_bytes(b, &v, 1);
+}
+
+static void put_varint(RecordBuf *b, uint64_t v)
+{
+    uint8_t tmp[10];
+    uint32_t n = 0;
+    do {
+        uint8_t byte = (uint8_t)(v & 0x7Fu);
+        v >>= 7;
+        if (v) byte |= 0x80u;
+        tmp[n++] = byte;
+    } while (v);
+    put_bytes(b, tmp, n);
+}
+
+static void put_u32le(RecordBuf *b, uint32_t v)
+{
+    const uint8_t tmp[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    put_bytes(b, tmp, 4);
+}
+
+static void put_f32(RecordBuf *b, float v)
+{
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    put_u32le(b, u);
+}
+
+static void put_f64(RecordBuf *b, double v)
+{
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    put_u32le(b, (uint32_t)u);
+    put_u32le(b, (uint32_t)(u >> 32));
+}
+
+static const uint8_t *get_bytes(RecordBuf *b, uint32_t n)
+{
+    if (b->bad || n > b->len - b->pos) {
+        b->bad = true;
+        return NULL;
+    }
+    const uint8_t *p = b->data + b->pos;
+    b->pos += n;
+    return p;
+}
+
+static uint8_t get_u8(RecordBuf *b)
+{
+    const uint8_t *p = get_bytes(b, 1);
+    return p ? p[0] : 0;
+}
+
+static uint64_t get_varint(RecordBuf *b)
+{
+    uint64_t v = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        const uint8_t byte = get_u8(b);
+        if (b->bad) return 0;
+        v |= (uint64_t)(byte & 0x7Fu) << shift;
+        if (!(byte & 0x80u)) return v;
+    }
+    b->bad = true;
+    return 0;
+}
+
+static uint32_t get_u32le(RecordBuf *b)
+{
+    const uint8_t *p = get_bytes(b, 4);
+    if (!p) return 0;
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float get_f32(RecordBuf *b)
+{
+    const uint32_t u = get_u32le(b);
+    float v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+
+static double get_f64(RecordBuf *b)
+{
+    const uint64_t lo = get_u32le(b);
+    const uint64_t hi = get_u32le(b);
+    const uint64_t u = lo | (hi << 32);
+    double v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// UTF-8 <-> wchar_t (UTF-16 on Windows, UTF-32 elsewhere)
+
+static uint32_t utf8_from_wide(const wchar_t *s, char *out, uint32_t cap)
+{
+    uint32_t n = 0;
+    for (; s && *s; s++) {
+        uint32_t cp = (uint32_t)*s;
+#if WCHAR_MAX <= 0xFFFF
+        if (cp >= 0xD800u && cp <= 0xDBFFu && s[1] >= 0xDC00 && s[1] <= 0xDFFF) {
+            cp = 0x10000u + ((cp - 0xD800u) << 10) + ((uint32_t)s[1] - 0xDC00u);
+            s++;
+        }
+#endif
+        uint8_t enc[4];
+        uint32_t len;
+        if (cp < 0x80u) {
+            enc[0] = (uint8_t)cp;
+            len = 1;
+        } else if (cp < 0x800u) {
+            enc[0] = (uint8_t)(0xC0u | (cp >> 6));
+            enc[1] = (uint8_t)(0x80u | (cp & 0x3Fu));
+            len = 2;
+        } else if (cp < 0x10000u) {
+            enc[0] = (uint8_t)(0xE0u | (cp >> 12));
+            enc[1] = (uint8_t)(0x80u | ((cp >> 6) & 0x3Fu));
+            enc[2] = (uint8_t)(0x80u | (cp & 0x3Fu));
+            len = 3;
+        } else {
+            enc[0] = (uint8_t)(0xF0u | (cp >> 18));
+            enc[1] = (uint8_t)(0x80u | ((cp >> 12) & 0x3Fu));
+            enc[2] = (uint8_t)(0x80u | ((cp >> 6) & 0x3Fu));
+            enc[3] = (uint8_t)(0x80u | (cp & 0x3Fu));
+            len = 4;
+        }
+        if (n + len > cap) break; // truncate on a code point boundary
+        memcpy(out + n, enc, len);
+        n += len;
+    }
+    return n;
+}
+
+static void wide_from_utf8(const char *s, uint32_t len, wchar_t *out, uint32_t outCount)
+{
+    if (!out || outCount == 0) return;
+    uint32_t n = 0;
+    uint32_t i = 0;
+    while (i < len) {
+        const uint8_t c = (uint8_t)s[i];
+        uint32_t cp;
+        uint32_t extra;
+        if (c < 0x80u) {
+            cp = c;
+            extra = 0;
+        } else if ((c & 0xE0u) == 0xC0u) {
+            cp = c & 0x1Fu;
+            extra = 1;
+        } else if ((c & 0xF0u) == 0xE0u) {
+            cp = c & 0x0Fu;
+            extra = 2;
+        } else {
+            cp = c & 0x07u;
+            extra = 3;
+        }
+        i++;
+        for (uint32_t k = 0; k < extra && i < len; k++, i++) {
+            cp = (cp << 6) | ((uint8_t)s[i] & 0x3Fu);
+        }
+
+#if WCHAR_MAX <= 0xFFFF
+        if (cp >= 0x10000u) {
+            if (n + 2 >= outCount) break;
+            cp -= 0x10000u;
+            out[n++] = (wchar_t)(0xD800u + (cp >> 10));
+            out[n++] = (wchar_t)(0xDC00u + (cp & 0x3FFu));
+            continue;
+        }
+#endif
+        if (n + 1 >= outCount) break;
+        out[n++] = (wchar_t)cp;
+    }
+    out[n] = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Interned strings
+
+static uint32_t hash_bytes(const char *p, uint32_t n)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < n; i++) {
+        h ^= (uint8_t)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void strings_free(RecordStrings *t)
+{
+    free(t->arena);
+    free(t->offset);
+    free(t->length);
+    free(t->slots);
+    memset(t, 0, sizeof(*t));
+}
+
+static bool strings_rehash(RecordStrings *t, uint32_t slotCap)
+{
+    uint32_t *slots = (uint32_t *)calloc(slotCap, sizeof(uint32_t));
+    if (!slots) return false;
+    SelfStats_NoteAlloc();
+    for (uint32_t i = 0; i < t->count; i++) {
+        uint32_t s = hash_bytes(t->arena + t->offset[i], t->length[i]) & (slotCap - 1u);
+        while (slots[s]) s = (s + 1u) & (slotCap - 1u);
+        slots[s] = i + 1u;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->slotCap = slotCap;
+    return true;
+}
+
+// Appends a string to the table; returns false when full or out of memory.
+static bool strings_add(RecordStrings *t, const char *p, uint32_t n, bool hashed)
+{
+    if (t->count >= RECORD_STRING_TABLE_MAX) return false;
+
+    if (t->count == t->cap) {
+        const uint32_t newCap = t->cap ? t->cap * 2u : 256u;
+        uint32_t *off = (uint32_t *)realloc(t->offset, (size_t)newCap * sizeof(uint32_t));
+        if (!off) return false;
+        t->offset = off;
+        uint32_t *len = (uint32_t *)realloc(t->length, (size_t)newCap * sizeof(uint32_t));
+        if (!len) return false;
+        t->length = len;
+        t->cap = newCap;
+        SelfStats_NoteAlloc();
+    }
+    if (n > t->arenaCap - t->arenaLen) {
+        uint32_t newCap = t->arenaCap ? t->arenaCap : 16384u;
+        while (newCap - t->arenaLen < n) newCap *= 2u;
+        char *a = (char *)realloc(t->arena, newCap);
+        if (!a) return false;
+        SelfStats_NoteAlloc();
+        t->arena = a;
+        t->arenaCap = newCap;
+    }
+    if (hashed && (t->count + 1u) * 2u > t->slotCap) {
+        if (!strings_rehash(t, t->slotCap ? t->slotCap * 2u : 1024u)) return false;
+    }
+
+    if (n) memcpy(t->arena + t->arenaLen, p, n);
+    t->offset[t->count] = t->arenaLen;
+    t->length[t->count] = n;
+    t->arenaLen += n;
+
+    if (hashed) {
+        uint32_t s = hash_bytes(p, n) & (t->slotCap - 1u);
+        while (t->slots[s]) s = (s + 1u) & (t->slotCap - 1u);
+        t->slots[s] = t->count + 1u;
+    }
+    t->count++;
+    return true;
+}
+
+// Writer: varint (index + 1) for a known string, else 0 + varint length + bytes.
+static void put_str(RecordBuf *b, RecordStrings *t, const wchar_t *s)
+{
+    char utf8[MAX_PATH * 4];
+    const uint32_t n = utf8_from_wide(s, utf8, (uint32_t)sizeof(utf8));
+
+    if (t->slotCap) {
+        uint32_t slot = hash_bytes(utf8, n) & (t->slotCap - 1u);
+        while (t->slots[slot]) {
+            const uint32_t i = t->slots[slot] - 1u;
+            if (t->length[i] == n && memcmp(t->arena + t->offset[i], utf8, n) == 0) {
+                put_varint(b, (uint64_t)i + 1u);
+                return;
+            }
+            slot = (slot + 1u) & (t->slotCap - 1u);
+        }
+    }
+
+    put_varint(b, 0);
+    put_varint(b, n);
+    put_bytes(b, utf8, n);
+    // Reader and writer must intern the same strings in the same order.
+    if (!strings_add(t, utf8, n, true) && t->count < RECORD_STRING_TABLE_MAX) {
+        b->bad = true;
+    }
+}
+
+static void get_str(RecordBuf *b, RecordStrings *t, wchar_t *out, uint32_t outCount)
+{
+    const uint64_t tag = get_varint(b);
+    if (tag == 0) {
+        const uint64_t n = get_varint(b);
+        const uint8_t *p = (n <= UINT32_MAX) ? get_bytes(b, (uint32_t)n) : NULL;
+        if (!p) {
+            b->bad = true;
+            if (out && outCount) out[0] = 0;
+            return;
+        }
+        // Mirrors the writer: interned until the table is full.
+        if (!strings_add(t, (const char *)p, (uint32_t)n, false) && t->count < RECORD_STRING_TABLE_MAX) {
+            b->bad = true;
+        }
+        wide_from_utf8((const char *)p, (uint32_t)n, out, outCount);
+        return;
+    }
+
+    const uint64_t i = tag - 1u;
+    if (i >= t->count) {
+        b->bad = true;
+        if (out && outCount) out[0] = 0;
+        return;
+    }
+    wide_from_utf8(t->arena + t->offset[i], t->length[i], out, outCount);
+}
+
+// ---------------------------------------------------------------------------
+// Sections
+
+static void put_cpu(RecordBuf *b, const CollectorSnapshot *s)
+{
+    put_u8(b, s->hasCpu ? 1u : 0u);
+    put_f32(b, s->totalCpu);
+    const uint32_t n = s->coreCpu ? s->logicalCount : 0;
+    put_varint(b, n);
+    for (uint32_t i = 0; i < n; i++) {
+        put_f32(b, s->coreCpu[i]);
+    }
+
+    put_f64(b, s->rates.contextSwitchesPerSec);
+    put_f64(b, s->rates.interruptsPerSec);
+    put_f64(b, s->rates.dpcsPerSec);
+    put_f64(b, s->rates.processorQueueLength);
+    put_u8(b, s->rates.hasPowerWatts ? 1u : 0u);
+    put_f64(b, s->rates.powerWatts);
+}
+
+static void get_cpu(RecordBuf *b, CollectorSnapshot *s)
+{
+    s->hasCpu = get_u8(b) != 0;
+    s->totalCpu = get_f32(b);
+    const uint64_t n = get_varint(b);
+    for (uint64_t i = 0; i < n && !b->bad; i++) {
+        const float v = get_f32(b);
+        if (i < s->logicalCount && s->coreCpu) s->coreCpu[i] = v;
+    }
+
+    s->rates.contextSwitchesPerSec = get_f64(b);
+    s->rates.interruptsPerSec = get_f64(b);
+    s->rates.dpcsPerSec = get_f64(b);
+    s->rates.processorQueueLength = get_f64(b);
+    s->rates.hasPowerWatts = get_u8(b) != 0;
+    s->rates.powerWatts = get_f64(b);
+}
+
+static void put_cpu_freq(RecordBuf *b, const CollectorSnapshot *s)
+{
+    const uint32_t n = (s->coreMHz && s->coreMaxMHz) ? s->logicalCount : 0;
+    put_varint(b, n);
+    for (uint32_t i = 0; i < n; i++) {
+        put_f32(b, s->coreMHz[i]);
+        put_f32(b, s->coreMaxMHz[i]);
+    }
+}
+
+static void get_cpu_freq(RecordBuf *b, CollectorSnapshot *s)
+{
+    const uint64_t n = get_varint(b);
+    for (uint64_t i = 0; i < n && !b->bad; i++) {
+        const float mhz = get_f32(b);
+        const float maxMhz = get_f32(b);
+        if (i < s->logicalCount && s->coreMHz && s->coreMaxMHz) {
+            s->coreMHz[i] = mhz;
+            s->coreMaxMHz[i] = maxMhz;
+        }
+    }
+}
+
+static void put_memory(RecordBuf *b, const CollectorSnapshot *s)
+{
+    put_u8(b, (uint8_t)((s->hasMemory ? 1u : 0u) | (s->hasCommit ? 2u : 0u)));
+    put_varint(b, s->memTotalPhysBytes);
+    put_varint(b, s->memAvailPhysBytes);
+    put_varint(b, s->commitTotalBytes);
+    put_varint(b, s->commitLimitBytes);
+}
+
+static void get_memory(RecordBuf *b, CollectorSnapshot *s)
+{
+    const uint8_t flags = get_u8(b);
+    s->hasMemory = (flags & 1u) != 0;
+    s->hasCommit = (flags & 2u) != 0;
+    s->memTotalPhysBytes = get_varint(b);
+    s->memAvailPhysBytes = get_varint(b);
+    s->commitTotalBytes = get_varint(b);
+    s->commitLimitBytes = get_varint(b);
+}
+
+static void put_disk(RecordBuf *b, const CollectorSnapshot *s)
+{
+    const bool perDisk = s->hasPerDisk && s->diskReadBytesPerSec && s->diskWriteBytesPerSec;
+    put_u8(b, (uint8_t)((s->rates.hasDisk ? 1u : 0u) | (perDisk ? 2u : 0u)));
+    put_f64(b, s->rates.diskReadBytesPerSec);
+    put_f64(b, s->rates.diskWriteBytesPerSec);
+    const uint32_t n = perDisk ? s->diskCount : 0;
+    put_varint(b, n);
+    for (uint32_t i = 0; i < n; i++) {
+        put_f64(b, s->diskReadBytesPerSec[i]);
+        put_f64(b, s->diskWriteBytesPerSec[i]);
+    }
+}
+
+static void get_disk(Replay *rp, CollectorSnapshot *s)
+{
+    RecordBuf *b = &rp->payload;
+    const uint8_t flags = get_u8(b);
+    s->rates.hasDisk = (flags & 1u) != 0;
+    s->rates.diskReadBytesPerSec = get_f64(b);
+    s->rates.diskWriteBytesPerSec = get_f64(b);
+    const uint64_t n = get_varint(b);
+    for (uint64_t i = 0; i < n && !b->bad; i++) {
+        const double r = get_f64(b);
+        const double w = get_f64(b);
+        if (i < rp->diskCount) {
+            rp->diskReadBytesPerSec[i] = r;
+            rp->diskWriteBytesPerSec[i] = w;
+        }
+    }
+    s->hasPerDisk = (flags & 2u) != 0 && n == rp->diskCount;
+}
+
+static void put_gpu(RecordBuf *b, const CollectorSnapshot *s)
+{
+    const bool engines = s->hasGpuEngines && s->gpuEnginePct;
+    put_u8(b, (uint8_t)((s->hasGpu ? 1u : 0u) | (s->hasGpuMemory ? 2u : 0u) | (engines ? 4u : 0u)));
+    put_varint(b, s->gpuDedicatedUsageBytes);
+    put_varint(b, s->gpuDedicatedLimitBytes);
+    put_varint(b, s->gpuSharedUsageBytes);
+    put_varint(b, s->gpuSharedLimitBytes);
+    const uint32_t n = engines ? s->gpuEngineCount : 0;
+    put_varint(b, n);
+    for (uint32_t i = 0; i < n; i++) {
+        put_f32(b, s->gpuEnginePct[i]);
+    }
+}
+
+static void get_gpu(Replay *rp, CollectorSnapshot *s)
+{
+    RecordBuf *b = &rp->payload;
+    const uint8_t flags = get_u8(b);
+    s->hasGpu = (flags & 1u) != 0;
+    s->hasGpuMemory = (flags & 2u) != 0;
+    s->gpuDedicatedUsageBytes = get_varint(b);
+    s->gpuDedicatedLimitBytes = get_varint(b);
+    s->gpuSharedUsageBytes = get_varint(b);
+    s->gpuSharedLimitBytes = get_varint(b);
+    const uint64_t n = get_varint(b);
+    for (uint64_t i = 0; i < n && !b->bad; i++) {
+        const float v = get_f32(b);
+        if (i < rp->gpuEngineCount) rp->gpuEnginePct[i] = v;
+    }
+    s->hasGpuEngines = (flags & 4u) != 0 && n == rp->gpuEngineCount;
+}
+
+static void put_sensors(RecordBuf *b, RecordStrings *t, const CollectorSnapshot *s)
+{
+    put_u8(b, (uint8_t)((s->hasSensors ? 1u : 0u) | (s->providerHasTempC ? 2u : 0u) |
+                        (s->providerHasFanRpm ? 4u : 0u) | (s->providerHasPowerW ? 8u : 0u)));
+    put_f32(b, s->cpuTempC);
+    put_f32(b, s->fanRpm);
+    put_f64(b, s->providerPowerW);
+    put_str(b, t, s->sensorStatus);
+}
+
+static void get_sensors(RecordBuf *b, RecordStrings *t, CollectorSnapshot *s)
+{
+    const uint8_t flags = get_u8(b);
+    s->hasSensors = (flags & 1u) != 0;
+    s->providerHasTempC = (flags & 2u) != 0;
+    s->providerHasFanRpm = (flags & 4u) != 0;
+    s->providerHasPowerW = (flags & 8u) != 0;
+    s->cpuTempC = get_f32(b);
+    s->fanRpm = get_f32(b);
+    s->providerPowerW = get_f64(b);
+    get_str(b, t, s->sensorStatus, (uint32_t)(sizeof(s->sensorStatus) / sizeof(s->sensorStatus[0])));
+}
+
+// EtwRates is all doubles; written field by field so the layout is explicit.
+#define ETW_RATE_FIELDS(X) \
+    X(cswitchPerSec) X(isrPerSec) X(dpcPerSec) X(threadPerSec) X(processPerSec) \
+    X(imageLoadPerSec) X(dispatcherPerSec) X(syscallPerSec) X(profilePerSec) \
+    X(pageFaultPerSec) X(fileIoPerSec) X(diskIoPerSec) X(tcpipPerSec) X(registryPerSec) \
+    X(otherPerSec)
+
+static void put_etw(RecordBuf *b, RecordStrings *t, const CollectorSnapshot *s)
+{
+    put_u8(b, s->hasEtw ? 1u : 0u);
+#define PUT_RATE(f) put_f64(b, s->etwRates.f);
+    ETW_RATE_FIELDS(PUT_RATE)
+#undef PUT_RATE
+    put_str(b, t, s->etwStatus);
+}
+
+static void get_etw(RecordBuf *b, RecordStrings *t, CollectorSnapshot *s)
+{
+    s->hasEtw = get_u8(b) != 0;
+#define GET_RATE(f) s->etwRates.f = get_f64(b);
+    ETW_RATE_FIELDS(GET_RATE)
+#undef GET_RATE
+    get_str(b, t, s->etwStatus, (uint32_t)(sizeof(s->etwStatus) / sizeof(s->etwStatus[0])));
+}
+
+// Process sections (version 2): u8 has, u8 mode, varint count, then count rows
+// (PROCS_ROWS, the whole table) or delta records (PROCS_DELTA, against the table of the
+// previous tick that carried one). Version 1 sections are rows without the mode byte;
+// from version 3 the Net column carries the connection count after the endpoint.
+#define PROCS_ROWS 0u
+#define PROCS_DELTA 1u
+
+#define PROC_TOMBSTONE UINT32_MAX // pid of a mirrored row removed by an EXITED record
+
+static void put_row(RecordBuf *b, RecordStrings *t, const StrPool *pool, const ProcRow *r)
+{
+    put_varint(b, r->pid);
+    put_f32(b, r->cpuPct);
+    put_varint(b, r->workingSetBytes);
+    put_u8(b, r->hasNet ? 1u : 0u);
+    put_str(b, t, StrPool_Get(pool, r->nameId));
+    put_str(b, t, StrPool_Get(pool, r->pathId));
+    put_str(b, t, StrPool_Get(pool, r->ownerId));
+    if (r->hasNet) {
+        put_str(b, t, StrPool_Get(pool, r->netRemoteId));
+        put_varint(b, r->netConns);
+    }
+}
+
+static void put_columns(RecordBuf *b, RecordStrings *t, const StrPool *pool, const ProcRow *r, uint8_t columns)
+{
+    put_u8(b, columns);
+    if (columns & PROC_COL_CPU) put_f32(b, r->cpuPct);
+    if (columns & PROC_COL_MEM) put_varint(b, r->workingSetBytes);
+    if (columns & PROC_COL_NAME) put_str(b, t, StrPool_Get(pool, r->nameId));
+    if (columns & PROC_COL_PATH) put_str(b, t, StrPool_Get(pool, r->pathId));
+    if (columns & PROC_COL_OWNER) put_str(b, t, StrPool_Get(pool, r->ownerId));
+    if (columns & PROC_COL_NET) {
+        put_u8(b, r->hasNet ? 1u : 0u);
+        if (r->hasNet) {
+            put_str(b, t, StrPool_Get(pool, r->netRemoteId));
+            put_varint(b, r->netConns);
+        }
+    }
+}
+
+// Writes the delta stream when the last process section written holds the table it
+// applies to, else the whole table.
+static void put_procs(Recorder *rec, const CollectorSnapshot *s)
+{
+    RecordBuf *b = &rec->payload;
+    RecordStrings *t = &rec->strings;
+    const ProcTable *pt = s->hasProcs ? s->procs : NULL;
+    put_u8(b, pt ? 1u : 0u);
+    if (!pt) {
+        put_u8(b, PROCS_ROWS);
+        put_varint(b, 0);
+        rec->procSynced = false;
+        return;
+    }
+
+    const StrPool *pool = &pt->strings;
+    if (rec->procSynced && pt->deltaSeq == rec->procSeq + 1u) {
+        put_u8(b, PROCS_DELTA);
+        put_varint(b, pt->deltaCount);
+        for (uint32_t i = 0; i < pt->deltaCount; i++) {
+            const ProcDelta *d = &pt->deltas[i];
+            const ProcRow *r = (d->kind == PROC_DELTA_EXITED) ? NULL : ProcTable_FindRow(pt, d->pid);
+            if (!r) {
+                put_u8(b, PROC_DELTA_EXITED);
+                put_varint(b, d->pid);
+            } else if (d->kind == PROC_DELTA_STARTED) {
+                put_u8(b, PROC_DELTA_STARTED);
+                put_row(b, t, pool, r);
+            } else {
+                put_u8(b, PROC_DELTA_CHANGED);
+                put_varint(b, d->pid);
+                put_columns(b, t, pool, r, d->columns);
+            }
+        }
+    } else {
+        put_u8(b, PROCS_ROWS);
+        put_varint(b, pt->rowCount);
+        for (uint32_t i = 0; i < pt->rowCount; i++) {
+            put_row(b, t, pool, &pt->rows[i]);
+        }
+    }
+    rec->procSynced = true;
+    rec->procSeq = pt->deltaSeq;
+}
+
+// Reads a string into pool (when there is one) and returns its id.
+static uint32_t get_pooled_str(RecordBuf *b, RecordStrings *t, StrPool *pool)
+{
+    wchar_t tmp[MAX_PATH];
+    get_str(b, t, tmp, (uint32_t)(sizeof(tmp) / sizeof(tmp[0])));
+    return pool ? StrPool_Intern(pool, tmp) : STR_POOL_EMPTY;
+}
+
+static uint16_t get_net_conns(RecordBuf *b, uint32_t version)
+{
+    if (version < 3u) return 1;
+    const uint64_t v = get_varint(b);
+    return (v < UINT16_MAX) ? (uint16_t)v : UINT16_MAX;
+}
+
+static void get_row(RecordBuf *b, RecordStrings *t, StrPool *pool, ProcRow *r, uint32_t version)
+{
+    memset(r, 0, sizeof(*r)); // createTime is not recorded; replayed rows never meet live state
+    r->pid = (uint32_t)get_varint(b);
+    r->cpuPct = get_f32(b);
+    r->workingSetBytes = get_varint(b);
+    r->hasNet = get_u8(b) != 0;
+    r->nameId = get_pooled_str(b, t, pool);
+    r->pathId = get_pooled_str(b, t, pool);
+    r->ownerId = get_pooled_str(b, t, pool);
+    if (r->hasNet) {
+        r->netRemoteId = get_pooled_str(b, t, pool);
+        r->netConns = get_net_conns(b, version);
+    }
+}
+
+static void get_columns(RecordBuf *b, RecordStrings *t, StrPool *pool, ProcRow *r, uint32_t version)
+{
+    const uint8_t columns = get_u8(b);
+    if (columns & PROC_COL_CPU) r->cpuPct = get_f32(b);
+    if (columns & PROC_COL_MEM) r->workingSetBytes = get_varint(b);
+    if (columns & PROC_COL_NAME) r->nameId = get_pooled_str(b, t, pool);
+    if (columns & PROC_COL_PATH) r->pathId = get_pooled_str(b, t, pool);
+    if (columns & PROC_COL_OWNER) r->ownerId = get_pooled_str(b, t, pool);
+    if (columns & PROC_COL_NET) {
+        r->hasNet = get_u8(b) != 0;
+        r->netRemoteId = r->hasNet ? get_pooled_str(b, t, pool) : STR_POOL_EMPTY;
+        r->netConns = r->hasNet ? get_net_conns(b, version) : 0;
+    }
+}
+
+// Row of pid among rows [0, indexed), the rows the table's index covered when the delta
+// started; UINT32_MAX if none.
+static uint32_t find_mirror_row(const ProcTable *pt, uint32_t indexed, bool useIndex, uint32_t pid)
+{
+    if (useIndex) {
+        const uint32_t i = PidIndex_FindPid(&pt->rowIndex, pid);
+        return (i < indexed && pt->rows[i].pid == pid) ? i : UINT32_MAX;
+    }
+    for (uint32_t i = 0; i < indexed; i++) {
+        if (pt->rows[i].pid == pid) return i;
+    }
+    return UINT32_MAX;
+}
+
+// Applies n delta records to pt, the table the previous process section left.
+static void apply_proc_delta(RecordBuf *b, RecordStrings *t, ProcTable *pt, uint64_t n, uint32_t version)
+{
+    StrPool *pool = pt ? &pt->strings : NULL;
+    const uint32_t indexed = pt ? pt->rowCount : 0;
+    const bool useIndex = pt && pt->rowIndex.slots && pt->rowIndex.count == pt->rowCount;
+    bool removed = false;
+    ProcRow scratch;
+    for (uint64_t k = 0; k < n && !b->bad; k++) {
+        const uint8_t kind = get_u8(b);
+        if (kind == PROC_DELTA_STARTED) {
+            const bool add = pt && ProcTable_EnsureRows(pt, pt->rowCount + 1u);
+            get_row(b, t, pool, add ? &pt->rows[pt->rowCount] : &scratch, version);
+            if (add) pt->rowCount++;
+            continue;
+        }
+        if (kind != PROC_DELTA_EXITED && kind != PROC_DELTA_CHANGED) {
+            b->bad = true;
+            break;
+        }
+        const uint32_t pid = (uint32_t)get_varint(b);
+        const uint32_t i = pt ? find_mirror_row(pt, indexed, useIndex, pid) : UINT32_MAX;
+        if (kind == PROC_DELTA_EXITED) {
+            if (i != UINT32_MAX) {
+                pt->rows[i].pid = PROC_TOMBSTONE;
+                removed = true;
+            }
+        } else {
+            ProcRow *r = (i != UINT32_MAX) ? &pt->rows[i] : &scratch;
+            get_columns(b, t, pool, r, version);
+        }
+    }
+
+    if (pt && removed) {
+        uint32_t w = 0;
+        for (uint32_t i = 0; i < pt->rowCount; i++) {
+            if (pt->rows[i].pid != PROC_TOMBSTONE) pt->rows[w++] = pt->rows[i];
+        }
+        pt->rowCount = w;
+    }
+}
+
+static void get_procs(Replay *rp, CollectorSnapshot *s)
+{
+    RecordBuf *b = &rp->payload;
+    RecordStrings *t = &rp->strings;
+    const bool has = get_u8(b) != 0;
+    const uint8_t mode = (rp->version >= 2u) ? get_u8(b) : PROCS_ROWS;
+    const uint64_t n = get_varint(b);
+    ProcTable *pt = s->procs;
+
+    bool store = false;
+    if (mode == PROCS_DELTA) {
+        // Only a mirror of the previous section can take a delta.
+        store = pt && rp->procSynced;
+        apply_proc_delta(b, t, store ? pt : NULL, n, rp->version);
+    } else if (mode == PROCS_ROWS) {
+        store = pt && n <= UINT32_MAX && ProcTable_EnsureRows(pt, (uint32_t)n);
+        StrPool *pool = store ? &pt->strings : NULL;
+        ProcRow scratch;
+        for (uint64_t i = 0; i < n && !b->bad; i++) {
+            get_row(b, t, pool, store ? &pt->rows[i] : &scratch, rp->version);
+        }
+        if (store) pt->rowCount = (uint32_t)n;
+    } else {
+        b->bad = true;
+    }
+
+    if (store) {
+        if (b->bad) pt->rowCount = 0;
+        pt->sortedCount = 0;
+        ProcTable_TrimStrings(pt);
+        ProcTable_IndexRows(pt);
+    }
+    rp->procSynced = store && has && !b->bad;
+    s->hasProcs = has && store;
+}
+
+// ---------------------------------------------------------------------------
+// Recorder
+
+static void write_record(Recorder *r, uint8_t type)
+{
+    if (r->failed) return;
+    if (r->payload.bad) {
+        r->failed = true;
+        return;
+    }
+
+    RecordBuf hdr;
+    uint8_t hdrBytes[16];
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.data = hdrBytes;
+    hdr.cap = (uint32_t)sizeof(hdrBytes);
+    put_u8(&hdr, type);
+    put_varint(&hdr, r->payload.len);
+
+    if (fwrite(hdr.data, 1, hdr.len, r->f) != hdr.len ||
+        fwrite(r->payload.data, 1, r->payload.len, r->f) != r->payload.len) {
+        r->failed = true;
+        return;
+    }
+    r->bytesWritten += (uint64_t)hdr.len + r->payload.len;
+}
+
+bool Recorder_Begin(Recorder *r, FILE *f, const CollectorSnapshot *snap, int64_t now, double qpcFreq)
+{
+    memset(r, 0, sizeof(*r));
+    if (!f || !snap || qpcFreq <= 0.0) {
+        if (f) fclose(f);
+        return false;
+    }
+    r->f = f;
+    r->qpcFreq = qpcFreq;
+    r->startQpc = now;
+    r->logicalCount = snap->logicalCount;
+
+    RecordBuf *b = &r->payload;
+    put_bytes(b, kMagic, sizeof(kMagic));
+    put_u32le(b, RECORD_VERSION);
+    put_varint(b, snap->logicalCount);
+    if (b->bad || fwrite(b->data, 1, b->len, f) != b->len) {
+        Recorder_End(r);
+        return false;
+    }
+    r->bytesWritten = b->len;
+
+    // Shape published by collector init (stable until shutdown).
+    b->len = 0;
+    const uint32_t diskCount = snap->diskNames ? snap->diskCount : 0;
+    put_varint(b, diskCount);
+    for (uint32_t i = 0; i < diskCount; i++) {
+        put_str(b, &r->strings, snap->diskNames[i] ? snap->diskNames[i] : L"");
+    }
+    put_u8(b, (uint8_t)((snap->gpuPresent ? 1u : 0u) | (snap->hasGpuAdapter ? 2u : 0u)));
+    put_str(b, &r->strings, snap->gpuAdapterName);
+    put_varint(b, snap->gpuVendorId);
+    put_varint(b, snap->gpuDedicatedVideoMemoryBytes);
+    put_varint(b, snap->gpuSharedSystemMemoryBytes);
+    const uint32_t engineCount = snap->gpuEngineNames ? snap->gpuEngineCount : 0;
+    put_varint(b, engineCount);
+    for (uint32_t i = 0; i < engineCount; i++) {
+        put_str(b, &r->strings, snap->gpuEngineNames[i] ? snap->gpuEngineNames[i] : L"");
+    }
+    write_record(r, RECORD_TYPE_SHAPE);
+
+    if (r->failed) {
+        Recorder_End(r);
+        return false;
+    }
+    return true;
+}
+
+void Recorder_WriteTick(Recorder *r, const CollectorSnapshot *snap, uint32_t sections, int64_t t, double freqDt)
+{
+    if (!r || !r->f || r->failed || sections == 0) return;
+
+    const double sec = (t > r->startQpc) ? ((double)(t - r->startQpc) / r->qpcFreq) : 0.0;
+    uint64_t ns = (uint64_t)(sec * 1e9);
+    if (ns < r->lastNs) ns = r->lastNs;
+
+    RecordBuf *b = &r->payload;
+    b->len = 0;
+    put_varint(b, ns - r->lastNs);
+    put_varint(b, sections);
+    put_f64(b, freqDt);
+
+    if (sections & COLLECTOR_SECTION_CPU) put_cpu(b, snap);
+    if (sections & COLLECTOR_SECTION_CPU_FREQ) put_cpu_freq(b, snap);
+    if (sections & COLLECTOR_SECTION_MEMORY) put_memory(b, snap);
+    if (sections & COLLECTOR_SECTION_DISK) put_disk(b, snap);
+    if (sections & COLLECTOR_SECTION_GPU) put_gpu(b, snap);
+    if (sections & COLLECTOR_SECTION_SENSORS) put_sensors(b, &r->strings, snap);
+    if (sections & COLLECTOR_SECTION_ETW) put_etw(b, &r->strings, snap);
+    if (sections & COLLECTOR_SECTION_PROCS) put_procs(r, snap);
+
+    write_record(r, RECORD_TYPE_TICK);
+    if (!r->failed) {
+        r->lastNs = ns;
+        r->tickCount++;
+    }
+}
+
+void Recorder_End(Recorder *r)
+{
+    if (!r) return;
+    if (r->f) {
+        fclose(r->f);
+    }
+    buf_free(&r->payload);
+    strings_free(&r->strings);
+    memset(r, 0, sizeof(*r));
+}
+
+// ---------------------------------------------------------------------------
+// Replay
+
+static bool file_get_varint(FILE *f, uint64_t *out)
+{
+    uint64_t v = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        const int c = fgetc(f);
+        if (c == EOF) return false;
+        v |= (uint64_t)((uint32_t)c & 0x7Fu) << shift;
+        if (!((uint32_t)c & 0x80u)) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads the next record into rp->payload. Returns false at end of file or on a
+// truncated/oversized record.
+static bool read_record(Replay *rp, uint8_t *outType)
+{
+    const int type = fgetc(rp->f);
+    uint64_t len = 0;
+    if (type == EOF || !file_get_varint(rp->f, &len) || len > RECORD_MAX_PAYLOAD) {
+        return false;
+    }
+
+    RecordBuf *b = &rp->payload;
+    b->len = 0;
+    b->pos = 0;
+    b->bad = false;
+    if (!buf_reserve(b, (uint32_t)len)) return false;
+    if (fread(b->data, 1, (size_t)len, rp->f) != (size_t)len) return false;
+    b->len = (uint32_t)len;
+    *outType = (uint8_t)type;
+    return true;
+}
+
+static bool read_shape(Replay *rp)
+{
+    RecordBuf *b = &rp->payload;
+
+    const uint64_t diskCount = get_varint(b);
+    if (b->bad || diskCount > 4096u) return false;
+    if (diskCount > 0) {
+        rp->diskNames = (wchar_t (*)[128])calloc((size_t)diskCount, sizeof(*rp->diskNames));
+        rp->diskNamePtrs = (const wchar_t **)calloc((size_t)diskCount, sizeof(*rp->diskNamePtrs));
+        rp->diskReadBytesPerSec = (double *)calloc((size_t)diskCount, sizeof(double));
+        rp->diskWriteBytesPerSec = (double *)calloc((size_t)diskCount, sizeof(double));
+        if (!rp->diskNames || !rp->diskNamePtrs || !rp->diskReadBytesPerSec || !rp->diskWriteBytesPerSec) return false;
+    }
+    rp->diskCount = (uint32_t)diskCount;
+    for (uint32_t i = 0; i < rp->diskCount; i++) {
+        get_str(b, &rp->strings, rp->diskNames[i], 128);
+        rp->diskNamePtrs[i] = rp->diskNames[i];
+    }
+
+    const uint8_t flags = get_u8(b);
+    rp->gpuPresent = (flags & 1u) != 0;
+    rp->hasGpuAdapter = (flags & 2u) != 0;
+    get_str(b, &rp->strings, rp->gpuAdapterName, (uint32_t)(sizeof(rp->gpuAdapterName) / sizeof(rp->gpuAdapterName[0])));
+    rp->gpuVendorId = (uint32_t)get_varint(b);
+    rp->gpuDedicatedVideoMemoryBytes = get_varint(b);
+    rp->gpuSharedSystemMemoryBytes = get_varint(b);
+
+    const uint64_t engineCount = get_varint(b);
+    if (b->bad || engineCount > 4096u) return false;
+    if (engineCount > 0) {
+        rp->gpuEngineNames = (wchar_t (*)[64])calloc((size_t)engineCount, sizeof(*rp->gpuEngineNames));
+        rp->gpuEngineNamePtrs = (const wchar_t **)calloc((size_t)engineCount, sizeof(*rp->gpuEngineNamePtrs));
+        rp->gpuEnginePct = (float *)calloc((size_t)engineCount, sizeof(float));
+        if (!rp->gpuEngineNames || !rp->gpuEngineNamePtrs || !rp->gpuEnginePct) return false;
+    }
+    rp->gpuEngineCount = (uint32_t)engineCount;
+    for (uint32_t i = 0; i < rp->gpuEngineCount; i++) {
+        get_str(b, &rp->strings, rp->gpuEngineNames[i], 64);
+        rp->gpuEngineNamePtrs[i] = rp->gpuEngineNames[i];
+    }
+
+    return !b->bad;
+}
+
+bool Replay_Open(Replay *rp, FILE *f)
+{
+    memset(rp, 0, sizeof(*rp));
+    if (!f) return false;
+    rp->f = f;
+
+    uint8_t hdr[12];
+    if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) || memcmp(hdr, kMagic, sizeof(kMagic)) != 0) {
+        Replay_Close(rp);
+        return false;
+    }
+    const uint32_t version = (uint32_t)hdr[8] | ((uint32_t)hdr[9] << 8) | ((uint32_t)hdr[10] << 16) | ((uint32_t)hdr[11] << 24);
+    uint64_t logicalCount = 0;
+    if (version < 1u || version > RECORD_VERSION || !file_get_varint(f, &logicalCount) || logicalCount == 0 || logicalCount > 65536u) {
+        Replay_Close(rp);
+        return false;
+    }
+    rp->logicalCount = (uint32_t)logicalCount;
+    rp->version = version;
+
+    uint8_t type = 0;
+    if (!read_record(rp, &type) || type != RECORD_TYPE_SHAPE || !read_shape(rp)) {
+        Replay_Close(rp);
+        return false;
+    }
+    return true;
+}
+
+void Replay_PublishShape(Replay *rp, CollectorSnapshot *snap)
+{
+    snap->diskCount = rp->diskCount;
+    snap->diskNames = rp->diskCount ? rp->diskNamePtrs : NULL;
+    snap->diskReadBytesPerSec = rp->diskReadBytesPerSec;
+    snap->diskWriteBytesPerSec = rp->diskWriteBytesPerSec;
+
+    snap->gpuPresent = rp->gpuPresent;
+    snap->hasGpuAdapter = rp->hasGpuAdapter;
+    memcpy(snap->gpuAdapterName, rp->gpuAdapterName, sizeof(snap->gpuAdapterName));
+    snap->gpuVendorId = rp->gpuVendorId;
+    snap->gpuDedicatedVideoMemoryBytes = rp->gpuDedicatedVideoMemoryBytes;
+    snap->gpuSharedSystemMemoryBytes = rp->gpuSharedSystemMemoryBytes;
+    snap->gpuEngineCount = rp->gpuEngineCount;
+    snap->gpuEngineNames = rp->gpuEngineCount ? rp->gpuEngineNamePtrs : NULL;
+    snap->gpuEnginePct = rp->gpuEnginePct;
+}
+
+bool Replay_Next(Replay *rp, ReplayTick *out)
+{
+    if (!rp || !rp->f) return false;
+
+    uint8_t type = 0;
+    for (;;) {
+        if (!read_record(rp, &type)) return false;
+        if (type == RECORD_TYPE_TICK) break;
+        // Unknown (newer) record types are skipped.
+    }
+
+    RecordBuf *b = &rp->payload;
+    const uint64_t dtNs = get_varint(b);
+    const uint32_t sections = (uint32_t)get_varint(b);
+    const double freqDt = get_f64(b);
+    if (b->bad) return false;
+
+    rp->tNs += dtNs;
+    rp->tickCount++;
+    rp->pendingSections = sections;
+    if (out) {
+        out->tNs = rp->tNs;
+        out->sections = sections;
+        out->freqDt = freqDt;
+    }
+    return true;
+}
+
+bool Replay_Decode(Replay *rp, CollectorSnapshot *snap)
+{
+    if (!rp || !snap) return false;
+
+    const uint32_t sections = rp->pendingSections;
+    rp->pendingSections = 0;
+
+    RecordBuf *b = &rp->payload;
+    if (sections & COLLECTOR_SECTION_CPU) get_cpu(b, snap);
+    if (sections & COLLECTOR_SECTION_CPU_FREQ) get_cpu_freq(b, snap);
+    if (sections & COLLECTOR_SECTION_MEMORY) get_memory(b, snap);
+    if (sections & COLLECTOR_SECTION_DISK) get_disk(rp, snap);
+    if (sections & COLLECTOR_SECTION_GPU) get_gpu(rp, snap);
+    if (sections & COLLECTOR_SECTION_SENSORS) get_sensors(b, &rp->strings, snap);
+    if (sections & COLLECTOR_SECTION_ETW) get_etw(b, &rp->strings, snap);
+    if (sections & COLLECTOR_SECTION_PROCS) get_procs(rp, snap);
+    return !b->bad;
+}
+
+void Replay_Close(Replay *rp)
+{
+    if (!rp) return;
+    if (rp->f) {
+        fclose(rp->f);
+    }
+    buf_free(&rp->payload);
+    strings_free(&rp->strings);
+    free(rp->diskNames);
+    free(rp->diskNamePtrs);
+    free(rp->diskReadBytesPerSec);
+    free(rp->diskWriteBytesPerSec);
+    free(rp->gpuEngineNames);
+    free(rp->gpuEngineNamePtrs);
+    free(rp->gpuEnginePct);
+    memset(rp, 0, sizeof(*rp));
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <wchar.h>
+
+#include "collector.h"
+
+// Record/replay of raw collector output.
+//
+// The Recorder writes every scheduler tick's CollectorSnapshot sections (CPU counters,
+// frequencies, memory, disks, GPU, sensors, ETW rates, the process table) to a compact
+// binary stream; Replay reads it back into a CollectorSnapshot so Monitor_Apply, the
+// process view and the UI run on captured data without any collector touching the OS.
+// Captures are portable: a file recorded on Windows replays on the Linux headless build.
+//
+// Stream layout (little-endian):
+//   header  "CCMREC\0\0", u32 version, varint logicalCount
+//   records u8 type, varint payload length, payload
+//     SHAPE  disk names, GPU adapter and engine names (published once by collector init)
+//     TICK   varint ns since the previous tick, varint CollectorSection mask,
+//            f64 frequency dt, then one payload per section bit in ascending order
+// Integers are LEB128 varints, strings are UTF-8 and interned: each is written once and
+// referenced by index afterwards. The process section is the table's delta stream
+// (ProcDelta: started rows, exited PIDs, changed columns) whenever the previous process
+// section holds the table it applies to, so a tick costs bytes per changed process rather
+// than per process; otherwise, and in version 1 captures, it is the whole table.
+// Unknown record types are skipped; a truncated final record ends the replay.
+
+#define RECORD_VERSION 3u // 1 (whole process tables) and 2 (no connection counts) still replay
+
+// Strings interned per file; later new strings are written inline every time.
+#define RECORD_STRING_TABLE_MAX 65536u
+
+typedef struct RecordBuf {
+    uint8_t *data;
+    uint32_t len;
+    uint32_t cap;
+    uint32_t pos; // read cursor
+    bool bad;     // overflow / allocation failure
+} RecordBuf;
+
+typedef struct RecordStrings {
+    char *arena; // UTF-8 bytes of every interned string, back to back
+    uint32_t arenaLen;
+    uint32_t arenaCap;
+    uint32_t *offset; // per string: start in arena
+    uint32_t *length;
+    uint32_t count;
+    uint32_t cap;
+    uint32_t *slots; // writer only: open-addressing hash -> string index + 1
+    uint32_t slotCap;
+} RecordStrings;
+
+typedef struct Recorder {
+    FILE *f;
+    double qpcFreq;
+    int64_t startQpc;
+    uint64_t lastNs;
+    uint32_t logicalCount;
+    RecordBuf payload;
+    RecordStrings strings;
+    uint64_t tickCount;
+    uint64_t bytesWritten;
+    uint32_t procSeq;  // ProcTable.deltaSeq of the last process section written
+    bool procSynced;   // and that section carried a table
+    bool failed; // write error; further ticks are dropped
+} Recorder;
+
+typedef struct ReplayTick {
+    uint64_t tNs;      // since the start of the capture
+    uint32_t sections; // CollectorSection mask refreshed by this tick
+    double freqDt;     // Monitor_Apply dt for COLLECTOR_SECTION_CPU_FREQ
+} ReplayTick;
+
+typedef struct Replay {
+    FILE *f;
+    uint32_t logicalCount;
+    uint32_t version;
+    uint64_t tNs;
+    uint64_t tickCount;
+    uint32_t pendingSections; // read by Replay_Next, not yet decoded
+    RecordBuf payload;
+    RecordStrings strings;
+    bool procSynced; // the snapshot's table mirrors the last process section
+
+    // Recorded shape; published into the snapshot by Replay_PublishShape.
+    uint32_t diskCount;
+    wchar_t (*diskNames)[128];
+    const wchar_t **diskNamePtrs;
+    double *diskReadBytesPerSec;
+    double *diskWriteBytesPerSec;
+
+    bool gpuPresent;
+    bool hasGpuAdapter;
+    wchar_t gpuAdapterName[128];
+    uint32_t gpuVendorId;
+    uint64_t gpuDedicatedVideoMemoryBytes;
+    uint64_t gpuSharedSystemMemoryBytes;
+    uint32_t gpuEngineCount;
+    wchar_t (*gpuEngineNames)[64];
+    const wchar_t **gpuEngineNamePtrs;
+    float *gpuEnginePct;
+} Replay;
+
+// Starts a capture on f (opened for binary writing; the Recorder owns it from here on).
+// snap supplies the logical CPU count and the shape published by collector init;
+// now/qpcFreq define the capture's time origin.
+bool Recorder_Begin(Recorder *r, FILE *f, const CollectorSnapshot *snap, int64_t now, double qpcFreq);
+// Appends one tick: the given sections of snap, sampled at t (Qpc_Now() ticks).
+void Recorder_WriteTick(Recorder *r, const CollectorSnapshot *snap, uint32_t sections, int64_t t, double freqDt);
+// Flushes and closes the file.
+void Recorder_End(Recorder *r);
+
+// Opens a capture (f opened for binary reading; the Replay owns it) and reads its
+// header and shape. Returns false if f is not a capture of a supported version.
+bool Replay_Open(Replay *rp, FILE *f);
+// Points snap's disk/GPU shape at the recorded one (storage owned by rp). Call before
+// Monitor_InitDeviceSeries so the Monitor sizes its per-device series to match.
+void Replay_PublishShape(Replay *rp, CollectorSnapshot *snap);
+// Reads the next tick's header (time, sections). Returns false at the end of the capture.
+bool Replay_Next(Replay *rp, ReplayTick *out);
+// Decodes the tick read by Replay_Next into snap, whose CPU arrays must hold
+// rp->logicalCount entries. Split from Replay_Next so paced replay can leave snap
+// untouched until the tick is due. Returns false on a corrupt record.
+bool Replay_Decode(Replay *rp, CollectorSnapshot *snap);
+void Replay_Close(Replay *rp);
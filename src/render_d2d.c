@@ -7,6 +7,8 @@
 #include <dxgi.h>
 #include <dxgiformat.h>
 
+#include "proc_view.h"
+
 #ifndef SAFE_RELEASE
 #define SAFE_RELEASE_IFACE(type, x) do { if ((x)) { type##_Release((x)); (x) = NULL; } } while (0)
 #endif
@@ -101,6 +103,46 @@ static ID2D1Brush* usage_brush(RenderD2D *r, float pct)
     return (ID2D1Brush*)r->brushRed;
 }
 
+// Draws a history as a polyline, oldest sample at the left edge. Points are spaced by the
+// history's logical capacity, so a series that is still filling grows from the left.
+// Values are clamped to [0, maxV]; brush == NULL colours each segment by usage (percent).
+// Walks the spans directly instead of indexing sample by sample.
+static void draw_spans(RenderD2D *r, const RingBufSpans *spans, uint32_t cap, float left, float width,
+                       float top, float height, float maxV, ID2D1Brush *brush, float stroke)
+{
+    if (spans->aCount + spans->bCount < 2 || cap < 2 || maxV <= 0.0f) return;
+
+    ID2D1RenderTarget *rt = (ID2D1RenderTarget *)r->rt;
+    const float dx = width / (float)(cap - 1);
+    const float bottom = top + height;
+    const float scale = height / maxV;
+
+    D2D1_POINT_2F prev = { left, bottom };
+    uint32_t i = 0;
+    for (uint32_t part = 0; part < 2; part++) {
+        const float *v = part ? spans->b : spans->a;
+        const uint32_t n = part ? spans->bCount : spans->aCount;
+        for (uint32_t k = 0; k < n; k++, i++) {
+            float val = v[(size_t)k * spans->stride];
+            if (val < 0.0f) val = 0.0f;
+            if (val > maxV) val = maxV;
+            D2D1_POINT_2F p = { left + dx * (float)i, bottom - scale * val };
+            if (i > 0) {
+                ID2D1RenderTarget_DrawLine(rt, prev, p, brush ? brush : usage_brush(r, val), stroke, NULL);
+            }
+            prev = p;
+        }
+    }
+}
+
+static void draw_series(RenderD2D *r, const RingBufF *h, float left, float width,
+                        float top, float height, float maxV, ID2D1Brush *brush, float stroke)
+{
+    RingBufSpans spans;
+    RingBuf_GetSpans(h, &spans);
+    draw_spans(r, &spans, h->cap, left, width, top, height, maxV, brush, stroke);
+}
+
 bool Render_Init(RenderD2D *r, HWND hwnd)
 {
     ZeroMemory(r, sizeof(*r));
@@ -218,6 +260,10 @@ void Render_DrawTabs(RenderD2D *r, int activeTab)
     r->tabGpuY = y;
     r->tabGpuW = tabW;
     r->tabGpuH = tabH;
+    r->tabSelfX = x + (tabW + gap) * 3.0f;
+    r->tabSelfY = y;
+    r->tabSelfW = tabW;
+    r->tabSelfH = tabH;
 
     ID2D1RenderTarget *rt = (ID2D1RenderTarget *)r->rt;
 
@@ -225,24 +271,41 @@ void Render_DrawTabs(RenderD2D *r, int activeTab)
     D2D1_RECT_F cpuR = { r->tabCpuX, r->tabCpuY, r->tabCpuX + r->tabCpuW, r->tabCpuY + r->tabCpuH };
     D2D1_RECT_F memR = { r->tabMemX, r->tabMemY, r->tabMemX + r->tabMemW, r->tabMemY + r->tabMemH };
     D2D1_RECT_F gpuR = { r->tabGpuX, r->tabGpuY, r->tabGpuX + r->tabGpuW, r->tabGpuY + r->tabGpuH };
+    D2D1_RECT_F selfR = { r->tabSelfX, r->tabSelfY, r->tabSelfX + r->tabSelfW, r->tabSelfY + r->tabSelfH };
     ID2D1RenderTarget_FillRectangle(rt, &cpuR, (ID2D1Brush*)r->brushGrid);
     ID2D1RenderTarget_FillRectangle(rt, &memR, (ID2D1Brush*)r->brushGrid);
     ID2D1RenderTarget_FillRectangle(rt, &gpuR, (ID2D1Brush*)r->brushGrid);
+    ID2D1RenderTarget_FillRectangle(rt, &selfR, (ID2D1Brush*)r->brushGrid);
 
     const ID2D1Brush *cpuBrush = (activeTab == 0) ? (ID2D1Brush*)r->brushText : (ID2D1Brush*)r->brushDim;
     const ID2D1Brush *memBrush = (activeTab == 1) ? (ID2D1Brush*)r->brushText : (ID2D1Brush*)r->brushDim;
     const ID2D1Brush *gpuBrush = (activeTab == 2) ? (ID2D1Brush*)r->brushText : (ID2D1Brush*)r->brushDim;
+    const ID2D1Brush *selfBrush = (activeTab == 3) ? (ID2D1Brush*)r->brushText : (ID2D1Brush*)r->brushDim;
     draw_text(r, r->tabCpuX + 10.0f * r->dpiScale, r->tabCpuY + 1.0f * r->dpiScale,
               r->tabCpuW - 10.0f * r->dpiScale, r->tabCpuH, r->textSmall, (ID2D1Brush*)cpuBrush, L"CPU");
     draw_text(r, r->tabMemX + 10.0f * r->dpiScale, r->tabMemY + 1.0f * r->dpiScale,
               r->tabMemW - 10.0f * r->dpiScale, r->tabMemH, r->textSmall, (ID2D1Brush*)memBrush, L"Memory");
     draw_text(r, r->tabGpuX + 10.0f * r->dpiScale, r->tabGpuY + 1.0f * r->dpiScale,
               r->tabGpuW - 10.0f * r->dpiScale, r->tabGpuH, r->textSmall, (ID2D1Brush*)gpuBrush, L"GPU");
+    draw_text(r, r->tabSelfX + 10.0f * r->dpiScale, r->tabSelfY + 1.0f * r->dpiScale,
+              r->tabSelfW - 10.0f * r->dpiScale, r->tabSelfH, r->textSmall, (ID2D1Brush*)selfBrush, L"Self");
 
     // Advance layout start.
     r->tabsBottomY = y + tabH + (10.0f * r->dpiScale);
 }
 
+void Render_DrawStatusText(RenderD2D *r, const wchar_t *text)
+{
+    if (!r->rt || !text) return;
+
+    const float pad = 12.0f * r->dpiScale;
+    const float x = r->tabSelfX + r->tabSelfW + (24.0f * r->dpiScale);
+    const float w = (float)r->width - x - pad;
+    if (w <= 0.0f) return;
+
+    draw_text(r, x, r->tabSelfY + 1.0f * r->dpiScale, w, r->tabSelfH, r->textSmall, (ID2D1Brush*)r->brushDim, text);
+}
+
 static void fmt_bytes_gb(uint64_t bytes, wchar_t *out, uint32_t outCch)
 {
     if (!out || outCch == 0) return;
@@ -373,14 +436,7 @@ void Render_DrawValueGraph(RenderD2D *r, const RingBufF *history, const wchar_t
     const float left = pad + axisW;
     const float right = (float)r->width - pad;
 
-    float maxV = maxValue;
-    if (maxV <= 0.0f) {
-        for (uint32_t i = 0; i < history->count; i++) {
-            const float v = RingBuf_GetOldest(history, i);
-            if (v > maxV) maxV = v;
-        }
-        if (maxV < 1.0f) maxV = 1.0f;
-    }
+    const float maxV = (maxValue > 1.0f) ? maxValue : 1.0f;
 
     D2D1_RECT_F rect = { left, top, right, top + graphH };
 
@@ -400,20 +456,77 @@ void Render_DrawValueGraph(RenderD2D *r, const RingBufF *history, const wchar_t
     draw_text(r, left, baseTop + 2.0f * r->dpiScale, 520.0f * r->dpiScale, titleH,
               r->textSmall, (ID2D1Brush*)r->brushDim, title);
 
-    const float w = right - left;
-    D2D1_POINT_2F prev = { left, top + graphH };
-    for (uint32_t i = 0; i < history->count; i++) {
-        float v = RingBuf_GetOldest(history, i);
-        if (v < 0.0f) v = 0.0f;
-        if (v > maxV) v = maxV;
-        const float x = left + (w * (float)i / (float)(history->cap - 1));
-        const float yy = top + graphH - (graphH * (v / maxV));
-        D2D1_POINT_2F p = { x, yy };
-        if (i > 0) {
-            ID2D1RenderTarget_DrawLine(rt, prev, p, (ID2D1Brush*)r->brushGreen, 2.0f, NULL);
-        }
-        prev = p;
+    draw_series(r, history, left, right - left, top, graphH, maxV, (ID2D1Brush*)r->brushGreen, 2.0f);
+
+    ID2D1RenderTarget_DrawRectangle(rt, &rect, (ID2D1Brush*)r->brushGrid, 1.0f, NULL);
+    r->graphBottomY = top + graphH + (10.0f * r->dpiScale);
+}
+
+static float newest(const RingBufF *h)
+{
+    return h->count ? RingBuf_GetOldest(h, h->count - 1u) : 0.0f;
+}
+
+void Render_DrawWatchGraph(RenderD2D *r, const ProcWatchSeries *s, const wchar_t *name, double hz)
+{
+    if (!r->rt || !s) return;
+
+    ID2D1RenderTarget *rt = (ID2D1RenderTarget *)r->rt;
+    const float pad = 12.0f * r->dpiScale;
+    const float baseTop = (r->graphBottomY > 0.0f) ? r->graphBottomY :
+                          ((r->headerBottomY > 0.0f) ? r->headerBottomY :
+                           ((r->tabsBottomY > 0.0f) ? r->tabsBottomY : pad));
+    const float titleH = 18.0f * r->dpiScale;
+    const float titlePad = 6.0f * r->dpiScale;
+    const float top = baseTop + titleH + titlePad;
+    const float graphH = 110.0f * r->dpiScale;
+    const float axisW = 52.0f * r->dpiScale;
+    const float left = pad + axisW;
+    const float right = (float)r->width - pad;
+
+    D2D1_RECT_F rect = { left, top, right, top + graphH };
+
+    for (int i = 0; i <= 4; i++) {
+        const float yy = top + (graphH * (float)i / 4.0f);
+        D2D1_POINT_2F a = { left, yy };
+        D2D1_POINT_2F b = { right, yy };
+        ID2D1RenderTarget_DrawLine(rt, a, b, (ID2D1Brush*)r->brushGrid, 1.0f, NULL);
+
+        wchar_t lbl[16];
+        swprintf(lbl, 16, L"%d%%", 100 - (i * 25));
+        draw_text(r, pad, yy - 8.0f * r->dpiScale, axisW - 6.0f * r->dpiScale, 18.0f * r->dpiScale,
+                  r->textSmall, (ID2D1Brush*)r->brushDim, lbl);
+    }
+
+    // Latest values; the other series are scaled to their peak, given in the title.
+    wchar_t title[256];
+    int n = swprintf(title, (uint32_t)_countof(title), L"Watch %u %ls @ %.0f Hz | CPU %.1f%% | WS %.1f MB",
+                     (unsigned)s->pid, name ? name : L"", hz, newest(&s->cpuPct), newest(&s->workingSetMB));
+    const float wsMax = (s->workingSetPeakMB > 1.0f) ? s->workingSetPeakMB : 1.0f;
+    const float ioMax = (s->ioPeakMBps > 0.1f) ? s->ioPeakMBps : 0.1f;
+    const float csMax = (s->ctxPeakPerSec > 10.0f) ? s->ctxPeakPerSec : 10.0f;
+    if (n > 0 && s->hasIo) {
+        n += swprintf(title + n, (uint32_t)_countof(title) - (uint32_t)n, L" | I/O %.2f MB/s (peak %.2f)",
+                      newest(&s->ioMBps), ioMax);
     }
+    if (n > 0 && s->hasCtx) {
+        n += swprintf(title + n, (uint32_t)_countof(title) - (uint32_t)n, L" | cs/s %.0f (peak %.0f)",
+                      newest(&s->ctxPerSec), csMax);
+    }
+    if (n > 0 && (s->exited || s->failed)) {
+        swprintf(title + n, (uint32_t)_countof(title) - (uint32_t)n, s->failed ? L" | cannot open" : L" | exited");
+    }
+    draw_text(r, left, baseTop + 2.0f * r->dpiScale, right - left, titleH,
+              r->textSmall, (ID2D1Brush*)r->brushDim, title);
+
+    draw_series(r, &s->workingSetMB, left, right - left, top, graphH, wsMax, (ID2D1Brush*)r->brushDim, 1.0f);
+    if (s->hasIo) {
+        draw_series(r, &s->ioMBps, left, right - left, top, graphH, ioMax, (ID2D1Brush*)r->brushYellow, 1.0f);
+    }
+    if (s->hasCtx) {
+        draw_series(r, &s->ctxPerSec, left, right - left, top, graphH, csMax, (ID2D1Brush*)r->brushRed, 1.0f);
+    }
+    draw_series(r, &s->cpuPct, left, right - left, top, graphH, 100.0f, (ID2D1Brush*)r->brushGreen, 2.0f);
 
     ID2D1RenderTarget_DrawRectangle(rt, &rect, (ID2D1Brush*)r->brushGrid, 1.0f, NULL);
     r->graphBottomY = top + graphH + (10.0f * r->dpiScale);
@@ -454,22 +567,7 @@ static void draw_percent_graph_internal(RenderD2D *r, const RingBufF *history, c
     draw_text(r, left, baseTop + 2.0f * r->dpiScale, 320.0f * r->dpiScale, titleH,
               r->textSmall, (ID2D1Brush*)r->brushDim, title);
 
-    if (history->count >= 2) {
-        const uint32_t n = history->count;
-        const float w = right - left;
-
-        D2D1_POINT_2F prev = { left, top + graphH };
-        for (uint32_t i = 0; i < n; i++) {
-            const float pct = clamp01(RingBuf_GetOldest(history, i));
-            const float x = left + (w * (float)i / (float)(history->cap - 1));
-            const float yy = top + graphH - (graphH * pct / 100.0f);
-            D2D1_POINT_2F p = { x, yy };
-            if (i > 0) {
-                ID2D1RenderTarget_DrawLine(rt, prev, p, usage_brush(r, pct), 2.0f, NULL);
-            }
-            prev = p;
-        }
-    }
+    draw_series(r, history, left, right - left, top, graphH, 100.0f, NULL, 2.0f);
 
     ID2D1RenderTarget_DrawRectangle(rt, &rect, (ID2D1Brush*)r->brushGrid, 1.0f, NULL);
     r->graphBottomY = top + graphH + (10.0f * r->dpiScale);
@@ -480,7 +578,8 @@ void Render_DrawPercentGraph(RenderD2D *r, const RingBufF *history, const wchar_
     draw_percent_graph_internal(r, history, title);
 }
 
-void Render_DrawDiskGraph(RenderD2D *r, const RingBufF *readMBpsHistory, const RingBufF *writeMBpsHistory)
+void Render_DrawDiskGraph(RenderD2D *r, const RingBufF *readMBpsHistory, const RingBufF *writeMBpsHistory,
+                          float maxMBps)
 {
     if (!r->rt || !readMBpsHistory || !writeMBpsHistory) return;
     if (readMBpsHistory->count < 2 && writeMBpsHistory->count < 2) return;
@@ -496,17 +595,7 @@ void Render_DrawDiskGraph(RenderD2D *r, const RingBufF *readMBpsHistory, const R
     const float left = pad + axisW;
     const float right = (float)r->width - pad;
 
-    // Find max for scaling.
-    float maxV = 0.0f;
-    for (uint32_t i = 0; i < readMBpsHistory->count; i++) {
-        const float v = RingBuf_GetOldest(readMBpsHistory, i);
-        if (v > maxV) maxV = v;
-    }
-    for (uint32_t i = 0; i < writeMBpsHistory->count; i++) {
-        const float v = RingBuf_GetOldest(writeMBpsHistory, i);
-        if (v > maxV) maxV = v;
-    }
-    if (maxV < 1.0f) maxV = 1.0f;
+    const float maxV = (maxMBps > 1.0f) ? maxMBps : 1.0f;
 
     D2D1_RECT_F rect = { left, top, right, top + graphH };
 
@@ -530,33 +619,8 @@ void Render_DrawDiskGraph(RenderD2D *r, const RingBufF *readMBpsHistory, const R
     // Plot both series.
     const float w = right - left;
 
-    if (readMBpsHistory->count >= 2) {
-        D2D1_POINT_2F prev = { left, top + graphH };
-        for (uint32_t i = 0; i < readMBpsHistory->count; i++) {
-            const float v = RingBuf_GetOldest(readMBpsHistory, i);
-            const float x = left + (w * (float)i / (float)(readMBpsHistory->cap - 1));
-            const float yy = top + graphH - (graphH * (v / maxV));
-            D2D1_POINT_2F p = { x, yy };
-            if (i > 0) {
-                ID2D1RenderTarget_DrawLine(rt, prev, p, (ID2D1Brush*)r->brushGreen, 2.0f, NULL);
-            }
-            prev = p;
-        }
-    }
-
-    if (writeMBpsHistory->count >= 2) {
-        D2D1_POINT_2F prev = { left, top + graphH };
-        for (uint32_t i = 0; i < writeMBpsHistory->count; i++) {
-            const float v = RingBuf_GetOldest(writeMBpsHistory, i);
-            const float x = left + (w * (float)i / (float)(writeMBpsHistory->cap - 1));
-            const float yy = top + graphH - (graphH * (v / maxV));
-            D2D1_POINT_2F p = { x, yy };
-            if (i > 0) {
-                ID2D1RenderTarget_DrawLine(rt, prev, p, (ID2D1Brush*)r->brushYellow, 2.0f, NULL);
-            }
-            prev = p;
-        }
-    }
+    draw_series(r, readMBpsHistory, left, w, top, graphH, maxV, (ID2D1Brush*)r->brushGreen, 2.0f);
+    draw_series(r, writeMBpsHistory, left, w, top, graphH, maxV, (ID2D1Brush*)r->brushYellow, 2.0f);
 
     ID2D1RenderTarget_DrawRectangle(rt, &rect, (ID2D1Brush*)r->brushGrid, 1.0f, NULL);
     r->graphBottomY = top + graphH + (10.0f * r->dpiScale);
@@ -598,24 +662,10 @@ void Render_DrawDisksGraph(RenderD2D *r, const RenderDiskSeries *disks, uint32_t
     if (rowH > maxRowH) rowH = maxRowH;
 
     // Determine global max for scaling (MB/s).
-    float maxV = 0.0f;
+    float maxV = 1.0f;
     for (uint32_t d = 0; d < diskCount; d++) {
-        const RingBufF *rh = disks[d].readMBpsHistory;
-        const RingBufF *wh = disks[d].writeMBpsHistory;
-        if (rh) {
-            for (uint32_t i = 0; i < rh->count; i++) {
-                const float v = RingBuf_GetOldest(rh, i);
-                if (v > maxV) maxV = v;
-            }
-        }
-        if (wh) {
-            for (uint32_t i = 0; i < wh->count; i++) {
-                const float v = RingBuf_GetOldest(wh, i);
-                if (v > maxV) maxV = v;
-            }
-        }
+        if (disks[d].peakMBps > maxV) maxV = disks[d].peakMBps;
     }
-    if (maxV < 1.0f) maxV = 1.0f;
 
     // Draw each disk as a small sparkline pair.
     for (uint32_t d = 0; d < diskCount; d++) {
@@ -648,33 +698,13 @@ void Render_DrawDisksGraph(RenderD2D *r, const RenderDiskSeries *disks, uint32_t
         const RingBufF *wh = disks[d].writeMBpsHistory;
 
         // Read (green) - top half
-        if (rh && rh->count >= 2) {
-            D2D1_POINT_2F prev = { left, gTopRead + halfH };
-            for (uint32_t i = 0; i < rh->count; i++) {
-                const float v = RingBuf_GetOldest(rh, i);
-                const float x = left + graphW * (float)i / (float)(rh->cap - 1);
-                const float yy = gTopRead + halfH - (halfH * (v / maxV));
-                D2D1_POINT_2F p = { x, yy };
-                if (i > 0) {
-                    ID2D1RenderTarget_DrawLine(rt, prev, p, (ID2D1Brush*)r->brushGreen, 2.0f, NULL);
-                }
-                prev = p;
-            }
+        if (rh) {
+            draw_series(r, rh, left, graphW, gTopRead, halfH, maxV, (ID2D1Brush*)r->brushGreen, 2.0f);
         }
 
         // Write (yellow) - bottom half
-        if (wh && wh->count >= 2) {
-            D2D1_POINT_2F prev = { left, gTopWrite + halfH };
-            for (uint32_t i = 0; i < wh->count; i++) {
-                const float v = RingBuf_GetOldest(wh, i);
-                const float x = left + graphW * (float)i / (float)(wh->cap - 1);
-                const float yy = gTopWrite + halfH - (halfH * (v / maxV));
-                D2D1_POINT_2F p = { x, yy };
-                if (i > 0) {
-                    ID2D1RenderTarget_DrawLine(rt, prev, p, (ID2D1Brush*)r->brushYellow, 2.0f, NULL);
-                }
-                prev = p;
-            }
+        if (wh) {
+            draw_series(r, wh, left, graphW, gTopWrite, halfH, maxV, (ID2D1Brush*)r->brushYellow, 2.0f);
         }
 
         y += rowH;
@@ -907,25 +937,7 @@ void Render_DrawUsageGraph(RenderD2D *r, const RingBufF *history)
         return;
     }
 
-    const uint32_t n = history->count;
-    const float w = right - left;
-
-    D2D1_POINT_2F prev;
-    prev.x = left;
-    prev.y = top + graphH;
-
-    for (uint32_t i = 0; i < n; i++) {
-        const float pct = clamp01(RingBuf_GetOldest(history, i));
-        const float x = left + (w * (float)i / (float)(history->cap - 1));
-        const float y = top + graphH - (graphH * pct / 100.0f);
-        D2D1_POINT_2F p;
-        p.x = x;
-        p.y = y;
-        if (i > 0) {
-            ID2D1RenderTarget_DrawLine(rt, prev, p, usage_brush(r, pct), 2.0f, NULL);
-        }
-        prev = p;
-    }
+    draw_series(r, history, left, right - left, top, graphH, 100.0f, NULL, 2.0f);
 
     // border
     ID2D1RenderTarget_DrawRectangle(rt, &rect, (ID2D1Brush*)r->brushGrid, 1.0f, NULL);
@@ -937,7 +949,8 @@ void Render_DrawPerCore(RenderD2D *r,
                         uint32_t logicalCount,
                         const float *coreUsage,
                         const float *coreMHz,
-                        const RingBufF *coreHistory)
+                        const RingBufSpans *coreHistory,
+                        uint32_t historyCap)
 {
     if (!r->rt || !coreUsage || logicalCount == 0) return;
 
@@ -989,29 +1002,10 @@ void Render_DrawPerCore(RenderD2D *r,
 
         // optional mini history sparkline
         if (coreHistory) {
-            const RingBufF *h = &coreHistory[i];
-            if (h->count > 1) {
-                const float sparkH = barH;
-                const float sparkTop = y;
-                const float sparkLeft = pad + labelW + barW - 140.0f * r->dpiScale;
-                const float sparkRight = pad + labelW + barW;
-
-                D2D1_POINT_2F prev;
-                prev.x = sparkLeft;
-                prev.y = sparkTop + sparkH;
-                for (uint32_t s = 0; s < h->count; s++) {
-                    float sp = clamp01(RingBuf_GetOldest(h, s));
-                    float x = sparkLeft + (sparkRight - sparkLeft) * (float)s / (float)(h->cap - 1);
-                    float yy = sparkTop + sparkH - (sparkH * sp / 100.0f);
-                    D2D1_POINT_2F p;
-                    p.x = x;
-                    p.y = yy;
-                    if (s > 0) {
-                        ID2D1RenderTarget_DrawLine(rt, prev, p, (ID2D1Brush*)r->brushDim, 1.0f, NULL);
-                    }
-                    prev = p;
-                }
-            }
+            const float sparkLeft = pad + labelW + barW - 140.0f * r->dpiScale;
+            const float sparkRight = pad + labelW + barW;
+            draw_spans(r, &coreHistory[i], historyCap, sparkLeft, sparkRight - sparkLeft, y, barH, 100.0f,
+                       (ID2D1Brush*)r->brushDim, 1.0f);
         }
 
         y += barH + gap;
@@ -1021,9 +1015,58 @@ void Render_DrawPerCore(RenderD2D *r,
     r->graphBottomY = y + (8.0f * r->dpiScale);
 }
 
+void Render_DrawSelfStats(RenderD2D *r,
+                          const SelfStats *const *sets,
+                          const wchar_t *const *setNames,
+                          uint32_t setCount,
+                          float reserveBottom)
+{
+    if (!r->rt || !sets) return;
+
+    const float pad = 12.0f * r->dpiScale;
+    const float rowH = 16.0f * r->dpiScale;
+    const float w = (float)r->width - 2 * pad;
+    const float bottom = (float)r->height - reserveBottom;
+    float y = (r->tabsBottomY > 0.0f) ? r->tabsBottomY : pad;
+
+    draw_text(r, pad, y, w, 26.0f * r->dpiScale, r->text, (ID2D1Brush*)r->brushText, L"Self (CCM's own cost)");
+    y += 22.0f * r->dpiScale;
+
+    wchar_t line[192];
+    swprintf(line, 192, L"%-22ls %9ls %10ls %10ls %10ls %9ls %7ls",
+             L"Stage", L"calls", L"p50 us", L"p99 us", L"max us", L"allocs", L"max");
+    draw_text(r, pad, y, w, rowH + 4.0f * r->dpiScale, r->textSmall, (ID2D1Brush*)r->brushDim, line);
+    y += rowH;
+
+    for (uint32_t si = 0; si < setCount; si++) {
+        const SelfStats *set = sets[si];
+        if (!set) continue;
+        if (y + rowH > bottom) break;
+
+        draw_text(r, pad, y, w, rowH + 4.0f * r->dpiScale, r->textSmall, (ID2D1Brush*)r->brushText,
+                  (setNames && setNames[si]) ? setNames[si] : L"");
+        y += rowH;
+
+        for (uint32_t i = 0; i < set->stageCount; i++) {
+            if (y + rowH > bottom) break;
+
+            SelfStageSummary sum;
+            SelfStats_Summarize(&set->stages[i], &sum);
+            swprintf(line, 192, L"  %-20ls %9llu %10.1f %10.1f %10.1f %9.1f %7u",
+                     set->stages[i].name, (unsigned long long)sum.count,
+                     sum.p50Us, sum.p99Us, sum.maxUs, sum.allocsPerCall, (unsigned)sum.allocMax);
+            draw_text(r, pad, y, w, rowH + 4.0f * r->dpiScale, r->textSmall, (ID2D1Brush*)r->brushDim, line);
+            y += rowH;
+        }
+    }
+
+    r->graphBottomY = y + (10.0f * r->dpiScale);
+}
+
 void Render_DrawProcessTable(RenderD2D *r,
                              const ProcRow *rows,
                              uint32_t rowCount,
+                             const StrPool *strings,
                              uint32_t totalRunningCount,
                              bool stacked,
                              uint32_t scrollRow,
@@ -1166,10 +1209,12 @@ void Render_DrawProcessTable(RenderD2D *r,
         swprintf(cpu, 24, L"%.1f", pr->cpuPct);
         swprintf(mem, 24, L"%.1f", (double)pr->workingSetBytes / (1024.0 * 1024.0));
 
-        const wchar_t *owner = pr->owner[0] ? pr->owner : L"";
-        const wchar_t *net = pr->hasNet ? pr->netRemote : L"";
-        const wchar_t *name = pr->name[0] ? pr->name : L"";
-        const wchar_t *path = pr->path[0] ? pr->path : L"";
+        const wchar_t *owner = StrPool_Get(strings, pr->ownerId);
+        const wchar_t *path = StrPool_Get(strings, pr->pathId);
+        wchar_t net[80];
+        ProcView_RowNet(pr, strings, net, sizeof(net) / sizeof(net[0]));
+        wchar_t name[96];
+        ProcView_RowName(pr, strings, name, sizeof(name) / sizeof(name[0]));
 
         x = left + 6.0f * r->dpiScale;
         draw_text(r, x, y, colPid, rowH, r->textSmall, (ID2D1Brush*)r->brushDim, pid);
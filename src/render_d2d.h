@@ -16,6 +16,8 @@
 #include "pdh_counters.h"
 #include "etw_kernel.h"
 #include "proc_table.h"
+#include "proc_watch.h"
+#include "self_stats.h"
 
 typedef struct RenderD2D {
     HWND hwnd;
@@ -56,6 +58,10 @@ typedef struct RenderD2D {
     float tabGpuY;
     float tabGpuW;
     float tabGpuH;
+    float tabSelfX;
+    float tabSelfY;
+    float tabSelfW;
+    float tabSelfH;
 
     // Process table layout (from last draw) for input hit-testing
     float procTableX;
@@ -86,6 +92,8 @@ void Render_End(RenderD2D *r);
 
 // UI tabs
 void Render_DrawTabs(RenderD2D *r, int activeTab);
+// Dim status line to the right of the tabs (call after Render_DrawTabs).
+void Render_DrawStatusText(RenderD2D *r, const wchar_t *text);
 
 void Render_DrawHeader(RenderD2D *r,
                        const CpuStaticInfo *cpu,
@@ -114,7 +122,9 @@ void Render_DrawMemoryHeader(RenderD2D *r,
                              double diskWriteMBps);
 
 void Render_DrawPercentGraph(RenderD2D *r, const RingBufF *history, const wchar_t *title);
-void Render_DrawDiskGraph(RenderD2D *r, const RingBufF *readMBpsHistory, const RingBufF *writeMBpsHistory);
+// maxMBps: peak of both series over the window (from WindowStats); the scale top.
+void Render_DrawDiskGraph(RenderD2D *r, const RingBufF *readMBpsHistory, const RingBufF *writeMBpsHistory,
+                          float maxMBps);
 
 // GPU tab
 void Render_DrawGpuHeader(RenderD2D *r,
@@ -127,16 +137,21 @@ void Render_DrawGpuHeader(RenderD2D *r,
                           double sharedUsedMB,
                           double sharedLimitMB);
 
-// Generic single-series graph (best-effort) with a fixed max scale.
-// Used for GPU memory usage (MB).
+// Generic single-series graph (best-effort) scaled to maxValue (at least 1): a fixed
+// limit, or the series' window peak. Used for GPU memory usage (MB).
 void Render_DrawValueGraph(RenderD2D *r, const RingBufF *history, const wchar_t *title, float maxValue);
 
+// Detail graph of one watched process (proc_watch.h): CPU% on a 0-100 scale, working
+// set, I/O and context switch rate each scaled to their own peak. name may be NULL.
+void Render_DrawWatchGraph(RenderD2D *r, const ProcWatchSeries *s, const wchar_t *name, double hz);
+
 typedef struct RenderDiskSeries {
     const wchar_t *name;
     const RingBufF *readMBpsHistory;
     const RingBufF *writeMBpsHistory;
     double readMBps;
     double writeMBps;
+    float peakMBps; // max of read/write over the history window
 } RenderDiskSeries;
 
 void Render_DrawDisksGraph(RenderD2D *r, const RenderDiskSeries *disks, uint32_t diskCount);
@@ -145,11 +160,22 @@ void Render_DrawPerCore(RenderD2D *r,
                     uint32_t logicalCount,
                     const float *coreUsage,
                     const float *coreMHz,
-                    const RingBufF *coreHistory);
-
+                    const RingBufSpans *coreHistory, // per core; NULL = no sparklines
+                    uint32_t historyCap);
+
+// Self tab: p50/p99/max latency and allocations per call for every stage in each set.
+// Rows stop reserveBottom pixels above the window bottom (room for the process table).
+void Render_DrawSelfStats(RenderD2D *r,
+                          const SelfStats *const *sets,
+                          const wchar_t *const *setNames,
+                          uint32_t setCount,
+                          float reserveBottom);
+
+// rows name their strings in strings (the table's pool).
 void Render_DrawProcessTable(RenderD2D *r,
                         const ProcRow *rows,
                         uint32_t rowCount,
+                        const StrPool *strings,
                         uint32_t totalRunningCount,
                         bool stacked,
                         uint32_t scrollRow,
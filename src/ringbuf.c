@@ -3,48 +3,159 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Initializes a ring buffer with the given capacity.
-bool RingBuf_Init(RingBufF *rb, uint32_t capacity)
+#include "self_stats.h"
+#include "sys_thread.h"
+
+static volatile uint32_t g_nextId;
+
+static uint32_t storage_for(uint32_t capacity)
+{
+    uint32_t n = 1;
+    while (n < capacity && n < 0x80000000u) {
+        n <<= 1;
+    }
+    return n;
+}
+
+static void init_cursor(RingBufF *rb, uint32_t capacity, uint32_t slots)
+{
+    rb->cap = capacity;
+    rb->mask = slots - 1u;
+    rb->count = 0;
+    rb->head = 0;
+    rb->id = Atomic_AddU32(&g_nextId, 1u);
+    if (rb->id == 0) {
+        rb->id = Atomic_AddU32(&g_nextId, 1u); // 0 never matches a live ring
+    }
+}
+
+static bool init_ring(RingBufF *rb, uint32_t capacity, bool timed)
 {
     memset(rb, 0, sizeof(*rb));
     if (capacity == 0) {
         return false;
     }
-    rb->data = (float *)calloc(capacity, sizeof(float));
-    if (!rb->data) {
+    const uint32_t slots = storage_for(capacity);
+    rb->data = (float *)calloc(slots, sizeof(float));
+    rb->ts = timed ? (int64_t *)calloc(slots, sizeof(int64_t)) : NULL;
+    if (!rb->data || (timed && !rb->ts)) {
+        free(rb->data);
+        free(rb->ts);
+        memset(rb, 0, sizeof(*rb));
         return false;
     }
-    rb->cap = capacity;
-    rb->count = 0;
-    rb->head = 0;
+    SelfStats_NoteAlloc();
+    init_cursor(rb, capacity, slots);
+    return true;
+}
+
+// Initializes a ring buffer with the given capacity.
+bool RingBuf_Init(RingBufF *rb, uint32_t capacity)
+{
+    return init_ring(rb, capacity, true);
+}
+
+bool RingBuf_InitUntimed(RingBufF *rb, uint32_t capacity)
+{
+    return init_ring(rb, capacity, false);
+}
+
+bool RingBuf_InitBorrowed(RingBufF *rb, uint32_t capacity, float *data, int64_t *ts)
+{
+    memset(rb, 0, sizeof(*rb));
+    if (capacity == 0 || !data) {
+        return false;
+    }
+    rb->data = data;
+    rb->ts = ts;
+    rb->borrowed = true;
+    init_cursor(rb, capacity, storage_for(capacity));
     return true;
 }
+
+uint32_t RingBuf_StorageSlots(uint32_t capacity)
+{
+    return storage_for(capacity);
+}
+
 // Shuts down the ring buffer and frees resources.
 void RingBuf_Shutdown(RingBufF *rb)
 {
-    free(rb->data);
+    if (!rb->borrowed) {
+        free(rb->data);
+        free(rb->ts);
+    }
     memset(rb, 0, sizeof(*rb));
 }
 
 void RingBuf_Push(RingBufF *rb, float v)
+{
+    RingBuf_PushAt(rb, v, 0);
+}
+
+void RingBuf_PushAt(RingBufF *rb, float v, int64_t t)
 {
     if (!rb || !rb->data || rb->cap == 0) {
         return;
     }
     rb->data[rb->head] = v;
-    rb->head = (rb->head + 1) % rb->cap;
+    if (rb->ts) {
+        rb->ts[rb->head] = t;
+    }
+    rb->head = (rb->head + 1u) & rb->mask;
+    rb->pushes++;
     if (rb->count < rb->cap) {
         rb->count++;
     }
 }
-// Helper to get the index of the oldest element.
-static uint32_t oldest_index(const RingBufF *rb)
+// Copies n slots starting at slot `from`, wrapping at the end of storage.
+static void copy_slots(RingBufF *dst, const RingBufF *src, uint32_t from, uint32_t n)
 {
-    // head points to next write; oldest is head when full, else 0
-    if (rb->count < rb->cap) {
-        return 0;
+    while (n > 0) {
+        const uint32_t run = (n < src->mask + 1u - from) ? n : src->mask + 1u - from;
+        memcpy(dst->data + from, src->data + from, (size_t)run * sizeof(float));
+        if (src->ts) {
+            memcpy(dst->ts + from, src->ts + from, (size_t)run * sizeof(int64_t));
+        }
+        n -= run;
+        from = 0;
     }
-    return rb->head;
+}
+
+// Copies contents and cursor; dst is reallocated if its capacity differs.
+bool RingBuf_CopyFrom(RingBufF *dst, const RingBufF *src)
+{
+    if (!dst || !src) {
+        return false;
+    }
+    if (dst->cap != src->cap || !dst->data || (dst->ts == NULL) != (src->ts == NULL)) {
+        RingBuf_Shutdown(dst);
+        if (src->cap == 0 || !src->data) {
+            return true;
+        }
+        if (!init_ring(dst, src->cap, src->ts != NULL)) {
+            return false;
+        }
+    }
+    const uint32_t slots = src->mask + 1u;
+    const uint64_t fresh = src->pushes - dst->pushes;
+    if (dst->id == src->id && dst->pushes <= src->pushes && fresh < slots) {
+        // dst is an older copy of src: only the newest pushes differ.
+        copy_slots(dst, src, (src->head - (uint32_t)fresh) & src->mask, (uint32_t)fresh);
+    } else {
+        copy_slots(dst, src, 0, slots);
+    }
+    dst->count = src->count;
+    dst->head = src->head;
+    dst->id = src->id;
+    dst->pushes = src->pushes;
+    return true;
+}
+// Slot of the i-th oldest element (i < count).
+static uint32_t oldest_slot(const RingBufF *rb, uint32_t i)
+{
+    // head points to next write; the oldest is count slots behind it
+    return (rb->head - rb->count + i) & rb->mask;
 }
 
 float RingBuf_GetOldest(const RingBufF *rb, uint32_t i)
@@ -55,7 +166,47 @@ float RingBuf_GetOldest(const RingBufF *rb, uint32_t i)
     if (i >= rb->count) {
         i = rb->count - 1;
     }
-    const uint32_t start = oldest_index(rb);
-    const uint32_t idx = (start + i) % rb->cap;
-    return rb->data[idx];
+    return rb->data[oldest_slot(rb, i)];
+}
+
+int64_t RingBuf_GetOldestTime(const RingBufF *rb, uint32_t i)
+{
+    if (!rb || !rb->ts || rb->count == 0) {
+        return 0;
+    }
+    if (i >= rb->count) {
+        i = rb->count - 1;
+    }
+    return rb->ts[oldest_slot(rb, i)];
+}
+
+uint32_t RingBuf_GetSpans(const RingBufF *rb, RingBufSpans *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->stride = 1u;
+    if (!rb || !rb->data || rb->count == 0) {
+        return 0;
+    }
+    const uint32_t start = oldest_slot(rb, 0);
+    const uint32_t tail = rb->mask + 1u - start; // slots from start to the end of storage
+    out->a = rb->data + start;
+    out->aCount = (rb->count < tail) ? rb->count : tail;
+    out->b = rb->data;
+    out->bCount = rb->count - out->aCount;
+    return rb->count;
+}
+
+static float span_max(const float *v, uint32_t n, float m)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        m = (v[i] > m) ? v[i] : m;
+    }
+    return m;
+}
+
+float RingBuf_Max(const RingBufF *rb, float floor)
+{
+    RingBufSpans s;
+    RingBuf_GetSpans(rb, &s);
+    return span_max(s.b, s.bCount, span_max(s.a, s.aCount, floor));
 }
@@ -3,16 +3,55 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+// Fixed-capacity float history.
+//
+// cap is the logical capacity (how many samples a graph spans); storage is rounded up
+// to a power of two so advancing the head is a mask, and the live samples form at most
+// two contiguous runs that loops can walk as plain arrays (RingBuf_GetSpans).
 typedef struct RingBufF {
     float *data;
+    int64_t *ts; // sample time (Qpc_Now() ticks) per slot; 0 when pushed without one; NULL if untimed
     uint32_t cap;
+    uint32_t mask; // storage slots - 1
     uint32_t count;
-    uint32_t head;
+    uint32_t head; // next write slot
+    uint32_t id;     // unique per RingBuf_Init; copies carry their source's id
+    uint64_t pushes; // total pushes since init
+    bool borrowed;   // data/ts owned by someone else (RingBuf_InitBorrowed)
 } RingBufF;
 
+// The history oldest first: aCount samples from a, then bCount from b, stride floats
+// apart (1 for a RingBufF; strided views come from matrix stores such as CoreHistory).
+// Points into the buffer; valid until the next push.
+typedef struct RingBufSpans {
+    const float *a;
+    const float *b;
+    uint32_t aCount;
+    uint32_t bCount;
+    uint32_t stride;
+} RingBufSpans;
+
 bool RingBuf_Init(RingBufF *rb, uint32_t capacity);
+// Like RingBuf_Init without per-sample timestamps (GetOldestTime returns 0).
+bool RingBuf_InitUntimed(RingBufF *rb, uint32_t capacity);
+// Like RingBuf_Init on caller-owned storage of RingBuf_StorageSlots(capacity) floats and
+// timestamps (a mapped history file). The ring starts empty; Shutdown leaves it alone.
+bool RingBuf_InitBorrowed(RingBufF *rb, uint32_t capacity, float *data, int64_t *ts);
+uint32_t RingBuf_StorageSlots(uint32_t capacity);
 void RingBuf_Shutdown(RingBufF *rb);
 void RingBuf_Push(RingBufF *rb, float v);
+// Pushes v stamped with the time it was actually sampled.
+void RingBuf_PushAt(RingBufF *rb, float v, int64_t t);
+
+// Copies src into dst, (re)allocating dst when capacities differ. When dst is an earlier
+// copy of src, only the samples pushed since are copied.
+bool RingBuf_CopyFrom(RingBufF *dst, const RingBufF *src);
 
 // Gets i-th oldest element, where i=0 is oldest.
 float RingBuf_GetOldest(const RingBufF *rb, uint32_t i);
+int64_t RingBuf_GetOldestTime(const RingBufF *rb, uint32_t i);
+
+// Zero-copy view of the history. Returns the sample count (aCount + bCount).
+uint32_t RingBuf_GetSpans(const RingBufF *rb, RingBufSpans *out);
+// Largest sample, or floor if every sample is below it (or the buffer is empty).
+float RingBuf_Max(const RingBufF *rb, float floor);
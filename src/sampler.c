@@ -0,0 +1,339 @@
+#include "sampler.h"
+
+#include <string.h>
+
+#include "qpc.h"
+
+#define SAMPLER_FRESH_BIT 0x4u
+#define SAMPLER_INDEX_MASK 0x3u
+
+static void publish(Sampler *s, double collectMs)
+{
+    MonitorFrame *f = &s->frames[s->backIdx];
+    const SelfTimer t = SelfStats_Begin();
+    (void)MonitorFrame_Capture(f, &s->mon);
+    SelfStats_End(&s->mon.self, s->stageCapture, &t);
+    f->seq = ++s->publishCount;
+    f->sampleQpc = Qpc_Now();
+    f->collectMs = collectMs;
+
+    const uint32_t prev = Atomic_ExchangeU32(&s->latest, s->backIdx | SAMPLER_FRESH_BIT);
+    s->backIdx = prev & SAMPLER_INDEX_MASK;
+}
+
+static bool apply_settings(Sampler *s)
+{
+    SysMutex_Lock(&s->settingsLock);
+    const bool changed = (s->settingsApplied != s->settingsSeq);
+    if (changed) {
+        s->mon.procView.settings = s->settings;
+        s->settingsApplied = s->settingsSeq;
+    }
+    SysMutex_Unlock(&s->settingsLock);
+
+    if (changed) {
+        Monitor_RefreshProcView(&s->mon);
+    }
+    return changed;
+}
+
+static void stop_recording(Sampler *s)
+{
+    if (s->mon.recorder) {
+        Recorder_End(&s->recorder);
+        s->mon.recorder = NULL;
+        Atomic_StoreU32(&s->recording, 0u);
+    }
+}
+
+static void apply_recording(Sampler *s)
+{
+    SysMutex_Lock(&s->settingsLock);
+    const bool pending = s->recordPending;
+    FILE *f = s->recordFile;
+    s->recordPending = false;
+    s->recordFile = NULL;
+    SysMutex_Unlock(&s->settingsLock);
+
+    if (!pending) return;
+
+    stop_recording(s);
+    if (f && Recorder_Begin(&s->recorder, f, &s->mon.snap, Qpc_Now(), Qpc_Freq())) {
+        s->mon.recorder = &s->recorder;
+        Atomic_StoreU32(&s->recording, 1u);
+    }
+}
+
+static uint32_t sampler_main(void *arg)
+{
+    Sampler *s = (Sampler *)arg;
+
+    const bool ok = Monitor_Init(&s->mon, s->logicalCount, s->histCap, s->collectors, s->collectorCount);
+    if (ok && s->historyFile) {
+        (void)Monitor_AttachHistoryFile(&s->mon, s->historyFile, Qpc_Now()); // best-effort
+    } else if (s->historyFile) {
+        fclose(s->historyFile);
+    }
+    s->historyFile = NULL;
+    if (ok) {
+        s->stageCapture = SelfStats_AddStage(&s->mon.self, L"frame capture");
+        (void)apply_settings(s);
+        publish(s, 0.0);
+    }
+    Atomic_StoreU32(&s->initOk, ok ? 1u : 0u);
+    SysEvent_Signal(&s->ready);
+
+    if (!ok) {
+        Monitor_Shutdown(&s->mon);
+        return 1;
+    }
+
+    const double freq = Qpc_Freq();
+    Monitor_StartSchedule(&s->mon, (double)s->intervalMs / 1000.0, Qpc_Now());
+    const int64_t flushTicks = (int64_t)(SAMPLER_HISTORY_FLUSH_SEC * freq);
+    int64_t lastFlush = Qpc_Now();
+
+    while (!Atomic_LoadU32(&s->stop)) {
+        bool dirty = apply_settings(s);
+        apply_recording(s);
+
+        // Each collector runs on its own period/phase; a tick samples only the due ones.
+        const int64_t now = Qpc_Now();
+        double collectMs = 0.0;
+        if (Monitor_Tick(&s->mon, now) != 0) {
+            collectMs = Qpc_Seconds(Qpc_Now() - now, freq) * 1000.0;
+            dirty = true;
+        }
+
+        if (dirty) {
+            publish(s, collectMs);
+        }
+        if (now - lastFlush >= flushTicks) {
+            Monitor_FlushHistoryFile(&s->mon, now);
+            lastFlush = now;
+        }
+
+        const double remain = Qpc_Seconds(Monitor_NextDueQpc(&s->mon, now) - Qpc_Now(), freq);
+        const uint32_t waitMs = (remain > 0.0) ? (uint32_t)(remain * 1000.0) + 1u : 0u;
+        if (waitMs > 0) {
+            (void)SysEvent_Wait(&s->wake, waitMs);
+        }
+    }
+
+    stop_recording(s);
+    Monitor_Shutdown(&s->mon);
+    return 0;
+}
+
+static uint32_t replay_main(void *arg)
+{
+    Sampler *s = (Sampler *)arg;
+
+    // No collectors: the Monitor's snapshot is filled from the capture.
+    bool ok = Monitor_Init(&s->mon, s->replay.logicalCount, s->histCap, NULL, 0);
+    if (ok) {
+        Replay_PublishShape(&s->replay, &s->mon.snap);
+        Monitor_InitDeviceSeries(&s->mon);
+        s->stageCapture = SelfStats_AddStage(&s->mon.self, L"frame capture");
+        s->stageReplay = SelfStats_AddStage(&s->mon.self, L"replay decode");
+        (void)apply_settings(s);
+        publish(s, 0.0);
+    }
+    Atomic_StoreU32(&s->initOk, ok ? 1u : 0u);
+    SysEvent_Signal(&s->ready);
+
+    if (!ok) {
+        Monitor_Shutdown(&s->mon);
+        return 1;
+    }
+
+    const double freq = Qpc_Freq();
+    const int64_t start = Qpc_Now();
+    ReplayTick tick;
+    bool pending = false;
+
+    while (!Atomic_LoadU32(&s->stop)) {
+        bool dirty = apply_settings(s);
+        uint32_t waitMs = 0;
+
+        if (!Atomic_LoadU32(&s->replayDone)) {
+            if (!pending) {
+                pending = Replay_Next(&s->replay, &tick);
+                if (!pending) {
+                    Atomic_StoreU32(&s->replayDone, 1u);
+                }
+            }
+        }
+
+        if (pending) {
+            // Recorded time compressed by the speed factor; histories are stamped with
+            // the replay clock so series stay evenly spaced at any speed.
+            const int64_t now = Qpc_Now();
+            const int64_t due = (s->replaySpeed > 0.0)
+                                    ? start + (int64_t)((double)tick.tNs * 1e-9 / s->replaySpeed * freq)
+                                    : now;
+            if (due <= now) {
+                const SelfTimer t = SelfStats_Begin();
+                const bool decoded = Replay_Decode(&s->replay, &s->mon.snap);
+                SelfStats_End(&s->mon.self, s->stageReplay, &t);
+                pending = false;
+
+                if (decoded) {
+                    Monitor_Apply(&s->mon, tick.sections, due, tick.freqDt);
+                    dirty = true;
+                } else {
+                    Atomic_StoreU32(&s->replayDone, 1u);
+                }
+            } else {
+                waitMs = (uint32_t)(Qpc_Seconds(due - now, freq) * 1000.0) + 1u;
+            }
+        } else if (Atomic_LoadU32(&s->replayDone)) {
+            waitMs = 0xFFFFFFFFu; // idle until a settings change or stop
+        }
+
+        if (dirty) {
+            publish(s, 0.0);
+        }
+        if (waitMs > 0) {
+            (void)SysEvent_Wait(&s->wake, waitMs);
+        }
+    }
+
+    Monitor_Shutdown(&s->mon);
+    return 0;
+}
+
+static bool start_thread(Sampler *s, SysThreadFn fn)
+{
+    // Frame 0 is the reader's, 1 the sampler's back buffer, 2 starts as "latest".
+    s->frontIdx = 0;
+    s->backIdx = 1;
+    s->latest = 2;
+
+    ProcViewSettings_Init(&s->settings);
+    s->settingsSeq = 1; // apply defaults once
+
+    if (!SysMutex_Init(&s->settingsLock) || !SysEvent_Init(&s->wake) || !SysEvent_Init(&s->ready)) {
+        return false;
+    }
+
+    if (!SysThread_Start(&s->thread, fn, s)) {
+        return false;
+    }
+
+    SysEvent_Wait(&s->ready, 0xFFFFFFFFu);
+    if (!Atomic_LoadU32(&s->initOk)) {
+        SysThread_Join(&s->thread);
+        return false;
+    }
+    return true;
+}
+
+bool Sampler_Start(Sampler *s, uint32_t logicalCount, uint32_t histCap,
+                   const CollectorOps *const *collectors, uint32_t collectorCount,
+                   double intervalSec, FILE *historyFile)
+{
+    memset(s, 0, sizeof(*s));
+    s->historyFile = historyFile;
+    s->logicalCount = logicalCount;
+    s->histCap = histCap;
+    s->collectors = collectors;
+    s->collectorCount = collectorCount;
+    s->intervalMs = (uint32_t)(intervalSec * 1000.0);
+    return start_thread(s, sampler_main);
+}
+
+bool Sampler_StartReplay(Sampler *s, uint32_t histCap, FILE *f, double speed)
+{
+    memset(s, 0, sizeof(*s));
+    if (!Replay_Open(&s->replay, f)) {
+        return false;
+    }
+    s->replayMode = true;
+    s->logicalCount = s->replay.logicalCount;
+    s->histCap = histCap;
+    s->replaySpeed = speed;
+    return start_thread(s, replay_main);
+}
+
+void Sampler_Stop(Sampler *s)
+{
+    if (!s) return;
+
+    if (s->thread.handle) {
+        Atomic_StoreU32(&s->stop, 1u);
+        SysEvent_Signal(&s->wake);
+        SysThread_Join(&s->thread);
+    }
+
+    for (uint32_t i = 0; i < SAMPLER_FRAME_COUNT; i++) {
+        MonitorFrame_Shutdown(&s->frames[i]);
+    }
+
+    if (s->recordFile) {
+        fclose(s->recordFile); // requested but never picked up
+    }
+    if (s->historyFile) {
+        fclose(s->historyFile); // the thread never started
+    }
+    Replay_Close(&s->replay);
+
+    SysEvent_Shutdown(&s->ready);
+    SysEvent_Shutdown(&s->wake);
+    SysMutex_Shutdown(&s->settingsLock);
+    memset(s, 0, sizeof(*s));
+}
+
+const MonitorFrame *Sampler_AcquireFrame(Sampler *s, bool *outIsNew)
+{
+    bool isNew = false;
+    if (Atomic_LoadU32(&s->latest) & SAMPLER_FRESH_BIT) {
+        const uint32_t prev = Atomic_ExchangeU32(&s->latest, s->frontIdx);
+        s->frontIdx = prev & SAMPLER_INDEX_MASK;
+        isNew = true;
+    }
+    if (outIsNew) *outIsNew = isNew;
+    return &s->frames[s->frontIdx];
+}
+
+void Sampler_SetProcViewSettings(Sampler *s, const ProcViewSettings *settings)
+{
+    if (!s || !settings) return;
+    SysMutex_Lock(&s->settingsLock);
+    s->settings = *settings;
+    s->settingsSeq++;
+    SysMutex_Unlock(&s->settingsLock);
+    SysEvent_Signal(&s->wake);
+}
+
+double Sampler_FrameAgeSec(const MonitorFrame *f)
+{
+    if (!f || f->seq == 0) return 0.0;
+    return Qpc_Seconds(Qpc_Now() - f->sampleQpc, Qpc_Freq());
+}
+
+void Sampler_SetRecording(Sampler *s, FILE *f)
+{
+    if (!s) {
+        if (f) fclose(f);
+        return;
+    }
+    SysMutex_Lock(&s->settingsLock);
+    if (s->recordFile) {
+        fclose(s->recordFile); // superseded before the sampler picked it up
+    }
+    s->recordFile = f;
+    s->recordPending = true;
+    SysMutex_Unlock(&s->settingsLock);
+    SysEvent_Signal(&s->wake);
+}
+
+bool Sampler_IsRecording(Sampler *s)
+{
+    return s && Atomic_LoadU32(&s->recording) != 0;
+}
+
+bool Sampler_ReplayDone(Sampler *s)
+{
+    return s && s->replayMode && Atomic_LoadU32(&s->replayDone) != 0;
+}
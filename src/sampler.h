@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "monitor.h"
+#include "record.h"
+#include "sys_thread.h"
+
+// Background sampler.
+//
+// Owns a Monitor on a dedicated thread (collectors are opened, sampled and closed
+// there) and publishes MonitorFrame copies through a lock-free triple buffer:
+// the sampler fills a private back frame, then atomically swaps it with the shared
+// "latest" slot; the UI swaps its front frame with "latest" only when a newer one
+// exists. Neither side ever waits on the other, so UI frame time no longer depends
+// on collector latency (process walk, WMI, provider pipe timeouts).
+//
+// The same thread can record every tick's raw collector output (Sampler_SetRecording)
+// or, started with Sampler_StartReplay, feed a capture back through the Monitor in
+// place of the collectors.
+
+#define SAMPLER_FRAME_COUNT 3u
+
+// How often the history file's cursors are saved (its data is written in place).
+#define SAMPLER_HISTORY_FLUSH_SEC 10.0
+
+typedef struct Sampler {
+    Monitor mon; // touched only by the sampler thread while running
+
+    MonitorFrame frames[SAMPLER_FRAME_COUNT];
+    volatile uint32_t latest; // frame index | SAMPLER_FRESH_BIT
+    uint32_t backIdx;         // sampler-owned
+    uint32_t frontIdx;        // reader-owned
+    uint64_t publishCount;
+    uint32_t stageCapture; // SelfStats stage in mon.self
+
+    // Config (fixed at start)
+    uint32_t logicalCount;
+    uint32_t histCap;
+    const CollectorOps *const *collectors;
+    uint32_t collectorCount;
+    uint32_t intervalMs; // base period for collectors without their own
+    FILE *historyFile;   // handed to Monitor_AttachHistoryFile on the sampler thread
+
+    // Process view settings requested by the UI (rarely changes; guarded by settingsLock).
+    SysMutex settingsLock;
+    ProcViewSettings settings;
+    uint32_t settingsSeq;
+    uint32_t settingsApplied;
+
+    // Recording requested by the UI (guarded by settingsLock until the sampler picks it up).
+    FILE *recordFile;
+    bool recordPending;
+    Recorder recorder; // sampler-owned; mon.recorder points here while recording
+    volatile uint32_t recording;
+
+    // Replay mode (Sampler_StartReplay): the capture drives the Monitor instead of collectors.
+    bool replayMode;
+    Replay replay;
+    double replaySpeed; // 1 = real time, 100 = 100x, 0 = as fast as possible
+    uint32_t stageReplay;
+    volatile uint32_t replayDone;
+
+    SysThread thread;
+    SysEvent wake;
+    SysEvent ready;
+    volatile uint32_t stop;
+    volatile uint32_t initOk;
+} Sampler;
+
+// Starts the sampler thread and waits for Monitor_Init to finish on it.
+// An initial (empty) frame is published before returning true. Collectors run on their
+// own periods (CollectorOps.periodSec); intervalSec is the fallback for those without one.
+// historyFile (optional, opened for binary read/write; the sampler owns it) persists the
+// raw histories across restarts (Monitor_AttachHistoryFile).
+bool Sampler_Start(Sampler *s, uint32_t logicalCount, uint32_t histCap,
+                   const CollectorOps *const *collectors, uint32_t collectorCount,
+                   double intervalSec, FILE *historyFile);
+// Starts the sampler in replay mode on a capture written by the Recorder (f opened
+// for binary reading; the sampler owns it). Ticks are applied at their recorded times
+// divided by speed (speed <= 0: back to back). Returns false if f is not a capture.
+bool Sampler_StartReplay(Sampler *s, uint32_t histCap, FILE *f, double speed);
+void Sampler_Stop(Sampler *s);
+
+// Starts recording to f (opened for binary writing; the sampler owns it), replacing any
+// capture in progress; NULL stops recording. Takes effect before the next tick.
+void Sampler_SetRecording(Sampler *s, FILE *f);
+bool Sampler_IsRecording(Sampler *s);
+
+// Replay mode: true once every tick of the capture has been applied.
+bool Sampler_ReplayDone(Sampler *s);
+
+// Reader side (one thread only). Returns the newest published frame; the pointer
+// stays valid until the next call. *outIsNew is set when it differs from the last call.
+const MonitorFrame *Sampler_AcquireFrame(Sampler *s, bool *outIsNew);
+
+// Requests a process view rebuild with new settings; the sampler republishes promptly.
+void Sampler_SetProcViewSettings(Sampler *s, const ProcViewSettings *settings);
+
+// Seconds since the frame's sample was taken (how stale the displayed data is).
+double Sampler_FrameAgeSec(const MonitorFrame *f);
@@ -0,0 +1,89 @@
+#include "schedule.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool Schedule_Init(Schedule *s, uint32_t capacity)
+{
+    memset(s, 0, sizeof(*s));
+    if (capacity == 0) {
+        return true;
+    }
+    s->heap = (ScheduleEntry *)calloc(capacity, sizeof(ScheduleEntry));
+    if (!s->heap) {
+        return false;
+    }
+    s->cap = capacity;
+    return true;
+}
+
+void Schedule_Shutdown(Schedule *s)
+{
+    free(s->heap);
+    memset(s, 0, sizeof(*s));
+}
+
+void Schedule_Clear(Schedule *s)
+{
+    s->count = 0;
+}
+
+// Ties on due time are broken by id so collectors that share a deadline run in
+// registration order (PDH before powrprof, etc.).
+static bool entry_less(const ScheduleEntry *a, const ScheduleEntry *b)
+{
+    if (a->due != b->due) return a->due < b->due;
+    return a->id < b->id;
+}
+
+bool Schedule_Push(Schedule *s, uint32_t id, int64_t due)
+{
+    if (s->count >= s->cap) {
+        return false;
+    }
+
+    uint32_t i = s->count++;
+    const ScheduleEntry e = {due, id};
+    while (i > 0) {
+        const uint32_t parent = (i - 1) / 2;
+        if (!entry_less(&e, &s->heap[parent])) break;
+        s->heap[i] = s->heap[parent];
+        i = parent;
+    }
+    s->heap[i] = e;
+    return true;
+}
+
+bool Schedule_Peek(const Schedule *s, ScheduleEntry *out)
+{
+    if (s->count == 0) {
+        return false;
+    }
+    *out = s->heap[0];
+    return true;
+}
+
+bool Schedule_PopDue(Schedule *s, int64_t now, ScheduleEntry *out)
+{
+    if (s->count == 0 || s->heap[0].due > now) {
+        return false;
+    }
+
+    *out = s->heap[0];
+    const ScheduleEntry last = s->heap[--s->count];
+
+    uint32_t i = 0;
+    for (;;) {
+        const uint32_t l = 2 * i + 1;
+        if (l >= s->count) break;
+        const uint32_t r = l + 1;
+        const uint32_t c = (r < s->count && entry_less(&s->heap[r], &s->heap[l])) ? r : l;
+        if (!entry_less(&s->heap[c], &last)) break;
+        s->heap[i] = s->heap[c];
+        i = c;
+    }
+    if (s->count > 0) {
+        s->heap[i] = last;
+    }
+    return true;
+}
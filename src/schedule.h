@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Deadline scheduler: a binary min-heap of (due time, id) pairs.
+// Used by the Monitor to run each collector at its own period and phase.
+// Times are Qpc_Now() ticks; ids are caller-defined (collector indices).
+
+typedef struct ScheduleEntry {
+    int64_t due;
+    uint32_t id;
+} ScheduleEntry;
+
+typedef struct Schedule {
+    ScheduleEntry *heap;
+    uint32_t count;
+    uint32_t cap;
+} Schedule;
+
+bool Schedule_Init(Schedule *s, uint32_t capacity);
+void Schedule_Shutdown(Schedule *s);
+void Schedule_Clear(Schedule *s);
+
+// Adds an entry. Returns false when the heap is full.
+bool Schedule_Push(Schedule *s, uint32_t id, int64_t due);
+
+// Earliest entry. Returns false when empty.
+bool Schedule_Peek(const Schedule *s, ScheduleEntry *out);
+
+// Removes and returns the earliest entry if it is due at or before now.
+bool Schedule_PopDue(Schedule *s, int64_t now, ScheduleEntry *out);
@@ -0,0 +1,159 @@
+#include "self_stats.h"
+
+#include <string.h>
+
+#include "qpc.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SELF_THREAD_LOCAL __declspec(thread)
+#else
+#define SELF_THREAD_LOCAL _Thread_local
+#endif
+
+static SELF_THREAD_LOCAL uint32_t t_allocCount;
+
+static uint32_t floor_log2_u64(uint64_t v)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx = 0;
+    _BitScanReverse64(&idx, v);
+    return (uint32_t)idx;
+#elif defined(__GNUC__) || defined(__clang__)
+    return 63u - (uint32_t)__builtin_clzll(v);
+#else
+    uint32_t r = 0;
+    while (v >>= 1) r++;
+    return r;
+#endif
+}
+
+static uint32_t bucket_index(uint64_t v)
+{
+    if (v < 2u * SELF_HIST_SUB_COUNT) {
+        return (uint32_t)v;
+    }
+    const uint32_t e = floor_log2_u64(v);
+    if (e >= SELF_HIST_MAX_EXP) {
+        return SELF_HIST_BUCKETS - 1u;
+    }
+    const uint32_t sub = (uint32_t)(v >> (e - SELF_HIST_SUB_BITS)) - SELF_HIST_SUB_COUNT;
+    return 2u * SELF_HIST_SUB_COUNT + (e - SELF_HIST_SUB_BITS - 1u) * SELF_HIST_SUB_COUNT + sub;
+}
+
+static uint64_t bucket_upper(uint32_t idx)
+{
+    if (idx < 2u * SELF_HIST_SUB_COUNT) {
+        return idx;
+    }
+    const uint32_t rel = idx - 2u * SELF_HIST_SUB_COUNT;
+    const uint32_t e = rel / SELF_HIST_SUB_COUNT + SELF_HIST_SUB_BITS + 1u;
+    const uint64_t sub = rel % SELF_HIST_SUB_COUNT;
+    return ((SELF_HIST_SUB_COUNT + sub + 1u) << (e - SELF_HIST_SUB_BITS)) - 1u;
+}
+
+void SelfHist_Record(SelfHist *h, uint64_t v)
+{
+    h->buckets[bucket_index(v)]++;
+    h->count++;
+    h->sum += v;
+    if (v > h->max) h->max = v;
+}
+
+uint64_t SelfHist_Percentile(const SelfHist *h, double p)
+{
+    if (!h || h->count == 0) return 0;
+    if (p <= 0.0) p = 0.0;
+    if (p > 100.0) p = 100.0;
+
+    // Rank of the sample we want (1-based), rounded up.
+    uint64_t rank = (uint64_t)((p / 100.0) * (double)h->count + 0.999999);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < SELF_HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            if (i == SELF_HIST_BUCKETS - 1u) return h->max;
+            const uint64_t up = bucket_upper(i);
+            return (up < h->max) ? up : h->max;
+        }
+    }
+    return h->max;
+}
+
+void SelfStats_Init(SelfStats *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->qpcFreq = Qpc_Freq();
+}
+
+void SelfStats_Reset(SelfStats *s)
+{
+    for (uint32_t i = 0; i < s->stageCount; i++) {
+        SelfStage *st = &s->stages[i];
+        memset(&st->ns, 0, sizeof(st->ns));
+        st->allocTotal = 0;
+        st->allocMax = 0;
+        st->allocLast = 0;
+    }
+}
+
+uint32_t SelfStats_AddStage(SelfStats *s, const wchar_t *name)
+{
+    if (s->stageCount >= SELF_STATS_MAX_STAGES) {
+        return UINT32_MAX;
+    }
+    SelfStage *st = &s->stages[s->stageCount];
+    memset(st, 0, sizeof(*st));
+    wcsncpy(st->name, name ? name : L"?", (sizeof(st->name) / sizeof(st->name[0])) - 1);
+    return s->stageCount++;
+}
+
+SelfTimer SelfStats_Begin(void)
+{
+    SelfTimer t;
+    t.qpc = Qpc_Now();
+    t.allocs = t_allocCount;
+    return t;
+}
+
+void SelfStats_End(SelfStats *s, uint32_t stage, const SelfTimer *t)
+{
+    const int64_t now = Qpc_Now();
+    if (!s || stage >= s->stageCount) return;
+
+    SelfStage *st = &s->stages[stage];
+    const int64_t d = now - t->qpc;
+    const double ns = (d > 0) ? ((double)d * 1e9 / s->qpcFreq) : 0.0;
+    SelfHist_Record(&st->ns, (uint64_t)ns);
+
+    const uint32_t allocs = t_allocCount - t->allocs;
+    st->allocTotal += allocs;
+    st->allocLast = allocs;
+    if (allocs > st->allocMax) st->allocMax = allocs;
+}
+
+void SelfStats_Summarize(const SelfStage *st, SelfStageSummary *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!st || st->ns.count == 0) return;
+
+    out->count = st->ns.count;
+    out->p50Us = (double)SelfHist_Percentile(&st->ns, 50.0) / 1000.0;
+    out->p99Us = (double)SelfHist_Percentile(&st->ns, 99.0) / 1000.0;
+    out->maxUs = (double)st->ns.max / 1000.0;
+    out->meanUs = ((double)st->ns.sum / (double)st->ns.count) / 1000.0;
+    out->allocsPerCall = (double)st->allocTotal / (double)st->ns.count;
+    out->allocMax = st->allocMax;
+}
+
+void SelfStats_NoteAlloc(void)
+{
+    t_allocCount++;
+}
+
+uint32_t SelfStats_AllocCount(void)
+{
+    return t_allocCount;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wchar.h>
+
+// Self-instrumentation: per-stage latency histograms for CCM's own work.
+//
+// Each stage (a collector, the process sort, a Render_Draw* call, ...) records its
+// wall time into a fixed-bucket log-linear histogram: values below 16 ns get one
+// bucket each, above that every power of two is split into 8 linear sub-buckets, so
+// percentiles are accurate to ~12% at any scale with no allocation on record.
+// A SelfStats set is owned by one thread (the sampler's lives in its Monitor and is
+// copied into every published frame; the UI keeps its own for painting).
+
+#define SELF_HIST_SUB_BITS 3u
+#define SELF_HIST_SUB_COUNT (1u << SELF_HIST_SUB_BITS)
+#define SELF_HIST_MAX_EXP 40u // 2^40 ns ~ 18 min; larger values land in the last bucket
+#define SELF_HIST_BUCKETS (2u * SELF_HIST_SUB_COUNT + (SELF_HIST_MAX_EXP - SELF_HIST_SUB_BITS - 1u) * SELF_HIST_SUB_COUNT)
+
+#define SELF_STATS_MAX_STAGES 32u
+
+typedef struct SelfHist {
+    uint32_t buckets[SELF_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+} SelfHist;
+
+typedef struct SelfStage {
+    wchar_t name[32];
+    SelfHist ns;          // wall time per call
+    uint64_t allocTotal;  // heap allocations made during calls (see SelfStats_NoteAlloc)
+    uint32_t allocMax;    // most allocations in a single call
+    uint32_t allocLast;
+} SelfStage;
+
+typedef struct SelfStats {
+    SelfStage stages[SELF_STATS_MAX_STAGES];
+    uint32_t stageCount;
+    double qpcFreq;
+} SelfStats;
+
+// Start mark for one timed call.
+typedef struct SelfTimer {
+    int64_t qpc;
+    uint32_t allocs;
+} SelfTimer;
+
+typedef struct SelfStageSummary {
+    uint64_t count;
+    double p50Us;
+    double p99Us;
+    double maxUs;
+    double meanUs;
+    double allocsPerCall;
+    uint32_t allocMax;
+} SelfStageSummary;
+
+void SelfHist_Record(SelfHist *h, uint64_t v);
+// Upper bound of the bucket holding the p-th percentile (0..100); 0 when empty.
+uint64_t SelfHist_Percentile(const SelfHist *h, double p);
+
+void SelfStats_Init(SelfStats *s);
+void SelfStats_Reset(SelfStats *s); // clears samples, keeps stage names
+// Registers a stage and returns its index (stages are never removed).
+// Returns UINT32_MAX when the set is full; recording into it is then a no-op.
+uint32_t SelfStats_AddStage(SelfStats *s, const wchar_t *name);
+
+SelfTimer SelfStats_Begin(void);
+void SelfStats_End(SelfStats *s, uint32_t stage, const SelfTimer *t);
+
+void SelfStats_Summarize(const SelfStage *st, SelfStageSummary *out);
+
+// Per-thread allocation counter. The allocation sites on the sampling and paint paths
+// (buffer growth, per-sample scratch) call NoteAlloc, so stages can report allocations
+// per call without counting work done concurrently on the other thread.
+void SelfStats_NoteAlloc(void);
+uint32_t SelfStats_AllocCount(void);
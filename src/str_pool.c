@@ -0,0 +1,309 @@
+#include "str_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+
+#include "self_stats.h"
+#include "sys_thread.h"
+
+static volatile uint32_t g_nextId;
+
+static uint32_t new_id(void)
+{
+    uint32_t id = Atomic_AddU32(&g_nextId, 1u);
+    if (id == 0) {
+        id = Atomic_AddU32(&g_nextId, 1u); // 0 never matches a live pool
+    }
+    return id;
+}
+
+static uint32_t hash_chars(const wchar_t *s, uint32_t len)
+{
+    // FNV-1a over the code units.
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < len; i++) {
+        h ^= (uint32_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t str_len(const StrPool *p, uint32_t id)
+{
+    const uint32_t end = (id + 1u < p->count) ? p->offsets[id + 1u] : p->charCount;
+    return end - p->offsets[id] - 1u;
+}
+
+static bool grow_array(void **arr, uint32_t *cap, uint32_t want, size_t elemSize, uint32_t initial)
+{
+    if (want <= *cap) return true;
+    uint32_t newCap = *cap ? *cap : initial;
+    while (newCap < want) {
+        if (newCap > (UINT32_MAX / 2u)) {
+            newCap = want;
+            break;
+        }
+        newCap *= 2u;
+    }
+    void *p = realloc(*arr, (size_t)newCap * elemSize);
+    if (!p) return false;
+    SelfStats_NoteAlloc();
+    *arr = p;
+    *cap = newCap;
+    return true;
+}
+
+static bool ensure_ids(StrPool *p, uint32_t want)
+{
+    uint32_t hashCap = p->cap;
+    uint32_t collateCap = p->cap;
+    if (!grow_array((void **)&p->hashes, &hashCap, want, sizeof(uint32_t), 256u)) return false;
+    if (!grow_array((void **)&p->collate, &collateCap, hashCap, sizeof(uint64_t), 256u)) return false;
+    if (!grow_array((void **)&p->offsets, &p->cap, hashCap, sizeof(uint32_t), 256u)) return false;
+    return true;
+}
+
+static bool ensure_chars(StrPool *p, uint32_t want)
+{
+    uint32_t foldedCap = p->charCap;
+    if (!grow_array((void **)&p->folded, &foldedCap, want, sizeof(wchar_t), 4096u)) return false;
+    return grow_array((void **)&p->chars, &p->charCap, foldedCap, sizeof(wchar_t), 4096u);
+}
+
+// True when a key holds an escape unit (a code unit from 0xFFFF up).
+static bool key_escaped(uint64_t key)
+{
+    for (uint32_t i = 0; i < 4u; i++, key >>= 16) {
+        if ((key & 0xFFFFu) == 0xFFFFu) return true;
+    }
+    return false;
+}
+
+static uint64_t pack_units(const wchar_t *folded, uint32_t len, uint32_t from)
+{
+    uint64_t k = 0;
+    if (sizeof(wchar_t) == 2) {
+        // UTF-16 code units are the 16-bit units themselves.
+        for (uint32_t i = from; i < from + 4u; i++) {
+            k = (k << 16) | ((i < len) ? (uint32_t)(uint16_t)folded[i] : 0u);
+        }
+        return k;
+    }
+
+    uint32_t packed = 0;
+    uint32_t pos = 0; // in 16-bit units
+    for (uint32_t i = 0; i < len && packed < 4u; i++) {
+        const uint32_t c = (uint32_t)folded[i];
+        uint32_t units[3] = {c, 0, 0};
+        uint32_t n = 1;
+        if (c >= 0xFFFFu) {
+            // 0xFFFF, then the 21-bit value as 11 + 10 bits, each + 1 so no unit is 0.
+            units[0] = 0xFFFFu;
+            units[1] = (c >> 10) + 1u;
+            units[2] = (c & 0x3FFu) + 1u;
+            n = 3;
+        }
+        for (uint32_t j = 0; j < n && packed < 4u; j++, pos++) {
+            if (pos >= from) {
+                k = (k << 16) | units[j];
+                packed++;
+            }
+        }
+    }
+    for (; packed < 4u; packed++) {
+        k <<= 16;
+    }
+    return k;
+}
+
+static void slot_insert(StrPool *p, uint32_t id)
+{
+    uint32_t i = p->hashes[id] & p->mask;
+    while (p->slots[i] != 0) {
+        i = (i + 1u) & p->mask;
+    }
+    p->slots[i] = id;
+}
+
+// Brings the slot table up to date with every id and leaves room for one more (at most
+// half full).
+static bool ensure_slots(StrPool *p)
+{
+    const uint32_t want = (p->count + 1u) * 2u;
+    if (!p->slots || want > p->mask + 1u) {
+        uint32_t n = p->slots ? (p->mask + 1u) : 512u;
+        while (n < want) {
+            if (n > (UINT32_MAX / 2u)) return false;
+            n *= 2u;
+        }
+        uint32_t *s = (uint32_t *)calloc(n, sizeof(uint32_t));
+        if (!s) return false;
+        SelfStats_NoteAlloc();
+        free(p->slots);
+        p->slots = s;
+        p->mask = n - 1u;
+        p->hashed = 1;
+    }
+    for (; p->hashed < p->count; p->hashed++) {
+        slot_insert(p, p->hashed);
+    }
+    return true;
+}
+
+static void clear(StrPool *p)
+{
+    p->chars[0] = 0;
+    p->folded[0] = 0;
+    p->charCount = 1;
+    p->offsets[0] = 0;
+    p->hashes[0] = hash_chars(L"", 0);
+    p->collate[0] = 0;
+    p->count = 1;
+    if (p->slots) {
+        memset(p->slots, 0, ((size_t)p->mask + 1u) * sizeof(uint32_t));
+    }
+    p->hashed = 1;
+    p->id = new_id();
+}
+
+bool StrPool_Init(StrPool *p)
+{
+    memset(p, 0, sizeof(*p));
+    if (!ensure_chars(p, 1u) || !ensure_ids(p, 1u)) {
+        StrPool_Shutdown(p);
+        return false;
+    }
+    clear(p);
+    return true;
+}
+
+void StrPool_Shutdown(StrPool *p)
+{
+    if (!p) return;
+    free(p->chars);
+    free(p->folded);
+    free(p->offsets);
+    free(p->hashes);
+    free(p->collate);
+    free(p->slots);
+    memset(p, 0, sizeof(*p));
+}
+
+void StrPool_Reset(StrPool *p)
+{
+    if (p && p->chars) {
+        clear(p);
+    }
+}
+
+uint32_t StrPool_InternN(StrPool *p, const wchar_t *s, uint32_t len)
+{
+    if (!p || !p->chars || !s || len == 0) return STR_POOL_EMPTY;
+    if (!ensure_slots(p)) return STR_POOL_EMPTY;
+
+    const uint32_t h = hash_chars(s, len);
+    uint32_t i = h & p->mask;
+    while (p->slots[i] != 0) {
+        const uint32_t id = p->slots[i];
+        if (p->hashes[id] == h && str_len(p, id) == len &&
+            wmemcmp(p->chars + p->offsets[id], s, len) == 0) {
+            return id;
+        }
+        i = (i + 1u) & p->mask;
+    }
+
+    if (len > UINT32_MAX - 1u - p->charCount || p->count == UINT32_MAX) return STR_POOL_EMPTY;
+    if (!ensure_chars(p, p->charCount + len + 1u) || !ensure_ids(p, p->count + 1u)) {
+        return STR_POOL_EMPTY;
+    }
+
+    const uint32_t id = p->count++;
+    wchar_t *folded = p->folded + p->charCount;
+    for (uint32_t k = 0; k < len; k++) {
+        folded[k] = (wchar_t)towlower((wint_t)s[k]);
+    }
+    folded[len] = 0;
+    p->offsets[id] = p->charCount;
+    p->hashes[id] = h;
+    p->collate[id] = pack_units(folded, len, 0);
+    wmemcpy(p->chars + p->charCount, s, len);
+    p->chars[p->charCount + len] = 0;
+    p->charCount += len + 1u;
+    p->slots[i] = id;
+    p->hashed = p->count;
+    return id;
+}
+
+uint32_t StrPool_Intern(StrPool *p, const wchar_t *s)
+{
+    if (!s) return STR_POOL_EMPTY;
+    const size_t len = wcslen(s);
+    return (len < UINT32_MAX) ? StrPool_InternN(p, s, (uint32_t)len) : STR_POOL_EMPTY;
+}
+
+uint64_t StrPool_CollateKey(const StrPool *p, uint32_t id, uint32_t from)
+{
+    if (!p || id >= p->count) return 0;
+    if (from == 0) return p->collate[id];
+    return pack_units(p->folded + p->offsets[id], str_len(p, id), from);
+}
+
+int StrPool_CompareFolded(const StrPool *p, uint32_t a, uint32_t b)
+{
+    if (a == b || !p) return 0;
+    const uint64_t ka = (a < p->count) ? p->collate[a] : 0;
+    const uint64_t kb = (b < p->count) ? p->collate[b] : 0;
+    if (ka != kb) return (ka < kb) ? -1 : 1;
+    if (ka == 0) return 0; // both empty
+
+    if ((ka & 0xFFFFu) == 0) return 0; // both ended within the prefix
+
+    // Same first four units. Without an escape those are the first four code units and
+    // the rest is compared from there; with one, the whole text is (the encoding orders
+    // like the code units, so both agree).
+    const uint32_t skip = key_escaped(ka) ? 0u : 4u;
+    const wchar_t *sa = StrPool_GetFolded(p, a) + skip;
+    const wchar_t *sb = StrPool_GetFolded(p, b) + skip;
+    for (;; sa++, sb++) {
+        if (*sa != *sb) return ((uint32_t)*sa < (uint32_t)*sb) ? -1 : 1;
+        if (*sa == 0) return 0;
+    }
+}
+
+bool StrPool_CopyFrom(StrPool *dst, const StrPool *src)
+{
+    if (!dst || !src) return false;
+    if (!src->chars) {
+        StrPool_Reset(dst);
+        return true;
+    }
+
+    // Same pool, older state: everything up to dst's counts is already identical.
+    const bool incremental = dst->chars && dst->id == src->id && dst->count <= src->count &&
+                             dst->charCount <= src->charCount;
+    const uint32_t firstId = incremental ? dst->count : 0;
+    const uint32_t firstChar = incremental ? dst->charCount : 0;
+
+    if (!ensure_chars(dst, src->charCount) || !ensure_ids(dst, src->count)) {
+        StrPool_Reset(dst);
+        return false;
+    }
+    const size_t chars = (size_t)(src->charCount - firstChar) * sizeof(wchar_t);
+    const size_t ids = (size_t)(src->count - firstId);
+    memcpy(dst->chars + firstChar, src->chars + firstChar, chars);
+    memcpy(dst->folded + firstChar, src->folded + firstChar, chars);
+    memcpy(dst->offsets + firstId, src->offsets + firstId, ids * sizeof(uint32_t));
+    memcpy(dst->hashes + firstId, src->hashes + firstId, ids * sizeof(uint32_t));
+    memcpy(dst->collate + firstId, src->collate + firstId, ids * sizeof(uint64_t));
+    dst->charCount = src->charCount;
+    dst->count = src->count;
+    if (!incremental) {
+        if (dst->slots) {
+            memset(dst->slots, 0, ((size_t)dst->mask + 1u) * sizeof(uint32_t));
+        }
+        dst->hashed = 1;
+    }
+    dst->id = src->id;
+    return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wchar.h>
+
+// Interned wide strings: each distinct string is stored once and named by a 32-bit id,
+// so records can carry ids instead of inline buffers and compare them for equality
+// without touching the characters.
+//
+// Append-only: ids stay valid until StrPool_Reset, and a copy of the pool (frames) only
+// needs the strings added since the last copy. Id 0 is always the empty string. Pointers
+// from StrPool_Get are valid until the next intern into the same pool.
+//
+// Each string is also case-folded once, when interned: a folded copy (towlower per code
+// unit, the folding wcsicmp/wcscasecmp apply on every call) and its first four folded
+// units packed into a 64-bit collation prefix. Case-insensitive ordering then compares
+// integers, falling back to the folded text only when the prefixes match.
+
+#define STR_POOL_EMPTY 0u
+
+typedef struct StrPool {
+    wchar_t *chars;     // NUL-terminated strings back to back
+    wchar_t *folded;    // the same, case-folded (same offsets)
+    uint32_t charCount;
+    uint32_t charCap;
+    uint32_t *offsets;  // per id: start in chars
+    uint32_t *hashes;   // per id
+    uint64_t *collate;  // per id: StrPool_CollateKey(p, id, 0)
+    uint32_t count;     // ids in use (including the empty string)
+    uint32_t cap;
+    uint32_t *slots;    // open-addressing table of ids (0 = empty slot)
+    uint32_t mask;      // slots - 1 (0 when unallocated)
+    uint32_t hashed;    // ids [1, hashed) are in slots; copies catch up lazily
+    uint32_t id;        // unique per Init/Reset; copies carry their source's id
+} StrPool;
+
+bool StrPool_Init(StrPool *p);
+void StrPool_Shutdown(StrPool *p);
+// Drops every string (ids are reassigned from scratch).
+void StrPool_Reset(StrPool *p);
+
+// Id of s (len characters, no NUL needed), adding it if new. Returns STR_POOL_EMPTY for
+// an empty string or when out of memory.
+uint32_t StrPool_InternN(StrPool *p, const wchar_t *s, uint32_t len);
+uint32_t StrPool_Intern(StrPool *p, const wchar_t *s);
+
+static inline const wchar_t *StrPool_Get(const StrPool *p, uint32_t id)
+{
+    return (p && id < p->count) ? p->chars + p->offsets[id] : L"";
+}
+
+static inline const wchar_t *StrPool_GetFolded(const StrPool *p, uint32_t id)
+{
+    return (p && id < p->count) ? p->folded + p->offsets[id] : L"";
+}
+
+// Folded units [from, from + 4) of a string, 16 bits each, first unit most significant
+// and 0 past the end, so keys order like the folded text. A unit from 0xFFFF up (non-BMP
+// characters with a 32-bit wchar_t) counts as three: 0xFFFF and two nonzero units holding
+// its value, so keys stay exact and in order; from then counts in those units.
+uint64_t StrPool_CollateKey(const StrPool *p, uint32_t id, uint32_t from);
+
+// Case-insensitive comparison (<0, 0, >0) of two strings of the pool, as wcsicmp orders
+// them; the empty string first.
+int StrPool_CompareFolded(const StrPool *p, uint32_t a, uint32_t b);
+
+// Characters held, terminators included (for deciding when to compact).
+static inline uint32_t StrPool_CharCount(const StrPool *p)
+{
+    return p->charCount;
+}
+
+// Copies src into dst. When dst is an earlier copy of src, only the strings added since
+// are copied.
+bool StrPool_CopyFrom(StrPool *dst, const StrPool *src);
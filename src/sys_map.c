@@ -0,0 +1,124 @@
+#include "sys_map.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+
+bool SysMap_Open(SysMap *m, FILE *f, size_t size)
+{
+    memset(m, 0, sizeof(*m));
+    m->file = f;
+    if (!f || size == 0) {
+        SysMap_Close(m);
+        return false;
+    }
+
+    HANDLE h = (HANDLE)_get_osfhandle(_fileno(f));
+    if (h == INVALID_HANDLE_VALUE) {
+        SysMap_Close(m);
+        return false;
+    }
+
+    // A mapping larger than the file extends it; a smaller file is truncated first so the
+    // size always matches.
+    LARGE_INTEGER cur;
+    if (GetFileSizeEx(h, &cur) && (uint64_t)cur.QuadPart > (uint64_t)size) {
+        LARGE_INTEGER pos;
+        pos.QuadPart = (LONGLONG)size;
+        if (!SetFilePointerEx(h, pos, NULL, FILE_BEGIN) || !SetEndOfFile(h)) {
+            SysMap_Close(m);
+            return false;
+        }
+    }
+
+    const uint64_t sz = (uint64_t)size;
+    HANDLE mapping = CreateFileMappingW(h, NULL, PAGE_READWRITE, (DWORD)(sz >> 32), (DWORD)(sz & 0xFFFFFFFFu), NULL);
+    if (!mapping) {
+        SysMap_Close(m);
+        return false;
+    }
+    m->impl = mapping;
+    m->base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!m->base) {
+        SysMap_Close(m);
+        return false;
+    }
+    m->size = size;
+    return true;
+}
+
+void SysMap_Flush(SysMap *m)
+{
+    if (m && m->base) {
+        (void)FlushViewOfFile(m->base, 0);
+    }
+}
+
+void SysMap_Close(SysMap *m)
+{
+    if (!m) return;
+    if (m->base) {
+        UnmapViewOfFile(m->base);
+    }
+    if (m->impl) {
+        CloseHandle((HANDLE)m->impl);
+    }
+    if (m->file) {
+        fclose(m->file);
+    }
+    memset(m, 0, sizeof(*m));
+}
+
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool SysMap_Open(SysMap *m, FILE *f, size_t size)
+{
+    memset(m, 0, sizeof(*m));
+    m->file = f;
+    if (!f || size == 0) {
+        SysMap_Close(m);
+        return false;
+    }
+
+    const int fd = fileno(f);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || ((size_t)st.st_size != size && ftruncate(fd, (off_t)size) != 0)) {
+        SysMap_Close(m);
+        return false;
+    }
+
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        SysMap_Close(m);
+        return false;
+    }
+    m->base = p;
+    m->size = size;
+    return true;
+}
+
+void SysMap_Flush(SysMap *m)
+{
+    if (m && m->base) {
+        (void)msync(m->base, m->size, MS_ASYNC);
+    }
+}
+
+void SysMap_Close(SysMap *m)
+{
+    if (!m) return;
+    if (m->base) {
+        munmap(m->base, m->size);
+    }
+    if (m->file) {
+        fclose(m->file);
+    }
+    memset(m, 0, sizeof(*m));
+}
+
+#endif
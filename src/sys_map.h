@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Shared read/write mapping of a whole file.
+// File mappings on Windows, mmap elsewhere. Writes land in the page cache; SysMap_Flush
+// only starts writing dirty pages back (no fsync), so it is cheap enough for periodic use.
+
+typedef struct SysMap {
+    void *base;
+    size_t size;
+    FILE *file;
+    void *impl; // Windows: mapping handle
+} SysMap;
+
+// Maps f (opened for binary read/write; the SysMap owns it from here on), first resizing
+// the file to size bytes. Bytes beyond the old end of the file read as zero.
+bool SysMap_Open(SysMap *m, FILE *f, size_t size);
+void SysMap_Flush(SysMap *m);
+// Unmaps and closes the file (dirty pages are still written back by the OS).
+void SysMap_Close(SysMap *m);
@@ -0,0 +1,253 @@
+#include "sys_thread.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef struct ThreadStart {
+    SysThreadFn fn;
+    void *arg;
+} ThreadStart;
+
+static DWORD WINAPI thread_main(LPVOID p)
+{
+    ThreadStart ts = *(ThreadStart *)p;
+    free(p);
+    return (DWORD)ts.fn(ts.arg);
+}
+
+bool SysThread_Start(SysThread *t, SysThreadFn fn, void *arg)
+{
+    t->handle = NULL;
+    ThreadStart *ts = (ThreadStart *)malloc(sizeof(*ts));
+    if (!ts) return false;
+    ts->fn = fn;
+    ts->arg = arg;
+
+    HANDLE h = CreateThread(NULL, 0, thread_main, ts, 0, NULL);
+    if (!h) {
+        free(ts);
+        return false;
+    }
+    t->handle = h;
+    return true;
+}
+
+void SysThread_Join(SysThread *t)
+{
+    if (!t || !t->handle) return;
+    WaitForSingleObject((HANDLE)t->handle, INFINITE);
+    CloseHandle((HANDLE)t->handle);
+    t->handle = NULL;
+}
+
+uint32_t SysThread_CpuCount(void)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? (uint32_t)si.dwNumberOfProcessors : 1u;
+}
+
+bool SysEvent_Init(SysEvent *e)
+{
+    e->impl = CreateEventW(NULL, FALSE, FALSE, NULL);
+    return e->impl != NULL;
+}
+
+void SysEvent_Shutdown(SysEvent *e)
+{
+    if (!e || !e->impl) return;
+    CloseHandle((HANDLE)e->impl);
+    e->impl = NULL;
+}
+
+void SysEvent_Signal(SysEvent *e)
+{
+    if (e && e->impl) SetEvent((HANDLE)e->impl);
+}
+
+bool SysEvent_Wait(SysEvent *e, uint32_t timeoutMs)
+{
+    if (!e || !e->impl) return false;
+    return WaitForSingleObject((HANDLE)e->impl, (DWORD)timeoutMs) == WAIT_OBJECT_0;
+}
+
+bool SysMutex_Init(SysMutex *m)
+{
+    CRITICAL_SECTION *cs = (CRITICAL_SECTION *)malloc(sizeof(CRITICAL_SECTION));
+    if (!cs) return false;
+    InitializeCriticalSection(cs);
+    m->impl = cs;
+    return true;
+}
+
+void SysMutex_Shutdown(SysMutex *m)
+{
+    if (!m || !m->impl) return;
+    DeleteCriticalSection((CRITICAL_SECTION *)m->impl);
+    free(m->impl);
+    m->impl = NULL;
+}
+
+void SysMutex_Lock(SysMutex *m)
+{
+    EnterCriticalSection((CRITICAL_SECTION *)m->impl);
+}
+
+void SysMutex_Unlock(SysMutex *m)
+{
+    LeaveCriticalSection((CRITICAL_SECTION *)m->impl);
+}
+
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct ThreadStart {
+    SysThreadFn fn;
+    void *arg;
+} ThreadStart;
+
+static void *thread_main(void *p)
+{
+    ThreadStart ts = *(ThreadStart *)p;
+    free(p);
+    (void)ts.fn(ts.arg);
+    return NULL;
+}
+
+bool SysThread_Start(SysThread *t, SysThreadFn fn, void *arg)
+{
+    t->handle = NULL;
+    pthread_t *th = (pthread_t *)malloc(sizeof(pthread_t));
+    ThreadStart *ts = (ThreadStart *)malloc(sizeof(*ts));
+    if (!th || !ts) {
+        free(th);
+        free(ts);
+        return false;
+    }
+    ts->fn = fn;
+    ts->arg = arg;
+
+    if (pthread_create(th, NULL, thread_main, ts) != 0) {
+        free(th);
+        free(ts);
+        return false;
+    }
+    t->handle = th;
+    return true;
+}
+
+void SysThread_Join(SysThread *t)
+{
+    if (!t || !t->handle) return;
+    pthread_join(*(pthread_t *)t->handle, NULL);
+    free(t->handle);
+    t->handle = NULL;
+}
+
+uint32_t SysThread_CpuCount(void)
+{
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (uint32_t)n : 1u;
+}
+
+typedef struct EventImpl {
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    bool signaled;
+} EventImpl;
+
+bool SysEvent_Init(SysEvent *e)
+{
+    EventImpl *ev = (EventImpl *)calloc(1, sizeof(EventImpl));
+    if (!ev) return false;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ev->cv, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&ev->mu, NULL);
+
+    e->impl = ev;
+    return true;
+}
+
+void SysEvent_Shutdown(SysEvent *e)
+{
+    if (!e || !e->impl) return;
+    EventImpl *ev = (EventImpl *)e->impl;
+    pthread_cond_destroy(&ev->cv);
+    pthread_mutex_destroy(&ev->mu);
+    free(ev);
+    e->impl = NULL;
+}
+
+void SysEvent_Signal(SysEvent *e)
+{
+    if (!e || !e->impl) return;
+    EventImpl *ev = (EventImpl *)e->impl;
+    pthread_mutex_lock(&ev->mu);
+    ev->signaled = true;
+    pthread_cond_signal(&ev->cv);
+    pthread_mutex_unlock(&ev->mu);
+}
+
+bool SysEvent_Wait(SysEvent *e, uint32_t timeoutMs)
+{
+    if (!e || !e->impl) return false;
+    EventImpl *ev = (EventImpl *)e->impl;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += (time_t)(timeoutMs / 1000u);
+    deadline.tv_nsec += (long)(timeoutMs % 1000u) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&ev->mu);
+    while (!ev->signaled) {
+        if (pthread_cond_timedwait(&ev->cv, &ev->mu, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    const bool got = ev->signaled;
+    ev->signaled = false;
+    pthread_mutex_unlock(&ev->mu);
+    return got;
+}
+
+bool SysMutex_Init(SysMutex *m)
+{
+    pthread_mutex_t *mu = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    if (!mu) return false;
+    pthread_mutex_init(mu, NULL);
+    m->impl = mu;
+    return true;
+}
+
+void SysMutex_Shutdown(SysMutex *m)
+{
+    if (!m || !m->impl) return;
+    pthread_mutex_destroy((pthread_mutex_t *)m->impl);
+    free(m->impl);
+    m->impl = NULL;
+}
+
+void SysMutex_Lock(SysMutex *m)
+{
+    pthread_mutex_lock((pthread_mutex_t *)m->impl);
+}
+
+void SysMutex_Unlock(SysMutex *m)
+{
+    pthread_mutex_unlock((pthread_mutex_t *)m->impl);
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Minimal threading primitives shared by the sampler and worker code.
+// Win32 threads/events on Windows, pthreads elsewhere.
+
+typedef uint32_t (*SysThreadFn)(void *arg);
+
+typedef struct SysThread {
+    void *handle;
+} SysThread;
+
+bool SysThread_Start(SysThread *t, SysThreadFn fn, void *arg);
+void SysThread_Join(SysThread *t);
+// Logical processors available to this process (at least 1).
+uint32_t SysThread_CpuCount(void);
+
+// Auto-reset event: one Wait is released per Signal.
+typedef struct SysEvent {
+    void *impl;
+} SysEvent;
+
+bool SysEvent_Init(SysEvent *e);
+void SysEvent_Shutdown(SysEvent *e);
+void SysEvent_Signal(SysEvent *e);
+// Returns true if signaled, false on timeout.
+bool SysEvent_Wait(SysEvent *e, uint32_t timeoutMs);
+
+typedef struct SysMutex {
+    void *impl;
+} SysMutex;
+
+bool SysMutex_Init(SysMutex *m);
+void SysMutex_Shutdown(SysMutex *m);
+void SysMutex_Lock(SysMutex *m);
+void SysMutex_Unlock(SysMutex *m);
+
+// Sequentially consistent atomics on naturally aligned 32-bit values.
+#if defined(_MSC_VER)
+#include <intrin.h>
+static inline uint32_t Atomic_LoadU32(volatile uint32_t *p) { return (uint32_t)_InterlockedOr((volatile long *)p, 0); }
+static inline void Atomic_StoreU32(volatile uint32_t *p, uint32_t v) { (void)_InterlockedExchange((volatile long *)p, (long)v); }
+static inline uint32_t Atomic_ExchangeU32(volatile uint32_t *p, uint32_t v) { return (uint32_t)_InterlockedExchange((volatile long *)p, (long)v); }
+static inline uint32_t Atomic_AddU32(volatile uint32_t *p, uint32_t v) { return (uint32_t)_InterlockedExchangeAdd((volatile long *)p, (long)v) + v; }
+#else
+static inline uint32_t Atomic_LoadU32(volatile uint32_t *p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+static inline void Atomic_StoreU32(volatile uint32_t *p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+static inline uint32_t Atomic_ExchangeU32(volatile uint32_t *p, uint32_t v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+static inline uint32_t Atomic_AddU32(volatile uint32_t *p, uint32_t v) { return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST); }
+#endif
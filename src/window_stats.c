@@ -0,0 +1,171 @@
+#include "window_stats.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "self_stats.h"
+
+static uint32_t floor_log2_u64(uint64_t v)
+{
+    uint32_t r = 0;
+    while (v >>= 1) r++;
+    return r;
+}
+
+static uint32_t bucket_index(float v)
+{
+    if (!(v > 0.0f)) {
+        return 0; // zero, negative, NaN
+    }
+    const float scaled = v * WSTATS_SCALE;
+    if (scaled >= (float)(1ull << WSTATS_MAX_EXP)) {
+        return WSTATS_BUCKETS - 1u;
+    }
+    const uint64_t u = (uint64_t)scaled;
+    if (u < 2u * WSTATS_SUB_COUNT) {
+        return (uint32_t)u;
+    }
+    const uint32_t e = floor_log2_u64(u);
+    const uint32_t sub = (uint32_t)(u >> (e - WSTATS_SUB_BITS)) - WSTATS_SUB_COUNT;
+    return 2u * WSTATS_SUB_COUNT + (e - WSTATS_SUB_BITS - 1u) * WSTATS_SUB_COUNT + sub;
+}
+
+static float bucket_upper(uint32_t idx)
+{
+    if (idx < 2u * WSTATS_SUB_COUNT) {
+        return (float)(idx + 1u) / WSTATS_SCALE;
+    }
+    const uint32_t rel = idx - 2u * WSTATS_SUB_COUNT;
+    const uint32_t e = rel / WSTATS_SUB_COUNT + WSTATS_SUB_BITS + 1u;
+    const uint64_t sub = rel % WSTATS_SUB_COUNT;
+    return (float)((WSTATS_SUB_COUNT + sub + 1u) << (e - WSTATS_SUB_BITS)) / WSTATS_SCALE;
+}
+
+bool WindowStats_Init(WindowStats *s, uint32_t window)
+{
+    memset(s, 0, sizeof(*s));
+    if (window == 0 || window > 0x40000000u) {
+        return false;
+    }
+    uint32_t slots = 1;
+    while (slots < window) {
+        slots <<= 1;
+    }
+    s->values = (float *)calloc(slots, sizeof(float));
+    s->minQ = (uint32_t *)calloc(slots, sizeof(uint32_t));
+    s->maxQ = (uint32_t *)calloc(slots, sizeof(uint32_t));
+    if (!s->values || !s->minQ || !s->maxQ) {
+        WindowStats_Shutdown(s);
+        return false;
+    }
+    SelfStats_NoteAlloc();
+    s->window = window;
+    s->mask = slots - 1u;
+    return true;
+}
+
+void WindowStats_Shutdown(WindowStats *s)
+{
+    if (!s) return;
+    free(s->values);
+    free(s->minQ);
+    free(s->maxQ);
+    memset(s, 0, sizeof(*s));
+}
+
+void WindowStats_Push(WindowStats *s, float v)
+{
+    if (!s || !s->values) return;
+
+    const uint32_t seq = s->seq;
+    if (s->count == s->window) {
+        const uint32_t oldSeq = seq - s->window;
+        const float old = s->values[oldSeq & s->mask];
+        s->sum -= (double)old;
+        s->sumSq -= (double)old * (double)old;
+        s->hist[bucket_index(old)]--;
+        if (s->minHead != s->minTail && s->minQ[s->minHead & s->mask] == oldSeq) s->minHead++;
+        if (s->maxHead != s->maxTail && s->maxQ[s->maxHead & s->mask] == oldSeq) s->maxHead++;
+    } else {
+        s->count++;
+    }
+
+    s->values[seq & s->mask] = v;
+    s->sum += (double)v;
+    s->sumSq += (double)v * (double)v;
+    s->hist[bucket_index(v)]++;
+
+    while (s->minTail != s->minHead && s->values[s->minQ[(s->minTail - 1u) & s->mask] & s->mask] >= v) s->minTail--;
+    s->minQ[s->minTail++ & s->mask] = seq;
+    while (s->maxTail != s->maxHead && s->values[s->maxQ[(s->maxTail - 1u) & s->mask] & s->mask] <= v) s->maxTail--;
+    s->maxQ[s->maxTail++ & s->mask] = seq;
+
+    s->seq = seq + 1u;
+
+    // Rebuild the running sums once per window so add/subtract rounding cannot drift.
+    if (s->seq % s->window == 0) {
+        double sum = 0.0, sumSq = 0.0;
+        for (uint32_t i = 0; i < s->count; i++) {
+            const double x = (double)s->values[(s->seq - 1u - i) & s->mask];
+            sum += x;
+            sumSq += x * x;
+        }
+        s->sum = sum;
+        s->sumSq = sumSq;
+    }
+}
+
+float WindowStats_Min(const WindowStats *s)
+{
+    if (!s || s->count == 0) return 0.0f;
+    return s->values[s->minQ[s->minHead & s->mask] & s->mask];
+}
+
+float WindowStats_Max(const WindowStats *s)
+{
+    if (!s || s->count == 0) return 0.0f;
+    return s->values[s->maxQ[s->maxHead & s->mask] & s->mask];
+}
+
+float WindowStats_Mean(const WindowStats *s)
+{
+    if (!s || s->count == 0) return 0.0f;
+    return (float)(s->sum / (double)s->count);
+}
+
+float WindowStats_Percentile(const WindowStats *s, double p)
+{
+    if (!s || s->count == 0) return 0.0f;
+    if (p <= 0.0) p = 0.0;
+    if (p > 100.0) p = 100.0;
+
+    uint32_t rank = (uint32_t)((p / 100.0) * (double)s->count + 0.999999);
+    if (rank == 0) rank = 1;
+
+    const float max = WindowStats_Max(s);
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < WSTATS_BUCKETS; i++) {
+        seen += s->hist[i];
+        if (seen >= rank) {
+            if (i == 0) return (max < 0.0f) ? max : 0.0f;
+            const float up = bucket_upper(i);
+            return (up < max) ? up : max;
+        }
+    }
+    return max;
+}
+
+void WindowStats_Summarize(const WindowStats *s, WindowSummary *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!s || s->count == 0) return;
+    out->count = s->count;
+    out->min = WindowStats_Min(s);
+    out->max = WindowStats_Max(s);
+    out->mean = WindowStats_Mean(s);
+    const double mean = s->sum / (double)s->count;
+    const double var = s->sumSq / (double)s->count - mean * mean;
+    out->stddev = (var > 0.0) ? (float)sqrt(var) : 0.0f;
+    out->p95 = WindowStats_Percentile(s, 95.0);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Sliding-window statistics over the last N samples of a series.
+//
+// Min and max come from monotonic deques (every sample enters and leaves each deque at
+// most once, so a push is O(1) amortized); mean and variance from running sums, rebuilt
+// from the window once per N pushes so rounding never accumulates; p95 from a log-linear
+// histogram (the scheme of self_stats.h over 1/256 units) whose evicted sample is
+// decremented. Min, max and mean are exact; percentiles are accurate to one bucket (~12%).
+// Reading any statistic never scans the window.
+
+#define WSTATS_SUB_BITS 3u
+#define WSTATS_SUB_COUNT (1u << WSTATS_SUB_BITS)
+#define WSTATS_MAX_EXP 40u // 2^40 / 256 ~ 4e9; larger values land in the last bucket
+#define WSTATS_BUCKETS (2u * WSTATS_SUB_COUNT + (WSTATS_MAX_EXP - WSTATS_SUB_BITS - 1u) * WSTATS_SUB_COUNT)
+#define WSTATS_SCALE 256.0f // histogram units per value unit
+
+typedef struct WindowStats {
+    float *values;   // ring of the window's samples (for eviction)
+    uint32_t *minQ;  // deque of sample sequence numbers, values increasing
+    uint32_t *maxQ;  // deque of sample sequence numbers, values decreasing
+    uint32_t window;
+    uint32_t mask;   // ring/deque slots - 1
+    uint32_t count;  // samples in the window
+    uint32_t seq;    // samples pushed (wraps; only differences are used)
+    uint32_t minHead, minTail;
+    uint32_t maxHead, maxTail;
+    double sum;
+    double sumSq;
+    uint32_t hist[WSTATS_BUCKETS];
+} WindowStats;
+
+// Point-in-time copy of the statistics (what frames and the UI carry).
+typedef struct WindowSummary {
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float stddev;
+    float p95;
+} WindowSummary;
+
+bool WindowStats_Init(WindowStats *s, uint32_t window);
+void WindowStats_Shutdown(WindowStats *s);
+void WindowStats_Push(WindowStats *s, float v);
+
+// O(1) reads; 0 when empty.
+float WindowStats_Min(const WindowStats *s);
+float WindowStats_Max(const WindowStats *s);
+float WindowStats_Mean(const WindowStats *s);
+// Upper bound of the bucket holding the p-th percentile (0..100), capped at the max.
+float WindowStats_Percentile(const WindowStats *s, double p);
+
+void WindowStats_Summarize(const WindowStats *s, WindowSummary *out);
@@ -0,0 +1,92 @@
+#include "work_pool.h"
+
+#include <string.h>
+
+#define WAIT_FOREVER 0xFFFFFFFFu
+
+static void claim_shards(WorkPool *p, uint32_t thread)
+{
+    for (;;) {
+        const uint32_t shard = Atomic_AddU32(&p->nextShard, 1u) - 1u;
+        if (shard >= p->shards) return;
+        p->fn(p->ctx, shard, thread);
+    }
+}
+
+static uint32_t worker_main(void *arg)
+{
+    WorkPoolWorker *w = (WorkPoolWorker *)arg;
+    WorkPool *p = w->pool;
+    for (;;) {
+        while (!SysEvent_Wait(&w->wake, WAIT_FOREVER)) {
+        }
+        if (Atomic_LoadU32(&p->stop)) return 0;
+        claim_shards(p, w->index);
+        if (Atomic_AddU32(&p->active, UINT32_MAX) == 0) {
+            SysEvent_Signal(&p->done);
+        }
+    }
+}
+
+// Starts workers until want are running; returns how many are.
+static uint32_t start_workers(WorkPool *p, uint32_t want)
+{
+    if (!p->doneInit) {
+        if (!SysEvent_Init(&p->done)) return 0;
+        p->doneInit = true;
+    }
+    while (p->started < want) {
+        WorkPoolWorker *w = &p->workers[p->started];
+        w->pool = p;
+        w->index = p->started + 1u;
+        if (!SysEvent_Init(&w->wake)) break;
+        if (!SysThread_Start(&w->thread, worker_main, w)) {
+            SysEvent_Shutdown(&w->wake);
+            break;
+        }
+        p->started++;
+    }
+    return p->started;
+}
+
+void WorkPool_Init(WorkPool *p)
+{
+    if (p) memset(p, 0, sizeof(*p));
+}
+
+void WorkPool_Shutdown(WorkPool *p)
+{
+    if (!p) return;
+    Atomic_StoreU32(&p->stop, 1u);
+    for (uint32_t i = 0; i < p->started; i++) {
+        SysEvent_Signal(&p->workers[i].wake);
+        SysThread_Join(&p->workers[i].thread);
+        SysEvent_Shutdown(&p->workers[i].wake);
+    }
+    if (p->doneInit) SysEvent_Shutdown(&p->done);
+    memset(p, 0, sizeof(*p));
+}
+
+void WorkPool_Run(WorkPool *p, uint32_t threads, uint32_t shards, WorkPoolFn fn, void *ctx)
+{
+    if (!p || !fn || shards == 0) return;
+    if (threads > WORK_POOL_MAX_THREADS) threads = WORK_POOL_MAX_THREADS;
+    if (threads > shards) threads = shards;
+
+    uint32_t workers = (threads > 1u) ? start_workers(p, threads - 1u) : 0;
+    if (workers > threads - 1u) workers = threads - 1u;
+
+    p->fn = fn;
+    p->ctx = ctx;
+    p->shards = shards;
+    Atomic_StoreU32(&p->nextShard, 0);
+    Atomic_StoreU32(&p->active, workers);
+    for (uint32_t i = 0; i < workers; i++) {
+        SysEvent_Signal(&p->workers[i].wake);
+    }
+    claim_shards(p, 0);
+    if (workers > 0) {
+        while (!SysEvent_Wait(&p->done, WAIT_FOREVER)) {
+        }
+    }
+}
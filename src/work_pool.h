@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sys_thread.h"
+
+// Persistent worker threads for data-parallel passes on the sampler thread. A run splits
+// the work into shards; the calling thread and the workers claim shards with an atomic
+// counter until none are left, so nothing on the per-shard path takes a lock. Workers
+// sleep on an event between runs and are started once, by the first run that wants them.
+//
+// One thread runs a pool at a time. Each shard callback gets the index of the thread
+// running it (0 = the caller) for per-thread scratch.
+
+#define WORK_POOL_MAX_THREADS 8u
+
+typedef void (*WorkPoolFn)(void *ctx, uint32_t shard, uint32_t thread);
+
+typedef struct WorkPool WorkPool;
+
+typedef struct WorkPoolWorker {
+    WorkPool *pool;
+    uint32_t index; // 1..WORK_POOL_MAX_THREADS - 1
+    SysThread thread;
+    SysEvent wake;
+} WorkPoolWorker;
+
+struct WorkPool {
+    WorkPoolWorker workers[WORK_POOL_MAX_THREADS - 1u];
+    uint32_t started; // workers running (workers[0, started))
+    SysEvent done;
+    bool doneInit;
+
+    WorkPoolFn fn;
+    void *ctx;
+    uint32_t shards;
+    volatile uint32_t nextShard;
+    volatile uint32_t active; // woken workers that have not finished this run
+    volatile uint32_t stop;
+};
+
+void WorkPool_Init(WorkPool *p);
+// Stops and joins the workers.
+void WorkPool_Shutdown(WorkPool *p);
+
+// Runs fn for every shard in [0, shards) on up to threads threads (the caller included)
+// and returns when all are done. Falls back to fewer threads, down to the caller alone,
+// when workers cannot be started.
+void WorkPool_Run(WorkPool *p, uint32_t threads, uint32_t shards, WorkPoolFn fn, void *ctx);
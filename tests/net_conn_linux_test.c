@@ -0,0 +1,127 @@
+// Socket owner search of the Linux connection backend, run on a fake /proc tree
+// (NET_PROC_ROOT, with a small NET_FD_SCAN_BUDGET) that the test builds and changes between
+// refreshes. The backend is compiled in so the test can read its socket map.
+
+#include "../src/linux/net_conn_linux.c"
+
+#include <sys/stat.h>
+
+#define OLD_FIRST 100u
+#define OLD_COUNT 40u
+#define CHURN 200u      // processes started, and gone by the next refresh, per refresh
+#define ORPHAN 999999u  // a socket no process holds
+#define REFRESHES 24u
+
+static int s_failures;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+static void make_process(uint32_t pid)
+{
+    char path[sizeof(NET_PROC_ROOT) + 32];
+    snprintf(path, sizeof(path), NET_PROC_ROOT "/%u", (unsigned)pid);
+    (void)mkdir(path, 0755);
+    snprintf(path, sizeof(path), NET_PROC_ROOT "/%u/fd", (unsigned)pid);
+    (void)mkdir(path, 0755);
+}
+
+// Only processes that hold no sockets end.
+static void end_process(uint32_t pid)
+{
+    char path[sizeof(NET_PROC_ROOT) + 32];
+    snprintf(path, sizeof(path), NET_PROC_ROOT "/%u/fd", (unsigned)pid);
+    (void)rmdir(path);
+    snprintf(path, sizeof(path), NET_PROC_ROOT "/%u", (unsigned)pid);
+    (void)rmdir(path);
+}
+
+static void open_socket(uint32_t pid, uint32_t fd, uint64_t inode)
+{
+    char path[sizeof(NET_PROC_ROOT) + 48];
+    char target[48];
+    snprintf(path, sizeof(path), NET_PROC_ROOT "/%u/fd/%u", (unsigned)pid, (unsigned)fd);
+    snprintf(target, sizeof(target), "socket:[%llu]", (unsigned long long)inode);
+    (void)symlink(target, path);
+}
+
+static void write_tcp(const uint64_t *inodes, uint32_t count)
+{
+    FILE *f = fopen(NET_PROC_ROOT "/net/tcp", "w");
+    if (!f) return;
+    fprintf(f, "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  "
+               "timeout inode\n");
+    for (uint32_t i = 0; i < count; i++) {
+        fprintf(f, "%4u: 0100007F:%04X 0100007F:0050 01 00000000:00000000 00:00000000 00000000  1000        0 %llu\n",
+                (unsigned)i, (unsigned)(1024u + i), (unsigned long long)inodes[i]);
+    }
+    fclose(f);
+}
+
+// Sockets opened by long-lived processes while many new ones come and go: each must still
+// be attributed once the round-robin reaches its owner, and the socket nobody holds must
+// be given up on after one full round.
+static void test_churn(void)
+{
+    NetConns nc;
+    NetConns_Init(&nc);
+    uint64_t inodes[OLD_COUNT + 2u];
+
+    for (uint32_t i = 0; i < OLD_COUNT; i++) make_process(OLD_FIRST + i);
+    make_process(1u);
+    open_socket(1u, 3u, 1u);
+    inodes[0] = 1u;
+    write_tcp(inodes, 1u);
+    NetConns_Refresh(&nc, 0); // every process read once, as a new one
+
+    // The old processes open a socket each, then keep running while others churn.
+    for (uint32_t i = 0; i < OLD_COUNT; i++) {
+        open_socket(OLD_FIRST + i, 3u, 1000u + i);
+        inodes[i] = 1000u + i;
+    }
+    inodes[OLD_COUNT] = 1u;
+    inodes[OLD_COUNT + 1u] = ORPHAN;
+    write_tcp(inodes, OLD_COUNT + 2u);
+
+    uint32_t churnFirst = 0;
+    for (uint32_t r = 0; r < REFRESHES; r++) {
+        if (churnFirst) {
+            for (uint32_t p = 0; p < CHURN; p++) end_process(churnFirst + p);
+        }
+        churnFirst = 10000u + r * CHURN;
+        for (uint32_t p = 0; p < CHURN; p++) make_process(churnFirst + p);
+        NetConns_Refresh(&nc, (int64_t)r + 1);
+    }
+
+    const NetLinux *nl = (const NetLinux *)nc.backend;
+    check(nl != NULL, "backend created");
+    if (nl) {
+        uint32_t owned = 0;
+        for (uint32_t i = 0; i < OLD_COUNT; i++) {
+            owned += (map_get(&nl->known, 1000u + i) == OLD_FIRST + i);
+        }
+        if (owned != OLD_COUNT) printf("  %u of %u old sockets attributed\n", (unsigned)owned, (unsigned)OLD_COUNT);
+        check(owned == OLD_COUNT, "sockets of old processes attributed under churn");
+        check(map_get(&nl->known, 1u) == 1u, "socket of a process read when new");
+        check(map_get(&nl->known, ORPHAN) == (UNOWNED | NOT_FOUND), "unheld socket given up on");
+    }
+    NetConns_Shutdown(&nc);
+}
+
+int main(void)
+{
+    (void)system("rm -rf '" NET_PROC_ROOT "'");
+    (void)mkdir(NET_PROC_ROOT, 0755);
+    (void)mkdir(NET_PROC_ROOT "/net", 0755);
+
+    test_churn();
+
+    (void)system("rm -rf '" NET_PROC_ROOT "'");
+    if (s_failures == 0) printf("net_conn_linux: ok\n");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,863 @@
+// CCM_bench: micro-benchmarks for the portable hot paths, run on synthetic data (plus, on
+// Linux, the live /proc process walk).
+//
+// Usage: CCM_bench [--filter SUBSTR] [--min-time SEC] [--csv FILE] [--quick]
+//
+// Each benchmark repeats its operation until --min-time seconds of measured time have
+// accumulated and reports ns/op and allocations/op (allocations counted at the
+// SelfStats_NoteAlloc sites, i.e. the same ones the Self tab reports) in steady state:
+// the calibration batch doubles as warm-up, so one-time buffer growth is not counted.
+// Per-op setup such as restoring unsorted rows before a sort is excluded from the
+// measurement.
+// --csv writes one row per benchmark so runs from two builds can be diffed.
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "../src/etw_kernel.h"
+#include "../src/external_sensors.h"
+#include "../src/monitor.h"
+#include "../src/qpc.h"
+
+typedef struct BenchResult {
+    char name[64];
+    uint64_t ops;
+    double nsPerOp;
+    double allocsPerOp;
+} BenchResult;
+
+// Runs reps operations and returns the measured Qpc ticks (setup excluded).
+typedef int64_t (*BenchFn)(void *ctx, uint32_t reps);
+
+typedef struct BenchRunner {
+    const char *filter;
+    double minTimeSec;
+    double qpcFreq;
+    BenchResult *results;
+    uint32_t resultCount;
+    uint32_t resultCap;
+} BenchRunner;
+
+static volatile uint64_t g_sink;
+
+static uint32_t rng_next(uint32_t *state)
+{
+    // xorshift32: deterministic synthetic data across runs and platforms.
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static bool bench_wanted(const BenchRunner *br, const char *name)
+{
+    return !br->filter || strstr(name, br->filter) != NULL;
+}
+
+static void bench_run(BenchRunner *br, const char *name, BenchFn fn, void *ctx)
+{
+    if (!bench_wanted(br, name)) return;
+
+    // Calibrate: grow the batch until one batch takes ~1/10 of the budget.
+    uint32_t reps = 1;
+    for (;;) {
+        const double sec = Qpc_Seconds(fn(ctx, reps), br->qpcFreq);
+        if (sec >= br->minTimeSec * 0.1 || reps >= (1u << 30)) break;
+        reps *= 2u;
+    }
+
+    uint64_t ops = 0;
+    int64_t ticks = 0;
+    const uint32_t allocs0 = SelfStats_AllocCount();
+    while (ops == 0 || Qpc_Seconds(ticks, br->qpcFreq) < br->minTimeSec) {
+        ticks += fn(ctx, reps);
+        ops += reps;
+    }
+    const uint32_t allocs = SelfStats_AllocCount() - allocs0;
+
+    if (br->resultCount == br->resultCap) {
+        const uint32_t newCap = br->resultCap ? br->resultCap * 2u : 64u;
+        BenchResult *p = (BenchResult *)realloc(br->results, (size_t)newCap * sizeof(*p));
+        if (!p) return;
+        br->results = p;
+        br->resultCap = newCap;
+    }
+    BenchResult *r = &br->results[br->resultCount++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->ops = ops;
+    r->nsPerOp = Qpc_Seconds(ticks, br->qpcFreq) * 1e9 / (double)ops;
+    r->allocsPerOp = (double)allocs / (double)ops;
+
+    printf("%-40s %12llu %14.1f %10.3f\n", r->name, (unsigned long long)r->ops, r->nsPerOp, r->allocsPerOp);
+    fflush(stdout);
+}
+
+// --- RingBuf -------------------------------------------------------------------------
+
+static int64_t bench_ringbuf_push(void *ctx, uint32_t reps)
+{
+    RingBufF *rb = (RingBufF *)ctx;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        RingBuf_Push(rb, (float)(i & 127u));
+    }
+    return Qpc_Now() - t0;
+}
+
+static int64_t bench_ringbuf_get_oldest(void *ctx, uint32_t reps)
+{
+    const RingBufF *rb = (const RingBufF *)ctx;
+    float acc = 0.0f;
+    uint32_t idx = 0;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        acc += RingBuf_GetOldest(rb, idx);
+        if (++idx == rb->count) idx = 0;
+    }
+    const int64_t dt = Qpc_Now() - t0;
+    g_sink += (uint64_t)acc;
+    return dt;
+}
+
+// One op = a full pass over the history, as the graph autoscale does per series per frame.
+static int64_t bench_ringbuf_scan_oldest(void *ctx, uint32_t reps)
+{
+    const RingBufF *rb = (const RingBufF *)ctx;
+    float acc = 0.0f;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        float m = 0.0f;
+        for (uint32_t k = 0; k < rb->count; k++) {
+            const float v = RingBuf_GetOldest(rb, k);
+            if (v > m) m = v;
+        }
+        acc += m;
+    }
+    const int64_t dt = Qpc_Now() - t0;
+    g_sink += (uint64_t)acc;
+    return dt;
+}
+
+static int64_t bench_ringbuf_max(void *ctx, uint32_t reps)
+{
+    const RingBufF *rb = (const RingBufF *)ctx;
+    float acc = 0.0f;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        acc += RingBuf_Max(rb, 0.0f);
+    }
+    const int64_t dt = Qpc_Now() - t0;
+    g_sink += (uint64_t)acc;
+    return dt;
+}
+
+// One op = one sample in and the window's max/mean/p95 read back (what replaces the scan).
+static int64_t bench_window_stats(void *ctx, uint32_t reps)
+{
+    WindowStats *ws = (WindowStats *)ctx;
+    uint32_t rng = 12345u;
+    float acc = 0.0f;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        WindowStats_Push(ws, (float)(rng_next(&rng) % 10000u) * 0.01f);
+        acc += WindowStats_Max(ws) + WindowStats_Mean(ws) + WindowStats_Percentile(ws, 95.0);
+    }
+    const int64_t dt = Qpc_Now() - t0;
+    g_sink += (uint64_t)acc;
+    return dt;
+}
+
+// One op = one usage-like sample appended to a day-long archive (1/8 % steps, 5 s apart).
+static int64_t bench_cseries_push(void *ctx, uint32_t reps)
+{
+    CompressedSeries *cs = (CompressedSeries *)ctx;
+    uint32_t rng = 777u;
+    int64_t t = cs->prevT;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        t += 5000 + (int64_t)(rng_next(&rng) % 3u);
+        CompressedSeries_Push(cs, 20.0f + (float)(rng_next(&rng) % 2000u) * 0.01f, t);
+    }
+    return Qpc_Now() - t0;
+}
+
+// One op = one sample streamed back out of the archive.
+static int64_t bench_cseries_decode(void *ctx, uint32_t reps)
+{
+    const CompressedSeries *cs = (const CompressedSeries *)ctx;
+    SeriesCursor c;
+    SeriesCursor_Begin(&c, cs);
+    float acc = 0.0f;
+    int64_t t = 0;
+    float v = 0.0f;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        if (!SeriesCursor_Next(&c, &t, &v)) {
+            SeriesCursor_Begin(&c, cs);
+        }
+        acc += v;
+    }
+    const int64_t dt = Qpc_Now() - t0;
+    g_sink += (uint64_t)acc + (uint64_t)t;
+    return dt;
+}
+
+// --- Per-core history ------------------------------------------------------------------
+
+#define BENCH_CORES 256u
+
+typedef struct CoreBench {
+    RingBufF rings[BENCH_CORES]; // one heap ring per core (the old layout)
+    CoreHistory matrix;
+    float values[BENCH_CORES];
+} CoreBench;
+
+// One op = one sample of every core.
+static int64_t bench_core_push_rings(void *ctx, uint32_t reps)
+{
+    CoreBench *b = (CoreBench *)ctx;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        for (uint32_t c = 0; c < BENCH_CORES; c++) {
+            RingBuf_PushAt(&b->rings[c], b->values[c], (int64_t)i);
+        }
+    }
+    return Qpc_Now() - t0;
+}
+
+static int64_t bench_core_push_matrix(void *ctx, uint32_t reps)
+{
+    CoreBench *b = (CoreBench *)ctx;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        CoreHistory_Push(&b->matrix, b->values, (int64_t)i);
+    }
+    return Qpc_Now() - t0;
+}
+
+// One op = a full copy of every core's history, as frame capture does when it falls behind.
+static int64_t bench_core_copy_matrix(void *ctx, uint32_t reps)
+{
+    CoreBench *b = (CoreBench *)ctx;
+    CoreHistory dst;
+    memset(&dst, 0, sizeof(dst));
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        dst.pushes = UINT64_MAX; // force the full copy
+        (void)CoreHistory_CopyFrom(&dst, &b->matrix);
+    }
+    const int64_t dt = Qpc_Now() - t0;
+    CoreHistory_Shutdown(&dst);
+    return dt;
+}
+
+static void run_core_benches(BenchRunner *br)
+{
+    CoreBench *b = (CoreBench *)calloc(1, sizeof(CoreBench));
+    if (!b) return;
+
+    bool ok = CoreHistory_Init(&b->matrix, BENCH_CORES, 240);
+    for (uint32_t c = 0; c < BENCH_CORES; c++) {
+        ok = RingBuf_Init(&b->rings[c], 240) && ok;
+        b->values[c] = (float)(c % 100u);
+    }
+    if (ok) {
+        bench_run(br, "core_push/rings/256", bench_core_push_rings, b);
+        bench_run(br, "core_push/matrix/256", bench_core_push_matrix, b);
+        bench_run(br, "core_copy/matrix/256x240", bench_core_copy_matrix, b);
+    }
+
+    for (uint32_t c = 0; c < BENCH_CORES; c++) {
+        RingBuf_Shutdown(&b->rings[c]);
+    }
+    CoreHistory_Shutdown(&b->matrix);
+    free(b);
+}
+
+// --- Process table -------------------------------------------------------------------
+
+static const wchar_t *const kOwners[] = {
+    L"SYSTEM", L"LOCAL SERVICE", L"NETWORK SERVICE", L"user", L"admin", L"",
+};
+
+// Synthetic process list: a few large groups (browser-style multi-process apps) plus a
+// long tail of single-instance executables, in random order. Strings go into strings,
+// which each benchmarked table then copies.
+static void make_rows(ProcRow *rows, uint32_t count, uint32_t seed, StrPool *strings)
+{
+    uint32_t rng = seed ? seed : 1u;
+    const uint32_t nameCount = 64u + count / 100u;
+
+    for (uint32_t i = 0; i < count; i++) {
+        ProcRow *r = &rows[i];
+        memset(r, 0, sizeof(*r));
+
+        const uint32_t roll = rng_next(&rng);
+        const uint32_t nameIdx = (roll % 4u == 0) ? (roll >> 8) % 4u : (roll >> 8) % nameCount;
+
+        r->pid = 4u + i * 4u;
+        r->cpuPct = (rng_next(&rng) % 8u == 0) ? (float)(rng_next(&rng) % 10000u) / 100.0f : 0.0f;
+        r->workingSetBytes = (uint64_t)(rng_next(&rng) % 2000000u) * 1024u;
+
+        wchar_t buf[MAX_PATH];
+        swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"proc%03u.exe", (unsigned)nameIdx);
+        r->nameId = StrPool_Intern(strings, buf);
+        swprintf(buf, sizeof(buf) / sizeof(buf[0]),
+                 L"C:\\Program Files\\Vendor%02u\\App%03u\\proc%03u.exe",
+                 (unsigned)(nameIdx % 17u), (unsigned)nameIdx, (unsigned)nameIdx);
+        r->pathId = StrPool_Intern(strings, buf);
+        r->ownerId = StrPool_Intern(strings, kOwners[rng_next(&rng) % (sizeof(kOwners) / sizeof(kOwners[0]))]);
+
+        if (rng_next(&rng) % 4u == 0) {
+            r->hasNet = true;
+            swprintf(buf, sizeof(buf) / sizeof(buf[0]), L"10.%u.%u.%u:443",
+                     (unsigned)(rng_next(&rng) % 256u), (unsigned)(rng_next(&rng) % 256u),
+                     (unsigned)(rng_next(&rng) % 256u));
+            r->netRemoteId = StrPool_Intern(strings, buf);
+        }
+    }
+}
+
+typedef struct SortBench {
+    ProcTable pt;
+    const ProcRow *src;
+    uint32_t count;
+    ProcSortKey key;
+    bool ascending;
+    uint32_t limit;
+    uint32_t rng;
+} SortBench;
+
+static int64_t bench_proc_sort(void *ctx, uint32_t reps)
+{
+    SortBench *b = (SortBench *)ctx;
+    int64_t ticks = 0;
+    for (uint32_t i = 0; i < reps; i++) {
+        memcpy(b->pt.rows, b->src, (size_t)b->count * sizeof(ProcRow));
+        b->pt.rowCount = b->count;
+        const int64_t t0 = Qpc_Now();
+        ProcTable_Sort(&b->pt, b->key, b->ascending, b->limit);
+        ticks += Qpc_Now() - t0;
+    }
+    return ticks;
+}
+
+// Steady-state re-sort: the rows stay in the order the last sort left them (as
+// ProcTable_Sample seeds them) and 1 in 8 changes its CPU% between sorts.
+static int64_t bench_proc_resort(void *ctx, uint32_t reps)
+{
+    SortBench *b = (SortBench *)ctx;
+    int64_t ticks = 0;
+    for (uint32_t i = 0; i < reps; i++) {
+        for (uint32_t r = 0; r < b->count; r++) {
+            const uint32_t roll = rng_next(&b->rng);
+            if (roll % 8u == 0) {
+                b->pt.rows[r].cpuPct = (roll % 64u == 0) ? (float)((roll >> 8) % 10000u) / 100.0f : 0.0f;
+            }
+        }
+        const int64_t t0 = Qpc_Now();
+        ProcTable_Sort(&b->pt, b->key, b->ascending, b->limit);
+        ticks += Qpc_Now() - t0;
+    }
+    return ticks;
+}
+
+// One op = one process's share of a sample: its CPU-delta state lookup, its row lookup,
+// and (amortized) the end-of-sample compaction and re-indexing. Flat ns/op across process
+// counts means the per-sample cost is linear. Every pass, 1 in 64 PIDs belongs to a new
+// process (same PID, new creation time), so entries are added and dropped throughout.
+typedef struct StateBench {
+    ProcTable pt;
+    const ProcRow *src;
+    uint32_t count;
+    uint32_t next;
+    uint32_t pass;
+} StateBench;
+
+static int64_t bench_proc_state(void *ctx, uint32_t reps)
+{
+    StateBench *b = (StateBench *)ctx;
+    ProcTable *pt = &b->pt;
+    uint64_t acc = 0;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        if (b->next == 0) ProcTable_PrevBegin(pt);
+
+        const ProcRow *r = &b->src[b->next];
+        const uint64_t createTime = ((b->next + b->pass) % 64u == 0) ? b->pass : 0;
+        const uint32_t idx = ProcTable_PrevFindOrAdd(pt, r->pid, createTime);
+        pt->prev[idx].procTotal100ns += 1;
+        const ProcRow *row = ProcTable_FindRow(pt, r->pid);
+        acc += row ? row->pid : 0;
+
+        if (++b->next == b->count) {
+            ProcTable_PrevEnd(pt);
+            b->next = 0;
+            b->pass++;
+        }
+    }
+    const int64_t ticks = Qpc_Now() - t0;
+    g_sink += acc;
+    return ticks;
+}
+
+typedef struct ViewBench {
+    Monitor *mon;
+    const ProcRow *src;
+    uint32_t count;
+} ViewBench;
+
+static int64_t bench_proc_view(void *ctx, uint32_t reps)
+{
+    ViewBench *b = (ViewBench *)ctx;
+    int64_t ticks = 0;
+    for (uint32_t i = 0; i < reps; i++) {
+        // Flat mode sorts the table in place; start every rebuild from sample order.
+        memcpy(b->mon->procTable.rows, b->src, (size_t)b->count * sizeof(ProcRow));
+        b->mon->procTable.rowCount = b->count;
+        ProcTable_IndexRows(&b->mon->procTable); // as ProcTable_Sample leaves it
+        const int64_t t0 = Qpc_Now();
+        Monitor_RefreshProcView(b->mon);
+        ticks += Qpc_Now() - t0;
+    }
+    return ticks;
+}
+
+static const char *sort_key_name(ProcSortKey key)
+{
+    switch (key) {
+    case PROC_SORT_CPU: return "cpu";
+    case PROC_SORT_PID: return "pid";
+    case PROC_SORT_MEM: return "mem";
+    case PROC_SORT_OWNER: return "owner";
+    case PROC_SORT_NET: return "net";
+    case PROC_SORT_NAME: return "name";
+    case PROC_SORT_PATH: return "path";
+    }
+    return "?";
+}
+
+static void run_proc_benches(BenchRunner *br, uint32_t count)
+{
+    ProcRow *src = (ProcRow *)malloc((size_t)count * sizeof(ProcRow));
+    StrPool strings;
+    if (!src || !StrPool_Init(&strings)) {
+        free(src);
+        return;
+    }
+    make_rows(src, count, 0x9E3779B9u ^ count, &strings);
+
+    char name[64];
+
+    SortBench sb;
+    memset(&sb, 0, sizeof(sb));
+    ProcTable_Init(&sb.pt);
+    if (ProcTable_EnsureRows(&sb.pt, count) && StrPool_CopyFrom(&sb.pt.strings, &strings)) {
+        sb.src = src;
+        sb.count = count;
+        for (int k = PROC_SORT_CPU; k <= PROC_SORT_PATH; k++) {
+            // Default direction when the column header is first clicked.
+            sb.key = (ProcSortKey)k;
+            sb.ascending = !(sb.key == PROC_SORT_CPU || sb.key == PROC_SORT_MEM);
+            snprintf(name, sizeof(name), "proc_sort/%s/%u", sort_key_name(sb.key), (unsigned)count);
+            bench_run(br, name, bench_proc_sort, &sb);
+        }
+
+        // What the UI asks for: the visible rows plus a page, in order.
+        sb.key = PROC_SORT_CPU;
+        sb.ascending = false;
+        sb.limit = 64;
+        snprintf(name, sizeof(name), "proc_sort/cpu_top64/%u", (unsigned)count);
+        bench_run(br, name, bench_proc_sort, &sb);
+
+        sb.rng = 0x2545F491u;
+        memcpy(sb.pt.rows, src, (size_t)count * sizeof(ProcRow));
+        sb.pt.rowCount = count;
+        ProcTable_Sort(&sb.pt, sb.key, sb.ascending, 0);
+        sb.limit = 0;
+        snprintf(name, sizeof(name), "proc_resort/cpu/%u", (unsigned)count);
+        bench_run(br, name, bench_proc_resort, &sb);
+        sb.limit = 64;
+        snprintf(name, sizeof(name), "proc_resort/cpu_top64/%u", (unsigned)count);
+        bench_run(br, name, bench_proc_resort, &sb);
+    }
+    ProcTable_Shutdown(&sb.pt);
+
+    StateBench stb;
+    memset(&stb, 0, sizeof(stb));
+    ProcTable_Init(&stb.pt);
+    if (ProcTable_EnsureRows(&stb.pt, count) && StrPool_CopyFrom(&stb.pt.strings, &strings)) {
+        memcpy(stb.pt.rows, src, (size_t)count * sizeof(ProcRow));
+        stb.pt.rowCount = count;
+        ProcTable_IndexRows(&stb.pt);
+        stb.src = src;
+        stb.count = count;
+        snprintf(name, sizeof(name), "proc_state/%u", (unsigned)count);
+        bench_run(br, name, bench_proc_state, &stb);
+    }
+    ProcTable_Shutdown(&stb.pt);
+
+    static Monitor mon;
+    if (Monitor_Init(&mon, 1, 2, NULL, 0) && ProcTable_EnsureRows(&mon.procTable, count) &&
+        StrPool_CopyFrom(&mon.procTable.strings, &strings)) {
+        ViewBench vb = {&mon, src, count};
+
+        ProcViewSettings_Init(&mon.procView.settings);
+        mon.procView.settings.stacked = false;
+        snprintf(name, sizeof(name), "proc_view/flat/%u", (unsigned)count);
+        bench_run(br, name, bench_proc_view, &vb);
+
+        ProcViewSettings_Init(&mon.procView.settings);
+        snprintf(name, sizeof(name), "proc_view/stacked/%u", (unsigned)count);
+        bench_run(br, name, bench_proc_view, &vb);
+
+        // Expand the biggest group (the first four names get a quarter of all rows).
+        ProcViewSettings_ToggleExpanded(&mon.procView.settings, L"proc000.exe");
+        snprintf(name, sizeof(name), "proc_view/expanded/%u", (unsigned)count);
+        bench_run(br, name, bench_proc_view, &vb);
+    }
+    Monitor_Shutdown(&mon);
+
+    StrPool_Shutdown(&strings);
+    free(src);
+}
+
+// --- Sharded walk ---------------------------------------------------------------------
+
+typedef struct WalkBench {
+    ProcTable pt;
+    uint32_t *out;
+    uint32_t count;
+} WalkBench;
+
+// Stands in for a backend probe: a fixed amount of per-process work, one record written.
+static void walk_probe(void *ctx, uint32_t first, uint32_t end, ProcWalkText *text)
+{
+    (void)text;
+    WalkBench *b = (WalkBench *)ctx;
+    for (uint32_t i = first; i < end; i++) {
+        uint32_t x = i + 1u;
+        for (uint32_t k = 0; k < 256u; k++) x = rng_next(&x);
+        b->out[i] = x;
+    }
+}
+
+static int64_t bench_proc_walk(void *ctx, uint32_t reps)
+{
+    WalkBench *b = (WalkBench *)ctx;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        ProcTable_Walk(&b->pt, b->count, walk_probe, b);
+    }
+    const int64_t ticks = Qpc_Now() - t0;
+    g_sink += b->out[b->count - 1u];
+    return ticks;
+}
+
+// The walk dispatch on a synthetic list, so thread scaling shows whatever the process count
+// of the machine running the bench.
+static void run_walk_benches(BenchRunner *br, uint32_t count)
+{
+    static const uint32_t kThreads[] = {1u, 2u, 4u};
+    static WalkBench wb;
+    wb.count = count;
+    wb.out = (uint32_t *)calloc(count, sizeof(uint32_t));
+    if (!wb.out) return;
+    for (uint32_t i = 0; i < sizeof(kThreads) / sizeof(kThreads[0]); i++) {
+        ProcTable_Init(&wb.pt);
+        wb.pt.walkThreads = kThreads[i];
+        char name[64];
+        snprintf(name, sizeof(name), "proc_walk/synthetic/%u/t%u", (unsigned)count, (unsigned)kThreads[i]);
+        bench_run(br, name, bench_proc_walk, &wb);
+        ProcTable_Shutdown(&wb.pt);
+    }
+    free(wb.out);
+}
+
+#if CCM_BENCH_PROCFS
+// --- Live process walk (Linux /proc backend) -----------------------------------------------
+
+typedef struct SampleBench {
+    ProcTable pt;
+} SampleBench;
+
+static int64_t bench_proc_sample(void *ctx, uint32_t reps)
+{
+    SampleBench *b = (SampleBench *)ctx;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        ProcTable_Sample(&b->pt);
+    }
+    const int64_t ticks = Qpc_Now() - t0;
+    g_sink += b->pt.rowCount;
+    return ticks;
+}
+
+// One walk of this machine's processes per op, refreshing every process with 1, 2 and 4
+// walk threads (pinned, so used whatever the process count), then on one thread with the
+// adaptive refresh tiers settled.
+static void run_sample_benches(BenchRunner *br)
+{
+    static const uint32_t kThreads[] = {1u, 2u, 4u, 1u};
+    const uint32_t runs = sizeof(kThreads) / sizeof(kThreads[0]);
+    for (uint32_t i = 0; i < runs; i++) {
+        static SampleBench sb;
+        const bool adaptive = (i == runs - 1u);
+        ProcTable_Init(&sb.pt);
+        sb.pt.walkThreads = kThreads[i];
+        if (!adaptive) sb.pt.slowPeriod = 1;
+        for (uint32_t k = 0; k <= (adaptive ? PROC_TIER_QUIET_SAMPLES : 0u); k++) {
+            ProcTable_Sample(&sb.pt);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "proc_sample/procfs/%u/%s%u", (unsigned)sb.pt.rowCount,
+                 adaptive ? "adaptive/t" : "t", (unsigned)kThreads[i]);
+        bench_run(br, name, bench_proc_sample, &sb);
+        ProcTable_Shutdown(&sb.pt);
+    }
+}
+#endif
+
+// --- Connection table ------------------------------------------------------------------
+
+typedef struct NetBench {
+    NetConns nc;
+    NetConn *conns;
+    uint32_t count;
+    uint32_t pids; // conns belong to pids 4, 8, ..., 4 * pids
+} NetBench;
+
+static void make_conns(NetBench *b, uint32_t count, uint32_t pids)
+{
+    uint32_t rng = 0x6E657431u;
+    b->count = count;
+    b->pids = pids;
+    for (uint32_t i = 0; i < count; i++) {
+        NetConn *c = &b->conns[i];
+        memset(c, 0, sizeof(*c));
+        c->pid = 4u + (rng_next(&rng) % pids) * 4u;
+        const uint32_t roll = rng_next(&rng);
+        c->proto = (roll % 5u == 0) ? NET_PROTO_UDP : NET_PROTO_TCP;
+        c->family = (roll % 3u == 0) ? 6 : 4;
+        c->state = (roll % 7u == 0) ? NET_STATE_LISTEN : NET_STATE_ESTABLISHED;
+        // A few hundred endpoints, so processes repeat them.
+        const uint32_t host = rng_next(&rng) % 256u;
+        if (c->family == 4) {
+            c->remote[0] = 10;
+            c->remote[3] = (uint8_t)host;
+        } else {
+            c->remote[0] = 0x20;
+            c->remote[1] = 0x01;
+            c->remote[15] = (uint8_t)host;
+        }
+        c->remotePort = (roll % 2u) ? 443 : 80;
+    }
+}
+
+// One refresh's work minus the OS listing: index the sockets, then look up every process.
+static int64_t bench_net_index(void *ctx, uint32_t reps)
+{
+    NetBench *b = (NetBench *)ctx;
+    uint64_t acc = 0;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        NetConns_Begin(&b->nc);
+        for (uint32_t k = 0; k < b->count; k++) {
+            NetConns_Add(&b->nc, &b->conns[k]);
+        }
+        NetConns_End(&b->nc, t0);
+        for (uint32_t p = 0; p < b->pids; p++) {
+            const NetPidStats *st = NetConns_Find(&b->nc, 4u + p * 4u);
+            acc += st ? st->remoteConns : 0;
+        }
+    }
+    const int64_t ticks = Qpc_Now() - t0;
+    g_sink += acc;
+    return ticks;
+}
+
+static void run_net_benches(BenchRunner *br, uint32_t count)
+{
+    NetBench nb;
+    memset(&nb, 0, sizeof(nb));
+    nb.conns = (NetConn *)malloc((size_t)count * sizeof(NetConn));
+    if (nb.conns) {
+        NetConns_Init(&nb.nc);
+        make_conns(&nb, count, count / 8u);
+        char name[64];
+        snprintf(name, sizeof(name), "net_index/%u", (unsigned)count);
+        bench_run(br, name, bench_net_index, &nb);
+        NetConns_Shutdown(&nb.nc);
+    }
+    free(nb.conns);
+}
+
+// --- External sensor provider response -----------------------------------------------
+
+static const char kSensorResponse[] =
+    "tempC=61.5\n"
+    "powerW=37.25\n"
+    "fanRpm=1450\n"
+    "status=ok (bench provider)\n"
+    "vendorKey=ignored\n";
+
+static int64_t bench_sensor_parse(void *ctx, uint32_t reps)
+{
+    (void)ctx;
+    ExternalSensorsSample s;
+    memset(&s, 0, sizeof(s));
+    uint64_t hits = 0;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        hits += ExternalSensors_ParseResponse(kSensorResponse, (uint32_t)(sizeof(kSensorResponse) - 1), &s) ? 1u : 0u;
+    }
+    const int64_t dt = Qpc_Now() - t0;
+    g_sink += hits + (uint64_t)s.fanRpm;
+    return dt;
+}
+
+// --- ETW event classification --------------------------------------------------------
+
+#define ETW_EVENT_MIX 4096u
+
+typedef struct EtwBench {
+    uint64_t keyword[ETW_EVENT_MIX];
+    uint8_t opcode[ETW_EVENT_MIX];
+    uint64_t counts[ETW_CAT_COUNT];
+} EtwBench;
+
+static void make_etw_events(EtwBench *b)
+{
+    // Roughly what a busy desktop session sees: mostly context switches and DPC/ISR,
+    // then syscalls, file and disk I/O, with a few unclassified keywords.
+    static const uint64_t kKeywords[] = {
+        0x00000800ull, 0x00000800ull, 0x00000800ull, 0x00000080ull, 0x00000002ull,
+        0x02000000ull, 0x00000100ull, 0x00001000ull, 0x00010000ull, 0x00020000ull,
+        0x00000001ull, 0x00000004ull, 0x01000000ull, 0x00000000ull, 0x80000000ull,
+    };
+    static const uint8_t kOpcodes[] = {36, 36, 36, 50, 51, 1, 2, 10, 0};
+
+    uint32_t rng = 0x12345678u;
+    for (uint32_t i = 0; i < ETW_EVENT_MIX; i++) {
+        b->keyword[i] = kKeywords[rng_next(&rng) % (sizeof(kKeywords) / sizeof(kKeywords[0]))];
+        b->opcode[i] = kOpcodes[rng_next(&rng) % (sizeof(kOpcodes) / sizeof(kOpcodes[0]))];
+    }
+}
+
+static int64_t bench_etw_classify(void *ctx, uint32_t reps)
+{
+    EtwBench *b = (EtwBench *)ctx;
+    uint32_t idx = 0;
+    const int64_t t0 = Qpc_Now();
+    for (uint32_t i = 0; i < reps; i++) {
+        const uint32_t cats = EtwKernel_Classify(b->keyword[idx], b->opcode[idx]);
+        // Same per-category counting the ETW callback does (without the interlocked ops).
+        for (uint32_t c = 0; c < ETW_CAT_COUNT; c++) {
+            b->counts[c] += (cats >> c) & 1u;
+        }
+        idx = (idx + 1u) & (ETW_EVENT_MIX - 1u);
+    }
+    return Qpc_Now() - t0;
+}
+
+// -------------------------------------------------------------------------------------
+
+static bool write_csv(const BenchRunner *br, const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "bench,ops,ns_per_op,allocs_per_op\n");
+    for (uint32_t i = 0; i < br->resultCount; i++) {
+        const BenchResult *r = &br->results[i];
+        fprintf(f, "%s,%llu,%.3f,%.4f\n", r->name, (unsigned long long)r->ops, r->nsPerOp, r->allocsPerOp);
+    }
+    return fclose(f) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    setlocale(LC_ALL, "C");
+
+    BenchRunner br;
+    memset(&br, 0, sizeof(br));
+    br.minTimeSec = 0.25;
+    br.qpcFreq = Qpc_Freq();
+    const char *csvPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            br.filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            br.minTimeSec = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            br.minTimeSec = 0.02;
+        } else {
+            fprintf(stderr, "usage: %s [--filter SUBSTR] [--min-time SEC] [--csv FILE] [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (br.minTimeSec <= 0.0) br.minTimeSec = 0.02;
+
+    printf("%-40s %12s %14s %10s\n", "bench", "ops", "ns/op", "allocs/op");
+
+    RingBufF rb;
+    if (RingBuf_Init(&rb, 240)) {
+        bench_run(&br, "ringbuf_push/240", bench_ringbuf_push, &rb);
+        bench_run(&br, "ringbuf_get_oldest/240", bench_ringbuf_get_oldest, &rb);
+        bench_run(&br, "ringbuf_scan_oldest/240", bench_ringbuf_scan_oldest, &rb);
+        bench_run(&br, "ringbuf_max/240", bench_ringbuf_max, &rb);
+        RingBuf_Shutdown(&rb);
+    }
+
+    CompressedSeries cs;
+    if (CompressedSeries_Init(&cs, (int64_t)MONITOR_ARCHIVE_SEC * 1000, 0.125f, 16u)) {
+        bench_run(&br, "cseries_push/day", bench_cseries_push, &cs);
+        bench_run(&br, "cseries_decode/day", bench_cseries_decode, &cs);
+        const uint64_t samples = CompressedSeries_SampleCount(&cs);
+        if (samples > 0) {
+            printf("%-40s %12llu samples %8.2f bytes/sample\n", "  cseries archive",
+                   (unsigned long long)samples, (double)CompressedSeries_Bytes(&cs) / (double)samples);
+        }
+        CompressedSeries_Shutdown(&cs);
+    }
+
+    WindowStats ws;
+    if (WindowStats_Init(&ws, 240)) {
+        bench_run(&br, "window_stats_push_read/240", bench_window_stats, &ws);
+        WindowStats_Shutdown(&ws);
+    }
+
+    run_core_benches(&br);
+
+    static const uint32_t kRowCounts[] = {1000u, 10000u, 50000u};
+    for (uint32_t i = 0; i < sizeof(kRowCounts) / sizeof(kRowCounts[0]); i++) {
+        run_proc_benches(&br, kRowCounts[i]);
+    }
+    run_net_benches(&br, 1000u);
+    run_net_benches(&br, 20000u);
+    run_walk_benches(&br, 8192u);
+#if CCM_BENCH_PROCFS
+    run_sample_benches(&br);
+#endif
+
+    bench_run(&br, "sensor_parse_response", bench_sensor_parse, NULL);
+
+    static EtwBench etw;
+    make_etw_events(&etw);
+    bench_run(&br, "etw_classify", bench_etw_classify, &etw);
+
+    int rc = 0;
+    if (csvPath && !write_csv(&br, csvPath)) {
+        fprintf(stderr, "cannot write %s\n", csvPath);
+        rc = 1;
+    }
+    free(br.results);
+    return rc;
+}
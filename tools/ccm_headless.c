@@ -0,0 +1,305 @@
+// Headless CCM: runs the portable sampling engine (Sampler thread + platform collectors)
+// without any UI and prints a short text summary of the newest frame per interval.
+//
+// Usage: CCM_headless [--interval SEC] [--count N] [--top N] [--flat] [--self]
+//                     [--group-by name|owner|path]
+//                     [--record FILE | --replay FILE [--speed X]]
+//                     [--watch PID]... [--watch-hz HZ]
+//
+// --group-by picks the column the stacked process view groups by (default name).
+// --self prints the sampler's per-stage latency/allocation summary (CSV) on exit.
+// --record writes every tick's raw collector output to FILE (record.h).
+// --replay runs the engine on a capture instead of the collectors, at X times the
+// recorded speed (default 1; 0 = as fast as possible) until it ends or --count frames
+// were printed. Captures from the Windows build replay here unchanged.
+// --watch samples PID on the high-frequency watch list (proc_watch.h; up to 4, at HZ,
+// default 50) and prints per interval what its samples since the last print averaged.
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/proc_watch.h"
+#include "../src/sampler.h"
+
+static void sleep_seconds(double sec)
+{
+    if (sec <= 0.0) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)sec;
+    ts.tv_nsec = (long)((sec - (double)ts.tv_sec) * 1e9);
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+static void print_sample(const MonitorFrame *m, uint32_t top)
+{
+    printf("Frame #%llu  age %.1f ms  collect %.2f ms\n",
+           (unsigned long long)m->seq, Sampler_FrameAgeSec(m) * 1000.0, m->collectMs);
+    printf("CPU %5.1f%% (min %.1f max %.1f avg %.1f p95 %.1f)  ctx/s %.0f  intr/s %.0f  runq %.0f\n",
+           m->totalUsage,
+           m->totalUsageMin, m->totalUsageMax,
+           m->totalUsageStats.mean, m->totalUsageStats.p95,
+           m->snap.rates.contextSwitchesPerSec,
+           m->snap.rates.interruptsPerSec,
+           m->snap.rates.processorQueueLength);
+
+    printf("Mem %5.1f%% of %.0f MB  commit %5.1f%%  disk R %.2f MB/s W %.2f MB/s\n",
+           m->memUsedPct, (double)m->memTotalPhysBytes / (1024.0 * 1024.0),
+           m->commitUsedPct,
+           m->diskReadMBps, m->diskWriteMBps);
+
+    for (uint32_t i = 0; i < m->diskCount; i++) {
+        printf("  %-12ls R %8.2f MB/s  W %8.2f MB/s\n", m->disks[i].name, m->disks[i].readMBps, m->disks[i].writeMBps);
+    }
+
+    uint32_t viewCount = 0;
+    const ProcRow *rows = ProcView_Rows(&m->procView, &m->procTable, &viewCount);
+    printf("Processes: %u (%u rows shown as %s)\n",
+           (unsigned)m->procCount, (unsigned)viewCount,
+           m->procView.settings.stacked ? "groups" : "processes");
+
+    const uint32_t n = (viewCount < top) ? viewCount : top;
+    for (uint32_t i = 0; i < n; i++) {
+        const ProcRow *r = &rows[i];
+        wchar_t name[96];
+        ProcView_RowName(r, &m->procTable.strings, name, sizeof(name) / sizeof(name[0]));
+        printf("  %7u %6.1f%% %9.1f MB  %-10ls %ls\n",
+               (unsigned)r->pid, r->cpuPct,
+               (double)r->workingSetBytes / (1024.0 * 1024.0),
+               StrPool_Get(&m->procTable.strings, r->ownerId), name);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+// Mean of the samples pushed since the last print (*seen = pushes seen by it), and the peak.
+static double fresh_mean(const RingBufF *rb, uint64_t *seen, uint32_t *outN, float *outPeak)
+{
+    const uint64_t fresh = rb->pushes - *seen;
+    const uint32_t n = (fresh < rb->count) ? (uint32_t)fresh : rb->count;
+    *seen = rb->pushes;
+    double sum = 0.0;
+    float peak = 0.0f;
+    for (uint32_t i = rb->count - n; i < rb->count; i++) {
+        const float v = RingBuf_GetOldest(rb, i);
+        sum += v;
+        if (v > peak) peak = v;
+    }
+    *outN = n;
+    if (outPeak) *outPeak = peak;
+    return n ? sum / n : 0.0;
+}
+
+static void print_watch(ProcWatch *w, ProcWatchView *v, uint64_t seen[][4], double interval)
+{
+    ProcWatch_Copy(w, v);
+    for (uint32_t i = 0; i < v->count; i++) {
+        const ProcWatchSeries *s = &v->series[i];
+        if (s->failed) {
+            printf("Watch %7u  cannot be opened\n", (unsigned)s->pid);
+            continue;
+        }
+        uint32_t n = 0;
+        uint32_t unused = 0;
+        float peak = 0.0f;
+        const double cpu = fresh_mean(&s->cpuPct, &seen[i][0], &n, &peak);
+        const double ws = fresh_mean(&s->workingSetMB, &seen[i][1], &unused, NULL);
+        const double io = fresh_mean(&s->ioMBps, &seen[i][2], &unused, NULL);
+        const double cs = fresh_mean(&s->ctxPerSec, &seen[i][3], &unused, NULL);
+        printf("Watch %7u  %4u samples (%.1f Hz)  CPU %5.1f%% (peak %.1f)  WS %.1f MB", (unsigned)s->pid, (unsigned)n,
+               (double)n / interval, cpu, peak, ws);
+        if (s->hasIo) printf("  I/O %.2f MB/s", io);
+        if (s->hasCtx) printf("  cs/s %.0f", cs);
+        printf("%s\n", s->exited ? "  (exited)" : "");
+    }
+    if (v->count) printf("\n");
+    fflush(stdout);
+}
+
+static void print_self_stats(const SelfStats *set)
+{
+    printf("thread,stage,calls,p50_us,p99_us,max_us,mean_us,allocs_per_call,allocs_max\n");
+    for (uint32_t i = 0; i < set->stageCount; i++) {
+        SelfStageSummary sum;
+        SelfStats_Summarize(&set->stages[i], &sum);
+        printf("sampler,%ls,%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%u\n",
+               set->stages[i].name, (unsigned long long)sum.count,
+               sum.p50Us, sum.p99Us, sum.maxUs, sum.meanUs,
+               sum.allocsPerCall, (unsigned)sum.allocMax);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    setlocale(LC_ALL, "");
+
+    double interval = 1.0;
+    long count = 5;
+    uint32_t top = 10;
+    bool flat = false;
+    ProcGroupKey groupBy = PROC_GROUP_NAME;
+    bool usage = false;
+    bool self = false;
+    const char *recordPath = NULL;
+    const char *replayPath = NULL;
+    const char *exportPath = NULL;
+    const char *historyPath = NULL;
+    double speed = 1.0;
+    uint32_t watchPids[PROC_WATCH_MAX];
+    uint32_t watchCount = 0;
+    double watchHz = PROC_WATCH_DEFAULT_HZ;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = (uint32_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--flat") == 0) {
+            flat = true;
+        } else if (strcmp(argv[i], "--group-by") == 0 && i + 1 < argc) {
+            const char *col = argv[++i];
+            if (strcmp(col, "name") == 0) {
+                groupBy = PROC_GROUP_NAME;
+            } else if (strcmp(col, "owner") == 0) {
+                groupBy = PROC_GROUP_OWNER;
+            } else if (strcmp(col, "path") == 0) {
+                groupBy = PROC_GROUP_PATH;
+            } else {
+                usage = true;
+            }
+        } else if (strcmp(argv[i], "--self") == 0) {
+            self = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+            exportPath = argv[++i];
+        } else if (strcmp(argv[i], "--history-file") == 0 && i + 1 < argc) {
+            historyPath = argv[++i];
+        } else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc && watchCount < PROC_WATCH_MAX) {
+            watchPids[watchCount++] = (uint32_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--watch-hz") == 0 && i + 1 < argc) {
+            watchHz = atof(argv[++i]);
+        } else {
+            usage = true;
+        }
+        if (usage) {
+            fprintf(stderr, "usage: %s [--interval SEC] [--count N] [--top N] [--flat] [--self]\n"
+                            "       [--group-by name|owner|path]\n"
+                            "       [--record FILE | --replay FILE [--speed X]] [--export FILE]\n"
+                            "       [--history-file FILE] [--watch PID]... [--watch-hz HZ]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (recordPath && replayPath) {
+        fprintf(stderr, "--record and --replay are mutually exclusive\n");
+        return 2;
+    }
+    if (interval < 0.05) interval = 0.05;
+
+    long ncpu = sysconf(_SC_NPROCESSORS_CONF);
+    if (ncpu <= 0) ncpu = 1;
+
+    static Sampler sampler;
+    if (replayPath) {
+        FILE *f = fopen(replayPath, "rb");
+        if (!f) {
+            fprintf(stderr, "cannot open %s\n", replayPath);
+            return 1;
+        }
+        if (!Sampler_StartReplay(&sampler, 240, f, speed)) {
+            fprintf(stderr, "%s is not a CCM capture\n", replayPath);
+            Sampler_Stop(&sampler);
+            return 1;
+        }
+    } else {
+        uint32_t collectorCount = 0;
+        const CollectorOps *const *collectors = Collector_PlatformDefaults(&collectorCount);
+        FILE *history = NULL;
+        if (historyPath) {
+            history = fopen(historyPath, "r+b");
+            if (!history) history = fopen(historyPath, "w+b");
+            if (!history) fprintf(stderr, "cannot open %s; history is not persisted\n", historyPath);
+        }
+        if (!Sampler_Start(&sampler, (uint32_t)ncpu, 240, collectors, collectorCount, interval, history)) {
+            fprintf(stderr, "Sampler_Start failed\n");
+            Sampler_Stop(&sampler);
+            return 1;
+        }
+    }
+
+    if (recordPath) {
+        FILE *f = fopen(recordPath, "wb");
+        if (!f) {
+            fprintf(stderr, "cannot create %s\n", recordPath);
+            Sampler_Stop(&sampler);
+            return 1;
+        }
+        Sampler_SetRecording(&sampler, f);
+    }
+
+    static ProcWatch watch;
+    ProcWatchView watchView;
+    uint64_t watchSeen[PROC_WATCH_MAX][4];
+    memset(&watchView, 0, sizeof(watchView));
+    memset(watchSeen, 0, sizeof(watchSeen));
+    if (watchCount > 0 && !replayPath) {
+        if (ProcWatch_Start(&watch, ProcWatch_PlatformOps(), watchHz, PROC_WATCH_HISTORY)) {
+            ProcWatch_SetPids(&watch, watchPids, watchCount);
+        } else {
+            fprintf(stderr, "ProcWatch_Start failed\n");
+        }
+    }
+
+    // Only the printed rows need to be in order.
+    ProcViewSettings settings;
+    ProcViewSettings_Init(&settings);
+    settings.stacked = !flat;
+    settings.groupBy = groupBy;
+    settings.sortDepth = top;
+    Sampler_SetProcViewSettings(&sampler, &settings);
+
+    // The first sample only primes the rate counters; print from the second one.
+    sleep_seconds(interval);
+    for (long i = 0; count <= 0 || i < count; i++) {
+        const bool done = Sampler_ReplayDone(&sampler);
+        if (!done) {
+            sleep_seconds(interval);
+        }
+        print_sample(Sampler_AcquireFrame(&sampler, NULL), top);
+        print_watch(&watch, &watchView, watchSeen, interval);
+        if (done) {
+            break;
+        }
+    }
+
+    if (Sampler_ReplayDone(&sampler)) {
+        printf("Replayed %llu ticks (%.1f s of capture)\n",
+               (unsigned long long)sampler.replay.tickCount, (double)sampler.replay.tNs * 1e-9);
+    }
+    if (self) {
+        print_self_stats(&Sampler_AcquireFrame(&sampler, NULL)->self);
+    }
+    if (exportPath) {
+        FILE *f = fopen(exportPath, "w");
+        const bool ok = f && MonitorFrame_ExportArchive(Sampler_AcquireFrame(&sampler, NULL), f);
+        if (f) fclose(f);
+        if (!ok) {
+            fprintf(stderr, "cannot write %s\n", exportPath);
+        }
+    }
+
+    ProcWatch_Stop(&watch);
+    ProcWatchView_Free(&watchView);
+    Sampler_Stop(&sampler);
+    return 0;
+}